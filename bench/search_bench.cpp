@@ -0,0 +1,250 @@
+// 转录全文搜索的索引构建与查询基准
+// 生成多小时的中英混合合成转录，测量倒排索引的构建吞吐量和每条消息的内存占用，
+// 以及子串、正则、拼音模糊三种方式的 p50/p99 查询延迟（与会话内搜索相同的流程：
+// 索引筛选候选消息后逐条校验）。每个查询的结果都与逐条扫描的参考实现比对，
+// 同时给出参考实现的延迟作为对照。子串查询另外测量只取前 kFirstPageHits 个命中（界面上的第一批结果）的延迟。
+// 默认 140 小时的转录约有 10 万条消息。
+//
+// 用法: meetant_search_bench [会议小时数=140] [子串查询数=500]
+
+#include "SearchIndex.h"
+#include "RegexSearch.h"
+#include "FuzzySearch.h"
+#include "Pinyin.h"
+#include "synthetic_transcript.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+using MeetAnt::SearchHit;
+using MeetAnt::SearchIndex;
+using MeetAnt::Synthetic::Message;
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    // 第一批结果的命中数
+    const size_t kFirstPageHits = 50;
+
+    struct ModeStats {
+        double p50;
+        double p99;
+        double referenceP50;
+        double referenceP99;
+        size_t hitMessages;     // 所有查询命中的消息数之和
+        size_t mismatches;      // 与参考实现不一致的查询数
+    };
+
+    double Percentile(std::vector<double> values, double fraction) {
+        if (values.empty()) {
+            return 0.0;
+        }
+        std::sort(values.begin(), values.end());
+        size_t index = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+        return values[std::min(index, values.size() - 1)];
+    }
+
+    double ElapsedMs(Clock::time_point start, Clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // 对每个查询分别计时索引搜索和参考实现，两者都返回命中的消息序号（升序）
+    template <typename Query, typename IndexedSearch, typename ReferenceSearch>
+    ModeStats Measure(const std::vector<Query>& queries, IndexedSearch indexed, ReferenceSearch reference) {
+        ModeStats stats = {};
+        std::vector<double> latencies;
+        std::vector<double> referenceLatencies;
+        for (const Query& query : queries) {
+            auto start = Clock::now();
+            std::vector<size_t> documents = indexed(query);
+            auto middle = Clock::now();
+            std::vector<size_t> expected = reference(query);
+            auto end = Clock::now();
+
+            latencies.push_back(ElapsedMs(start, middle));
+            referenceLatencies.push_back(ElapsedMs(middle, end));
+            stats.hitMessages += documents.size();
+            if (documents != expected) {
+                stats.mismatches++;
+            }
+        }
+        stats.p50 = Percentile(latencies, 0.5);
+        stats.p99 = Percentile(latencies, 0.99);
+        stats.referenceP50 = Percentile(referenceLatencies, 0.5);
+        stats.referenceP99 = Percentile(referenceLatencies, 0.99);
+        return stats;
+    }
+
+    void PrintStats(const char* mode, size_t queryCount, const ModeStats& stats) {
+        std::printf("%-6s %4zu 个查询  p50 %8.3f ms  p99 %8.3f ms  | 逐条扫描 p50 %8.3f ms  p99 %8.3f ms"
+                    "  | 命中 %zu 条  不一致 %zu\n",
+                    mode, queryCount, stats.p50, stats.p99, stats.referenceP50, stats.referenceP99,
+                    stats.hitMessages, stats.mismatches);
+    }
+
+    std::vector<size_t> UniqueDocuments(const std::vector<SearchHit>& hits) {
+        std::vector<size_t> documents;
+        for (const auto& hit : hits) {
+            if (documents.empty() || documents.back() != hit.document) {
+                documents.push_back(hit.document);
+            }
+        }
+        return documents;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    double hours = argc > 1 ? std::strtod(argv[1], nullptr) : 140.0;
+    size_t substringQueryCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500;
+    if (hours <= 0.0 || substringQueryCount == 0) {
+        std::fprintf(stderr, "用法: %s [会议小时数] [子串查询数]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Message> messages = MeetAnt::Synthetic::GenerateTranscript(hours, 20240601);
+    size_t characters = 0;
+    for (const auto& message : messages) {
+        characters += message.text.length();
+    }
+
+    // 构建吞吐量：与会话加载时相同，逐条追加
+    SearchIndex index;
+    auto buildStart = Clock::now();
+    for (const auto& message : messages) {
+        index.AddDocument(message.text);
+    }
+    double buildMs = ElapsedMs(buildStart, Clock::now());
+
+    size_t memory = index.GetMemoryUsage();
+    std::printf("转录: %.1f 小时, %zu 条消息, %zu 字\n", hours, messages.size(), characters);
+    std::printf("构建: %.0f ms, %.0f 条/秒, %.2f M字/秒\n", buildMs,
+                messages.size() / (buildMs / 1000.0), characters / (buildMs / 1000.0) / 1e6);
+    std::printf("内存: %.1f MB, 每条消息 %.0f 字节\n", memory / 1048576.0,
+                static_cast<double>(memory) / std::max<size_t>(1, messages.size()));
+
+    // 转录控件的索引只保存倒排表，原文在分页文件中
+    {
+        SearchIndex postingsOnly(false);
+        for (const auto& message : messages) {
+            postingsOnly.AddDocument(message.text);
+        }
+        size_t postingsMemory = postingsOnly.GetMemoryUsage();
+        std::printf("内存（仅倒排表）: %.1f MB, 每条消息 %.0f 字节\n", postingsMemory / 1048576.0,
+                    static_cast<double>(postingsMemory) / std::max<size_t>(1, messages.size()));
+    }
+
+    // 子串：倒排索引筛选 + 规范化文本校验
+    std::vector<std::wstring> substrings = MeetAnt::Synthetic::MakeSubstringQueries(messages, substringQueryCount, 7);
+    ModeStats substringStats = Measure(substrings,
+        [&index](const std::wstring& query) {
+            return UniqueDocuments(index.Search(query));
+        },
+        [&messages](const std::wstring& query) {
+            return UniqueDocuments(MeetAnt::Synthetic::BruteForceSubstring(messages, query));
+        });
+    PrintStats("子串", substrings.size(), substringStats);
+
+    // 子串第一批：命中达到 kFirstPageHits 即停止；参考实现同样在逐条扫描中提前停止
+    ModeStats firstPageStats = Measure(substrings,
+        [&index](const std::wstring& query) {
+            return UniqueDocuments(index.Search(query, kFirstPageHits));
+        },
+        [&messages](const std::wstring& query) {
+            std::vector<size_t> documents;
+            std::wstring needle = SearchIndex::Normalize(query);
+            size_t hitCount = 0;
+            for (size_t document = 0; document < messages.size() && hitCount < kFirstPageHits; ++document) {
+                std::wstring text = SearchIndex::Normalize(messages[document].text);
+                size_t pos = text.find(needle);
+                if (pos != std::wstring::npos) {
+                    documents.push_back(document);
+                }
+                for (; pos != std::wstring::npos && hitCount < kFirstPageHits;
+                     pos = text.find(needle, pos + needle.length())) {
+                    hitCount++;
+                }
+            }
+            return documents;
+        });
+    PrintStats("首批", substrings.size(), firstPageStats);
+
+    // 正则：字面串筛选候选后在原文上匹配；参考实现在全部消息上匹配
+    std::vector<std::wstring> patterns = MeetAnt::Synthetic::MakeRegexQueries();
+    std::vector<size_t> validPatterns;
+    std::vector<std::unique_ptr<MeetAnt::RegexQuery>> regexes;
+    for (const auto& pattern : patterns) {
+        std::unique_ptr<MeetAnt::RegexQuery> regex(new MeetAnt::RegexQuery());
+        if (regex->Compile(pattern, false)) {
+            validPatterns.push_back(regexes.size());
+            regexes.push_back(std::move(regex));
+        }
+    }
+    std::vector<SearchHit> hits;
+    ModeStats regexStats = Measure(validPatterns,
+        [&](size_t q) {
+            std::vector<size_t> documents;
+            for (uint32_t document : regexes[q]->FindCandidates(index)) {
+                hits.clear();
+                if (regexes[q]->Match(messages[document].text, document, hits, 1)) {
+                    documents.push_back(document);
+                }
+            }
+            return documents;
+        },
+        [&](size_t q) {
+            std::vector<size_t> documents;
+            for (size_t document = 0; document < messages.size(); ++document) {
+                hits.clear();
+                if (regexes[q]->Match(messages[document].text, document, hits, 1)) {
+                    documents.push_back(document);
+                }
+            }
+            return documents;
+        });
+    PrintStats("正则", validPatterns.size(), regexStats);
+
+    // 拼音模糊：拼音双字母的位图筛选候选后逐条运行位并行自动机；参考实现在拼音键上做动态规划
+    std::vector<std::wstring> fuzzyQueries = MeetAnt::Synthetic::MakeFuzzyQueries();
+    ModeStats fuzzyStats = Measure(fuzzyQueries,
+        [&](const std::wstring& query) {
+            std::vector<size_t> documents;
+            MeetAnt::FuzzyQuery fuzzy;
+            if (!fuzzy.Compile(query)) {
+                return documents;
+            }
+            for (uint32_t document : fuzzy.FindCandidates(index)) {
+                hits.clear();
+                if (fuzzy.Match(index.GetNormalizedText(document), index.GetPinyinKey(document), document, hits, 1)) {
+                    documents.push_back(document);
+                }
+            }
+            return documents;
+        },
+        [&](const std::wstring& query) {
+            std::vector<size_t> documents;
+            MeetAnt::FuzzyQuery fuzzy;
+            if (!fuzzy.Compile(query)) {
+                return documents;
+            }
+            for (size_t document = 0; document < messages.size(); ++document) {
+                std::string key = MeetAnt::ToPinyinKey(SearchIndex::Normalize(messages[document].text));
+                if (MeetAnt::Synthetic::ApproximateContains(key, fuzzy.GetKey(), fuzzy.GetMaxDistance())) {
+                    documents.push_back(document);
+                }
+            }
+            return documents;
+        });
+    PrintStats("模糊", fuzzyQueries.size(), fuzzyStats);
+
+    size_t mismatches = substringStats.mismatches + firstPageStats.mismatches + regexStats.mismatches +
+                        fuzzyStats.mismatches;
+    if (mismatches > 0) {
+        std::printf("有 %zu 个查询的结果与参考实现不一致\n", mismatches);
+        return 2;
+    }
+    return 0;
+}
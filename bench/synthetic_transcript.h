@@ -0,0 +1,198 @@
+// 搜索基准和单元测试共用的合成转录与暴力参考实现
+// 按固定随机种子生成中英混合的会议转录：中文词、英文术语（大小写混杂）、数字和标点，
+// 消息间隔 1.5~8.5 秒，按小时数决定消息条数。参考实现逐条扫描全部消息，
+// 不经过倒排索引，用来校验索引筛选和自动机匹配的结果。
+
+#ifndef MEETANT_SYNTHETIC_TRANSCRIPT_H
+#define MEETANT_SYNTHETIC_TRANSCRIPT_H
+
+#include "SearchIndex.h"
+#include "Pinyin.h"
+#include <algorithm>
+#include <cstdint>
+#include <cwctype>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace MeetAnt {
+namespace Synthetic {
+
+struct Message {
+    std::wstring speaker;
+    std::wstring text;
+    int64_t timeMs;         // 相对会议开始的毫秒数
+};
+
+namespace Detail {
+    const wchar_t* const kChineseWords[] = {
+        L"项目", L"进度", L"预算", L"审批", L"客户", L"需求", L"上线", L"时间", L"测试", L"版本",
+        L"发布", L"会议", L"讨论", L"市场", L"调研", L"用户", L"反馈", L"设计", L"方案", L"开发",
+        L"团队", L"资源", L"风险", L"评估", L"合同", L"供应商", L"数据", L"分析", L"报告", L"季度",
+        L"目标", L"销售", L"增长", L"成本", L"优化", L"流程", L"培训", L"部门", L"负责人", L"安排",
+        L"确认", L"问题", L"解决", L"下周", L"今天", L"明天", L"我们", L"大家", L"这个", L"那个",
+        L"然后", L"就是", L"可以", L"需要", L"已经", L"还是", L"比较", L"重要", L"一下", L"关于"
+    };
+    const wchar_t* const kEnglishWords[] = {
+        L"API", L"roadmap", L"deadline", L"release", L"sprint", L"backend", L"frontend", L"OKR",
+        L"KPI", L"demo", L"review", L"feature", L"bug", L"server", L"database", L"iOS", L"Android",
+        L"cloud", L"budget", L"launch", L"meeting", L"customer", L"pipeline", L"dashboard",
+        L"metrics", L"version", L"staging", L"rollout", L"Q1", L"Q2", L"Q3", L"Q4"
+    };
+    const wchar_t* const kSeparators[] = { L"，", L"、", L"；" };
+    const wchar_t* const kEndings[] = { L"。", L"？", L"！", L"。" };
+    const wchar_t* const kSpeakers[] = { L"张经理", L"李总", L"王工", L"赵敏", L"Alice", L"Bob" };
+
+    template <typename T, size_t N>
+    const T& Pick(const T (&items)[N], std::mt19937& rng) {
+        return items[std::uniform_int_distribution<size_t>(0, N - 1)(rng)];
+    }
+
+    inline std::wstring MakeSentence(std::mt19937& rng) {
+        std::uniform_int_distribution<int> tokenCount(6, 40);
+        std::uniform_int_distribution<int> percent(0, 99);
+        std::wstring text;
+        bool lastLatin = false;
+        int count = tokenCount(rng);
+        for (int t = 0; t < count; ++t) {
+            int kind = percent(rng);
+            std::wstring token;
+            bool latin = true;
+            if (kind < 70) {
+                token = Pick(kChineseWords, rng);
+                latin = false;
+            } else if (kind < 90) {
+                token = Pick(kEnglishWords, rng);
+                if (percent(rng) < 10) {
+                    for (wchar_t& ch : token) {
+                        ch = static_cast<wchar_t>(std::towupper(ch));
+                    }
+                } else if (percent(rng) < 20) {
+                    token[0] = static_cast<wchar_t>(std::towupper(token[0]));
+                }
+            } else {
+                token = std::to_wstring(percent(rng));
+                if (percent(rng) < 30) {
+                    token += L"%";
+                }
+            }
+            // 拉丁词之间用空格分隔，中文和拉丁词之间随机加空格
+            if (!text.empty() && ((lastLatin && latin) || ((lastLatin || latin) && percent(rng) < 50))) {
+                text += L' ';
+            }
+            text += token;
+            lastLatin = latin;
+
+            if (t + 1 < count && percent(rng) < 15) {
+                text += Pick(kSeparators, rng);
+                lastLatin = false;
+            }
+        }
+        text += Pick(kEndings, rng);
+        return text;
+    }
+}
+
+// 生成 hours 小时的会议转录
+inline std::vector<Message> GenerateTranscript(double hours, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int64_t> gap(1500, 8500);
+    const int64_t duration = static_cast<int64_t>(hours * 3600.0 * 1000.0);
+
+    std::vector<Message> messages;
+    for (int64_t time = 0; time < duration; time += gap(rng)) {
+        messages.push_back(Message{Detail::Pick(Detail::kSpeakers, rng), Detail::MakeSentence(rng), time});
+    }
+    return messages;
+}
+
+// 子串查询：词表中的词和词组、大小写变体、从消息中截取的片段，以及几个不会命中的查询
+inline std::vector<std::wstring> MakeSubstringQueries(const std::vector<Message>& messages, size_t count,
+                                                      uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> kind(0, 9);
+    std::vector<std::wstring> queries = { L"量子计算", L"blockchain", L"ＡＰＩ", L"Release", L"DEADLINE" };
+    while (queries.size() < count) {
+        int k = kind(rng);
+        if (k < 3) {
+            queries.push_back(Detail::Pick(Detail::kChineseWords, rng));
+        } else if (k < 5) {
+            queries.push_back(std::wstring(Detail::Pick(Detail::kChineseWords, rng)) +
+                              Detail::Pick(Detail::kChineseWords, rng));
+        } else if (k < 7) {
+            queries.push_back(Detail::Pick(Detail::kEnglishWords, rng));
+        } else if (!messages.empty()) {
+            const std::wstring& text = messages[rng() % messages.size()].text;
+            size_t length = std::min<size_t>(text.length(), 2 + rng() % 5);
+            size_t start = rng() % (text.length() - length + 1);
+            queries.push_back(text.substr(start, length));
+        }
+    }
+    queries.resize(count);
+    return queries;
+}
+
+// 正则查询：有可用于筛选的字面串、只有分支、完全没有字面串的各几种
+inline std::vector<std::wstring> MakeRegexQueries() {
+    return {
+        L"预算.{0,6}审批", L"release\\s+\\w+", L"(?i)deadline", L"Q[1-4]\\s*目标", L"\\d{2}%",
+        L"会议|讨论", L"上线(时间)?", L"(API|SDK)\\s*版本", L"客户.*反馈", L"^我们", L"问题[？?]$",
+        L"[A-Z]{3}", L"风险评估", L"iOS|Android"
+    };
+}
+
+// 拼音模糊查询：同音字错写、近音字和直接输入的拼音
+inline std::vector<std::wstring> MakeFuzzyQueries() {
+    return {
+        L"玉算", L"相木", L"禁度", L"客户需求", L"上线时间", L"yusuan", L"xiangmu", L"fengxian",
+        L"市场条验", L"供应商合同", L"负责人安排", L"季度目标", L"shujufenxi", L"cloud"
+    };
+}
+
+// 参考实现：在规范化原文中逐条查找规范化查询，命中规则与 SearchIndex 的子串查询一致（不重叠）
+inline std::vector<SearchHit> BruteForceSubstring(const std::vector<Message>& messages, const std::wstring& query) {
+    std::vector<SearchHit> hits;
+    std::wstring needle = SearchIndex::Normalize(query);
+    if (needle.empty()) {
+        return hits;
+    }
+    for (size_t document = 0; document < messages.size(); ++document) {
+        std::wstring text = SearchIndex::Normalize(messages[document].text);
+        for (size_t pos = text.find(needle); pos != std::wstring::npos; pos = text.find(needle, pos + needle.length())) {
+            hits.push_back(SearchHit{document, pos, needle.length()});
+        }
+    }
+    return hits;
+}
+
+// 参考实现：拼音键上的近似子串匹配（Sellers 动态规划），存在编辑距离不超过 maxDistance 的子串时为真
+inline bool ApproximateContains(const std::string& text, const std::string& pattern, int maxDistance) {
+    if (pattern.empty()) {
+        return false;
+    }
+    std::vector<int> column(pattern.length() + 1);
+    for (size_t i = 0; i <= pattern.length(); ++i) {
+        column[i] = static_cast<int>(i);
+    }
+    if (column.back() <= maxDistance) {
+        return true;
+    }
+    std::vector<int> next(pattern.length() + 1);
+    for (char ch : text) {
+        next[0] = 0;     // 匹配可以从文本的任意位置开始
+        for (size_t i = 1; i <= pattern.length(); ++i) {
+            int cost = pattern[i - 1] == ch ? 0 : 1;
+            next[i] = std::min(std::min(column[i] + 1, next[i - 1] + 1), column[i - 1] + cost);
+        }
+        column.swap(next);
+        if (column.back() <= maxDistance) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace Synthetic
+} // namespace MeetAnt
+
+#endif // MEETANT_SYNTHETIC_TRANSCRIPT_H
@@ -0,0 +1,135 @@
+// 句向量索引的查询延迟基准
+// 生成带主题聚簇的随机单位向量（模拟句向量的分布），分别测量暴力搜索和 IVF
+// 在不同探测列表数下的 p50/p99 延迟与 top-k 召回率（以暴力搜索结果为准）。
+//
+// 用法: meetant_vector_bench [向量数=100000] [维度=384] [查询数=200]
+
+#include "VectorIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+using MeetAnt::VectorIndex;
+using MeetAnt::VectorMatch;
+
+namespace {
+    const size_t kTopK = 10;
+    const size_t kTopicCount = 1000;
+
+    struct LatencyStats {
+        double p50;
+        double p99;
+        double recall;
+    };
+
+    double Percentile(std::vector<double> values, double fraction) {
+        std::sort(values.begin(), values.end());
+        size_t index = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+        return values[std::min(index, values.size() - 1)];
+    }
+
+    // 主题中心加高斯噪声后归一化
+    std::vector<float> MakeVectors(size_t count, size_t dimension, const std::vector<float>& topics,
+                                   float noise, std::mt19937& rng) {
+        std::normal_distribution<float> gauss(0.0f, noise);
+        std::uniform_int_distribution<size_t> pickTopic(0, kTopicCount - 1);
+        std::vector<float> vectors(count * dimension);
+        for (size_t i = 0; i < count; ++i) {
+            const float* topic = &topics[pickTopic(rng) * dimension];
+            float* vector = &vectors[i * dimension];
+            for (size_t d = 0; d < dimension; ++d) {
+                vector[d] = topic[d] + gauss(rng);
+            }
+            MeetAnt::NormalizeVector(vector, dimension);
+        }
+        return vectors;
+    }
+
+    template <typename SearchFunction>
+    LatencyStats Measure(const std::vector<float>& queries, size_t dimension,
+                         const std::vector<std::vector<VectorMatch>>& truth, SearchFunction search) {
+        size_t queryCount = queries.size() / dimension;
+        std::vector<double> latencies;
+        latencies.reserve(queryCount);
+        size_t found = 0;
+        for (size_t q = 0; q < queryCount; ++q) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<VectorMatch> matches = search(&queries[q * dimension]);
+            auto end = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+            std::unordered_set<uint32_t> expected;
+            for (const auto& match : truth[q]) {
+                expected.insert(match.id);
+            }
+            for (const auto& match : matches) {
+                found += expected.count(match.id);
+            }
+        }
+        return LatencyStats{Percentile(latencies, 0.5), Percentile(latencies, 0.99),
+                            static_cast<double>(found) / (queryCount * kTopK)};
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    size_t dimension = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 384;
+    size_t queryCount = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200;
+    if (count == 0 || dimension == 0 || queryCount == 0) {
+        std::fprintf(stderr, "用法: %s [向量数] [维度] [查询数]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 rng(20240601);
+    std::vector<float> topics(kTopicCount * dimension);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    for (float& value : topics) {
+        value = gauss(rng);
+    }
+    for (size_t t = 0; t < kTopicCount; ++t) {
+        MeetAnt::NormalizeVector(&topics[t * dimension], dimension);
+    }
+
+    // 噪声与主题方向的模长相当，同主题向量的余弦相似度约为 0.5
+    float noise = 1.0f / std::sqrt(static_cast<float>(dimension));
+    std::vector<float> vectors = MakeVectors(count, dimension, topics, noise, rng);
+    std::vector<float> queries = MakeVectors(queryCount, dimension, topics, noise, rng);
+
+    VectorIndex index(dimension);
+    for (size_t i = 0; i < count; ++i) {
+        index.Add(static_cast<uint32_t>(i), &vectors[i * dimension]);
+    }
+    std::printf("向量: %zu x %zu 维, 查询: %zu, top-%zu, 索引内存: %.1f MB\n",
+                count, dimension, queryCount, kTopK, index.GetMemoryUsage() / 1048576.0);
+
+    std::vector<std::vector<VectorMatch>> truth(queryCount);
+    for (size_t q = 0; q < queryCount; ++q) {
+        truth[q] = index.SearchExact(&queries[q * dimension], kTopK);
+    }
+
+    LatencyStats flat = Measure(queries, dimension, truth, [&index](const float* query) {
+        return index.Search(query, kTopK);
+    });
+    std::printf("flat           p50 %8.3f ms  p99 %8.3f ms  召回 %.3f\n", flat.p50, flat.p99, flat.recall);
+
+    size_t listCount = std::max<size_t>(2, static_cast<size_t>(std::sqrt(static_cast<double>(count))));
+    auto buildStart = std::chrono::steady_clock::now();
+    index.BuildClusters(listCount);
+    auto buildEnd = std::chrono::steady_clock::now();
+    std::printf("IVF 训练: %zu 个列表, %.0f ms\n", listCount,
+                std::chrono::duration<double, std::milli>(buildEnd - buildStart).count());
+
+    for (size_t probeCount : { 4, 8, 16, 32 }) {
+        LatencyStats ivf = Measure(queries, dimension, truth, [&index, probeCount](const float* query) {
+            return index.Search(query, kTopK, probeCount);
+        });
+        std::printf("ivf nprobe=%-3zu p50 %8.3f ms  p99 %8.3f ms  召回 %.3f\n",
+                    probeCount, ivf.p50, ivf.p99, ivf.recall);
+    }
+    return 0;
+}
@@ -1,18 +1,19 @@
 #include "Annotation.h"
-#include <wx/file.h>
+#include "AnnotationJournal.h"
+#include "RecordCodec.h"
 #include <wx/tokenzr.h>
-#include <wx/filename.h>
-#include <wx/textfile.h>
-#include <wx/wfstream.h>
-#include <wx/txtstrm.h>
 #include <algorithm>
-#include <sstream>
 
 namespace MeetAnt {
 
+namespace {
+    // 日志记录数达到快照中的批注数、且不少于该值时压缩为新快照
+    const size_t kCompactMinRecords = 256;
+}
+
 // --------- Annotation 基类实现 ---------
 Annotation::Annotation(const wxString& sessionId, TimeStamp timestamp, const wxString& content)
-    : m_sessionId(sessionId), m_timestamp(timestamp), m_content(content) {
+    : m_sessionId(sessionId), m_timestamp(timestamp), m_content(content), m_id(0) {
     m_creationTime = wxDateTime::Now();
 }
 
@@ -28,6 +29,59 @@ wxString Annotation::ToString() const {
                            m_content);
 }
 
+void Annotation::Encode(std::string& out) const {
+    // 类型|时间戳|创建时间（毫秒）|会话ID|内容，派生类在后面追加各自的字段
+    AppendValue<uint8_t>(out, static_cast<uint8_t>(GetType()));
+    AppendValue<int64_t>(out, m_timestamp);
+    AppendValue<int64_t>(out, m_creationTime.IsValid() ? m_creationTime.GetValue().GetValue() : 0);
+    AppendString(out, m_sessionId);
+    AppendString(out, m_content);
+}
+
+std::unique_ptr<Annotation> Annotation::Decode(const char* data, size_t size) {
+    ByteReader reader(data, size);
+    uint8_t type;
+    int64_t timestamp;
+    int64_t creationTime;
+    wxString sessionId;
+    wxString content;
+    if (!reader.Read(type) || !reader.Read(timestamp) || !reader.Read(creationTime) ||
+        !reader.ReadString(sessionId) || !reader.ReadString(content)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<Annotation> annotation;
+    switch (static_cast<AnnotationType>(type)) {
+        case AnnotationType::Highlight: {
+            uint32_t rgba;
+            if (reader.Read(rgba)) {
+                wxColour color;
+                color.SetRGBA(rgba);
+                annotation = std::make_unique<HighlightAnnotation>(sessionId, timestamp, content, color);
+            }
+            break;
+        }
+        case AnnotationType::Note: {
+            wxString title;
+            if (reader.ReadString(title)) {
+                annotation = std::make_unique<NoteAnnotation>(sessionId, timestamp, content, title);
+            }
+            break;
+        }
+        case AnnotationType::Bookmark: {
+            wxString label;
+            if (reader.ReadString(label)) {
+                annotation = std::make_unique<BookmarkAnnotation>(sessionId, timestamp, content, label);
+            }
+            break;
+        }
+    }
+    if (annotation) {
+        annotation->SetParsedCreationTime(wxDateTime(wxLongLong(creationTime)));
+    }
+    return annotation;
+}
+
 wxString Annotation::Serialize() const {
     // 基本序列化格式：会话ID|时间戳|创建时间|内容
     return wxString::Format(wxT("%s|%lld|%s|%s"),
@@ -38,28 +92,73 @@ wxString Annotation::Serialize() const {
 }
 
 std::unique_ptr<Annotation> Annotation::Deserialize(const wxString& data) {
-    // 这个基类方法将根据数据格式确定具体批注类型，然后调用相应的构造函数
-    // 实际解析应在 AnnotationManager::LoadAnnotations 中根据前缀调用各派生类的特定解析方法
-    // 或者在这里实现一个工厂，但由于派生类需要不同的参数，放在Manager中逐层解析更清晰
-    wxStringTokenizer tokenizer(data, wxT("|"));
-    if (tokenizer.CountTokens() < 1) return nullptr;
+    // TypePrefix|SessionID|Timestamp|CreationTimeStr|Content|SpecificData
+    wxStringTokenizer tokenizer(data, wxT('|'));
+    if (tokenizer.CountTokens() < 6) { // Minimum parts: Prefix|SID|TS|CTS|Content|Specific
+        wxLogWarning(wxT("Skipping malformed annotation line (not enough primary tokens): %s"), data);
+        return nullptr;
+    }
 
     wxString typePrefix = tokenizer.GetNextToken();
-    // 剩余的 data 部分是派生类序列化内容，或者说，是基类序列化 + 派生类特定序列化
-    // 但我们这里不能简单地传递 data.Mid(2) 因为基类的 Serialize 并不包含类型前缀
-
-    // 由于每个派生类的 Serialize 方法格式不同，且都以类型前缀开头
-    // 真正的反序列化逻辑最好放在 AnnotationManager::LoadAnnotations 中
-    // 或者每个派生类提供一个静态的 Deserialize 方法
-    // 例如：
-    // if (typePrefix == wxT("H")) {
-    //     return HighlightAnnotation::DeserializeFromString(data); // 假设有此方法
-    // } else if (typePrefix == wxT("N")) {
-    //     return NoteAnnotation::DeserializeFromString(data);
-    // } else if (typePrefix == wxT("B")) {
-    //     return BookmarkAnnotation::DeserializeFromString(data);
-    // }
-    return nullptr; // 应该由 AnnotationManager 处理
+    wxString sessionId = tokenizer.GetNextToken();
+    wxString timestampStr = tokenizer.GetNextToken();
+    wxString creationTimeStr = tokenizer.GetNextToken();
+    wxString content = tokenizer.GetNextToken(); // This will be the base content
+    // SpecificData will be the rest of the tokens, joined if necessary, or the last token.
+
+    long long timestampVal;
+    if (!timestampStr.ToLongLong(&timestampVal)) {
+        wxLogWarning(wxT("Skipping annotation line (bad timestamp): %s"), data);
+        return nullptr;
+    }
+
+    wxDateTime creationTime;
+    if (!creationTime.ParseFormat(creationTimeStr, wxT("%Y-%m-%d %H:%M:%S"))) {
+         wxLogWarning(wxT("Skipping annotation line (bad creation time format): %s"), data);
+        return nullptr;
+    }
+    
+    // Reconstruct specificData if it was tokenized due to containing pipes.
+    // This is still a simplification. Ideally, content and specific data fields that
+    // might contain the delimiter should be robustly escaped/unescaped or a different format (JSON) used.
+    wxString specificData = wxT("");
+    if (tokenizer.HasMoreTokens()){
+        specificData = tokenizer.GetNextToken();
+        while(tokenizer.HasMoreTokens()){ // if specific data itself has pipes for some complex future case
+             specificData << wxT("|") << tokenizer.GetNextToken();
+        }
+    } else if (typePrefix == wxT("H") || typePrefix == wxT("N") || typePrefix == wxT("B")){
+        // If there are exactly 6 tokens (Prefix|SID|TS|CTS|Content|Specific) and Specific should not be empty.
+        wxLogWarning(wxT("Skipping annotation line (missing specific data like color, title, or label): %s"), data);
+        return nullptr;
+    }
+    // If specificData is truly optional for some types, the above check needs adjustment.
+
+    std::unique_ptr<Annotation> annotation = nullptr;
+
+    if (typePrefix == wxT("H")) {
+        wxColour color;
+        if (!color.Set(specificData)) { // specificData is colorStr for Highlight
+             wxLogWarning(wxT("Skipping Highlight annotation line (bad color string '%s'): %s"), specificData, data);
+            return nullptr;
+        }
+        annotation = std::make_unique<HighlightAnnotation>(sessionId, timestampVal, content, color);
+
+    } else if (typePrefix == wxT("N")) {
+        // specificData is title for Note
+        annotation = std::make_unique<NoteAnnotation>(sessionId, timestampVal, content, specificData);
+
+    } else if (typePrefix == wxT("B")) {
+        // specificData is label for Bookmark
+        annotation = std::make_unique<BookmarkAnnotation>(sessionId, timestampVal, content, specificData);
+    } else {
+        wxLogWarning(wxT("Unknown annotation type prefix: '%s' in line: %s"), typePrefix, data);
+    }
+
+    if (annotation) {
+        annotation->SetParsedCreationTime(creationTime); // Use the new public setter
+    }
+    return annotation;
 }
 
 // --------- HighlightAnnotation 实现 ---------
@@ -72,6 +171,11 @@ wxString HighlightAnnotation::ToString() const {
     return wxString::Format(wxT("[高亮] %s"), Annotation::ToString());
 }
 
+void HighlightAnnotation::Encode(std::string& out) const {
+    Annotation::Encode(out);
+    AppendValue<uint32_t>(out, m_color.GetRGBA());
+}
+
 wxString HighlightAnnotation::Serialize() const {
     // 继承基类序列化并添加颜色信息: H|BaseSerialized|R,G,B
     return wxString::Format(wxT("H|%s|%s"), 
@@ -93,6 +197,11 @@ wxString NoteAnnotation::ToString() const {
     }
 }
 
+void NoteAnnotation::Encode(std::string& out) const {
+    Annotation::Encode(out);
+    AppendString(out, m_title);
+}
+
 wxString NoteAnnotation::Serialize() const {
     // 继承基类序列化并添加标题信息: N|BaseSerialized|Title
     return wxString::Format(wxT("N|%s|%s"), 
@@ -114,6 +223,11 @@ wxString BookmarkAnnotation::ToString() const {
     }
 }
 
+void BookmarkAnnotation::Encode(std::string& out) const {
+    Annotation::Encode(out);
+    AppendString(out, m_label);
+}
+
 wxString BookmarkAnnotation::Serialize() const {
     // 继承基类序列化并添加标签信息: B|BaseSerialized|Label
     return wxString::Format(wxT("B|%s|%s"), 
@@ -122,7 +236,8 @@ wxString BookmarkAnnotation::Serialize() const {
 }
 
 // --------- AnnotationManager 实现 ---------
-AnnotationManager::AnnotationManager() {
+AnnotationManager::AnnotationManager()
+    : m_nextId(1) {
 }
 
 AnnotationManager::~AnnotationManager() {
@@ -130,13 +245,19 @@ AnnotationManager::~AnnotationManager() {
 }
 
 void AnnotationManager::AddAnnotation(std::unique_ptr<Annotation> annotation) {
-    m_annotations.push_back(std::move(annotation));
+    if (!annotation) {
+        return;
+    }
+    
+    Annotation* raw = InsertAnnotation(std::move(annotation));
+    RecordChange(MakeRecord('+', raw));
 }
 
 std::vector<Annotation*> AnnotationManager::GetSessionAnnotations(const wxString& sessionId) {
     std::vector<Annotation*> result;
-    for (auto& annotation : m_annotations) {
-        if (annotation->GetSessionId() == sessionId) {
+    if (const SessionBucket* bucket = FindBucket(sessionId)) {
+        result.reserve(bucket->annotations.size());
+        for (const auto& annotation : bucket->annotations) {
             result.push_back(annotation.get());
         }
     }
@@ -144,20 +265,18 @@ std::vector<Annotation*> AnnotationManager::GetSessionAnnotations(const wxString
 }
 
 std::vector<Annotation*> AnnotationManager::GetAnnotationsByType(const wxString& sessionId, AnnotationType type) {
-    std::vector<Annotation*> result;
-    for (auto& annotation : m_annotations) {
-        if (annotation->GetSessionId() == sessionId && annotation->GetType() == type) {
-            result.push_back(annotation.get());
-        }
+    if (const SessionBucket* bucket = FindBucket(sessionId)) {
+        return bucket->byType[static_cast<size_t>(type)];
     }
-    return result;
+    return std::vector<Annotation*>();
 }
 
 std::vector<BookmarkAnnotation*> AnnotationManager::GetAllBookmarks() {
     std::vector<BookmarkAnnotation*> result;
-    for (auto& annotation : m_annotations) {
-        if (annotation->GetType() == AnnotationType::Bookmark) {
-            result.push_back(static_cast<BookmarkAnnotation*>(annotation.get()));
+    const size_t type = static_cast<size_t>(AnnotationType::Bookmark);
+    for (const auto& session : m_sessions) {
+        for (Annotation* annotation : session.second.byType[type]) {
+            result.push_back(static_cast<BookmarkAnnotation*>(annotation));
         }
     }
     return result;
@@ -167,142 +286,401 @@ std::vector<Annotation*> AnnotationManager::GetAnnotationsByTimeRange(const wxSt
                                                                    TimeStamp startTime, 
                                                                    TimeStamp endTime) {
     std::vector<Annotation*> result;
-    for (auto& annotation : m_annotations) {
-        if (annotation->GetSessionId() == sessionId) {
-            TimeStamp ts = annotation->GetTimestamp();
-            if (ts >= startTime && ts <= endTime) {
-                result.push_back(annotation.get());
-            }
-        }
+    if (const SessionBucket* bucket = FindBucket(sessionId)) {
+        CollectRange(bucket->byTime, startTime, endTime, result);
     }
     return result;
 }
 
-bool AnnotationManager::RemoveAnnotation(Annotation* annotation) {
-    auto it = std::find_if(m_annotations.begin(), m_annotations.end(), 
-                          [annotation](const std::unique_ptr<Annotation>& ptr) {
-                              return ptr.get() == annotation;
-                          });
-    
-    if (it != m_annotations.end()) {
-        m_annotations.erase(it);
-        return true;
+std::vector<Annotation*> AnnotationManager::GetAnnotationsByTimeRange(const wxString& sessionId,
+                                                                   AnnotationType type,
+                                                                   TimeStamp startTime,
+                                                                   TimeStamp endTime) {
+    std::vector<Annotation*> result;
+    if (const SessionBucket* bucket = FindBucket(sessionId)) {
+        CollectRange(bucket->byType[static_cast<size_t>(type)], startTime, endTime, result);
     }
-    return false;
+    return result;
 }
 
-bool AnnotationManager::SaveAnnotations(const wxString& sessionPath) {
-    wxString annotationsPath = wxFileName(sessionPath, wxT("annotations.dat")).GetFullPath();
-    wxFile file;
-    
-    if (!file.Create(annotationsPath, true) || !file.Open(annotationsPath, wxFile::write)) {
+size_t AnnotationManager::GetAnnotationCount(const wxString& sessionId) const {
+    const SessionBucket* bucket = FindBucket(sessionId);
+    return bucket ? bucket->annotations.size() : 0;
+}
+
+bool AnnotationManager::RemoveAnnotation(Annotation* annotation) {
+    if (!annotation) {
         return false;
     }
     
-    for (auto& annotation : m_annotations) {
-        wxString line = annotation->Serialize() + wxT("\n");
-        file.Write(line);
+    std::string record = MakeRecord('-', annotation);
+    if (!EraseAnnotation(annotation)) {
+        return false;
     }
-    
-    file.Close();
+    RecordChange(std::move(record));
     return true;
 }
 
-bool AnnotationManager::LoadAnnotations(const wxString& sessionPath) {
-    wxString annotationsPath = wxFileName(sessionPath, wxT("annotations.dat")).GetFullPath();
+void AnnotationManager::UpdateAnnotation(Annotation* annotation) {
+    if (!annotation) {
+        return;
+    }
     
-    if (!wxFileExists(annotationsPath)) {
-        return false; // No annotations file, not an error, just nothing to load.
+    auto it = m_byId.find(annotation->m_id);
+    if (it == m_byId.end() || it->second != annotation) {
+        return;
     }
+    RecordChange(MakeRecord('~', annotation));
+}
+
+void AnnotationManager::RecordChange(std::string record) {
+    if (m_changeListener) {
+        m_changeListener(record);
+    }
+    m_pendingRecords.push_back(std::move(record));
+}
+
+Annotation* AnnotationManager::InsertAnnotation(std::unique_ptr<Annotation> annotation, bool keepSorted) {
+    // 新批注按顺序编号；加载快照和重放日志时沿用记录中的编号
+    if (annotation->m_id == 0) {
+        annotation->m_id = m_nextId;
+    }
+    m_nextId = std::max(m_nextId, annotation->m_id + 1);
     
-    wxTextFile file; // Use wxTextFile for easier line-by-line reading
-    if (!file.Open(annotationsPath)) {
-        wxLogError(wxT("Failed to open annotations file: %s"), annotationsPath);
+    SessionBucket& bucket = m_sessions[annotation->GetSessionId()];
+    Annotation* raw = annotation.get();
+    bucket.annotations.push_back(std::move(annotation));
+    std::vector<Annotation*>& byType = bucket.byType[static_cast<size_t>(raw->GetType())];
+    if (keepSorted) {
+        InsertSorted(bucket.byTime, raw);
+        InsertSorted(byType, raw);
+    } else {
+        bucket.byTime.push_back(raw);
+        byType.push_back(raw);
+    }
+    m_byId[raw->m_id] = raw;
+    return raw;
+}
+
+bool AnnotationManager::EraseAnnotation(Annotation* annotation) {
+    auto sessionIt = m_sessions.find(annotation->GetSessionId());
+    if (sessionIt == m_sessions.end()) {
         return false;
     }
+    SessionBucket& bucket = sessionIt->second;
     
-    ClearAnnotations(); // Clear existing annotations before loading new ones
+    auto it = std::find_if(bucket.annotations.begin(), bucket.annotations.end(), 
+                          [annotation](const std::unique_ptr<Annotation>& ptr) {
+                              return ptr.get() == annotation;
+                          });
+    if (it == bucket.annotations.end()) {
+        return false;
+    }
     
-    for (wxString line = file.GetFirstLine(); !file.Eof(); line = file.GetNextLine()) {
-        if (line.IsEmpty() || line.StartsWith(wxT("#"))) { // Skip empty lines or comments
-            continue;
-        }
+    m_byId.erase(annotation->m_id);
+    EraseSorted(bucket.byTime, annotation);
+    EraseSorted(bucket.byType[static_cast<size_t>(annotation->GetType())], annotation);
+    bucket.annotations.erase(it);
+    if (bucket.annotations.empty()) {
+        m_sessions.erase(sessionIt);
+    }
+    return true;
+}
 
-        // TypePrefix|SessionID|Timestamp|CreationTimeStr|Content|SpecificData
-        wxStringTokenizer tokenizer(line, wxT('|'));
-        if (tokenizer.CountTokens() < 6) { // Minimum parts: Prefix|SID|TS|CTS|Content|Specific
-            wxLogWarning(wxT("Skipping malformed annotation line (not enough primary tokens): %s"), line);
-            continue;
+void AnnotationManager::SortIndexes() {
+    // 稳定排序，时间相同时保持添加顺序，与逐条 InsertSorted 的结果一致
+    auto byTimestamp = [](const Annotation* a, const Annotation* b) {
+        return a->GetTimestamp() < b->GetTimestamp();
+    };
+    for (auto& session : m_sessions) {
+        SessionBucket& bucket = session.second;
+        std::stable_sort(bucket.byTime.begin(), bucket.byTime.end(), byTimestamp);
+        for (auto& list : bucket.byType) {
+            std::stable_sort(list.begin(), list.end(), byTimestamp);
         }
+    }
+}
 
-        wxString typePrefix = tokenizer.GetNextToken();
-        wxString sessionId = tokenizer.GetNextToken();
-        wxString timestampStr = tokenizer.GetNextToken();
-        wxString creationTimeStr = tokenizer.GetNextToken();
-        wxString content = tokenizer.GetNextToken(); // This will be the base content
-        // SpecificData will be the rest of the tokens, joined if necessary, or the last token.
-
-        long long timestampVal;
-        if (!timestampStr.ToLongLong(&timestampVal)) {
-            wxLogWarning(wxT("Skipping annotation line (bad timestamp): %s"), line);
-            continue;
-        }
+AnnotationManager::SessionBucket* AnnotationManager::FindBucket(const wxString& sessionId) {
+    auto it = m_sessions.find(sessionId);
+    return it != m_sessions.end() ? &it->second : nullptr;
+}
 
-        wxDateTime creationTime;
-        if (!creationTime.ParseFormat(creationTimeStr, wxT("%Y-%m-%d %H:%M:%S"))) {
-             wxLogWarning(wxT("Skipping annotation line (bad creation time format): %s"), line);
-            continue;
-        }
-        
-        // Reconstruct specificData if it was tokenized due to containing pipes.
-        // This is still a simplification. Ideally, content and specific data fields that
-        // might contain the delimiter should be robustly escaped/unescaped or a different format (JSON) used.
-        wxString specificData = wxT("");
-        if (tokenizer.HasMoreTokens()){
-            specificData = tokenizer.GetNextToken();
-            while(tokenizer.HasMoreTokens()){ // if specific data itself has pipes for some complex future case
-                 specificData << wxT("|") << tokenizer.GetNextToken();
-            }
-        } else if (typePrefix == wxT("H") || typePrefix == wxT("N") || typePrefix == wxT("B")){
-            // If there are exactly 6 tokens (Prefix|SID|TS|CTS|Content|Specific) and Specific should not be empty.
-            wxLogWarning(wxT("Skipping annotation line (missing specific data like color, title, or label): %s"), line);
-            continue;
+const AnnotationManager::SessionBucket* AnnotationManager::FindBucket(const wxString& sessionId) const {
+    auto it = m_sessions.find(sessionId);
+    return it != m_sessions.end() ? &it->second : nullptr;
+}
+
+void AnnotationManager::InsertSorted(std::vector<Annotation*>& list, Annotation* annotation) {
+    // 插在相同时间戳的最后，保持添加顺序
+    auto pos = std::upper_bound(list.begin(), list.end(), annotation->GetTimestamp(),
+                                [](TimeStamp timestamp, const Annotation* item) {
+                                    return timestamp < item->GetTimestamp();
+                                });
+    list.insert(pos, annotation);
+}
+
+bool AnnotationManager::EraseSorted(std::vector<Annotation*>& list, Annotation* annotation) {
+    auto first = std::lower_bound(list.begin(), list.end(), annotation->GetTimestamp(),
+                                  [](const Annotation* item, TimeStamp timestamp) {
+                                      return item->GetTimestamp() < timestamp;
+                                  });
+    for (auto it = first; it != list.end() && (*it)->GetTimestamp() == annotation->GetTimestamp(); ++it) {
+        if (*it == annotation) {
+            list.erase(it);
+            return true;
         }
-        // If specificData is truly optional for some types, the above check needs adjustment.
+    }
+    return false;
+}
+
+void AnnotationManager::CollectRange(const std::vector<Annotation*>& list, TimeStamp startTime,
+                                     TimeStamp endTime, std::vector<Annotation*>& result) {
+    if (startTime > endTime) {
+        return;
+    }
+    auto first = std::lower_bound(list.begin(), list.end(), startTime,
+                                  [](const Annotation* item, TimeStamp timestamp) {
+                                      return item->GetTimestamp() < timestamp;
+                                  });
+    auto last = std::upper_bound(first, list.end(), endTime,
+                                 [](TimeStamp timestamp, const Annotation* item) {
+                                     return timestamp < item->GetTimestamp();
+                                 });
+    result.insert(result.end(), first, last);
+}
 
-        std::unique_ptr<Annotation> annotation = nullptr;
+bool AnnotationManager::SaveAnnotations(const wxString& sessionPath) {
+    if (!m_journal || m_journal->GetSessionPath() != sessionPath) {
+        // 内存中的批注不是从这个目录加载的：整体写入一份快照，之后的修改追加到这里的日志
+        AppendPendingRecords();
+        m_journal.reset(new AnnotationJournal(sessionPath));
+        auto ignore = [](const char*, size_t) {};
+        m_journal->Load(ignore, ignore);
+        CompactJournal();
+        return true;
+    }
+    
+    AppendPendingRecords();
+    if (m_journal->GetRecordCount() >= std::max(kCompactMinRecords, m_byId.size())) {
+        CompactJournal();
+    }
+    return true;
+}
+
+bool AnnotationManager::FlushAnnotations(const wxString& sessionPath) {
+    if (!m_journal || m_journal->GetSessionPath() != sessionPath) {
+        return true;
+    }
+    AppendPendingRecords();
+    return m_journal->Flush();
+}
 
-        if (typePrefix == wxT("H")) {
-            wxColour color;
-            if (!color.Set(specificData)) { // specificData is colorStr for Highlight
-                 wxLogWarning(wxT("Skipping Highlight annotation line (bad color string '%s'): %s"), specificData, line);
-                continue;
+bool AnnotationManager::LoadAnnotations(const wxString& sessionPath) {
+    // 切换回已加载的目录时沿用内存中的批注和索引，期间的修改都已记入该目录的日志
+    if (m_journal && m_journal->GetSessionPath() == sessionPath) {
+        return true;
+    }
+    
+    AppendPendingRecords();
+    ClearAnnotations();
+    m_journal.reset(new AnnotationJournal(sessionPath, m_archiveReader));
+    
+    // 快照中的批注先整体追加再排序，日志记录要在排好序的索引上重放
+    bool snapshotDone = false;
+    bool found = m_journal->Load(
+        [this](const char* data, size_t size) {
+            // 版本 1 的快照没有记录编号，按出现顺序编号，与当时写快照时的编号一致
+            uint32_t id = 0;
+            if (m_journal->GetSnapshotVersion() >= 2) {
+                ByteReader reader(data, size);
+                if (reader.Read(id)) {
+                    data += sizeof(id);
+                    size -= sizeof(id);
+                }
+            } else {
+                id = static_cast<uint32_t>(m_nextId);
+            }
+            std::unique_ptr<Annotation> annotation = id != 0 ? Annotation::Decode(data, size) : nullptr;
+            if (annotation) {
+                annotation->m_id = id;
+                InsertAnnotation(std::move(annotation), false);
+            } else {
+                // 版本 1 中损坏的记录也占一个编号，之后的日志记录才能对上
+                wxLogWarning(wxT("Skipping damaged annotation record in %s"), m_journal->GetSessionPath());
+                m_nextId = std::max<unsigned long>(m_nextId, id + 1);
             }
-            annotation = std::make_unique<HighlightAnnotation>(sessionId, timestampVal, content, color);
+        },
+        [this, &snapshotDone](const char* data, size_t size) {
+            if (!snapshotDone) {
+                SortIndexes();
+                snapshotDone = true;
+            }
+            ApplyRecord(data, size);
+        });
+    if (!snapshotDone) {
+        SortIndexes();
+    }
+    
+    if (m_journal->IsLegacy()) {
+        MigrateLegacyFiles();
+    }
+    return found; // No annotations file is not an error, just nothing to load.
+}
 
-        } else if (typePrefix == wxT("N")) {
-            // specificData is title for Note
-            annotation = std::make_unique<NoteAnnotation>(sessionId, timestampVal, content, specificData);
+void AnnotationManager::ClearAnnotations() {
+    m_sessions.clear();
+    m_byId.clear();
+    m_nextId = 1;
+    m_pendingRecords.clear();
+    m_journal.reset();
+}
 
-        } else if (typePrefix == wxT("B")) {
-            // specificData is label for Bookmark
-            annotation = std::make_unique<BookmarkAnnotation>(sessionId, timestampVal, content, specificData);
-        } else {
-            wxLogWarning(wxT("Unknown annotation type prefix: '%s' in line: %s"), typePrefix, line);
-        }
+std::string AnnotationManager::MakeRecord(char operation, const Annotation* annotation) {
+    std::string record;
+    AppendValue<char>(record, operation);
+    AppendValue<uint32_t>(record, static_cast<uint32_t>(annotation->m_id));
+    if (operation != '-') {
+        annotation->Encode(record);
+    }
+    return record;
+}
 
+bool AnnotationManager::DecodeRecord(const char* data, size_t size, char& operation, unsigned long& id,
+                                     std::unique_ptr<Annotation>& annotation) {
+    ByteReader reader(data, size);
+    uint32_t recordId;
+    if (!reader.Read(operation) || !reader.Read(recordId) || recordId == 0) {
+        wxLogWarning(wxT("Skipping malformed annotation journal record"));
+        return false;
+    }
+    id = recordId;
+    annotation.reset();
+    if (operation == '-') {
+        return true;
+    }
+    if (operation != '+' && operation != '~') {
+        wxLogWarning(wxT("Unknown annotation journal operation: %d"), static_cast<int>(operation));
+        return false;
+    }
+    
+    const size_t headerSize = sizeof(operation) + sizeof(recordId);
+    annotation = Annotation::Decode(data + headerSize, size - headerSize);
+    if (!annotation) {
+        wxLogWarning(wxT("Skipping damaged annotation journal record %u"), recordId);
+        return false;
+    }
+    annotation->m_id = id;
+    return true;
+}
+
+bool AnnotationManager::ApplyRecord(const char* data, size_t size) {
+    char operation;
+    unsigned long id;
+    std::unique_ptr<Annotation> annotation;
+    if (!DecodeRecord(data, size, operation, id, annotation)) {
+        return false;
+    }
+    
+    // 编号已存在时先移除，重放已经包含的添加不会重复
+    auto it = m_byId.find(id);
+    if (it != m_byId.end()) {
+        EraseAnnotation(it->second);
+    }
+    if (annotation) {
+        InsertAnnotation(std::move(annotation));
+    }
+    return true;
+}
+
+bool AnnotationManager::ApplyChange(const std::string& record) {
+    if (!ApplyRecord(record.data(), record.size())) {
+        return false;
+    }
+    RecordChange(record);
+    return true;
+}
+
+void AnnotationManager::MigrateLegacyFiles() {
+    std::vector<wxString> snapshotLines;
+    std::vector<wxString> records;
+    m_journal->ReadLegacyFiles(snapshotLines, records);
+    
+    for (const auto& line : snapshotLines) {
+        std::unique_ptr<Annotation> annotation = Annotation::Deserialize(line);
         if (annotation) {
-            annotation->SetParsedCreationTime(creationTime); // Use the new public setter
-            AddAnnotation(std::move(annotation));
+            InsertAnnotation(std::move(annotation), false);
         }
     }
+    SortIndexes();
+    for (const auto& record : records) {
+        ApplyLegacyRecord(record);
+    }
     
-    file.Close();
+    // 写成新格式的快照，旧的文本日志随之作废
+    CompactJournal();
+    wxLogInfo(wxT("已将批注文件迁移为新格式: %s"), m_journal->GetSessionPath());
+}
+
+bool AnnotationManager::ApplyLegacyRecord(const wxString& record) {
+    // 操作|编号|竖线分隔的批注，删除记录没有第三段
+    wxString rest;
+    wxString operation = record.BeforeFirst(wxT('|'), &rest);
+    wxString payload;
+    unsigned long id = 0;
+    if (!rest.BeforeFirst(wxT('|'), &payload).ToULong(&id) || id == 0) {
+        wxLogWarning(wxT("Skipping malformed annotation journal record: %s"), record);
+        return false;
+    }
+    
+    if (operation == wxT("-") || operation == wxT("~")) {
+        auto it = m_byId.find(id);
+        if (it != m_byId.end()) {
+            EraseAnnotation(it->second);
+        }
+        if (operation == wxT("-")) {
+            return true;
+        }
+    } else if (operation != wxT("+")) {
+        wxLogWarning(wxT("Unknown annotation journal operation: %s"), record);
+        return false;
+    }
+    
+    std::unique_ptr<Annotation> annotation = Annotation::Deserialize(payload);
+    if (!annotation) {
+        return false;
+    }
+    annotation->m_id = id;
+    InsertAnnotation(std::move(annotation));
     return true;
 }
 
-void AnnotationManager::ClearAnnotations() {
-    m_annotations.clear();
+void AnnotationManager::AppendPendingRecords() {
+    if (m_journal && !m_pendingRecords.empty()) {
+        if (m_journal->IsArchived()) {
+            // 批注是从会话归档中加载的，目录中还没有快照：日志记录没有可接续的快照，整体写一份
+            m_pendingRecords.clear();
+            CompactJournal();
+            return;
+        }
+        m_journal->Append(std::move(m_pendingRecords));
+    }
+    m_pendingRecords.clear();
+}
+
+void AnnotationManager::CompactJournal() {
+    // 快照记录带有编号，压缩前后编号不变，会话数据库和恢复日志中按编号的记录仍然有效
+    std::vector<std::string> snapshotRecords;
+    snapshotRecords.reserve(m_byId.size());
+    for (const auto& session : m_sessions) {
+        for (const auto& annotation : session.second.annotations) {
+            std::string record;
+            AppendValue<uint32_t>(record, static_cast<uint32_t>(annotation->m_id));
+            annotation->Encode(record);
+            snapshotRecords.push_back(std::move(record));
+        }
+    }
+    m_journal->Compact(std::move(snapshotRecords));
 }
 
 } // namespace MeetAnt 
\ No newline at end of file
@@ -4,9 +4,12 @@
 #include <wx/wx.h>
 #include <wx/datetime.h>
 #include <wx/colour.h>
+#include <functional>
 #include <string>
 #include <vector>
+#include <map>
 #include <memory>
+#include <unordered_map>
 
 namespace MeetAnt {
 
@@ -20,6 +23,11 @@ enum class AnnotationType {
     Bookmark    // 书签
 };
 
+// 批注类型的数量，用于按类型分组
+const size_t kAnnotationTypeCount = 3;
+
+class AnnotationJournal;
+
 // 基本批注类
 class Annotation {
 public:
@@ -31,6 +39,9 @@ public:
     TimeStamp GetTimestamp() const { return m_timestamp; }
     wxString GetContent() const { return m_content; }
     wxDateTime GetCreationTime() const { return m_creationTime; }
+    // 在 AnnotationManager 中的编号，日志记录按编号引用批注；未加入管理器时为 0
+    // 编号在同一会话目录中保持不变，压缩日志时不重新编号
+    unsigned long GetId() const { return m_id; }
     
     // 设置内容
     void SetContent(const wxString& content) { m_content = content; }
@@ -42,7 +53,11 @@ public:
     // 转换为显示字符串
     virtual wxString ToString() const;
     
-    // 序列化和反序列化 (用于保存/加载)
+    // 二进制编码（用于保存/加载），数据不完整或类型未知时 Decode 返回 nullptr
+    virtual void Encode(std::string& out) const;
+    static std::unique_ptr<Annotation> Decode(const char* data, size_t size);
+    
+    // 旧版本的竖线分隔文本格式，只用于迁移旧的批注文件
     virtual wxString Serialize() const;
     static std::unique_ptr<Annotation> Deserialize(const wxString& data);
 
@@ -51,6 +66,10 @@ protected:
     TimeStamp m_timestamp;   // 关联的音频时间戳
     wxString m_content;      // 批注内容
     wxDateTime m_creationTime; // 创建时间
+
+private:
+    friend class AnnotationManager;
+    unsigned long m_id;
 };
 
 // 高亮批注
@@ -64,6 +83,7 @@ public:
     void SetColor(const wxColour& color) { m_color = color; }
     
     virtual wxString ToString() const override;
+    virtual void Encode(std::string& out) const override;
     virtual wxString Serialize() const override;
     
 private:
@@ -81,6 +101,7 @@ public:
     void SetTitle(const wxString& title) { m_title = title; }
     
     virtual wxString ToString() const override;
+    virtual void Encode(std::string& out) const override;
     virtual wxString Serialize() const override;
     
 private:
@@ -98,6 +119,7 @@ public:
     void SetLabel(const wxString& label) { m_label = label; }
     
     virtual wxString ToString() const override;
+    virtual void Encode(std::string& out) const override;
     virtual wxString Serialize() const override;
     
 private:
@@ -105,6 +127,11 @@ private:
 };
 
 // 批注管理器
+// 批注按会话分桶保存，每个桶内维护按时间戳排序的索引和按类型分组的列表（同样按时间排序），
+// 按会话、类型和时间范围查询时只访问该会话的桶，时间范围查询为 O(log N + k)。
+// 批注的会话和时间戳创建后不再改变，索引在添加和删除时增量维护。
+// 添加、修改和删除都记为一条日志记录，保存时只把这些记录追加到会话目录的日志
+// （见 AnnotationJournal），日志过长时在后台压缩为新的快照。
 class AnnotationManager {
 public:
     AnnotationManager();
@@ -113,32 +140,109 @@ public:
     // 添加批注
     void AddAnnotation(std::unique_ptr<Annotation> annotation);
     
-    // 获取特定会话的所有批注
+    // 获取特定会话的所有批注（按添加顺序）
     std::vector<Annotation*> GetSessionAnnotations(const wxString& sessionId);
     
-    // 获取特定类型的批注
+    // 获取特定类型的批注（按时间戳排序）
     std::vector<Annotation*> GetAnnotationsByType(const wxString& sessionId, AnnotationType type);
     
-    // 获取所有书签
+    // 获取所有书签（各会话内按时间戳排序）
     std::vector<BookmarkAnnotation*> GetAllBookmarks();
     
-    // 获取特定时间范围内的批注
+    // 获取特定时间范围 [startTime, endTime] 内的批注（按时间戳排序）
     std::vector<Annotation*> GetAnnotationsByTimeRange(const wxString& sessionId, 
                                                      TimeStamp startTime, 
                                                      TimeStamp endTime);
     
+    // 获取特定时间范围内某一类型的批注（按时间戳排序）
+    std::vector<Annotation*> GetAnnotationsByTimeRange(const wxString& sessionId,
+                                                     AnnotationType type,
+                                                     TimeStamp startTime,
+                                                     TimeStamp endTime);
+    
+    // 特定会话的批注数
+    size_t GetAnnotationCount(const wxString& sessionId) const;
+    
     // 删除批注
     bool RemoveAnnotation(Annotation* annotation);
     
+    // 批注的内容、标题等被修改后调用，记录一次修改
+    void UpdateAnnotation(Annotation* annotation);
+    
     // 保存和加载批注 (到特定会话目录)
+    // 保存时只追加上次保存以来的修改；内存中的批注不是从该目录加载的时候整体写入一次
     bool SaveAnnotations(const wxString& sessionPath);
+    // 已经从该目录加载过时直接返回，内存中的批注就是文件的当前状态
     bool LoadAnnotations(const wxString& sessionPath);
+    // 写入未保存的修改，等写入该目录的批注落盘后返回；写入全部成功时返回 true
+    // 内存中的批注不属于该目录时没有要写入的内容，返回 true
+    bool FlushAnnotations(const wxString& sessionPath);
     
-    // 清除所有批注
+    // 清除所有批注（未保存的修改一并丢弃）
     void ClearAnnotations();
     
+    // 读取会话归档中的文件，见 AnnotationJournal::ArchiveReader
+    typedef std::function<bool(const wxString& sessionPath, const wxString& fileName,
+                               std::string& data)> ArchiveReader;
+    // 设置后，会话目录中没有批注文件时从归档中加载；加载后的第一次保存在目录中写一份完整的快照
+    void SetArchiveReader(const ArchiveReader& reader) { m_archiveReader = reader; }
+    
+    // 添加、修改和删除批注时，以该次修改的日志记录回调（加载和重放日志时不回调）
+    typedef std::function<void(const std::string& record)> ChangeListener;
+    void SetChangeListener(const ChangeListener& listener) { m_changeListener = listener; }
+    
+    // 解析一条日志记录：operation 为 '+'、'~' 或 '-'，删除记录的 annotation 为空
+    // 记录不完整或操作未知时返回 false
+    static bool DecodeRecord(const char* data, size_t size, char& operation, unsigned long& id,
+                             std::unique_ptr<Annotation>& annotation);
+    // 重做一次记下的修改（如恢复日志中的记录），当作新的修改保存；已经包含这次修改时结果不变
+    bool ApplyChange(const std::string& record);
+    
 private:
-    std::vector<std::unique_ptr<Annotation>> m_annotations;
+    // 一个会话的批注
+    struct SessionBucket {
+        std::vector<std::unique_ptr<Annotation>> annotations;   // 按添加顺序，拥有批注
+        std::vector<Annotation*> byTime;                        // 按时间戳排序，时间相同时按添加顺序
+        std::vector<Annotation*> byType[kAnnotationTypeCount];  // 每种类型按时间戳排序
+    };
+    
+    // 加入和移除批注并维护索引，不产生日志记录
+    // 批量加载时 keepSorted 为假，先按添加顺序追加，最后由 SortIndexes 统一排序
+    Annotation* InsertAnnotation(std::unique_ptr<Annotation> annotation, bool keepSorted = true);
+    bool EraseAnnotation(Annotation* annotation);
+    void SortIndexes();
+    
+    // 日志记录：操作（'+' 添加、'~' 修改、'-' 删除）、4 字节编号，添加和修改之后是批注的编码
+    static std::string MakeRecord(char operation, const Annotation* annotation);
+    // 记下一次修改：通知监听者，并留待下次保存时追加到日志
+    void RecordChange(std::string record);
+    // 重放一条日志记录
+    bool ApplyRecord(const char* data, size_t size);
+    // 读取旧版本的文本格式文件，随即写成新格式
+    void MigrateLegacyFiles();
+    bool ApplyLegacyRecord(const wxString& record);
+    // 把未保存的记录追加到当前日志
+    void AppendPendingRecords();
+    // 按当前内容提交一份新快照
+    void CompactJournal();
+    
+    SessionBucket* FindBucket(const wxString& sessionId);
+    const SessionBucket* FindBucket(const wxString& sessionId) const;
+    
+    static void InsertSorted(std::vector<Annotation*>& list, Annotation* annotation);
+    static bool EraseSorted(std::vector<Annotation*>& list, Annotation* annotation);
+    static void CollectRange(const std::vector<Annotation*>& list, TimeStamp startTime,
+                             TimeStamp endTime, std::vector<Annotation*>& result);
+    
+    std::map<wxString, SessionBucket> m_sessions;
+    std::unordered_map<unsigned long, Annotation*> m_byId;
+    unsigned long m_nextId;
+    
+    // 内存中的批注所对应的会话目录的日志，以及尚未写入日志的记录
+    std::unique_ptr<AnnotationJournal> m_journal;
+    std::vector<std::string> m_pendingRecords;
+    ArchiveReader m_archiveReader;
+    ChangeListener m_changeListener;
 };
 
 } // namespace MeetAnt
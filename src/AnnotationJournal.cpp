@@ -0,0 +1,302 @@
+#include "AnnotationJournal.h"
+#include "RecordCodec.h"
+#include <wx/filename.h>
+#include <memory>
+
+namespace MeetAnt {
+
+namespace {
+    // 文件格式：RecordCodec 的记录文件，文件头中的值为快照的代数
+    const char kSnapshotMagic[4] = { 'M', 'A', 'A', 'S' };
+    const char kJournalMagic[4] = { 'M', 'A', 'A', 'J' };
+    // 版本 2 的快照记录带有批注的编号；版本 1 的日志记录与版本 2 相同，可以接着追加
+    const uint32_t kVersion = 2;
+    const uint32_t kOldestVersion = 1;
+
+    bool IsSupportedVersion(uint32_t version) {
+        return version >= kOldestVersion && version <= kVersion;
+    }
+
+    // 以下用于读取旧版本的文本格式
+    bool ParseLegacyGeneration(const wxString& line) {
+        wxString rest;
+        unsigned long generation;
+        return line.StartsWith(wxT("#generation="), &rest) && rest.ToULong(&generation);
+    }
+
+    wxString UnescapeLegacyLine(const wxString& line) {
+        wxString text;
+        text.reserve(line.length());
+        for (wxString::const_iterator it = line.begin(); it != line.end(); ++it) {
+            wxUniChar ch = *it;
+            if (ch == wxT('\\') && it + 1 != line.end()) {
+                ++it;
+                ch = *it;
+                if (ch == wxT('n')) {
+                    ch = wxT('\n');
+                } else if (ch == wxT('r')) {
+                    ch = wxT('\r');
+                }
+            }
+            text << ch;
+        }
+        return text;
+    }
+
+    // 按换行切分为 UTF-8 行；partialLine 为假时丢弃没有换行结尾的最后一行
+    void SplitLegacyLines(const std::string& data, bool partialLine, std::vector<wxString>& lines) {
+        size_t start = 0;
+        for (size_t end = data.find('\n'); end != std::string::npos; end = data.find('\n', start)) {
+            size_t lineEnd = end > start && data[end - 1] == '\r' ? end - 1 : end;
+            lines.push_back(wxString::FromUTF8(data.data() + start, lineEnd - start));
+            start = end + 1;
+        }
+        if (partialLine && start < data.size()) {
+            lines.push_back(wxString::FromUTF8(data.data() + start, data.size() - start));
+        }
+    }
+}
+
+AnnotationJournal::AnnotationJournal(const wxString& sessionPath, const ArchiveReader& archiveReader)
+    : m_sessionPath(sessionPath),
+      m_archiveReader(archiveReader),
+      m_recordCount(0),
+      m_legacy(false),
+      m_archived(false),
+      m_snapshotVersion(kVersion),
+      m_generation(0),
+      m_writable(true),
+      m_journalCurrent(false),
+      m_journalLength(0),
+      m_needsSync(false),
+      m_failed(false),
+      m_writer(kGroupCommitMs, GroupCommitWriter::Task(), [this]() { Sync(); })
+{
+}
+
+AnnotationJournal::~AnnotationJournal() {
+    m_writer.Stop();
+    m_journal.Close();
+}
+
+wxString AnnotationJournal::GetSnapshotPath(const wxString& sessionPath) {
+    return wxFileName(sessionPath, wxT("annotations.dat")).GetFullPath();
+}
+
+wxString AnnotationJournal::GetJournalPath(const wxString& sessionPath) {
+    return wxFileName(sessionPath, wxT("annotations.journal")).GetFullPath();
+}
+
+bool AnnotationJournal::ReadFile(const wxString& path, std::string& data) const {
+    if (m_archived) {
+        return m_archiveReader(m_sessionPath, wxFileName(path).GetFullName(), data);
+    }
+    return wxFileExists(path) && ReadFileBytes(path, data);
+}
+
+bool AnnotationJournal::Load(const RecordHandler& onSnapshotRecord, const RecordHandler& onJournalRecord) {
+    // 目录中两个文件都没有时才读取归档：目录中的快照总是先于日志写入
+    m_archived = m_archiveReader && !wxFileExists(GetSnapshotPath(m_sessionPath)) &&
+                 !wxFileExists(GetJournalPath(m_sessionPath));
+    m_generation = 0;
+    m_snapshotVersion = kVersion;
+    m_legacy = false;
+    m_writable = true;
+    m_journalCurrent = false;
+    m_journalLength = 0;
+    m_recordCount = 0;
+    bool found = false;
+
+    std::string data;
+    RecordFileHeader header;
+    wxString snapshotPath = GetSnapshotPath(m_sessionPath);
+    if (ReadFile(snapshotPath, data) && !data.empty()) {
+        found = true;
+        if (!ReadRecordFileHeader(data, kSnapshotMagic, header)) {
+            m_legacy = true;
+            return found;
+        }
+        if (!IsSupportedVersion(header.version)) {
+            wxLogWarning(wxT("不支持的批注文件版本 %u: %s"), header.version, snapshotPath);
+            m_writable = false;
+            return found;
+        }
+        m_snapshotVersion = header.version;
+        m_generation = header.value;
+        ForEachRecord(data, onSnapshotRecord);
+    }
+
+    wxString journalPath = GetJournalPath(m_sessionPath);
+    if (!ReadFile(journalPath, data) || data.empty()) {
+        return found;
+    }
+    if (!ReadRecordFileHeader(data, kJournalMagic, header)) {
+        // 还没有快照时旧版本只写了文本日志；已有新格式快照时这份日志不可能有效
+        m_legacy = !found;
+        return true;
+    }
+    found = true;
+
+    if (!IsSupportedVersion(header.version)) {
+        wxLogWarning(wxT("不支持的批注日志版本 %u: %s"), header.version, journalPath);
+        m_writable = false;
+        return found;
+    }
+    // 代数不同说明快照已经包含了这份日志，下次追加时重建日志
+    if (header.value != m_generation) {
+        return found;
+    }
+    size_t count = 0;
+    m_journalLength = static_cast<wxFileOffset>(ForEachRecord(data, [&](const char* record, size_t size) {
+        onJournalRecord(record, size);
+        count++;
+    }));
+    m_journalCurrent = true;
+    m_recordCount = count;
+    return found;
+}
+
+void AnnotationJournal::ReadLegacyFiles(std::vector<wxString>& snapshotLines, std::vector<wxString>& records) const {
+    // 带代数行的文件中换行被转义过，更早的文件按原样读取
+    std::string data;
+    std::vector<wxString> lines;
+    if (ReadFile(GetSnapshotPath(m_sessionPath), data)) {
+        SplitLegacyLines(data, true, lines);
+        bool escaped = !lines.empty() && ParseLegacyGeneration(lines[0]);
+        for (size_t i = escaped ? 1 : 0; i < lines.size(); ++i) {
+            if (!lines[i].IsEmpty() && !lines[i].StartsWith(wxT("#"))) {
+                snapshotLines.push_back(escaped ? UnescapeLegacyLine(lines[i]) : lines[i]);
+            }
+        }
+    }
+
+    lines.clear();
+    if (ReadFile(GetJournalPath(m_sessionPath), data)) {
+        SplitLegacyLines(data, false, lines);
+        if (lines.empty() || !ParseLegacyGeneration(lines[0])) {
+            return;
+        }
+        for (size_t i = 1; i < lines.size(); ++i) {
+            if (!lines[i].IsEmpty()) {
+                records.push_back(UnescapeLegacyLine(lines[i]));
+            }
+        }
+    }
+}
+
+void AnnotationJournal::Append(std::vector<std::string> records) {
+    if (records.empty()) {
+        return;
+    }
+    m_recordCount += records.size();
+    auto batch = std::make_shared<std::vector<std::string>>(std::move(records));
+    m_writer.Post([this, batch]() {
+        WriteRecords(*batch);
+    });
+}
+
+void AnnotationJournal::Compact(std::vector<std::string> snapshotRecords) {
+    // 新快照写在会话目录中，之后不再读取归档
+    m_archived = false;
+    m_snapshotVersion = kVersion;
+    m_recordCount = 0;
+    auto records = std::make_shared<std::vector<std::string>>(std::move(snapshotRecords));
+    m_writer.Post([this, records]() {
+        WriteSnapshot(*records);
+    });
+}
+
+bool AnnotationJournal::Flush() {
+    // 写入线程在 Flush 返回前已经结束，这里读取它的状态是安全的
+    m_writer.Flush();
+    return !m_failed;
+}
+
+bool AnnotationJournal::OpenJournal() {
+    if (m_journal.IsOpened()) {
+        return true;
+    }
+
+    wxString journalPath = GetJournalPath(m_sessionPath);
+    if (m_journalCurrent) {
+        // 上次退出时最后一条记录只写了一半：去掉它再继续追加
+        if (!TrimRecordFile(journalPath, m_journalLength)) {
+            m_journalCurrent = false;
+        }
+        if (m_journalCurrent && m_journal.Open(journalPath, wxFile::write_append)) {
+            return true;
+        }
+    }
+
+    // 日志不存在、已损坏或属于旧快照：重新开始
+    if (!m_journal.Create(journalPath, true) ||
+        !WriteFileBytes(m_journal, MakeRecordFileHeader(kJournalMagic, kVersion, m_generation))) {
+        wxLogWarning(wxT("无法创建批注日志: %s"), journalPath);
+        m_journal.Close();
+        m_failed = true;
+        return false;
+    }
+    m_journalCurrent = true;
+    m_needsSync = true;
+    return true;
+}
+
+void AnnotationJournal::WriteRecords(const std::vector<std::string>& records) {
+    if (!m_writable || !OpenJournal()) {
+        m_failed = true;
+        return;
+    }
+
+    std::string data;
+    for (const auto& record : records) {
+        AppendRecord(data, record);
+    }
+    if (!WriteFileBytes(m_journal, data)) {
+        wxLogWarning(wxT("写入批注日志失败: %s"), GetJournalPath(m_sessionPath));
+        m_failed = true;
+    }
+    m_needsSync = true;
+}
+
+void AnnotationJournal::WriteSnapshot(const std::vector<std::string>& snapshotRecords) {
+    if (!m_writable) {
+        m_failed = true;
+        return;
+    }
+
+    uint64_t generation = m_generation + 1;
+    wxString snapshotPath = GetSnapshotPath(m_sessionPath);
+    wxString tempPath = snapshotPath + wxT(".tmp");
+
+    std::string data = MakeRecordFileHeader(kSnapshotMagic, kVersion, generation);
+    for (const auto& record : snapshotRecords) {
+        AppendRecord(data, record);
+    }
+
+    // 先写临时文件并落盘再替换，任何时刻磁盘上都有一份完整的快照
+    wxFile file;
+    bool written = file.Create(tempPath, true) && WriteFileBytes(file, data) && file.Flush();
+    file.Close();
+    if (!written || !wxRenameFile(tempPath, snapshotPath, true)) {
+        wxLogWarning(wxT("写入批注快照失败: %s"), snapshotPath);
+        wxRemoveFile(tempPath);
+        m_failed = true;
+        return;
+    }
+
+    // 日志中的记录都已并入新快照，换一份空日志
+    m_generation = generation;
+    m_journal.Close();
+    m_journalCurrent = false;
+    OpenJournal();
+}
+
+void AnnotationJournal::Sync() {
+    if (m_needsSync && m_journal.IsOpened() && !m_journal.Flush()) {
+        wxLogWarning(wxT("批注日志落盘失败: %s"), GetJournalPath(m_sessionPath));
+        m_failed = true;
+    }
+    m_needsSync = false;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,102 @@
+#ifndef MEETANT_ANNOTATION_JOURNAL_H
+#define MEETANT_ANNOTATION_JOURNAL_H
+
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "GroupCommitWriter.h"
+
+namespace MeetAnt {
+
+// 会话批注的追加式日志
+// annotations.dat 是某一时刻的完整快照，annotations.journal 按顺序记录快照之后的每次
+// 添加、修改和删除。两个文件都是带版本号的二进制格式：16 字节文件头之后是一串
+// 以 4 字节长度开头的记录，记录内容由 AnnotationManager 编码，这里不解析。
+// 保存时只追加变化的记录；日志过长时由 AnnotationManager 提交一份新快照，
+// 写入新快照后清空日志。快照和日志的文件头都记有代数，写完快照、还没来得及清空
+// 日志就退出时，两者代数不同，旧日志在加载时被忽略。
+// 会话已归档时目录中没有这两个文件，加载时从归档中读取（见 ArchiveReader）；这时目录中没有快照，
+// 第一次写入必须是一份完整的快照（Compact），之后目录中的文件优先于归档。
+// 所有文件写入都在一个后台线程（GroupCommitWriter）中按提交顺序执行，同一批写入之后只做一次 fsync。
+class AnnotationJournal {
+public:
+    // 记录回调，data 指向读入的文件缓冲区，只在回调期间有效
+    typedef std::function<void(const char* data, size_t size)> RecordHandler;
+    // 读取会话归档中的文件（fileName 不含目录），没有归档或归档中没有这个文件时返回 false
+    typedef std::function<bool(const wxString& sessionPath, const wxString& fileName,
+                               std::string& data)> ArchiveReader;
+
+    // archiveReader 为空时只读取会话目录
+    explicit AnnotationJournal(const wxString& sessionPath, const ArchiveReader& archiveReader = ArchiveReader());
+    // 写完已提交的记录并 fsync 后停止写入线程
+    ~AnnotationJournal();
+
+    const wxString& GetSessionPath() const { return m_sessionPath; }
+
+    // 依次回调快照和快照之后的日志中的每条记录，必须在提交任何写入之前调用
+    // 快照和日志都不存在时返回 false。文件是旧版本的文本格式时不回调，
+    // 由 IsLegacy() 标明，调用者用 ReadLegacyFiles 读取后提交一份新快照完成迁移
+    bool Load(const RecordHandler& onSnapshotRecord, const RecordHandler& onJournalRecord);
+    bool IsLegacy() const { return m_legacy; }
+    // 加载的是会话归档中的文件，还没有提交新快照
+    bool IsArchived() const { return m_archived; }
+    // 加载的快照的格式版本：版本 1 的快照记录只有批注的编码，版本 2 在编码前带有 4 字节编号
+    // 没有快照或提交了新快照时为当前版本
+    uint32_t GetSnapshotVersion() const { return m_snapshotVersion; }
+
+    // 追加记录，立即返回
+    void Append(std::vector<std::string> records);
+
+    // 用 snapshotRecords 替换快照并清空日志
+    void Compact(std::vector<std::string> snapshotRecords);
+
+    // 等已提交的写入完成并落盘后返回；打开以来的写入全部成功时返回 true
+    bool Flush();
+
+    // 当前日志中的记录数（包括已提交、尚未写入的）
+    size_t GetRecordCount() const { return m_recordCount; }
+
+    static wxString GetSnapshotPath(const wxString& sessionPath);
+    static wxString GetJournalPath(const wxString& sessionPath);
+
+    // 读取旧版本的文本格式（与 Load 读取同一处的文件）：每行一条，竖线分隔，可能带有代数行和转义的换行
+    void ReadLegacyFiles(std::vector<wxString>& snapshotLines, std::vector<wxString>& records) const;
+
+    // 同一批写入最多等待这么久（毫秒）再 fsync
+    static const long kGroupCommitMs = 200;
+
+private:
+    // 读取快照或日志：m_archived 时读取归档中的同名文件；文件不存在或无法读取时返回 false
+    bool ReadFile(const wxString& path, std::string& data) const;
+
+    // 以下方法只在写入线程中调用
+    bool OpenJournal();
+    void WriteRecords(const std::vector<std::string>& records);
+    void WriteSnapshot(const std::vector<std::string>& snapshotRecords);
+    void Sync();
+
+    wxString m_sessionPath;
+    ArchiveReader m_archiveReader;
+    size_t m_recordCount;
+    bool m_legacy;
+    bool m_archived;
+    uint32_t m_snapshotVersion;
+
+    // 写入线程独占的状态（Load 在任何写入之前完成）
+    wxFile m_journal;
+    uint64_t m_generation;          // 快照的代数
+    bool m_writable;                // 文件是更新版本的格式时不写入，避免覆盖
+    bool m_journalCurrent;          // 日志文件存在且代数与快照一致
+    wxFileOffset m_journalLength;   // 日志中完整记录的字节数，之后是写了一半的记录
+    bool m_needsSync;
+    bool m_failed;                  // 有写入失败或因版本不符没有写入
+
+    // 最后构造：写入线程启动时其他成员都已初始化
+    GroupCommitWriter m_writer;
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_ANNOTATION_JOURNAL_H
@@ -0,0 +1,93 @@
+#include "AutosaveScheduler.h"
+
+namespace MeetAnt {
+
+namespace {
+    const int kDefaultIntervalMinutes = 5;
+
+    // 只在 Flush 时保存的部分
+    const unsigned kFlushOnlyParts = AutosaveIndexes;
+}
+
+AutosaveScheduler::AutosaveScheduler(const SaveFunction& save)
+    : m_save(save),
+      m_idleTimer(this),
+      m_intervalTimer(this),
+      m_enabled(true),
+      m_intervalMs(kDefaultIntervalMinutes * 60 * 1000),
+      m_dirtyParts(0),
+      m_saving(false)
+{
+    // 两个计时器到时都保存除 kFlushOnlyParts 外全部脏的部分
+    Bind(wxEVT_TIMER, &AutosaveScheduler::OnTimer, this);
+}
+
+AutosaveScheduler::~AutosaveScheduler() {
+    StopTimers();
+}
+
+void AutosaveScheduler::Configure(bool enabled, int intervalMinutes) {
+    m_enabled = enabled;
+    m_intervalMs = (intervalMinutes > 0 ? intervalMinutes : kDefaultIntervalMinutes) * 60 * 1000;
+
+    StopTimers();
+    if (m_enabled && (m_dirtyParts & ~kFlushOnlyParts) != 0) {
+        m_idleTimer.StartOnce(kIdleDelayMs);
+        m_intervalTimer.StartOnce(m_intervalMs);
+    }
+}
+
+void AutosaveScheduler::MarkDirty(unsigned parts) {
+    if (parts == 0) {
+        return;
+    }
+    m_dirtyParts |= parts;
+    if (!m_enabled || (parts & ~kFlushOnlyParts) == 0) {
+        return;
+    }
+
+    // 每次变化都推迟空闲保存；间隔计时从第一次未保存的变化开始
+    m_idleTimer.StartOnce(kIdleDelayMs);
+    if (!m_intervalTimer.IsRunning()) {
+        m_intervalTimer.StartOnce(m_intervalMs);
+    }
+}
+
+void AutosaveScheduler::Flush() {
+    Save(m_dirtyParts);
+}
+
+void AutosaveScheduler::Save(unsigned parts) {
+    StopTimers();
+    parts &= m_dirtyParts;
+    if (parts == 0 || m_saving) {
+        return;
+    }
+
+    // 先清除标记，保存期间的新变化重新标记
+    m_dirtyParts &= ~parts;
+    m_saving = true;
+    m_save(parts);
+    m_saving = false;
+
+    if (m_enabled && (m_dirtyParts & ~kFlushOnlyParts) != 0) {
+        m_idleTimer.StartOnce(kIdleDelayMs);
+        m_intervalTimer.StartOnce(m_intervalMs);
+    }
+}
+
+void AutosaveScheduler::Discard() {
+    StopTimers();
+    m_dirtyParts = 0;
+}
+
+void AutosaveScheduler::OnTimer(wxTimerEvent& event) {
+    Save(m_dirtyParts & ~kFlushOnlyParts);
+}
+
+void AutosaveScheduler::StopTimers() {
+    m_idleTimer.Stop();
+    m_intervalTimer.Stop();
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,69 @@
+#ifndef MEETANT_AUTOSAVE_SCHEDULER_H
+#define MEETANT_AUTOSAVE_SCHEDULER_H
+
+#include <wx/wx.h>
+#include <wx/timer.h>
+#include <functional>
+
+namespace MeetAnt {
+
+// 会话中分别保存的部分
+enum AutosavePart {
+    AutosaveTranscript  = 1 << 0,   // 定稿的转录消息
+    AutosaveAnnotations = 1 << 1,   // 批注
+    AutosaveMetadata    = 1 << 2,   // 会话信息（session.info）
+    AutosaveIndexes     = 1 << 3,   // 由内容派生的搜索索引和会话目录元数据，需要读取整个转录，只在 Flush 时保存
+    AutosaveAll         = AutosaveTranscript | AutosaveAnnotations | AutosaveMetadata | AutosaveIndexes
+};
+
+// 自动保存调度（在界面线程中使用）
+// 各部分变化时用 MarkDirty 标记，调度器把一段时间内的变化合并为一次保存：
+// 变化停止 kIdleDelayMs 后保存；持续变化时最迟在系统设置的自动保存间隔到达时保存。
+// 保存时只把脏的部分传给保存函数。未启用自动保存时只记录脏标记，
+// 由 Flush 保存（手动保存、停止录制、切换会话和关闭窗口时）。
+// AutosaveIndexes 不由计时器保存，保留到下一次 Flush，录音中每次自动保存的开销只与新内容有关。
+class AutosaveScheduler : public wxEvtHandler {
+public:
+    // 保存函数的参数为需要保存的 AutosavePart 组合
+    typedef std::function<void(unsigned parts)> SaveFunction;
+
+    explicit AutosaveScheduler(const SaveFunction& save);
+    ~AutosaveScheduler();
+
+    // 应用系统设置中的自动保存开关和间隔（分钟）
+    void Configure(bool enabled, int intervalMinutes);
+    bool IsEnabled() const { return m_enabled; }
+
+    void MarkDirty(unsigned parts);
+    bool IsDirty() const { return m_dirtyParts != 0; }
+    unsigned GetDirtyParts() const { return m_dirtyParts; }
+
+    // 立即保存脏的部分
+    void Flush();
+    // 丢弃脏标记，不保存
+    void Discard();
+
+    // 最后一次变化后等待这么久（毫秒）再保存
+    static const int kIdleDelayMs = 3000;
+
+private:
+    // 保存 parts 中脏的部分
+    void Save(unsigned parts);
+    void OnTimer(wxTimerEvent& event);
+    void StopTimers();
+
+    SaveFunction m_save;
+    wxTimer m_idleTimer;
+    wxTimer m_intervalTimer;
+    bool m_enabled;
+    int m_intervalMs;
+    unsigned m_dirtyParts;
+    bool m_saving;              // 保存函数执行期间的新标记留到下一次保存
+
+    AutosaveScheduler(const AutosaveScheduler&) = delete;
+    AutosaveScheduler& operator=(const AutosaveScheduler&) = delete;
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_AUTOSAVE_SCHEDULER_H
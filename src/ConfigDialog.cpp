@@ -17,6 +17,7 @@
 #include <wx/filefn.h>
 #include <wx/textfile.h>
 #include <nlohmann/json.hpp> // Use nlohmann/json
+#include "SessionArchive.h"
 #include <portaudio.h>
 
 // 如果未定义portaudio错误代码，则在此处定义
@@ -1571,6 +1572,40 @@ SystemConfigPanel::SystemConfigPanel(wxWindow* parent)
     intervalSizer->Add(m_autoSaveIntervalSpinCtrl, 0, wxALL, 5);
     saveSizer->Add(intervalSizer, 0, wxALL, 5);
     
+    // 归档设置
+    wxStaticBoxSizer* archiveSizer = new wxStaticBoxSizer(wxVERTICAL, this, wxT("归档设置"));
+    
+    m_archiveCheckBox = new wxCheckBox(archiveSizer->GetStaticBox(), wxID_ANY, 
+                                    wxT("自动归档旧会话（录音转为 FLAC，其余内容压缩）"));
+    archiveSizer->Add(m_archiveCheckBox, 0, wxALL, 5);
+    
+    wxBoxSizer* afterDaysSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* afterDaysLabel = new wxStaticText(archiveSizer->GetStaticBox(), wxID_ANY, 
+                                                 wxT("超过多少天未修改时归档:"));
+    m_archiveAfterDaysSpinCtrl = new wxSpinCtrl(archiveSizer->GetStaticBox(), wxID_ANY, 
+                                              wxT("90"), wxDefaultPosition, wxDefaultSize, 
+                                              wxSP_ARROW_KEYS, 1, 3650, 90);
+    
+    afterDaysSizer->Add(afterDaysLabel, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+    afterDaysSizer->Add(m_archiveAfterDaysSpinCtrl, 0, wxALL, 5);
+    archiveSizer->Add(afterDaysSizer, 0, wxALL, 5);
+    
+    wxBoxSizer* archiveSizeSizer = new wxBoxSizer(wxHORIZONTAL);
+    wxStaticText* archiveSizeLabel = new wxStaticText(archiveSizer->GetStaticBox(), wxID_ANY, 
+                                                   wxT("会话大于此大小时提前归档 (MB，0 为不限):"));
+    m_archiveSizeSpinCtrl = new wxSpinCtrl(archiveSizer->GetStaticBox(), wxID_ANY, 
+                                         wxT("500"), wxDefaultPosition, wxDefaultSize, 
+                                         wxSP_ARROW_KEYS, 0, 100000, 500);
+    
+    archiveSizeSizer->Add(archiveSizeLabel, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
+    archiveSizeSizer->Add(m_archiveSizeSpinCtrl, 0, wxALL, 5);
+    archiveSizer->Add(archiveSizeSizer, 0, wxALL, 5);
+    
+    if (!MeetAnt::SessionArchive::IsSupported()) {
+        m_archiveCheckBox->Disable();
+        m_archiveCheckBox->SetToolTip(wxT("此版本编译时未启用会话归档（MEETANT_ENABLE_SESSION_ARCHIVE）"));
+    }
+    
     // 诊断工具
     wxStaticBoxSizer* diagSizer = new wxStaticBoxSizer(wxVERTICAL, this, wxT("诊断工具"));
     
@@ -1592,6 +1627,7 @@ SystemConfigPanel::SystemConfigPanel(wxWindow* parent)
     // 添加所有组件到主布局
     mainSizer->Add(updateSizer, 0, wxALL | wxEXPAND, 5);
     mainSizer->Add(saveSizer, 0, wxALL | wxEXPAND, 5);
+    mainSizer->Add(archiveSizer, 0, wxALL | wxEXPAND, 5);
     mainSizer->Add(diagSizer, 0, wxALL | wxEXPAND, 5);
     mainSizer->Add(helpSizer, 0, wxALL | wxEXPAND, 5);
     
@@ -1752,7 +1788,10 @@ bool ConfigDialog::SaveConfigToJSON() {
         config["system"] = {
             {"autoUpdate", m_systemPanel->IsAutoUpdateEnabled()},
             {"autoSave", m_systemPanel->IsAutoSaveEnabled()},
-            {"autoSaveInterval", m_systemPanel->GetAutoSaveInterval()}
+            {"autoSaveInterval", m_systemPanel->GetAutoSaveInterval()},
+            {"archiveEnabled", m_systemPanel->IsArchiveEnabled()},
+            {"archiveAfterDays", m_systemPanel->GetArchiveAfterDays()},
+            {"archiveSizeMB", m_systemPanel->GetArchiveSizeMB()}
         };
         
         // 获取配置文件路径
@@ -1913,6 +1952,15 @@ bool ConfigDialog::LoadConfigFromJSON() {
                     
                 if (system.contains("autoSaveInterval"))
                     m_systemPanel->SetAutoSaveInterval(system["autoSaveInterval"].get<int>());
+                    
+                if (system.contains("archiveEnabled"))
+                    m_systemPanel->SetArchiveEnabled(system["archiveEnabled"].get<bool>());
+                    
+                if (system.contains("archiveAfterDays"))
+                    m_systemPanel->SetArchiveAfterDays(system["archiveAfterDays"].get<int>());
+                    
+                if (system.contains("archiveSizeMB"))
+                    m_systemPanel->SetArchiveSizeMB(system["archiveSizeMB"].get<int>());
             }
         } catch (const std::exception& e) {
             wxLogWarning(wxT("加载系统设置时发生错误: %s"), wxString(e.what()));
@@ -251,11 +251,17 @@ public:
     bool IsAutoUpdateEnabled() const { return m_autoUpdateCheckBox->GetValue(); }
     bool IsAutoSaveEnabled() const { return m_autoSaveCheckBox->GetValue(); }
     int GetAutoSaveInterval() const { return m_autoSaveIntervalSpinCtrl->GetValue(); }
+    bool IsArchiveEnabled() const { return m_archiveCheckBox->GetValue(); }
+    int GetArchiveAfterDays() const { return m_archiveAfterDaysSpinCtrl->GetValue(); }
+    int GetArchiveSizeMB() const { return m_archiveSizeSpinCtrl->GetValue(); }
     
     // 设置配置数据
     void SetAutoUpdateEnabled(bool enabled) { m_autoUpdateCheckBox->SetValue(enabled); }
     void SetAutoSaveEnabled(bool enabled) { m_autoSaveCheckBox->SetValue(enabled); }
     void SetAutoSaveInterval(int interval) { m_autoSaveIntervalSpinCtrl->SetValue(interval); }
+    void SetArchiveEnabled(bool enabled) { m_archiveCheckBox->SetValue(enabled); }
+    void SetArchiveAfterDays(int days) { m_archiveAfterDaysSpinCtrl->SetValue(days); }
+    void SetArchiveSizeMB(int sizeMB) { m_archiveSizeSpinCtrl->SetValue(sizeMB); }
     
 private:
     void OnRunDiagnostics(wxCommandEvent& event);
@@ -263,6 +269,9 @@ private:
     wxCheckBox* m_autoUpdateCheckBox;      // 自动更新选项
     wxCheckBox* m_autoSaveCheckBox;        // 自动保存选项
     wxSpinCtrl* m_autoSaveIntervalSpinCtrl;// 自动保存间隔设置
+    wxCheckBox* m_archiveCheckBox;         // 自动归档选项
+    wxSpinCtrl* m_archiveAfterDaysSpinCtrl;// 多少天未修改后归档
+    wxSpinCtrl* m_archiveSizeSpinCtrl;     // 超过多大提前归档 (MB)
     wxButton* m_runDiagnosticsButton;      // 运行诊断按钮
     wxStaticText* m_versionLabel;          // 版本信息标签
     wxHyperlinkCtrl* m_helpLink;           // 帮助链接
@@ -0,0 +1,309 @@
+#include "EmbeddingModel.h"
+#include "SearchIndex.h"
+#include "VectorIndex.h"
+#include <wx/filename.h>
+#include <wx/textfile.h>
+#include <wx/thread.h>
+#include <algorithm>
+
+#ifdef MEETANT_HAVE_ONNXRUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
+
+namespace MeetAnt {
+
+namespace {
+    // WordPiece 对过长的单词直接视为未知词
+    const size_t kMaxWordLength = 100;
+
+    bool IsSpaceChar(wchar_t ch) {
+        return ch == L' ' || ch == L'\t' || ch == L'\r' || ch == L'\n' || ch == 0x3000 || ch == 0xA0;
+    }
+
+    // 与 BERT 的基础切分一致：下划线也按标点处理
+    bool IsTokenChar(wchar_t ch) {
+        return ch != L'_' && SearchIndex::IsWordChar(ch);
+    }
+
+    uint64_t MixTag(uint64_t tag, uint64_t value) {
+        tag ^= value;
+        tag *= 1099511628211ULL;
+        return tag;
+    }
+}
+
+#ifdef MEETANT_HAVE_ONNXRUNTIME
+struct EmbeddingModel::Session {
+    Ort::Env env;
+    Ort::Session session;
+    std::vector<std::string> inputNames;
+    std::string outputName;
+    bool hasTokenTypeIds;
+
+    Session(const wxString& modelPath, const Ort::SessionOptions& options)
+        : env(ORT_LOGGING_LEVEL_WARNING, "MeetAnt"),
+#ifdef _WIN32
+          session(env, modelPath.wc_str(), options),
+#else
+          session(env, modelPath.utf8_str().data(), options),
+#endif
+          hasTokenTypeIds(false) {
+        Ort::AllocatorWithDefaultOptions allocator;
+        for (size_t i = 0; i < session.GetInputCount(); ++i) {
+            std::string name = session.GetInputNameAllocated(i, allocator).get();
+            if (name == "token_type_ids") {
+                hasTokenTypeIds = true;
+            }
+            inputNames.push_back(name);
+        }
+        outputName = session.GetOutputNameAllocated(0, allocator).get();
+    }
+};
+#else
+struct EmbeddingModel::Session {
+};
+#endif
+
+EmbeddingModel::EmbeddingModel()
+    : m_clsId(-1),
+      m_sepId(-1),
+      m_unknownId(-1),
+      m_dimension(0),
+      m_modelTag(0) {
+}
+
+EmbeddingModel::~EmbeddingModel() {
+}
+
+bool EmbeddingModel::IsSupported() {
+#ifdef MEETANT_HAVE_ONNXRUNTIME
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool EmbeddingModel::Load(const wxString& modelPath, const wxString& vocabPath) {
+    m_session.reset();
+    m_dimension = 0;
+    m_modelTag = 0;
+
+#ifdef MEETANT_HAVE_ONNXRUNTIME
+    if (!LoadVocabulary(vocabPath)) {
+        return false;
+    }
+
+    try {
+        Ort::SessionOptions options;
+        // 转写时 CPU 还在处理音频，只用一半的核心
+        options.SetIntraOpNumThreads(std::max(1, wxThread::GetCPUCount() / 2));
+        options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        m_session.reset(new Session(modelPath, options));
+    } catch (const Ort::Exception& e) {
+        wxLogWarning(wxT("无法加载句向量模型 %s: %s"), modelPath, wxString::FromUTF8(e.what()));
+        m_session.reset();
+        return false;
+    }
+
+    // 模型的输出维度可能是动态的，用一次空文本推理得到实际维度
+    std::vector<float> probe = Embed(std::wstring());
+    if (probe.empty()) {
+        m_session.reset();
+        return false;
+    }
+    m_dimension = probe.size();
+
+    wxFileName modelFile(modelPath);
+    uint64_t tag = 14695981039346656037ULL;
+    tag = MixTag(tag, modelFile.GetSize().GetValue());
+    tag = MixTag(tag, static_cast<uint64_t>(modelFile.GetModificationTime().GetTicks()));
+    tag = MixTag(tag, m_vocabulary.size());
+    tag = MixTag(tag, m_dimension);
+    m_modelTag = tag;
+
+    wxLogInfo(wxT("已加载句向量模型 %s（%zu 维，词表 %zu 项）"), modelPath, m_dimension, m_vocabulary.size());
+    return true;
+#else
+    wxUnusedVar(vocabPath);
+    wxLogWarning(wxT("当前版本未启用 ONNX Runtime，无法加载句向量模型: %s"), modelPath);
+    return false;
+#endif
+}
+
+bool EmbeddingModel::LoadVocabulary(const wxString& vocabPath) {
+    m_vocabulary.clear();
+    m_clsId = m_sepId = m_unknownId = -1;
+
+    wxTextFile file;
+    if (!file.Open(vocabPath, wxConvUTF8)) {
+        wxLogWarning(wxT("无法打开词表文件: %s"), vocabPath);
+        return false;
+    }
+
+    m_vocabulary.reserve(file.GetLineCount());
+    for (size_t i = 0; i < file.GetLineCount(); ++i) {
+        std::wstring token = file.GetLine(i).ToStdWstring();
+        if (!token.empty()) {
+            m_vocabulary.emplace(std::move(token), static_cast<int64_t>(i));
+        }
+    }
+    file.Close();
+
+    m_clsId = LookupToken(L"[CLS]");
+    m_sepId = LookupToken(L"[SEP]");
+    m_unknownId = LookupToken(L"[UNK]");
+    if (m_clsId < 0 || m_sepId < 0 || m_unknownId < 0) {
+        wxLogWarning(wxT("词表缺少 [CLS]/[SEP]/[UNK]: %s"), vocabPath);
+        m_vocabulary.clear();
+        return false;
+    }
+    return true;
+}
+
+int64_t EmbeddingModel::LookupToken(const std::wstring& token) const {
+    auto it = m_vocabulary.find(token);
+    return it != m_vocabulary.end() ? it->second : -1;
+}
+
+std::vector<int64_t> EmbeddingModel::Tokenize(const std::wstring& text) const {
+    std::vector<int64_t> ids;
+    ids.push_back(m_clsId);
+
+    std::wstring normalized = SearchIndex::Normalize(text);
+    size_t length = normalized.length();
+    size_t i = 0;
+    while (i < length && ids.size() < kMaxSequenceLength - 1) {
+        wchar_t ch = normalized[i];
+        if (IsSpaceChar(ch)) {
+            i++;
+        } else if (IsTokenChar(ch)) {
+            size_t end = i + 1;
+            while (end < length && IsTokenChar(normalized[end])) {
+                end++;
+            }
+            AppendWordPieces(normalized.substr(i, end - i), ids);
+            i = end;
+        } else {
+            // 汉字和标点各自成词
+            size_t width = (ch >= 0xD800 && ch <= 0xDBFF && i + 1 < length) ? 2 : 1;
+            int64_t id = LookupToken(normalized.substr(i, width));
+            ids.push_back(id >= 0 ? id : m_unknownId);
+            i += width;
+        }
+    }
+
+    if (ids.size() > kMaxSequenceLength - 1) {
+        ids.resize(kMaxSequenceLength - 1);
+    }
+    ids.push_back(m_sepId);
+    return ids;
+}
+
+void EmbeddingModel::AppendWordPieces(const std::wstring& word, std::vector<int64_t>& ids) const {
+    if (word.length() > kMaxWordLength) {
+        ids.push_back(m_unknownId);
+        return;
+    }
+
+    // 贪心最长匹配，后续片段带 "##" 前缀；有任何一段匹配不上则整个单词记为 [UNK]
+    std::vector<int64_t> pieces;
+    size_t start = 0;
+    while (start < word.length()) {
+        int64_t found = -1;
+        size_t end = word.length();
+        while (end > start) {
+            std::wstring piece = word.substr(start, end - start);
+            if (start > 0) {
+                piece.insert(0, L"##");
+            }
+            found = LookupToken(piece);
+            if (found >= 0) {
+                break;
+            }
+            end--;
+        }
+        if (found < 0) {
+            ids.push_back(m_unknownId);
+            return;
+        }
+        pieces.push_back(found);
+        start = end;
+    }
+    ids.insert(ids.end(), pieces.begin(), pieces.end());
+}
+
+std::vector<float> EmbeddingModel::Embed(const std::wstring& text) {
+    std::vector<float> embedding;
+#ifdef MEETANT_HAVE_ONNXRUNTIME
+    if (!m_session) {
+        return embedding;
+    }
+
+    std::vector<int64_t> inputIds = Tokenize(text);
+    const int64_t tokenCount = static_cast<int64_t>(inputIds.size());
+    std::vector<int64_t> attentionMask(inputIds.size(), 1);
+    std::vector<int64_t> tokenTypeIds(inputIds.size(), 0);
+    const int64_t shape[2] = { 1, tokenCount };
+
+    try {
+        Ort::MemoryInfo memory = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        std::vector<Ort::Value> inputs;
+        std::vector<const char*> inputNames;
+        for (const std::string& name : m_session->inputNames) {
+            std::vector<int64_t>* data = &inputIds;
+            if (name == "attention_mask") {
+                data = &attentionMask;
+            } else if (name == "token_type_ids") {
+                data = &tokenTypeIds;
+            }
+            inputs.push_back(Ort::Value::CreateTensor<int64_t>(memory, data->data(), data->size(), shape, 2));
+            inputNames.push_back(name.c_str());
+        }
+
+        const char* outputName = m_session->outputName.c_str();
+        std::vector<Ort::Value> outputs = m_session->session.Run(Ort::RunOptions{nullptr},
+            inputNames.data(), inputs.data(), inputs.size(), &outputName, 1);
+        if (outputs.empty() || !outputs[0].IsTensor()) {
+            return embedding;
+        }
+
+        std::vector<int64_t> outputShape = outputs[0].GetTensorTypeAndShapeInfo().GetShape();
+        const float* data = outputs[0].GetTensorData<float>();
+        if (outputShape.size() == 2) {
+            // 已经池化过的句向量 [1, dim]
+            embedding.assign(data, data + outputShape[1]);
+        } else if (outputShape.size() == 3 && outputShape[1] == tokenCount) {
+            // 逐词隐状态 [1, tokens, dim]，按注意力掩码做均值池化（掩码全为 1）
+            size_t dimension = static_cast<size_t>(outputShape[2]);
+            embedding.assign(dimension, 0.0f);
+            for (int64_t t = 0; t < tokenCount; ++t) {
+                const float* row = data + t * dimension;
+                for (size_t d = 0; d < dimension; ++d) {
+                    embedding[d] += row[d];
+                }
+            }
+            for (float& value : embedding) {
+                value /= static_cast<float>(tokenCount);
+            }
+        } else {
+            wxLogWarning(wxT("句向量模型的输出形状不受支持"));
+            return embedding;
+        }
+    } catch (const Ort::Exception& e) {
+        wxLogWarning(wxT("句向量推理失败: %s"), wxString::FromUTF8(e.what()));
+        embedding.clear();
+        return embedding;
+    }
+
+    if (m_dimension > 0 && embedding.size() != m_dimension) {
+        embedding.clear();
+        return embedding;
+    }
+    NormalizeVector(embedding.data(), embedding.size());
+#else
+    wxUnusedVar(text);
+#endif
+    return embedding;
+}
+
+} // namespace MeetAnt
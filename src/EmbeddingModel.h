@@ -0,0 +1,65 @@
+#ifndef MEETANT_EMBEDDING_MODEL_H
+#define MEETANT_EMBEDDING_MODEL_H
+
+#include <wx/wx.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MeetAnt {
+
+// 本地句向量模型
+// 加载 BERT 类 ONNX 模型（如 bge-small-zh、paraphrase-multilingual-MiniLM）和对应的 WordPiece 词表，
+// 在 CPU 上计算句向量：对最后一层隐状态按注意力掩码做均值池化后归一化。
+// 编译时未启用 ONNX Runtime（MEETANT_HAVE_ONNXRUNTIME）时 Load 总是失败。
+// 同一对象不能被多个线程同时使用。
+class EmbeddingModel {
+public:
+    EmbeddingModel();
+    ~EmbeddingModel();
+
+    // 是否编译了 ONNX Runtime 支持
+    static bool IsSupported();
+
+    // 加载模型和词表（vocab.txt，每行一个词，行号即编号）
+    bool Load(const wxString& modelPath, const wxString& vocabPath);
+    bool IsLoaded() const { return m_session != nullptr; }
+
+    // 向量维度，模型未加载时为 0
+    size_t GetDimension() const { return m_dimension; }
+
+    // 标识当前模型（文件大小和修改时间、词表大小、维度），用于判断已保存的向量是否过期
+    uint64_t GetModelTag() const { return m_modelTag; }
+
+    // 计算单位长度的句向量，失败时返回空
+    std::vector<float> Embed(const std::wstring& text);
+
+    // 切分为词表编号，首尾加 [CLS]/[SEP]，总长不超过 kMaxSequenceLength
+    std::vector<int64_t> Tokenize(const std::wstring& text) const;
+
+    static const size_t kMaxSequenceLength = 256;
+
+private:
+    struct Session;
+
+    bool LoadVocabulary(const wxString& vocabPath);
+    void AppendWordPieces(const std::wstring& word, std::vector<int64_t>& ids) const;
+    int64_t LookupToken(const std::wstring& token) const;
+
+    std::unique_ptr<Session> m_session;
+    std::unordered_map<std::wstring, int64_t> m_vocabulary;
+    int64_t m_clsId;
+    int64_t m_sepId;
+    int64_t m_unknownId;
+    size_t m_dimension;
+    uint64_t m_modelTag;
+
+    EmbeddingModel(const EmbeddingModel&) = delete;
+    EmbeddingModel& operator=(const EmbeddingModel&) = delete;
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_EMBEDDING_MODEL_H
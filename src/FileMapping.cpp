@@ -0,0 +1,97 @@
+#include "FileMapping.h"
+
+#ifdef __WXMSW__
+#include <wx/msw/wrapwin.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace MeetAnt {
+
+FileMapping::FileMapping()
+    : m_data(nullptr),
+      m_size(0)
+#ifdef __WXMSW__
+      , m_fileHandle(nullptr),
+      m_mappingHandle(nullptr)
+#endif
+{
+}
+
+FileMapping::~FileMapping() {
+    Close();
+}
+
+bool FileMapping::Open(const wxString& filePath) {
+    Close();
+
+#ifdef __WXMSW__
+    // 分页文件映射期间仍由 wxFile 追加写入，共享方式要允许写和删除
+    HANDLE file = ::CreateFileW(filePath.wc_str(), GENERIC_READ,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!::GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+        ::CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        ::CloseHandle(file);
+        return false;
+    }
+    void* data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        ::CloseHandle(mapping);
+        ::CloseHandle(file);
+        return false;
+    }
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+    m_data = data;
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(filePath.fn_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    // 映射建立后即可关闭描述符
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    m_data = data;
+    m_size = static_cast<size_t>(st.st_size);
+#endif
+    return true;
+}
+
+void FileMapping::Close() {
+    if (m_data) {
+#ifdef __WXMSW__
+        ::UnmapViewOfFile(m_data);
+        ::CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+        ::CloseHandle(static_cast<HANDLE>(m_fileHandle));
+        m_mappingHandle = nullptr;
+        m_fileHandle = nullptr;
+#else
+        ::munmap(m_data, m_size);
+#endif
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,40 @@
+#ifndef MEETANT_FILE_MAPPING_H
+#define MEETANT_FILE_MAPPING_H
+
+#include <wx/wx.h>
+#include <cstddef>
+
+namespace MeetAnt {
+
+// 整个文件的只读内存映射
+// 搜索索引文件和转录分页文件共用：打开时映射文件的当前内容，之后在映射区上直接读取。
+// 映射期间文件可以被其他句柄继续写入或删除；追加的内容要重新 Open 才能看到。
+class FileMapping {
+public:
+    FileMapping();
+    ~FileMapping();
+
+    // 映射整个文件，文件无法打开或为空时返回 false
+    bool Open(const wxString& filePath);
+    void Close();
+    bool IsOpen() const { return m_data != nullptr; }
+
+    const char* GetData() const { return static_cast<const char*>(m_data); }
+    size_t GetSize() const { return m_size; }
+
+private:
+    // 平台相关的文件映射句柄
+    void* m_data;
+    size_t m_size;
+#ifdef __WXMSW__
+    void* m_fileHandle;
+    void* m_mappingHandle;
+#endif
+
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_FILE_MAPPING_H
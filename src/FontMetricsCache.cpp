@@ -0,0 +1,177 @@
+#include "FontMetricsCache.h"
+#include <algorithm>
+
+FontMetricsCache::FontMetricsCache()
+    : m_wideWidth(14),
+      m_narrowWidth(7),
+      m_lineHeight(16),
+      m_prepared(false)
+{
+    std::fill(std::begin(m_asciiWidths), std::end(m_asciiWidths), 0);
+}
+
+void FontMetricsCache::Prepare(wxDC& dc, const wxFont& font) {
+    wxCriticalSectionLocker lock(m_critSect);
+
+    m_font = font;
+    m_widths.clear();
+    m_pending.clear();
+
+    dc.SetFont(font);
+    m_lineHeight = dc.GetCharHeight();
+
+    // 预先测量可打印ASCII字符
+    int totalNarrow = 0;
+    int narrowCount = 0;
+    for (int ch = 0; ch < 128; ++ch) {
+        if (ch < 0x20 || ch == 0x7F) {
+            m_asciiWidths[ch] = 0;
+            continue;
+        }
+        m_asciiWidths[ch] = dc.GetTextExtent(wxString(wxUniChar(ch))).x;
+        totalNarrow += m_asciiWidths[ch];
+        narrowCount++;
+    }
+    m_narrowWidth = narrowCount > 0 ? totalNarrow / narrowCount : 7;
+
+    // 汉字在同一字体中基本等宽，测量一个代表字符即可
+    m_wideWidth = dc.GetTextExtent(wxT("中")).x;
+
+    // 常用中文标点可能与汉字宽度不同，单独测量
+    static const wchar_t s_cjkPunctuation[] = L"，。、；：？！“”‘’（）《》【】—…·";
+    for (const wchar_t* p = s_cjkPunctuation; *p; ++p) {
+        m_widths[*p] = dc.GetTextExtent(wxString(*p)).x;
+    }
+
+    m_prepared = true;
+}
+
+bool FontMetricsCache::IsPrepared() const {
+    wxCriticalSectionLocker lock(m_critSect);
+    return m_prepared;
+}
+
+bool FontMetricsCache::MeasurePending(wxDC& dc) {
+    wxCriticalSectionLocker lock(m_critSect);
+    if (m_pending.empty()) {
+        return false;
+    }
+
+    dc.SetFont(m_font);
+    for (wchar_t ch : m_pending) {
+        m_widths[ch] = dc.GetTextExtent(wxString(ch)).x;
+    }
+    m_pending.clear();
+    return true;
+}
+
+int FontMetricsCache::GetLineHeight() const {
+    wxCriticalSectionLocker lock(m_critSect);
+    return m_lineHeight;
+}
+
+std::vector<int> FontMetricsCache::WrapText(const wchar_t* text, size_t length, int maxWidth,
+                                            int* widest, bool* estimated) const {
+    std::vector<int> lineStarts;
+    int widestLine = 0;
+    bool anyEstimated = false;
+
+    // 整段文本只加一次锁，避免逐字符加锁的开销
+    wxCriticalSectionLocker lock(m_critSect);
+
+    size_t pos = 0;
+    while (pos < length) {
+        size_t lineStart = pos;
+        int lineWidth = 0;
+        lineStarts.push_back(static_cast<int>(lineStart));
+
+        while (pos < length) {
+            wchar_t ch = text[pos];
+            if (ch == L'\n') {
+                pos++;
+                break;
+            }
+
+            int charWidth = LookupWidth(ch, &anyEstimated);
+            // 代理对的低位不能单独断开
+            bool isContinuation = (ch >= 0xDC00 && ch <= 0xDFFF);
+            if (lineWidth + charWidth > maxWidth && pos > lineStart && !isContinuation) {
+                break;
+            }
+
+            // 单个字符超宽时至少要包含这个字符
+            lineWidth += charWidth;
+            pos++;
+        }
+
+        widestLine = std::max(widestLine, lineWidth);
+    }
+
+    if (widest) {
+        *widest = widestLine;
+    }
+    if (estimated) {
+        *estimated = anyEstimated;
+    }
+    return lineStarts;
+}
+
+int FontMetricsCache::EstimateLineCount(const wchar_t* text, size_t length, int maxWidth) const {
+    if (length == 0) {
+        return 0;
+    }
+
+    wxCriticalSectionLocker lock(m_critSect);
+
+    // 用开头的一小段文字判断宽窄字符比例
+    size_t sampleLength = std::min<size_t>(length, 32);
+    size_t wideCount = 0;
+    for (size_t i = 0; i < sampleLength; ++i) {
+        if (IsWideChar(text[i])) {
+            wideCount++;
+        }
+    }
+
+    long long averageWidth = (static_cast<long long>(wideCount) * m_wideWidth +
+                              static_cast<long long>(sampleLength - wideCount) * m_narrowWidth) / sampleLength;
+    long long totalWidth = averageWidth * static_cast<long long>(length);
+    long long lineWidth = std::max(1, maxWidth);
+    return static_cast<int>(std::max<long long>(1, (totalWidth + lineWidth - 1) / lineWidth));
+}
+
+int FontMetricsCache::LookupWidth(wchar_t ch, bool* estimated) const {
+    if (ch < 128) {
+        return m_asciiWidths[static_cast<int>(ch)];
+    }
+
+    if (ch >= 0xDC00 && ch <= 0xDFFF) {
+        return 0;
+    }
+
+    auto it = m_widths.find(ch);
+    if (it != m_widths.end()) {
+        return it->second;
+    }
+
+    if (IsWideChar(ch)) {
+        return m_wideWidth;
+    }
+
+    // 未测量过的窄字符，先估算，稍后由UI线程补测
+    m_pending.insert(ch);
+    if (estimated) {
+        *estimated = true;
+    }
+    return m_narrowWidth;
+}
+
+bool FontMetricsCache::IsWideChar(wchar_t ch) {
+    return (ch >= 0x1100 && ch <= 0x115F) ||   // 谚文字母
+           (ch >= 0x2E80 && ch <= 0xA4CF) ||   // CJK 部首、假名、汉字、彝文
+           (ch >= 0xAC00 && ch <= 0xD7A3) ||   // 谚文音节
+           (ch >= 0xD800 && ch <= 0xDBFF) ||   // 代理对高位（扩展区汉字、表情等）
+           (ch >= 0xF900 && ch <= 0xFAFF) ||   // CJK 兼容汉字
+           (ch >= 0xFE30 && ch <= 0xFE4F) ||   // CJK 兼容形式
+           (ch >= 0xFF00 && ch <= 0xFF60) ||   // 全角字符
+           (ch >= 0xFFE0 && ch <= 0xFFE6);
+}
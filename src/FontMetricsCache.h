@@ -0,0 +1,53 @@
+#ifndef MEETANT_FONT_METRICS_CACHE_H
+#define MEETANT_FONT_METRICS_CACHE_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// 线程安全的字体度量缓存
+// 字形宽度只能在UI线程中通过 wxDC 测量；布局工作线程只读取缓存。
+// 未命中的字符按东亚宽度属性估算宽度并记录下来，之后由UI线程补测。
+class FontMetricsCache {
+public:
+    FontMetricsCache();
+
+    // 在UI线程中为指定字体预热缓存（ASCII、常用中文标点以及代表性汉字宽度）
+    void Prepare(wxDC& dc, const wxFont& font);
+    bool IsPrepared() const;
+
+    // 在UI线程中测量此前未命中的字符，返回是否有新测量的字符
+    bool MeasurePending(wxDC& dc);
+
+    // 行高（像素）
+    int GetLineHeight() const;
+
+    // 按最大宽度对文本进行贪心换行，返回每行在文本中的起始偏移，可在任意线程调用
+    // widest 返回最宽一行的宽度，estimated 返回是否用到了估算宽度
+    std::vector<int> WrapText(const wchar_t* text, size_t length, int maxWidth,
+                              int* widest = nullptr, bool* estimated = nullptr) const;
+
+    // 不逐字测量，按字符数粗略估算换行后的行数（用于尚未测量的消息）
+    int EstimateLineCount(const wchar_t* text, size_t length, int maxWidth) const;
+
+private:
+    // 查询单个字符宽度，调用方需持有 m_critSect
+    int LookupWidth(wchar_t ch, bool* estimated) const;
+
+    // 是否为东亚宽字符（汉字、假名、谚文、全角符号等）
+    static bool IsWideChar(wchar_t ch);
+
+    mutable wxCriticalSection m_critSect;
+    wxFont m_font;                                   // 当前缓存对应的字体
+    int m_asciiWidths[128];                          // ASCII 字符宽度
+    std::unordered_map<wchar_t, int> m_widths;       // 其它已测量字符的宽度
+    mutable std::unordered_set<wchar_t> m_pending;   // 待UI线程补测的字符
+    int m_wideWidth;                                 // 代表性汉字宽度
+    int m_narrowWidth;                               // 平均窄字符宽度
+    int m_lineHeight;                                // 行高
+    bool m_prepared;
+};
+
+#endif // MEETANT_FONT_METRICS_CACHE_H
@@ -0,0 +1,231 @@
+#include "FuzzySearch.h"
+#include "Pinyin.h"
+#include <algorithm>
+#include <iterator>
+
+namespace MeetAnt {
+
+namespace {
+    // 允许的最大编辑距离，自动机每个字符的代价与之成正比
+    const int kMaxDistance = 8;
+
+    // 筛选候选时片段的最大长度：更长的片段很少再减少候选，只增加查索引的次数
+    const size_t kMaxPieceLength = 8;
+}
+
+FuzzyQuery::FuzzyQuery()
+    : m_maxDistance(0) {
+    std::fill(std::begin(m_masks), std::end(m_masks), 0);
+}
+
+bool FuzzyQuery::Compile(const std::wstring& query, int maxDistance) {
+    m_key = ToPinyinKey(SearchIndex::Normalize(query));
+    std::fill(std::begin(m_masks), std::end(m_masks), 0);
+    m_maxDistance = 0;
+    if (m_key.empty()) {
+        return false;
+    }
+
+    size_t length = m_key.length();
+    if (length > kMaxAutomatonLength) {
+        return true;
+    }
+
+    // 短查询容错会带来大量误匹配：3 个字母以内要求精确，8 个以内允许 1 处，更长允许 2 处
+    if (maxDistance < 0) {
+        maxDistance = length <= 3 ? 0 : (length <= 7 ? 1 : 2);
+    }
+    // 编辑距离达到查询长度时任何文本都能匹配
+    m_maxDistance = std::min(maxDistance, std::min(static_cast<int>(length) - 1, kMaxDistance));
+
+    for (size_t i = 0; i < length; ++i) {
+        m_masks[static_cast<unsigned char>(m_key[i]) & 0x7F] |= uint64_t(1) << i;
+    }
+    return true;
+}
+
+std::vector<uint32_t> FuzzyQuery::FindCandidates(const SearchIndex& index) const {
+    const size_t length = m_key.length();
+    const size_t pieceCount = static_cast<size_t>(m_maxDistance) + 1;
+
+    std::vector<std::string> pieces;
+    if (length >= pieceCount * 2) {
+        // cost[s][n]：从第 s 个字母起、长 n 的片段的候选数；片段越长越少，但占用的字母也越多
+        const size_t unreachable = static_cast<size_t>(-1);
+        std::vector<std::vector<size_t>> cost(length, std::vector<size_t>(kMaxPieceLength + 1, unreachable));
+        for (size_t s = 0; s + 2 <= length; ++s) {
+            for (size_t n = 2; n <= kMaxPieceLength && s + n <= length; ++n) {
+                cost[s][n] = index.CountPinyinCandidates(m_key.substr(s, n));
+            }
+        }
+
+        // best[j][i]：在查询键的前 i 个字母中放 j 个片段时，各片段候选数之和的最小值
+        std::vector<std::vector<size_t>> best(pieceCount + 1, std::vector<size_t>(length + 1, unreachable));
+        std::vector<std::vector<size_t>> from(pieceCount + 1, std::vector<size_t>(length + 1, unreachable));
+        std::fill(best[0].begin(), best[0].end(), 0);
+        for (size_t j = 1; j <= pieceCount; ++j) {
+            for (size_t i = 2; i <= length; ++i) {
+                best[j][i] = best[j][i - 1];
+                from[j][i] = unreachable;   // 第 i 个字母不属于任何片段
+                for (size_t n = 2; n <= kMaxPieceLength && n <= i; ++n) {
+                    size_t s = i - n;
+                    if (best[j - 1][s] != unreachable && best[j - 1][s] + cost[s][n] < best[j][i]) {
+                        best[j][i] = best[j - 1][s] + cost[s][n];
+                        from[j][i] = s;
+                    }
+                }
+            }
+        }
+
+        size_t i = length;
+        for (size_t j = pieceCount; j > 0;) {
+            if (from[j][i] != unreachable) {
+                pieces.push_back(m_key.substr(from[j][i], i - from[j][i]));
+                i = from[j][i];
+                --j;
+            } else {
+                --i;
+            }
+        }
+    }
+
+    // 切不出足够的片段时 FindPinyinCandidates 返回全部文档
+    if (pieces.empty()) {
+        pieces.push_back(std::string());
+    }
+    return index.FindPinyinCandidates(pieces);
+}
+
+bool FuzzyQuery::Match(const std::wstring& normalizedText, const std::string& key, size_t document,
+                       std::vector<SearchHit>& hits, size_t maxHits) const {
+    if (m_key.empty() || key.length() + m_maxDistance < m_key.length()) {
+        return false;
+    }
+
+    std::vector<uint32_t> positions;
+    bool matched = false;
+    size_t begin = 0;
+    size_t start = 0;
+    size_t end = 0;
+    while (begin < key.length() && FindNext(key, begin, &start, &end)) {
+        if (!matched) {
+            // 只为有匹配的文档计算拼音键到原文的位置对应
+            ToPinyinKey(normalizedText, &positions);
+            matched = true;
+        }
+        if (positions.size() != key.length()) {
+            break;
+        }
+
+        size_t offset = positions[start];
+        hits.push_back(SearchHit{document, offset, positions[end] + 1 - offset});
+        if (maxHits > 0 && hits.size() >= maxHits) {
+            break;
+        }
+
+        // 下一次从下一个原文字符的拼音开始，避免两个匹配落在同一个字上
+        begin = end + 1;
+        while (begin < key.length() && positions[begin] == positions[end]) {
+            begin++;
+        }
+    }
+    return matched;
+}
+
+bool FuzzyQuery::FindNext(const std::string& key, size_t begin, size_t* start, size_t* end) const {
+    const size_t length = m_key.length();
+    if (length > kMaxAutomatonLength) {
+        size_t pos = key.find(m_key, begin);
+        if (pos == std::string::npos) {
+            return false;
+        }
+        *start = pos;
+        *end = pos + length - 1;
+        return true;
+    }
+
+    // state[d] 的第 i 位表示查询的前 i+1 个字母能以不超过 d 处编辑匹配到当前位置
+    const int k = m_maxDistance;
+    const uint64_t accept = uint64_t(1) << (length - 1);
+    uint64_t state[kMaxDistance + 1];
+    for (int d = 0; d <= k; ++d) {
+        state[d] = (uint64_t(1) << d) - 1;    // 开头的 d 个字母可以被删除
+    }
+
+    int bestDistance = -1;
+    size_t bestEnd = 0;
+    size_t firstEnd = 0;
+    for (size_t i = begin; i < key.length(); ++i) {
+        uint64_t mask = m_masks[static_cast<unsigned char>(key[i]) & 0x7F];
+        uint64_t previous = state[0];
+        state[0] = ((state[0] << 1) | 1) & mask;
+        for (int d = 1; d <= k; ++d) {
+            uint64_t old = state[d];
+            state[d] = (((old << 1) | 1) & mask)   // 匹配
+                     | ((previous << 1) | 1)       // 替换
+                     | ((state[d - 1] << 1) | 1)   // 查询多出一个字母
+                     | previous;                   // 文本多出一个字母
+            previous = old;
+        }
+
+        int distance = -1;
+        for (int d = 0; d <= k; ++d) {
+            if (state[d] & accept) {
+                distance = d;
+                break;
+            }
+        }
+        if (distance >= 0 && (bestDistance < 0 || distance < bestDistance)) {
+            if (bestDistance < 0) {
+                firstEnd = i;
+            }
+            bestDistance = distance;
+            bestEnd = i;
+        }
+
+        // 首次匹配后再向后看至多 k 个字母，取编辑距离最小的结束位置
+        if (bestDistance == 0 || (bestDistance > 0 && i >= firstEnd + k)) {
+            break;
+        }
+    }
+
+    if (bestDistance < 0) {
+        return false;
+    }
+    *end = bestEnd;
+    *start = FindStart(key, bestEnd, bestDistance);
+    return true;
+}
+
+size_t FuzzyQuery::FindStart(const std::string& key, size_t end, int distance) const {
+    // 反向比较查询和以 end 结尾的文本，column[i] 为查询末尾 i 个字母与文本末尾 j 个字母的编辑距离
+    const size_t length = m_key.length();
+    const size_t maxSpan = std::min(length + distance, end + 1);
+
+    std::vector<int> column(length + 1);
+    std::vector<int> next(length + 1);
+    for (size_t i = 0; i <= length; ++i) {
+        column[i] = static_cast<int>(i);
+    }
+
+    size_t bestSpan = std::min(length, maxSpan);
+    int best = -1;
+    for (size_t j = 1; j <= maxSpan; ++j) {
+        char ch = key[end + 1 - j];
+        next[0] = static_cast<int>(j);
+        for (size_t i = 1; i <= length; ++i) {
+            int cost = (m_key[length - i] == ch) ? 0 : 1;
+            next[i] = std::min(std::min(column[i] + 1, next[i - 1] + 1), column[i - 1] + cost);
+        }
+        column.swap(next);
+
+        // 编辑距离相同时取最短的范围
+        if (best < 0 || column[length] < best) {
+            best = column[length];
+            bestSpan = j;
+        }
+    }
+    return end + 1 - bestSpan;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,58 @@
+#ifndef MEETANT_FUZZY_SEARCH_H
+#define MEETANT_FUZZY_SEARCH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "SearchIndex.h"
+
+namespace MeetAnt {
+
+// 拼音模糊查询
+// 查询和文档都转为无声调拼音键（见 ToPinyinKey）后比较，同音字视为相同，
+// 并允许有限的编辑距离以容忍 zh/z、in/ing 之类的近音错误。
+// 编译时为查询预先计算每个字母的位掩码，匹配时用位并行的近似匹配自动机
+// （Wu-Manber）逐字符扫描拼音键，每个字符的代价与允许的编辑距离成正比。
+// 扫描之前用索引中拼音键的双字母位图筛选候选：编辑距离不超过 k 的匹配中，
+// 查询键的任意 k+1 个不相交片段至少有一个原样出现在文档的拼音键中。
+class FuzzyQuery {
+public:
+    // 自动机使用 64 位状态，更长的查询退化为拼音键的精确匹配
+    static const size_t kMaxAutomatonLength = 64;
+
+    FuzzyQuery();
+
+    // 编译查询；maxDistance 小于 0 时按拼音键长度选择允许的编辑距离
+    // 查询中没有汉字和字母数字时返回 false
+    bool Compile(const std::wstring& query, int maxDistance = -1);
+    bool IsValid() const { return !m_key.empty(); }
+
+    const std::string& GetKey() const { return m_key; }
+    int GetMaxDistance() const { return m_maxDistance; }
+
+    // 用索引筛选可能匹配的文档（已排序），只用索引过滤不做校验
+    // 选出候选数之和最小的 k+1 个不相交片段（每段二至八个字母），返回拼音键含有其中任一片段的文档；
+    // 查询键太短切不出这么多段时返回全部文档
+    std::vector<uint32_t> FindCandidates(const SearchIndex& index) const;
+
+    // 在一篇文档中查找不重叠的近似匹配，位置以原文字符计
+    // key 须为 ToPinyinKey(normalizedText)；maxHits 为 hits 的总数上限（0 不限）
+    // 返回本篇文档是否有匹配
+    bool Match(const std::wstring& normalizedText, const std::string& key, size_t document,
+               std::vector<SearchHit>& hits, size_t maxHits) const;
+
+private:
+    // 从 begin 开始查找下一个匹配在拼音键上的范围 [start, end]
+    bool FindNext(const std::string& key, size_t begin, size_t* start, size_t* end) const;
+
+    // 已知匹配在 end 结束、编辑距离为 distance，反向求最贴合的起点
+    size_t FindStart(const std::string& key, size_t end, int distance) const;
+
+    std::string m_key;
+    int m_maxDistance;
+    uint64_t m_masks[128];      // 每个 ASCII 字符在查询键中出现位置的位掩码
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_FUZZY_SEARCH_H
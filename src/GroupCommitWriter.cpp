@@ -0,0 +1,107 @@
+#include "GroupCommitWriter.h"
+#include <wx/stopwatch.h>
+
+namespace MeetAnt {
+
+// 写入线程：取到一个任务后开始一批，再等待 batchMs 内陆续提交的任务；取到空任务时结束并退出
+class GroupCommitWriter::Thread : public wxThread {
+public:
+    explicit Thread(GroupCommitWriter* owner)
+        : wxThread(wxTHREAD_JOINABLE),
+          m_owner(owner) {
+    }
+
+protected:
+    ExitCode Entry() override {
+        bool running = true;
+        while (running) {
+            Task task;
+            if (m_owner->m_tasks.Receive(task) != wxMSGQUEUE_NO_ERROR || !task) {
+                break;
+            }
+            if (m_owner->m_beginBatch) {
+                m_owner->m_beginBatch();
+            }
+            task();
+
+            wxStopWatch batch;
+            for (;;) {
+                long remaining = m_owner->m_batchMs - batch.Time();
+                if (remaining <= 0 || m_owner->m_tasks.ReceiveTimeout(remaining, task) != wxMSGQUEUE_NO_ERROR) {
+                    break;
+                }
+                if (!task) {
+                    running = false;
+                    break;
+                }
+                task();
+            }
+            if (m_owner->m_endBatch) {
+                m_owner->m_endBatch();
+            }
+        }
+        return (ExitCode)0;
+    }
+
+private:
+    GroupCommitWriter* m_owner;
+};
+
+GroupCommitWriter::GroupCommitWriter(long batchMs, const Task& beginBatch, const Task& endBatch)
+    : m_batchMs(batchMs),
+      m_beginBatch(beginBatch),
+      m_endBatch(endBatch),
+      m_thread(nullptr)
+{
+    Start();
+}
+
+GroupCommitWriter::~GroupCommitWriter() {
+    Stop();
+}
+
+void GroupCommitWriter::Start() {
+    m_thread = new Thread(this);
+    if (m_thread->Run() != wxTHREAD_NO_ERROR) {
+        wxLogWarning(wxT("无法启动后台写入线程，改为直接写入"));
+        delete m_thread;
+        m_thread = nullptr;
+    }
+}
+
+void GroupCommitWriter::Flush() {
+    // 线程只在空任务处结束一批并退出：停止后换一个新线程
+    if (m_thread) {
+        Stop();
+        Start();
+    }
+}
+
+void GroupCommitWriter::Stop() {
+    if (m_thread) {
+        m_tasks.Post(Task());
+        m_thread->Wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+}
+
+void GroupCommitWriter::Post(const Task& task) {
+    if (m_thread) {
+        m_tasks.Post(task);
+    } else {
+        RunNow(task);
+    }
+}
+
+void GroupCommitWriter::RunNow(const Task& task) {
+    if (m_beginBatch) {
+        m_beginBatch();
+    }
+    task();
+    if (m_endBatch) {
+        m_endBatch();
+    }
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,53 @@
+#ifndef MEETANT_GROUP_COMMIT_WRITER_H
+#define MEETANT_GROUP_COMMIT_WRITER_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <wx/msgqueue.h>
+#include <functional>
+
+namespace MeetAnt {
+
+// 成批提交的后台写入线程
+// 按提交顺序执行任务，把 batchMs 内陆续提交的任务并成一批：每批第一个任务之前回调 beginBatch，
+// 最后一个任务之后回调 endBatch（开始和提交事务、写入并 fsync 等），两个回调都可以为空。
+// 批注日志、转录日志、恢复日志和会话数据库各用一个。
+// 无法启动线程时改为在调用线程中直接执行，每个任务自成一批。
+class GroupCommitWriter {
+public:
+    typedef std::function<void()> Task;
+
+    GroupCommitWriter(long batchMs, const Task& beginBatch, const Task& endBatch);
+    // 等同于 Stop
+    ~GroupCommitWriter();
+
+    // 提交任务，立即返回；Stop 之后直接执行
+    void Post(const Task& task);
+
+    // 执行完已提交的任务、结束最后一批后返回，之后继续接受任务
+    void Flush();
+
+    // 执行完已提交的任务、结束最后一批后停止线程
+    // 回调和任务通常访问所有者的成员，所有者须在析构函数中先调用它
+    void Stop();
+
+private:
+    class Thread;
+    friend class Thread;
+
+    void Start();
+    void RunNow(const Task& task);
+
+    long m_batchMs;
+    Task m_beginBatch;
+    Task m_endBatch;
+    wxMessageQueue<Task> m_tasks;
+    Thread* m_thread;
+
+    GroupCommitWriter(const GroupCommitWriter&) = delete;
+    GroupCommitWriter& operator=(const GroupCommitWriter&) = delete;
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_GROUP_COMMIT_WRITER_H
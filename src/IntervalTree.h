@@ -0,0 +1,96 @@
+#ifndef MEETANT_INTERVAL_TREE_H
+#define MEETANT_INTERVAL_TREE_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace MeetAnt {
+
+// 静态区间树
+// 区间按起点排序后存放在数组中，以数组中点为根构成隐式平衡二叉树，
+// 每个节点记录其子树中最大的终点。查询与 [begin, end] 相交的区间为 O(log N + k)。
+// 区间为闭区间；内容变化时调用 Build 整体重建。
+template <typename Key, typename Value>
+class IntervalTree {
+public:
+    struct Entry {
+        Key begin;
+        Key end;
+        Value value;
+    };
+
+    void Build(std::vector<Entry> entries) {
+        m_entries = std::move(entries);
+        std::sort(m_entries.begin(), m_entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.begin < b.begin; });
+        m_maxEnd.assign(m_entries.size(), Key());
+        if (!m_entries.empty()) {
+            BuildMaxEnd(0, m_entries.size());
+        }
+    }
+
+    void Clear() {
+        m_entries.clear();
+        m_maxEnd.clear();
+    }
+
+    bool IsEmpty() const { return m_entries.empty(); }
+    size_t GetCount() const { return m_entries.size(); }
+
+    // 对每个与 [begin, end] 相交的区间调用 visit(const Entry&)
+    template <typename Visitor>
+    void Query(Key begin, Key end, Visitor visit) const {
+        if (!m_entries.empty()) {
+            QueryRange(0, m_entries.size(), begin, end, visit);
+        }
+    }
+
+private:
+    Key BuildMaxEnd(size_t lo, size_t hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        Key maxEnd = m_entries[mid].end;
+        if (lo < mid) {
+            maxEnd = std::max(maxEnd, BuildMaxEnd(lo, mid));
+        }
+        if (mid + 1 < hi) {
+            maxEnd = std::max(maxEnd, BuildMaxEnd(mid + 1, hi));
+        }
+        m_maxEnd[mid] = maxEnd;
+        return maxEnd;
+    }
+
+    template <typename Visitor>
+    void QueryRange(size_t lo, size_t hi, Key begin, Key end, Visitor& visit) const {
+        if (lo >= hi) {
+            return;
+        }
+
+        size_t mid = lo + (hi - lo) / 2;
+
+        // 子树中所有区间都在查询范围之前结束
+        if (m_maxEnd[mid] < begin) {
+            return;
+        }
+
+        QueryRange(lo, mid, begin, end, visit);
+
+        // 右侧区间的起点都不小于当前节点，当前起点已超出则右子树无需查找
+        if (end < m_entries[mid].begin) {
+            return;
+        }
+
+        if (!(m_entries[mid].end < begin)) {
+            visit(m_entries[mid]);
+        }
+
+        QueryRange(mid + 1, hi, begin, end, visit);
+    }
+
+    std::vector<Entry> m_entries;   // 按起点排序的区间
+    std::vector<Key> m_maxEnd;      // 以该位置为根的子树中的最大终点
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_INTERVAL_TREE_H
@@ -3,6 +3,7 @@
 #include "BookmarkDialog.h"
 #include "NoteDialog.h"
 #include "TranscriptionBubbleCtrl.h"  // 添加新控件头文件
+#include "TranscriptFile.h"
 #include <wx/sizer.h>
 #include <wx/menu.h>
 #include <wx/msgdlg.h>
@@ -61,6 +62,20 @@ typedef struct PaWasapiStreamInfo {
 } PaWasapiStreamInfo;
 #endif
 
+namespace {
+    // 语义搜索列出的结果数和每条结果显示的字数
+    const size_t kMaxSemanticResults = 20;
+    const size_t kSemanticSnippetLength = 40;
+    
+    // 搜索状态中列出的发言人数
+    const size_t kMaxFacetSpeakers = 2;
+    
+    // MP3录音在录制期间写入的临时WAV文件
+    wxString GetMP3SpoolPath(const wxString& audioFilePath) {
+        return audioFilePath + wxT(".temp.wav");
+    }
+}
+
 // 实现获取已移除会话列表文件路径的方法
 wxString MainFrame::GetRemovedSessionsFilePath() const {
     wxString sessionsDir = GetSessionsDirectory();
@@ -189,7 +204,7 @@ void MainFrame::LoadRemovedSessionsList() {
                     wxString sessionName = wxString::FromUTF8(line.c_str());
                     sessionName.Trim();
                     if (!sessionName.IsEmpty()) {
-                        m_removedSessions.push_back(sessionName);
+                        m_removedSessions.insert(sessionName.Lower());
                         sessionCount++;
                         wxLogDebug(wxT("添加已移除会话: %s"), sessionName);
                     }
@@ -214,7 +229,7 @@ void MainFrame::LoadRemovedSessionsList() {
         for (size_t i = 0; i < textFile.GetLineCount(); i++) {
             wxString sessionName = textFile.GetLine(i).Trim();
             if (!sessionName.IsEmpty()) {
-                m_removedSessions.push_back(sessionName);
+                m_removedSessions.insert(sessionName.Lower());
                 sessionCount++;
                 wxLogDebug(wxT("添加已移除会话: %s"), sessionName);
             }
@@ -292,7 +307,7 @@ void MainFrame::LoadRemovedSessionsList() {
         while (tokenizer.HasMoreTokens()) {
             wxString sessionName = tokenizer.GetNextToken().Trim();
             if (!sessionName.IsEmpty()) {
-                m_removedSessions.push_back(sessionName);
+                m_removedSessions.insert(sessionName.Lower());
                 sessionCount++;
                 wxLogDebug(wxT("添加已移除会话: %s"), sessionName);
             }
@@ -307,22 +322,11 @@ bool MainFrame::IsSessionRemoved(const wxString& sessionName) const {
     // 添加调试日志，显示正在检查的会话名称
     wxLogDebug(wxT("检查会话是否被移除: %s"), sessionName);
     
-    // 遍历已移除会话列表，进行更精确的比较（不区分大小写）
-    for (const auto& removedSession : m_removedSessions) {
-        if (sessionName.IsSameAs(removedSession, false)) { // false表示不区分大小写
-            wxLogDebug(wxT("会话已被移除: %s 匹配 %s"), sessionName, removedSession);
-            return true;
-        }
-    }
-    
-    // 如果使用标准算法查找
-    bool isRemoved = std::find_if(m_removedSessions.begin(), m_removedSessions.end(),
-        [&sessionName](const wxString& s) {
-            return sessionName.IsSameAs(s, false); // 不区分大小写比较
-        }) != m_removedSessions.end();
+    // 已移除列表中的名称已转为小写，不区分大小写比较
+    bool isRemoved = m_removedSessions.count(sessionName.Lower()) > 0;
     
     if (isRemoved) {
-        wxLogDebug(wxT("会话已被移除 (通过std::find): %s"), sessionName);
+        wxLogDebug(wxT("会话已被移除: %s"), sessionName);
     } else {
         wxLogDebug(wxT("会话未被移除: %s"), sessionName);
     }
@@ -440,6 +444,7 @@ wxBEGIN_EVENT_TABLE(MainFrame, wxFrame)
     EVT_BUTTON(ID_CreateSessionButton, MainFrame::OnCreateSession)
     EVT_TREE_SEL_CHANGED(ID_SessionTree, MainFrame::OnSessionSelected)
     EVT_TREE_SEL_CHANGED(ID_BookmarkTree, MainFrame::OnBookmarkSelected)
+    EVT_TREE_SEL_CHANGED(ID_SearchResultsTree, MainFrame::OnSearchResultSelected)
     EVT_TOOL(ID_Toolbar_Highlight_Yellow, MainFrame::OnHighlight)
     EVT_TOOL(ID_Toolbar_Highlight_Green, MainFrame::OnHighlight)
     EVT_TOOL(ID_Toolbar_Highlight_Blue, MainFrame::OnHighlight)
@@ -451,8 +456,12 @@ wxBEGIN_EVENT_TABLE(MainFrame, wxFrame)
     EVT_TEXT_ENTER(wxID_ANY, MainFrame::OnSearch)
     EVT_SEARCHCTRL_SEARCH_BTN(wxID_ANY, MainFrame::OnSearch)
     EVT_SEARCHCTRL_CANCEL_BTN(wxID_ANY, MainFrame::OnSearchCancel)
+    EVT_BUTTON(ID_SearchPrevButton, MainFrame::OnSearchPrev)
+    EVT_BUTTON(ID_SearchNextButton, MainFrame::OnSearchNext)
     // EVT_TREE_SEL_CHANGED(ID_AnnotationTree, MainFrame::OnAnnotationSelected)
     EVT_TREE_ITEM_RIGHT_CLICK(ID_SessionTree, MainFrame::OnSessionTreeContextMenu)
+    EVT_TREE_ITEM_GETTOOLTIP(ID_SessionTree, MainFrame::OnSessionTreeGetTooltip)
+    EVT_TREE_ITEM_EXPANDING(ID_SessionTree, MainFrame::OnSessionTreeExpanding)
     EVT_TIMER(wxID_ANY, MainFrame::OnAudioSaveTimer)
 wxEND_EVENT_TABLE()
 
@@ -522,7 +531,22 @@ MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& si
     m_searchCtrl = new wxSearchCtrl(sessionsPage, wxID_ANY, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
     m_searchCtrl->ShowSearchButton(true);
     m_searchCtrl->ShowCancelButton(true);
-    sessionPageSizer->Add(m_searchCtrl, 0, wxALL | wxEXPAND, 5);
+    
+    // 在会话内的搜索结果之间跳转
+    wxBoxSizer* searchSizer = new wxBoxSizer(wxHORIZONTAL);
+    searchSizer->Add(m_searchCtrl, 1, wxALIGN_CENTER_VERTICAL);
+    m_searchPrevButton = new wxButton(sessionsPage, ID_SearchPrevButton, wxT("↑"), wxDefaultPosition, wxDefaultSize, wxBU_EXACTFIT);
+    m_searchPrevButton->SetToolTip(wxT("上一个匹配项"));
+    m_searchNextButton = new wxButton(sessionsPage, ID_SearchNextButton, wxT("↓"), wxDefaultPosition, wxDefaultSize, wxBU_EXACTFIT);
+    m_searchNextButton->SetToolTip(wxT("下一个匹配项"));
+    m_searchPrevButton->Disable();
+    m_searchNextButton->Disable();
+    searchSizer->Add(m_searchPrevButton, 0, wxLEFT | wxALIGN_CENTER_VERTICAL, 2);
+    searchSizer->Add(m_searchNextButton, 0, wxLEFT | wxALIGN_CENTER_VERTICAL, 2);
+    sessionPageSizer->Add(searchSizer, 0, wxALL | wxEXPAND, 5);
+    
+    // 输入和选项变化时立即在后台重新搜索
+    m_searchCtrl->Bind(wxEVT_TEXT, &MainFrame::OnSearchTextChanged, this);
     
     // 添加搜索高级选项
     wxBoxSizer* searchOptionsSizer = new wxBoxSizer(wxHORIZONTAL);
@@ -531,6 +555,16 @@ MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& si
     m_useRegexCheckBox = new wxCheckBox(sessionsPage, wxID_ANY, wxT("使用正则表达式"));
     searchOptionsSizer->Add(m_useRegexCheckBox, 0, wxALL | wxALIGN_CENTER_VERTICAL, 2);
     
+    // 拼音模糊匹配，容忍转录中的同音字和近音字错误
+    m_fuzzySearchCheckBox = new wxCheckBox(sessionsPage, wxID_ANY, wxT("拼音模糊"));
+    m_fuzzySearchCheckBox->SetToolTip(wxT("按拼音匹配，同音字和近音字也能搜到"));
+    searchOptionsSizer->Add(m_fuzzySearchCheckBox, 0, wxALL | wxALIGN_CENTER_VERTICAL, 2);
+    
+    // 用本地句向量模型按意思搜索当前会话，回车后执行
+    m_semanticSearchCheckBox = new wxCheckBox(sessionsPage, wxID_ANY, wxT("语义搜索"));
+    m_semanticSearchCheckBox->SetToolTip(wxT("按意思查找相近的发言，不要求字面相同"));
+    searchOptionsSizer->Add(m_semanticSearchCheckBox, 0, wxALL | wxALIGN_CENTER_VERTICAL, 2);
+    
     // 添加发言人过滤选项
     wxStaticText* speakerLabel = new wxStaticText(sessionsPage, wxID_ANY, wxT("按发言人:"));
     searchOptionsSizer->Add(speakerLabel, 0, wxALL | wxALIGN_CENTER_VERTICAL, 2);
@@ -540,9 +574,36 @@ MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& si
     m_speakerFilterComboBox->Append(wxT("全部"));
     searchOptionsSizer->Add(m_speakerFilterComboBox, 1, wxALL, 2);
     
+    m_useRegexCheckBox->Bind(wxEVT_CHECKBOX, &MainFrame::OnSearchOptionChanged, this);
+    m_fuzzySearchCheckBox->Bind(wxEVT_CHECKBOX, &MainFrame::OnSearchOptionChanged, this);
+    m_semanticSearchCheckBox->Bind(wxEVT_CHECKBOX, &MainFrame::OnSearchOptionChanged, this);
+    m_speakerFilterComboBox->Bind(wxEVT_COMBOBOX, &MainFrame::OnSearchOptionChanged, this);
+    
     sessionPageSizer->Add(searchOptionsSizer, 0, wxALL | wxEXPAND, 5);
     
-    // 会话历史树
+    // 跨会话搜索选项和结果树（有结果时才显示）
+    m_searchAllSessionsCheckBox = new wxCheckBox(sessionsPage, wxID_ANY, wxT("搜索所有会话"));
+    sessionPageSizer->Add(m_searchAllSessionsCheckBox, 0, wxLEFT | wxRIGHT, 7);
+    
+    m_searchResultsTree = new wxTreeCtrl(sessionsPage, ID_SearchResultsTree, wxDefaultPosition, wxSize(-1, 200),
+                                         wxTR_DEFAULT_STYLE | wxTR_HIDE_ROOT | wxTR_FULL_ROW_HIGHLIGHT);
+    m_searchResultsTree->AddRoot(wxT("搜索结果"));
+    m_searchResultsTree->Hide();
+    sessionPageSizer->Add(m_searchResultsTree, 1, wxALL | wxEXPAND, 5);
+    
+    // 会话过滤：按会话名称或发言人
+    m_sessionFilterCtrl = new wxSearchCtrl(sessionsPage, wxID_ANY);
+    m_sessionFilterCtrl->SetDescriptiveText(wxT("过滤会话（名称或发言人）"));
+    m_sessionFilterCtrl->ShowCancelButton(true);
+    m_sessionFilterCtrl->Bind(wxEVT_TEXT, &MainFrame::OnSessionFilterChanged, this);
+    m_sessionFilterCtrl->Bind(wxEVT_SEARCHCTRL_CANCEL_BTN, [this](wxCommandEvent&) {
+        m_sessionFilterCtrl->Clear();
+    });
+    // 输入时已经过滤，回车和搜索按钮在这里消费掉，不传到事件表中的转录搜索（OnSearch）
+    m_sessionFilterCtrl->Bind(wxEVT_SEARCHCTRL_SEARCH_BTN, [](wxCommandEvent&) {});
+    sessionPageSizer->Add(m_sessionFilterCtrl, 0, wxLEFT | wxRIGHT | wxTOP | wxEXPAND, 5);
+    
+    // 会话历史树（按月或按周分组，分组展开时才创建其中的会话节点）
     m_sessionTree = new wxTreeCtrl(sessionsPage, ID_SessionTree, wxDefaultPosition, wxDefaultSize, 
                                   wxTR_DEFAULT_STYLE | wxTR_HIDE_ROOT | wxTR_FULL_ROW_HIGHLIGHT);
     sessionPageSizer->Add(m_sessionTree, 1, wxALL | wxEXPAND, 5);
@@ -589,10 +650,13 @@ MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& si
     // 绑定播放控制条事件
     Bind(wxEVT_PLAYBACK_POSITION_CHANGED, &MainFrame::OnPlaybackPositionChanged, this);
     Bind(wxEVT_PLAYBACK_STATE_CHANGED, &MainFrame::OnPlaybackStateChanged, this);
+    Bind(wxEVT_PLAYBACK_DENSITY_CLICKED, &MainFrame::OnPlaybackDensityClicked, this);
     
     // 绑定气泡控件事件
     Bind(wxEVT_TRANSCRIPTION_MESSAGE_CLICKED, &MainFrame::OnTranscriptionMessageClicked, this);
     Bind(wxEVT_TRANSCRIPTION_MESSAGE_RIGHT_CLICKED, &MainFrame::OnTranscriptionMessageRightClicked, this);
+    Bind(wxEVT_TRANSCRIPTION_SEARCH_UPDATED, &MainFrame::OnTranscriptionSearchUpdated, this);
+    Bind(wxEVT_TRANSCRIPTION_LOADED, &MainFrame::OnTranscriptionLoaded, this);
 
     // --- 创建批注面板 ---
     m_annotationPanel = new wxPanel(m_editorAnnotationSplitter, wxID_ANY);
@@ -698,6 +762,23 @@ MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& si
     // 初始化批注管理器
     InitAnnotationManager();
     
+    // 会话目录：启动时用缓存的元数据填充会话列表，过期的会话在后台重新扫描
+    m_rebuildingSessionTree = false;
+    m_sessionGrouping = SessionGrouping::Month;
+    m_sessionSortKey = SessionSortKey::CreationTime;
+    m_sessionCatalog.reset(new MeetAnt::SessionCatalog(GetSessionsDirectory()));
+    Bind(wxEVT_SESSION_CATALOG_UPDATED, &MainFrame::OnSessionCatalogUpdated, this);
+    Bind(wxEVT_SESSION_CATALOG_DONE, &MainFrame::OnSessionCatalogDone, this);
+    
+    // 会话归档：打开的会话先排除在外，所以要在加载会话之前创建
+    m_sessionArchive.reset(new MeetAnt::SessionArchiveManager());
+    Bind(wxEVT_SESSION_ARCHIVED, &MainFrame::OnSessionArchived, this);
+    Bind(wxEVT_SESSION_ARCHIVE_DONE, &MainFrame::OnSessionArchiveDone, this);
+    
+    // 自动保存：转录、批注和会话信息变化时只做标记，按系统设置的间隔或空闲时合并保存
+    m_autosave.reset(new MeetAnt::AutosaveScheduler([this](unsigned parts) { SaveSessionParts(parts); }));
+    LoadAutosaveConfig();
+    
     // 加载会话
     LoadSessions();
     
@@ -729,16 +810,18 @@ MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& si
             m_sessions.push_back(newSession);
             
             // 添加到会话树
-            wxTreeItemId rootId = m_sessionTree->GetRootItem();
-            wxTreeItemId newItemId = m_sessionTree->AppendItem(rootId, sessionName);
-            m_sessionTree->SelectItem(newItemId);
+            RefreshSessionTree();
+            SelectSessionInTree(sessionName);
             
             SetStatusText(wxString::Format(wxT("已创建默认会话: %s"), sessionName));
         }
     }
     
-    // 添加测试对话数据
-    AddTestTranscriptionData();
+    // 当前会话没有转录内容时添加测试对话数据（先等启动时选中的会话读完转录）
+    m_transcriptionBubbleCtrl->FinishLoad();
+    if (m_transcriptionBubbleCtrl->GetMessageCount() == 0) {
+        AddTestTranscriptionData();
+    }
     
     // 初始化PortAudio
     InitializePortAudio();
@@ -786,14 +869,70 @@ MainFrame::MainFrame(const wxString& title, const wxPoint& pos, const wxSize& si
     
     // 绑定AI超时定时器事件
     this->Bind(wxEVT_TIMER, &MainFrame::OnAIRequestTimeout, this);
+    
+    // 跨会话搜索：各会话索引保存在会话目录中，查询在线程池中并行执行
+    m_sessionSearchRequest = 0;
+    m_sessionSearchHitCount = 0;
+    m_sessionSearch.reset(new MeetAnt::SessionSearchManager(GetSessionsDirectory()));
+    Bind(wxEVT_SESSION_SEARCH_RESULT, &MainFrame::OnSessionSearchResult, this);
+    Bind(wxEVT_SESSION_SEARCH_DONE, &MainFrame::OnSessionSearchDone, this);
+    
+    // 语义搜索：模型放在配置目录的 models/embedding/ 下，缺少模型或未编译 ONNX Runtime 时禁用
+    m_semanticSearchRequest = 0;
+    m_semanticSearch.reset(new MeetAnt::SemanticSearchManager(GetEmbeddingModelDirectory()));
+    Bind(wxEVT_SEMANTIC_SEARCH_RESULT, &MainFrame::OnSemanticSearchResult, this);
+    if (!m_semanticSearch->IsAvailable()) {
+        m_semanticSearchCheckBox->Disable();
+        m_semanticSearchCheckBox->SetToolTip(wxString::Format(
+            MeetAnt::EmbeddingModel::IsSupported()
+                ? wxT("未找到句向量模型，请将 model.onnx 和 vocab.txt 放到 %s")
+                : wxT("当前版本未启用语义搜索（%s）"),
+            GetEmbeddingModelDirectory()));
+    } else if (!m_currentSessionPath.IsEmpty()) {
+        m_semanticSearch->OpenSession(m_currentSessionId, m_currentSessionPath,
+                                      m_transcriptionBubbleCtrl->CopyMessages());
+    }
+    
+    // 上次录制中异常退出的会话：修复录音，补回恢复日志中的内容并重新打开
+    RecoverUnfinishedSessions();
+    
+    // 在后台归档长期未修改的会话
+    LoadArchiveConfig();
 }
 
 MainFrame::~MainFrame() {
+    // 保存当前会话尚未写入的变化
+    if (m_autosave) {
+        m_autosave->Flush();
+        m_autosave.reset();
+    }
+    
+    // 先停止搜索线程池和会话目录线程，之后不会再有事件投递到本窗口
+    if (m_sessionSearch) {
+        m_sessionSearch->Shutdown();
+        m_sessionSearch.reset();
+    }
+    if (m_sessionArchive) {
+        m_sessionArchive->Shutdown();
+        m_sessionArchive.reset();
+    }
+    if (m_sessionCatalog) {
+        m_sessionCatalog->Shutdown();
+        m_sessionCatalog.reset();
+    }
+    if (m_semanticSearch) {
+        m_semanticSearch->Shutdown();
+        m_semanticSearch.reset();
+    }
+    
     // 停止录制（如果正在录制）
     if (m_isRecording) {
         StopAudioCapture();
         StopAudioRecording();
     }
+    if (m_recoveryLog) {
+        FinishRecoveryLog(m_recoveryLog->GetSessionPath());
+    }
     
     // 清理音频保存相关资源
     if (m_audioSaveTimer) {
@@ -962,6 +1101,28 @@ void MainFrame::CreateToolBar() {
 void MainFrame::InitAnnotationManager() {
     m_annotationManager = std::make_unique<MeetAnt::AnnotationManager>();
     
+    // 已归档的会话不还原，批注直接从归档中读取
+    m_annotationManager->SetArchiveReader(&MeetAnt::SessionArchive::ReadMember);
+    
+    // 每次修改按批注编号写入会话数据库，保存时不再整体重写；录制中同时记入恢复日志
+    m_annotationManager->SetChangeListener([this](const std::string& record) {
+        if (OpenSessionStore()) {
+            m_sessionStore->ApplyAnnotationChanges(std::vector<std::string>(1, record));
+        }
+        if (m_recoveryLog && m_recoveryLog->GetSessionPath() == m_currentSessionPath) {
+            m_recoveryLog->AppendAnnotationChange(record);
+        }
+    });
+    
+    // 气泡控件只查询可视时间段内的批注
+    m_transcriptionBubbleCtrl->SetAnnotationSource(
+        [this](MeetAnt::TimeStamp begin, MeetAnt::TimeStamp end) {
+            if (!m_annotationManager || m_currentSessionId.IsEmpty()) {
+                return std::vector<MeetAnt::Annotation*>();
+            }
+            return m_annotationManager->GetAnnotationsByTimeRange(m_currentSessionId, begin, end);
+        });
+    
     // 动态绑定滚动事件
     m_transcriptionBubbleCtrl->Bind(wxEVT_SCROLLWIN_THUMBTRACK, 
                                 [this](wxScrollWinEvent& event){ 
@@ -984,6 +1145,7 @@ void MainFrame::LoadBookmarks() {
     
     // 当前没有会话时不加载书签
     if (m_currentSessionPath.IsEmpty()) {
+        SyncInlineAnnotations();
         return;
     }
     
@@ -995,6 +1157,8 @@ void MainFrame::LoadBookmarks() {
     for (auto bookmark : bookmarks) {
         AddBookmarkToTree(bookmark);
     }
+    
+    SyncInlineAnnotations();
 }
 
 void MainFrame::AddBookmarkToTree(MeetAnt::BookmarkAnnotation* bookmark) {
@@ -1049,9 +1213,10 @@ void MainFrame::CreateBookmark(const wxString& label, const wxString& descriptio
     
     // 添加到书签树
     AddBookmarkToTree(bookmarkPtr);
+    SyncInlineAnnotations();
     
-    // 保存批注
-    m_annotationManager->SaveAnnotations(m_currentSessionPath);
+    // 标记批注已变化，由自动保存写入
+    MarkSessionDirty(MeetAnt::AutosaveAnnotations);
 }
 
 void MainFrame::CreateNote(const wxString& title, const wxString& content, MeetAnt::TimeStamp timestamp) {
@@ -1068,12 +1233,13 @@ void MainFrame::CreateNote(const wxString& title, const wxString& content, MeetA
     MeetAnt::NoteAnnotation* notePtr = note.get();
     
     m_annotationManager->AddAnnotation(std::move(note));
+    SyncInlineAnnotations();
     
     // 显示批注弹窗
     ShowNotePopup(notePtr);
     
-    // 保存批注
-    m_annotationManager->SaveAnnotations(m_currentSessionPath);
+    // 标记批注已变化，由自动保存写入
+    MarkSessionDirty(MeetAnt::AutosaveAnnotations);
 }
 
 void MainFrame::ApplyHighlight(const wxColour& color) {
@@ -1082,23 +1248,22 @@ void MainFrame::ApplyHighlight(const wxColour& color) {
         m_transcriptionBubbleCtrl->HighlightMessage(m_selectedTranscriptionMessageId, true);
         
         // 获取消息内容用于创建高亮批注
-        const auto& messages = m_transcriptionBubbleCtrl->GetMessages();
-        for (const auto& msg : messages) {
-            if (msg.messageId == m_selectedTranscriptionMessageId) {
-                // 获取当前时间戳
-                MeetAnt::TimeStamp timestamp = msg.timestamp.GetTicks() * 1000; // 转换为毫秒
+        int index = m_transcriptionBubbleCtrl->FindMessageIndex(m_selectedTranscriptionMessageId);
+        TranscriptionMessage msg;
+        if (index >= 0 && m_transcriptionBubbleCtrl->GetMessageAt(index, msg)) {
+            // 获取当前时间戳
+            MeetAnt::TimeStamp timestamp = msg.timestamp.GetTicks() * 1000; // 转换为毫秒
+            
+            // 创建高亮批注并加入管理器
+            if (!m_currentSessionId.IsEmpty()) {
+                auto highlight = std::make_unique<MeetAnt::HighlightAnnotation>(
+                    m_currentSessionId, timestamp, msg.content, color);
                 
-                // 创建高亮批注并加入管理器
-                if (!m_currentSessionId.IsEmpty()) {
-                    auto highlight = std::make_unique<MeetAnt::HighlightAnnotation>(
-                        m_currentSessionId, timestamp, msg.content, color);
-                    
-                    m_annotationManager->AddAnnotation(std::move(highlight));
-                    
-                    // 保存批注
-                    m_annotationManager->SaveAnnotations(m_currentSessionPath);
-                }
-                break;
+                m_annotationManager->AddAnnotation(std::move(highlight));
+                SyncInlineAnnotations();
+                
+                // 标记批注已变化，由自动保存写入
+                MarkSessionDirty(MeetAnt::AutosaveAnnotations);
             }
         }
     } else {
@@ -1127,6 +1292,16 @@ void MainFrame::ShowNotePopup(MeetAnt::NoteAnnotation* note) {
     m_activeNotePopups.push_back(popup);
 }
 
+void MainFrame::SaveEditedNote(MeetAnt::NoteAnnotation* note) {
+    if (!note || !m_annotationManager || m_currentSessionPath.IsEmpty()) {
+        return;
+    }
+    
+    m_annotationManager->UpdateAnnotation(note);
+    MarkSessionDirty(MeetAnt::AutosaveAnnotations);
+    SyncInlineAnnotations();
+}
+
 void MainFrame::JumpToTimestamp(MeetAnt::TimeStamp timestamp) {
     // 在实际应用中，这个方法应该跳转到音频文件的特定时间点
     // 并且可能需要滚动文本编辑器到相应位置
@@ -1191,10 +1366,15 @@ void MainFrame::OnBookmark(wxCommandEvent& event) {
                 // 更新状态栏
                 SetStatusText(wxString::Format(wxT("已创建默认会话: %s"), sessionName));
                 
-                // 可以选择将新会话添加到会话树中
-                wxTreeItemId rootId = m_sessionTree->GetRootItem();
-                wxTreeItemId newItemId = m_sessionTree->AppendItem(rootId, sessionName);
-                m_sessionTree->SelectItem(newItemId);
+                // 将新会话添加到会话列表和会话树中
+                SessionItem newSession;
+                newSession.name = sessionName;
+                newSession.path = sessionPath;
+                newSession.creationTime = now;
+                newSession.isActive = false;
+                m_sessions.push_back(newSession);
+                RefreshSessionTree();
+                SelectSessionInTree(sessionName);
             } else {
                 wxMessageBox(wxT("无法创建会话目录"), wxT("错误"), wxICON_ERROR);
                 return;
@@ -1209,12 +1389,9 @@ void MainFrame::OnBookmark(wxCommandEvent& event) {
     MeetAnt::TimeStamp currentTime;
     if (m_selectedTranscriptionMessageId > 0) {
         // 查找选中消息的时间戳
-        const auto& messages = m_transcriptionBubbleCtrl->GetMessages();
-        for (const auto& msg : messages) {
-            if (msg.messageId == m_selectedTranscriptionMessageId) {
-                currentTime = msg.timestamp.GetTicks() * 1000; // 转换为毫秒
-                break;
-            }
+        int index = m_transcriptionBubbleCtrl->FindMessageIndex(m_selectedTranscriptionMessageId);
+        if (index >= 0) {
+            currentTime = m_transcriptionBubbleCtrl->GetMessageTimestamp(index).GetTicks() * 1000; // 转换为毫秒
         }
     } else {
         // 使用当前时间
@@ -1242,13 +1419,20 @@ void MainFrame::OnSessionSelected(wxTreeEvent& event) {
         return;
     }
     
-    // 获取选中的会话名称
-    wxString sessionName = m_sessionTree->GetItemText(itemId);
+    // 重建会话树时不重新加载会话
+    if (m_rebuildingSessionTree) {
+        return;
+    }
     
-    // 如果会话名称前面有星号（表示活动会话），去掉星号和空格
-    if (sessionName.StartsWith(wxT("* "))) {
-        sessionName = sessionName.Mid(2);
+    // 获取选中的会话名称（选中分组节点时不切换会话）
+    SessionTreeItemData* data = dynamic_cast<SessionTreeItemData*>(m_sessionTree->GetItemData(itemId));
+    if (!data || data->sessionName.IsEmpty()) {
+        return;
     }
+    wxString sessionName = data->sessionName;
+    
+    // 切换前保存当前会话尚未写入的变化
+    m_autosave->Flush();
     
     // 查找对应的会话数据
     bool sessionFound = false;
@@ -1259,7 +1443,14 @@ void MainFrame::OnSessionSelected(wxTreeEvent& event) {
             m_currentSessionPath = session.path;
             sessionFound = true;
             
-            // 加载会话内容和批注
+            // 打开的会话本次运行不再归档；已归档的会话不还原，转录和批注直接从归档中读取，录音留在归档中
+            if (m_sessionArchive) {
+                m_sessionArchive->ExcludeSession(m_currentSessionPath);
+            }
+            
+            // 在后台读取会话内容，读完后在 OnTranscriptionLoaded 中更新发言人、句向量和搜索
+            LoadSessionTranscript(m_currentSessionPath);
+            
             if (m_annotationManager) {
                 // 加载和显示批注
                 m_annotationManager->LoadAnnotations(m_currentSessionPath);
@@ -1377,14 +1568,14 @@ void MainFrame::OnCreateSession(wxCommandEvent& event) {
     // 添加到会话列表
     m_sessions.push_back(newSession);
     
-    // 设置为当前会话
+    // 设置为当前会话（先保存原会话尚未写入的变化）
+    m_autosave->Flush();
     m_currentSessionId = sessionName;
     m_currentSessionPath = sessionPath;
     
     // 添加到会话树并选中
-    wxTreeItemId rootId = m_sessionTree->GetRootItem();
-    wxTreeItemId newItemId = m_sessionTree->AppendItem(rootId, wxString::Format(wxT("* %s"), sessionName));
-    m_sessionTree->SelectItem(newItemId);
+    RefreshSessionTree();
+    SelectSessionInTree(sessionName);
     
     // 确保批注管理器已初始化
     if (!m_annotationManager) {
@@ -1439,32 +1630,432 @@ void MainFrame::OnSearch(wxCommandEvent& event) {
         return;
     }
     
-    // 使用新控件的搜索功能
-    bool useRegex = m_useRegexCheckBox->GetValue();
+    // 语义搜索只在当前会话中进行，结果按相似度列在结果树中
+    if (m_semanticSearchCheckBox->GetValue()) {
+        StartSemanticSearch(searchQuery);
+        return;
+    }
+    
+    TranscriptionSearchMode mode = GetSearchMode();
+    wxString speaker = GetSearchSpeakerFilter();
+    
+    // 跨会话搜索在后台执行，结果按会话分组显示在结果树中
+    if (m_searchAllSessionsCheckBox->GetValue()) {
+        StartSessionSearch(searchQuery, mode, speaker);
+        return;
+    }
+    
+    // 会话内搜索已随输入执行，同一查询再次回车时跳到下一个结果
+    wxString key = wxString::Format(wxT("%d|%s|%s"), static_cast<int>(mode), speaker, searchQuery);
+    if (key == m_inSessionSearchKey && m_transcriptionBubbleCtrl->GetSearchResultCount() > 0) {
+        m_transcriptionBubbleCtrl->GotoNextSearchResult();
+        UpdateInSessionSearchStatus();
+        return;
+    }
+    StartInSessionSearch();
+}
+
+TranscriptionSearchMode MainFrame::GetSearchMode() const {
+    if (m_fuzzySearchCheckBox->GetValue()) {
+        return TranscriptionSearchMode::Fuzzy;
+    }
+    if (m_useRegexCheckBox->GetValue()) {
+        return TranscriptionSearchMode::Regex;
+    }
+    return TranscriptionSearchMode::Text;
+}
+
+wxString MainFrame::GetSearchSpeakerFilter() const {
     wxString speaker = m_speakerFilterComboBox->GetValue();
+    if (speaker == wxT("全部")) {
+        speaker.clear();
+    }
+    return speaker;
+}
+
+void MainFrame::StartInSessionSearch() {
+    wxString searchQuery = m_searchCtrl->GetValue();
+    TranscriptionSearchMode mode = GetSearchMode();
+    wxString speaker = GetSearchSpeakerFilter();
     
-    // 执行搜索
-    std::vector<int> results = m_transcriptionBubbleCtrl->SearchText(searchQuery, false);
+    m_inSessionSearchKey = wxString::Format(wxT("%d|%s|%s"), static_cast<int>(mode), speaker, searchQuery);
+    if (searchQuery.IsEmpty()) {
+        m_transcriptionBubbleCtrl->CancelSearch();
+        m_playbackControlBar->ClearSearchHits();
+        m_searchPrevButton->Disable();
+        m_searchNextButton->Disable();
+        SetStatusText(wxEmptyString);
+        return;
+    }
     
-    if (!results.empty()) {
-        // 滚动到第一个结果
-        m_transcriptionBubbleCtrl->ScrollToMessage(results[0]);
-        m_transcriptionBubbleCtrl->HighlightMessage(results[0], true);
-        
-        SetStatusText(wxString::Format(wxT("找到 %zu 个匹配项"), results.size()));
+    // 立即返回，结果通过 wxEVT_TRANSCRIPTION_SEARCH_UPDATED 分批送达
+    m_transcriptionBubbleCtrl->StartSearch(searchQuery, false, mode, speaker);
+}
+
+void MainFrame::OnSearchTextChanged(wxCommandEvent& event) {
+    event.Skip();
+    
+    // 跨会话搜索和语义搜索开销较大，只在回车时执行
+    if (m_searchAllSessionsCheckBox->GetValue() || m_semanticSearchCheckBox->GetValue()) {
+        return;
+    }
+    StartInSessionSearch();
+}
+
+void MainFrame::OnSearchOptionChanged(wxCommandEvent& event) {
+    // 正则、拼音模糊匹配和语义搜索互斥
+    wxObject* source = event.GetEventObject();
+    if (source == m_useRegexCheckBox && m_useRegexCheckBox->GetValue()) {
+        m_fuzzySearchCheckBox->SetValue(false);
+        m_semanticSearchCheckBox->SetValue(false);
+    } else if (source == m_fuzzySearchCheckBox && m_fuzzySearchCheckBox->GetValue()) {
+        m_useRegexCheckBox->SetValue(false);
+        m_semanticSearchCheckBox->SetValue(false);
+    } else if (source == m_semanticSearchCheckBox && m_semanticSearchCheckBox->GetValue()) {
+        m_useRegexCheckBox->SetValue(false);
+        m_fuzzySearchCheckBox->SetValue(false);
+        m_transcriptionBubbleCtrl->CancelSearch();
+        m_playbackControlBar->ClearSearchHits();
+        m_inSessionSearchKey.clear();
+        m_searchPrevButton->Disable();
+        m_searchNextButton->Disable();
+    }
+    
+    if (m_searchAllSessionsCheckBox->GetValue() || m_semanticSearchCheckBox->GetValue() ||
+        m_searchCtrl->GetValue().IsEmpty()) {
+        return;
+    }
+    StartInSessionSearch();
+}
+
+void MainFrame::OnSearchPrev(wxCommandEvent& event) {
+    if (m_transcriptionBubbleCtrl->GotoPreviousSearchResult() >= 0) {
+        UpdateInSessionSearchStatus();
+    }
+}
+
+void MainFrame::OnSearchNext(wxCommandEvent& event) {
+    if (m_transcriptionBubbleCtrl->GotoNextSearchResult() >= 0) {
+        UpdateInSessionSearchStatus();
+    }
+}
+
+void MainFrame::OnTranscriptionSearchUpdated(wxCommandEvent& event) {
+    UpdateInSessionSearchStatus();
+}
+
+void MainFrame::UpdateInSessionSearchStatus() {
+    size_t count = m_transcriptionBubbleCtrl->GetSearchResultCount();
+    bool pending = m_transcriptionBubbleCtrl->IsSearchPending();
+    const wxString& error = m_transcriptionBubbleCtrl->GetLastSearchError();
+    
+    m_searchPrevButton->Enable(count > 0);
+    m_searchNextButton->Enable(count > 0);
+    UpdateSearchHitDensity();
+    
+    if (!error.IsEmpty()) {
+        SetStatusText(wxString::Format(wxT("正则表达式无效: %s"), error));
+    } else if (count > 0) {
+        wxString status = wxString::Format(wxT("找到 %zu 个匹配项（第 %d 个）"), count,
+                                           m_transcriptionBubbleCtrl->GetCurrentSearchResult() + 1);
+        status += FormatSearchFacets(m_transcriptionBubbleCtrl->GetSearchFacets());
+        if (pending) {
+            status += wxT("，正在搜索...");
+        }
+        SetStatusText(status);
+    } else if (pending) {
+        SetStatusText(wxT("正在搜索..."));
     } else {
         SetStatusText(wxT("未找到匹配项"));
     }
 }
 
+wxString MainFrame::FormatSearchFacets(const TranscriptionSearchFacets& facets) const {
+    wxString summary;
+    
+    // 命中最多的几位发言人
+    std::vector<std::pair<size_t, int>> speakers;
+    for (size_t id = 0; id < facets.speakerHits.size(); ++id) {
+        if (facets.speakerHits[id] > 0) {
+            speakers.push_back(std::make_pair(facets.speakerHits[id], static_cast<int>(id)));
+        }
+    }
+    std::sort(speakers.begin(), speakers.end(),
+        [](const std::pair<size_t, int>& a, const std::pair<size_t, int>& b) { return a.first > b.first; });
+    for (size_t i = 0; i < speakers.size() && i < kMaxFacetSpeakers; ++i) {
+        summary += wxString::Format(wxT("%s%s %zu"), i == 0 ? wxT(" | ") : wxT("，"),
+                                    m_transcriptionBubbleCtrl->GetSpeakerName(speakers[i].second), speakers[i].first);
+    }
+    
+    // 命中最集中的时间段
+    auto densest = std::max_element(facets.timeBucketHits.begin(), facets.timeBucketHits.end());
+    if (densest != facets.timeBucketHits.end() && *densest > 0) {
+        long minutes = static_cast<long>((densest - facets.timeBucketHits.begin()) *
+                                         (TranscriptionSearchFacets::kTimeBucketLength / 60000));
+        summary += wxString::Format(wxT(" | 最集中: %02ld:%02ld 起 %zu 条"), minutes / 60, minutes % 60, *densest);
+    }
+    
+    // 附近有批注的命中
+    size_t annotated = 0;
+    for (size_t type = 0; type < MeetAnt::kAnnotationTypeCount; ++type) {
+        annotated += facets.annotationHits[type];
+    }
+    if (annotated > 0) {
+        summary += wxString::Format(wxT(" | 批注附近: 高亮 %zu，笔记 %zu，书签 %zu"),
+            facets.annotationHits[static_cast<size_t>(MeetAnt::AnnotationType::Highlight)],
+            facets.annotationHits[static_cast<size_t>(MeetAnt::AnnotationType::Note)],
+            facets.annotationHits[static_cast<size_t>(MeetAnt::AnnotationType::Bookmark)]);
+    }
+    return summary;
+}
+
+void MainFrame::UpdateSearchHitDensity() {
+    const TranscriptionSearchFacets& facets = m_transcriptionBubbleCtrl->GetSearchFacets();
+    size_t messageCount = m_transcriptionBubbleCtrl->GetMessageCount();
+    if (facets.hitOffsets.empty() || messageCount == 0) {
+        m_playbackControlBar->ClearSearchHits();
+        return;
+    }
+    
+    // 命中时间相对于首条消息；没有音频时以首尾消息的间隔作为时间轴
+    std::vector<int> hits;
+    hits.reserve(facets.hitOffsets.size());
+    for (MeetAnt::TimeStamp offset : facets.hitOffsets) {
+        hits.push_back(static_cast<int>(offset));
+    }
+    wxTimeSpan span = m_transcriptionBubbleCtrl->GetMessageTimestamp(messageCount - 1) -
+                      m_transcriptionBubbleCtrl->GetMessageTimestamp(0);
+    m_playbackControlBar->SetSearchHits(hits, std::max(1, static_cast<int>(span.GetMilliseconds().ToLong())));
+}
+
+void MainFrame::OnPlaybackDensityClicked(wxCommandEvent& event) {
+    if (m_transcriptionBubbleCtrl->GotoSearchResultAt(event.GetInt()) >= 0) {
+        UpdateInSessionSearchStatus();
+    }
+}
+
+void MainFrame::UpdateSpeakerFilterChoices() {
+    // 保留当前选择（如果新会话中仍有该发言人）
+    wxString selected = m_speakerFilterComboBox->GetValue();
+    
+    m_speakerFilterComboBox->Clear();
+    m_speakerFilterComboBox->Append(wxT("全部"));
+    for (const auto& name : m_transcriptionBubbleCtrl->GetSpeakerNames()) {
+        m_speakerFilterComboBox->Append(name);
+    }
+    
+    int index = m_speakerFilterComboBox->FindString(selected);
+    m_speakerFilterComboBox->SetSelection(index != wxNOT_FOUND ? index : 0);
+}
+
 void MainFrame::OnSearchCancel(wxCommandEvent& event) {
     // 取消搜索，清空搜索框
     m_searchCtrl->Clear();
+    ClearSessionSearchResults();
+    m_transcriptionBubbleCtrl->CancelSearch();
+    m_playbackControlBar->ClearSearchHits();
+    m_inSessionSearchKey.clear();
+    m_searchPrevButton->Disable();
+    m_searchNextButton->Disable();
     
-    // TODO: 重置搜索结果等
     SetStatusText(wxT("搜索已取消"));
 }
 
+void MainFrame::StartSessionSearch(const wxString& query, TranscriptionSearchMode mode, const wxString& speaker) {
+    if (!m_sessionSearch) {
+        return;
+    }
+    
+    MeetAnt::SessionSearchQuery searchQuery;
+    searchQuery.text = query;
+    searchQuery.speaker = speaker;
+    if (mode == TranscriptionSearchMode::Fuzzy) {
+        auto fuzzy = std::make_shared<MeetAnt::FuzzyQuery>();
+        if (!fuzzy->Compile(query.ToStdWstring())) {
+            SetStatusText(wxT("未找到匹配项"));
+            return;
+        }
+        searchQuery.fuzzy = fuzzy;
+    } else if (mode == TranscriptionSearchMode::Regex) {
+        // 正则只编译一次，由所有会话的搜索任务共享
+        auto regex = std::make_shared<MeetAnt::RegexQuery>();
+        if (!regex->Compile(query.ToStdWstring(), false)) {
+            SetStatusText(wxString::Format(wxT("正则表达式无效: %s"), wxString(regex->GetError())));
+            return;
+        }
+        searchQuery.regex = regex;
+    }
+    
+    ClearSessionSearchResults();
+    m_searchResultsTree->Show();
+    m_searchResultsTree->GetParent()->Layout();
+    
+    std::vector<std::pair<wxString, wxString>> sessions;
+    sessions.reserve(m_sessions.size());
+    for (const auto& session : m_sessions) {
+        if (!session.path.IsEmpty()) {
+            sessions.push_back(std::make_pair(session.name, session.path));
+        }
+    }
+    
+    m_sessionSearchRequest = m_sessionSearch->SearchAsync(searchQuery, sessions, this);
+    SetStatusText(wxString::Format(wxT("正在 %zu 个会话中搜索..."), sessions.size()));
+}
+
+void MainFrame::ClearSessionSearchResults() {
+    if (m_sessionSearch) {
+        m_sessionSearch->CancelSearch();
+    }
+    if (m_semanticSearch) {
+        m_semanticSearch->CancelSearch();
+    }
+    m_sessionSearchRequest = 0;
+    m_semanticSearchRequest = 0;
+    m_sessionSearchHitCount = 0;
+    
+    m_searchResultsTree->DeleteAllItems();
+    m_searchResultsTree->AddRoot(wxT("搜索结果"));
+    if (m_searchResultsTree->IsShown()) {
+        m_searchResultsTree->Hide();
+        m_searchResultsTree->GetParent()->Layout();
+    }
+}
+
+void MainFrame::OnSessionSearchResult(wxThreadEvent& event) {
+    auto result = event.GetPayload<std::shared_ptr<MeetAnt::SessionSearchResult>>();
+    if (!result || result->requestId != m_sessionSearchRequest) {
+        return;   // 已被新的搜索取代
+    }
+    
+    wxTreeItemId rootId = m_searchResultsTree->GetRootItem();
+    wxTreeItemId sessionId = m_searchResultsTree->AppendItem(
+        rootId, wxString::Format(wxT("%s (%zu)"), result->sessionName, result->hits.size()),
+        -1, -1, new SearchResultItemData(result->sessionName, -1));
+    
+    for (const auto& hit : result->hits) {
+        wxString label = wxString::Format(wxT("[%s] %s: %s"),
+                                          hit.timestamp.IsValid() ? hit.timestamp.Format(wxT("%H:%M:%S")) : wxString(wxT("--:--:--")),
+                                          hit.speaker, hit.snippet);
+        m_searchResultsTree->AppendItem(sessionId, label, -1, -1,
+                                        new SearchResultItemData(result->sessionName, static_cast<int>(hit.message)));
+    }
+    m_searchResultsTree->Expand(sessionId);
+    
+    m_sessionSearchHitCount += result->hits.size();
+    SetStatusText(wxString::Format(wxT("已找到 %zu 个匹配项..."), m_sessionSearchHitCount));
+}
+
+void MainFrame::OnSessionSearchDone(wxThreadEvent& event) {
+    if (event.GetInt() != m_sessionSearchRequest) {
+        return;
+    }
+    
+    size_t sessionCount = m_searchResultsTree->GetChildrenCount(m_searchResultsTree->GetRootItem(), false);
+    if (m_sessionSearchHitCount > 0) {
+        SetStatusText(wxString::Format(wxT("在 %zu 个会话中找到 %zu 个匹配项"), sessionCount, m_sessionSearchHitCount));
+    } else {
+        SetStatusText(wxT("未找到匹配项"));
+    }
+    
+    // 搜索过程中可能重建了部分会话的索引
+    m_sessionSearch->SaveManifest();
+}
+
+void MainFrame::StartSemanticSearch(const wxString& query) {
+    if (!m_semanticSearch || m_currentSessionPath.IsEmpty()) {
+        return;
+    }
+    
+    ClearSessionSearchResults();
+    m_searchResultsTree->Show();
+    m_searchResultsTree->GetParent()->Layout();
+    
+    m_semanticSearchRequest = m_semanticSearch->SearchAsync(query, kMaxSemanticResults, this);
+    SetStatusText(wxT("正在进行语义搜索..."));
+}
+
+void MainFrame::OnSemanticSearchResult(wxThreadEvent& event) {
+    auto result = event.GetPayload<std::shared_ptr<MeetAnt::SemanticSearchResult>>();
+    if (!result || result->requestId != m_semanticSearchRequest) {
+        return;   // 已被新的搜索取代
+    }
+    m_semanticSearchRequest = 0;
+    
+    if (result->failed) {
+        SetStatusText(wxT("语义搜索不可用，请检查句向量模型"));
+        return;
+    }
+    // 结果中的消息序号只对搜索时的会话有效
+    if (result->sessionName != m_currentSessionId || result->hits.empty()) {
+        SetStatusText(wxT("未找到匹配项"));
+        return;
+    }
+    
+    wxTreeItemId sessionId = m_searchResultsTree->AppendItem(
+        m_searchResultsTree->GetRootItem(),
+        wxString::Format(wxT("%s (%zu)"), result->sessionName, result->hits.size()),
+        -1, -1, new SearchResultItemData(result->sessionName, -1));
+    
+    // 只读取命中的消息，文本已换出时直接从分页文件读取
+    for (const auto& hit : result->hits) {
+        TranscriptionMessage message;
+        if (!m_transcriptionBubbleCtrl->GetMessageAt(hit.message, message)) {
+            continue;
+        }
+        wxString snippet = message.content.Left(kSemanticSnippetLength);
+        if (snippet.length() < message.content.length()) {
+            snippet += wxT("...");
+        }
+        wxString label = wxString::Format(wxT("[%s] %s: %s (%.2f)"),
+                                          message.timestamp.IsValid() ? message.timestamp.Format(wxT("%H:%M:%S")) : wxString(wxT("--:--:--")),
+                                          message.speakerName, snippet, hit.score);
+        m_searchResultsTree->AppendItem(sessionId, label, -1, -1,
+                                        new SearchResultItemData(result->sessionName, static_cast<int>(hit.message)));
+    }
+    m_searchResultsTree->Expand(sessionId);
+    SetStatusText(wxString::Format(wxT("找到 %zu 条语义相近的发言"), result->hits.size()));
+}
+
+wxString MainFrame::GetEmbeddingModelDirectory() const {
+    wxString configPath;
+#ifdef __WXMSW__
+    configPath = wxGetHomeDir() + wxT("\\MeetAntConfig");
+#else
+    configPath = wxGetHomeDir() + wxT("/.MeetAntConfig");
+#endif
+    wxFileName dir(configPath, wxEmptyString);
+    dir.AppendDir(wxT("models"));
+    dir.AppendDir(wxT("embedding"));
+    return dir.GetPath();
+}
+
+void MainFrame::OnSearchResultSelected(wxTreeEvent& event) {
+    wxTreeItemId itemId = event.GetItem();
+    if (!itemId.IsOk()) {
+        return;
+    }
+    
+    SearchResultItemData* data = dynamic_cast<SearchResultItemData*>(m_searchResultsTree->GetItemData(itemId));
+    if (!data) {
+        return;
+    }
+    
+    // 切换到命中所在的会话（通过会话树选择，复用加载流程）
+    if (data->sessionName != m_currentSessionId) {
+        SelectSessionInTree(data->sessionName);
+        if (data->sessionName != m_currentSessionId) {
+            return;
+        }
+    }
+    
+    if (data->messageIndex >= 0 &&
+        data->messageIndex < static_cast<int>(m_transcriptionBubbleCtrl->GetMessageCount())) {
+        int messageId = m_transcriptionBubbleCtrl->GetMessageId(data->messageIndex);
+        m_transcriptionBubbleCtrl->ScrollToMessage(messageId);
+        m_transcriptionBubbleCtrl->HighlightMessage(messageId, true);
+    }
+}
+
 void MainFrame::OnLabelSpeaker(wxCommandEvent& event) {
     // 标记发言人
     wxString speakerName = wxGetTextFromUser(
@@ -1536,6 +2127,7 @@ void MainFrame::OnExportText(wxCommandEvent& event) {
     
     wxFile file(path, wxFile::write);
     if (file.IsOpened()) {
+        m_transcriptionBubbleCtrl->FinishLoad();
         wxString content = m_transcriptionBubbleCtrl->ExportAsText();
         size_t bytesToWrite = content.Length();
         size_t bytesWritten = file.Write(content);
@@ -1567,11 +2159,41 @@ void MainFrame::OnExportJSON(wxCommandEvent& event) {
         return;
     }
     
-    // TODO: 实际导出JSON的逻辑
     wxString path = saveFileDialog.GetPath();
     
-    // 示例仅显示消息，实际应生成并保存JSON数据
-    SetStatusText(wxString::Format(wxT("JSON导出功能尚未实现，选定路径: %s"), path));
+    // 导出时才由内存中的消息生成，会话目录中只保存转录日志
+    m_transcriptionBubbleCtrl->FinishLoad();
+    std::string content;
+    try {
+        nlohmann::json messages = nlohmann::json::array();
+        for (const auto& msg : m_transcriptionBubbleCtrl->CopyMessages()) {
+            nlohmann::json item;
+            item["time"] = std::string(msg.timestamp.FormatISOCombined(' ').ToUTF8().data());
+            item["timestamp"] = msg.timestamp.IsValid() ? msg.timestamp.GetValue().GetValue() : 0;
+            item["speakerId"] = msg.speakerId;
+            item["speaker"] = std::string(msg.speakerName.ToUTF8().data());
+            item["content"] = std::string(msg.content.ToUTF8().data());
+            messages.push_back(item);
+        }
+        
+        nlohmann::json session;
+        session["session"] = std::string(m_currentSessionId.ToUTF8().data());
+        session["messages"] = messages;
+        content = session.dump(4);
+    } catch (const nlohmann::json::exception& e) {
+        wxMessageBox(wxString::Format(wxT("生成JSON失败: %s"), wxString::FromUTF8(e.what())),
+                    wxT("导出错误"), wxICON_ERROR);
+        return;
+    }
+    
+    wxFile file(path, wxFile::write);
+    if (file.IsOpened() && file.Write(content.data(), content.size()) == content.size()) {
+        file.Close();
+        SetStatusText(wxString::Format(wxT("JSON已导出到: %s"), path));
+    } else {
+        wxMessageBox(wxString::Format(wxT("无法写入文件: %s"), path), 
+                    wxT("导出错误"), wxICON_ERROR);
+    }
 }
 
 void MainFrame::OnExportAudio(wxCommandEvent& event) {
@@ -1700,15 +2322,27 @@ void MainFrame::LoadSessions() {
         SessionItem session;
         session.name = sessionDirName;
         session.path = sessionPath;
-        session.creationTime = wxDateTime::Now(); // 默认使用当前时间
         session.isActive = false;
         
+        // 优先使用会话目录中缓存的元数据，没有缓存时先用目录的修改时间，后台扫描后更新
+        MeetAnt::SessionMetadata metadata;
+        if (m_sessionCatalog && m_sessionCatalog->Lookup(sessionDirName, metadata) &&
+            metadata.creationTime.IsValid()) {
+            session.creationTime = metadata.creationTime;
+            session.durationMs = metadata.durationMs;
+            session.messageCount = metadata.messageCount;
+            session.speakers = metadata.speakers;
+            session.sizeBytes = metadata.sizeBytes;
+        } else {
+            session.creationTime = wxFileName::DirName(sessionPath).GetModificationTime();
+            if (!session.creationTime.IsValid()) {
+                session.creationTime = wxDateTime::Now();
+            }
+        }
+        
         // 无论是否能获取到创建时间，我们都加载这个会话
         m_sessions.push_back(session);
         
-        // 添加到会话树
-        AddSessionToTree(session.name, session.path, session.creationTime, session.isActive);
-        
         // 获取下一个会话目录
         try {
             cont = dir.GetNext(&sessionDirName);
@@ -1718,8 +2352,21 @@ void MainFrame::LoadSessions() {
         }
     }
     
-    // 确保树展开
-    m_sessionTree->ExpandAll();
+    // 按创建时间排序后重建会话树（最新的在前），并打开最新的会话
+    RefreshSessionTree();
+    if (!m_sessions.empty()) {
+        SelectSessionInTree(m_sessions.front().name);
+    }
+    
+    // 在后台检查缓存是否过期
+    if (m_sessionCatalog) {
+        std::vector<std::pair<wxString, wxString>> sessions;
+        sessions.reserve(m_sessions.size());
+        for (const auto& session : m_sessions) {
+            sessions.emplace_back(session.name, session.path);
+        }
+        m_sessionCatalog->Refresh(sessions, this);
+    }
     
     int loadedCount = static_cast<int>(m_sessions.size());
     int excludedCount = static_cast<int>(m_removedSessions.size());
@@ -1767,13 +2414,22 @@ void MainFrame::OnRemoveSession(wxCommandEvent& event) {
         
         // 将会话添加到已移除列表
         if (!IsSessionRemoved(sessionName)) {
-            m_removedSessions.push_back(sessionName);
+            m_removedSessions.insert(sessionName.Lower());
             SaveRemovedSessionsList();
         }
+        if (m_sessionSearch) {
+            m_sessionSearch->RemoveSession(sessionName);
+        }
+        if (m_sessionCatalog) {
+            m_sessionCatalog->Remove(sessionName);
+        }
         
-        // 清空当前会话信息
+        // 保存尚未写入的变化后清空当前会话信息
+        m_autosave->Flush();
         m_currentSessionId = wxEmptyString;
         m_currentSessionPath = wxEmptyString;
+        m_transcriptLog.reset();
+        m_sessionStore.reset();
         
         // 刷新会话树
         RefreshSessionTree();
@@ -1783,6 +2439,7 @@ void MainFrame::OnRemoveSession(wxCommandEvent& event) {
         if (m_annotationManager) {
             m_annotationManager->ClearAnnotations();
         }
+        SyncInlineAnnotations();
         // 清空批注树和书签树
         if (m_annotationTree) {
             m_annotationTree->DeleteAllItems();
@@ -1874,83 +2531,347 @@ void MainFrame::OnAddExistingSession(wxCommandEvent& event) {
     
     newSession.isActive = false;
     
-    // 添加到会话列表
+    // 添加到会话列表，在后台读取它的元数据
     m_sessions.push_back(newSession);
+    if (m_sessionCatalog) {
+        m_sessionCatalog->Update(newSession.name, newSession.path, this);
+    }
     
     // 如果此会话曾被移除，从已移除列表中删除它
-    auto it = std::find(m_removedSessions.begin(), m_removedSessions.end(), sessionName);
-    if (it != m_removedSessions.end()) {
-        m_removedSessions.erase(it);
+    if (m_removedSessions.erase(sessionName.Lower()) > 0) {
         SaveRemovedSessionsList();
     }
     
-    // 刷新会话树
+    // 刷新会话树并选择新添加的会话
     RefreshSessionTree();
+    SelectSessionInTree(sessionName);
     
-    // 自动选择新添加的会话
-    wxTreeItemId root = m_sessionTree->GetRootItem();
-    wxTreeItemIdValue cookie;
-    wxTreeItemId firstChild = m_sessionTree->GetFirstChild(root, cookie);
-    
-    if (firstChild.IsOk()) {
-        bool found = false;
-        wxTreeItemId currentItem = firstChild;
-        
-        // 查找并选择新添加的会话
-        do {
-            wxString itemText = m_sessionTree->GetItemText(currentItem);
-            if (itemText == sessionName) {
-                m_sessionTree->SelectItem(currentItem);
-                found = true;
-                break;
+    SetStatusText(wxString::Format(wxT("已添加现有会话: %s"), sessionName));
+}
+
+void MainFrame::RefreshSessionTree() {
+    // 记录展开的分组，重建后恢复
+    std::unordered_set<wxString> expandedGroups;
+    wxTreeItemId rootId = m_sessionTree->GetRootItem();
+    bool firstBuild = !rootId.IsOk() || !m_sessionTree->HasChildren(rootId);
+    if (rootId.IsOk()) {
+        wxTreeItemIdValue cookie;
+        for (wxTreeItemId item = m_sessionTree->GetFirstChild(rootId, cookie); item.IsOk();
+             item = m_sessionTree->GetNextChild(rootId, cookie)) {
+            SessionTreeItemData* data = dynamic_cast<SessionTreeItemData*>(m_sessionTree->GetItemData(item));
+            if (data && m_sessionTree->IsExpanded(item)) {
+                expandedGroups.insert(data->groupKey);
             }
-            
-            currentItem = m_sessionTree->GetNextSibling(currentItem);
-        } while (currentItem.IsOk());
+        }
+    }
+    
+    wxString filter = m_sessionFilterCtrl->GetValue().Lower();
+    filter.Trim().Trim(false);
+    
+    // 分组按会话的创建时间排列，排序后同一分组的会话是连续的
+    SortSessions();
+    
+    bool rebuilding = m_rebuildingSessionTree;
+    m_rebuildingSessionTree = true;
+    m_sessionTree->Freeze();
+    m_sessionTree->DeleteAllItems();
+    rootId = m_sessionTree->AddRoot(wxT("会话列表"));
+    
+    // 只创建分组节点，会话节点在分组展开时创建
+    struct Group {
+        wxTreeItemId id;
+        wxString key;
+        wxString label;
+        int count;
+    };
+    std::vector<Group> groups;
+    wxString currentGroup;
+    for (const auto& session : m_sessions) {
+        if (!filter.IsEmpty() && !SessionMatchesFilter(session, filter)) {
+            continue;
+        }
         
-        // 如果没找到，至少选择第一个
-        if (!found && firstChild.IsOk()) {
-            m_sessionTree->SelectItem(firstChild);
+        wxString key;
+        wxString label;
+        GetSessionGroup(session, &key, &label);
+        if (groups.empty() || groups.back().key != key) {
+            wxTreeItemId groupId = m_sessionTree->AppendItem(rootId, label, -1, -1,
+                                                             new SessionTreeItemData(wxEmptyString, key));
+            m_sessionTree->SetItemHasChildren(groupId, true);
+            groups.push_back({groupId, key, label, 0});
+        }
+        groups.back().count++;
+        if (session.name == m_currentSessionId) {
+            currentGroup = key;
         }
     }
     
-    SetStatusText(wxString::Format(wxT("已添加现有会话: %s"), sessionName));
+    // 分组名称后显示会话数；过滤时展开所有分组，首次显示时展开最新的分组
+    for (size_t i = 0; i < groups.size(); ++i) {
+        m_sessionTree->SetItemText(groups[i].id, wxString::Format(wxT("%s (%d)"), groups[i].label, groups[i].count));
+        bool expand = !filter.IsEmpty() || (firstBuild && i == 0) ||
+                      expandedGroups.count(groups[i].key) > 0 || groups[i].key == currentGroup;
+        if (expand) {
+            PopulateSessionGroup(groups[i].id);
+            m_sessionTree->Expand(groups[i].id);
+        }
+    }
+    
+    // 保持当前会话的选中状态（不重新加载）
+    if (!m_currentSessionId.IsEmpty()) {
+        wxTreeItemId item = FindSessionTreeItem(m_currentSessionId);
+        if (item.IsOk()) {
+            m_sessionTree->SelectItem(item);
+        }
+    }
+    
+    m_sessionTree->Thaw();
+    m_rebuildingSessionTree = rebuilding;
 }
 
-void MainFrame::RefreshSessionTree() {
-    // 清空会话树
-    m_sessionTree->DeleteAllItems();
-    wxTreeItemId rootId = m_sessionTree->AddRoot(wxT("会话列表"));
+void MainFrame::SortSessions() {
+    std::stable_sort(m_sessions.begin(), m_sessions.end(),
+        [](const SessionItem& a, const SessionItem& b) {
+            return a.creationTime.IsLaterThan(b.creationTime);
+        });
+}
+
+void MainFrame::GetSessionGroup(const SessionItem& session, wxString* key, wxString* label) const {
+    if (!session.creationTime.IsValid()) {
+        *key = wxEmptyString;
+        if (label) {
+            *label = wxT("未知日期");
+        }
+        return;
+    }
+    
+    if (m_sessionGrouping == SessionGrouping::Week) {
+        wxDateTime weekStart = session.creationTime;
+        weekStart.ResetTime();
+        weekStart.SetToWeekDayInSameWeek(wxDateTime::Mon);
+        *key = weekStart.Format(wxT("%Y-%m-%d"));
+        if (label) {
+            *label = wxString::Format(wxT("%s 起的一周"), *key);
+        }
+    } else {
+        *key = session.creationTime.Format(wxT("%Y-%m"));
+        if (label) {
+            *label = session.creationTime.Format(wxT("%Y年%m月"));
+        }
+    }
+}
+
+bool MainFrame::SessionMatchesFilter(const SessionItem& session, const wxString& filter) const {
+    if (session.name.Lower().Contains(filter)) {
+        return true;
+    }
+    for (const auto& speaker : session.speakers) {
+        if (speaker.Lower().Contains(filter)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MainFrame::PopulateSessionGroup(const wxTreeItemId& groupId) {
+    SessionTreeItemData* data = dynamic_cast<SessionTreeItemData*>(m_sessionTree->GetItemData(groupId));
+    if (!data || !data->sessionName.IsEmpty() || data->populated) {
+        return;
+    }
+    data->populated = true;
+    
+    wxString filter = m_sessionFilterCtrl->GetValue().Lower();
+    filter.Trim().Trim(false);
     
-    // 重新添加所有会话到树中
+    std::vector<const SessionItem*> sessions;
     for (const auto& session : m_sessions) {
-        AddSessionToTree(session.name, session.path, session.creationTime, session.isActive);
+        wxString key;
+        GetSessionGroup(session, &key, nullptr);
+        if (key == data->groupKey && (filter.IsEmpty() || SessionMatchesFilter(session, filter))) {
+            sessions.push_back(&session);
+        }
     }
     
-    // 展开树
-    m_sessionTree->ExpandAll();
+    // 分组内按会话目录中的元数据排序
+    SessionSortKey sortKey = m_sessionSortKey;
+    std::stable_sort(sessions.begin(), sessions.end(),
+        [sortKey](const SessionItem* a, const SessionItem* b) {
+            switch (sortKey) {
+                case SessionSortKey::Duration:
+                    return a->durationMs > b->durationMs;
+                case SessionSortKey::MessageCount:
+                    return a->messageCount > b->messageCount;
+                case SessionSortKey::Size:
+                    return a->sizeBytes > b->sizeBytes;
+                default:
+                    return a->creationTime.IsLaterThan(b->creationTime);
+            }
+        });
+    
+    for (const SessionItem* session : sessions) {
+        // 活动会话前加星号
+        wxString displayText = session->isActive ? wxString::Format(wxT("* %s"), session->name) : session->name;
+        m_sessionTree->AppendItem(groupId, displayText, -1, -1, new SessionTreeItemData(session->name, wxEmptyString));
+    }
+    if (sessions.empty()) {
+        m_sessionTree->SetItemHasChildren(groupId, false);
+    }
 }
 
-void MainFrame::AddSessionToTree(const wxString& name, const wxString& path, const wxDateTime& creationTime, bool isActive) {
+wxTreeItemId MainFrame::FindSessionTreeItem(const wxString& sessionName) {
+    auto it = std::find_if(m_sessions.begin(), m_sessions.end(),
+                           [&](const SessionItem& session) { return session.name == sessionName; });
+    if (it == m_sessions.end()) {
+        return wxTreeItemId();
+    }
+    
+    wxString key;
+    GetSessionGroup(*it, &key, nullptr);
+    
+    wxTreeItemIdValue groupCookie;
     wxTreeItemId rootId = m_sessionTree->GetRootItem();
-    if (!rootId.IsOk()) {
+    for (wxTreeItemId groupId = m_sessionTree->GetFirstChild(rootId, groupCookie); groupId.IsOk();
+         groupId = m_sessionTree->GetNextChild(rootId, groupCookie)) {
+        SessionTreeItemData* groupData = dynamic_cast<SessionTreeItemData*>(m_sessionTree->GetItemData(groupId));
+        if (!groupData || groupData->groupKey != key) {
+            continue;
+        }
+        
+        PopulateSessionGroup(groupId);
+        wxTreeItemIdValue cookie;
+        for (wxTreeItemId item = m_sessionTree->GetFirstChild(groupId, cookie); item.IsOk();
+             item = m_sessionTree->GetNextChild(groupId, cookie)) {
+            SessionTreeItemData* data = dynamic_cast<SessionTreeItemData*>(m_sessionTree->GetItemData(item));
+            if (data && data->sessionName == sessionName) {
+                return item;
+            }
+        }
+        break;
+    }
+    return wxTreeItemId();
+}
+
+bool MainFrame::SelectSessionInTree(const wxString& sessionName) {
+    wxTreeItemId item = FindSessionTreeItem(sessionName);
+    if (!item.IsOk() && !m_sessionFilterCtrl->IsEmpty()) {
+        // 会话被过滤掉了，清除过滤后再找
+        m_sessionFilterCtrl->ChangeValue(wxEmptyString);
+        RefreshSessionTree();
+        item = FindSessionTreeItem(sessionName);
+    }
+    if (!item.IsOk()) {
+        return false;
+    }
+    
+    // 已选中时先取消选中，保证选择事件触发会话加载
+    if (m_sessionTree->IsSelected(item)) {
+        bool rebuilding = m_rebuildingSessionTree;
+        m_rebuildingSessionTree = true;
+        m_sessionTree->Unselect();
+        m_rebuildingSessionTree = rebuilding;
+    }
+    m_sessionTree->EnsureVisible(item);
+    m_sessionTree->SelectItem(item);
+    return true;
+}
+
+void MainFrame::OnSessionTreeExpanding(wxTreeEvent& event) {
+    PopulateSessionGroup(event.GetItem());
+}
+
+void MainFrame::OnSessionFilterChanged(wxCommandEvent& event) {
+    RefreshSessionTree();
+}
+
+void MainFrame::OnSessionCatalogUpdated(wxThreadEvent& event) {
+    auto metadata = event.GetPayload<std::shared_ptr<MeetAnt::SessionMetadata>>();
+    if (!metadata) {
         return;
     }
     
-    // 格式化显示文本
-    wxString displayText;
-    if (isActive) {
-        displayText = wxString::Format(wxT("* %s"), name); // 活动会话前加星号
-    } else {
-        displayText = name;
+    for (auto& session : m_sessions) {
+        if (session.name == metadata->name) {
+            if (metadata->creationTime.IsValid()) {
+                session.creationTime = metadata->creationTime;
+            }
+            session.durationMs = metadata->durationMs;
+            session.messageCount = metadata->messageCount;
+            session.speakers = metadata->speakers;
+            session.sizeBytes = metadata->sizeBytes;
+            break;
+        }
+    }
+}
+
+void MainFrame::OnSessionCatalogDone(wxThreadEvent& event) {
+    if (event.GetInt() == 0) {
+        return;
     }
     
-    // 添加到树
-    wxTreeItemId itemId = m_sessionTree->AppendItem(rootId, displayText);
+    // 元数据变化后重新排序和分组，保持当前会话的选中状态
+    RefreshSessionTree();
+}
+
+void MainFrame::OnSessionArchived(wxThreadEvent& event) {
+    wxString sessionName = event.GetString();
+    for (const auto& session : m_sessions) {
+        if (session.name == sessionName) {
+            // 归档后目录中的文件变了，重新扫描元数据
+            if (m_sessionCatalog) {
+                m_sessionCatalog->Update(session.name, session.path, this);
+            }
+            break;
+        }
+    }
+    SetStatusText(wxString::Format(wxT("已归档会话: %s"), sessionName));
+}
+
+void MainFrame::OnSessionArchiveDone(wxThreadEvent& event) {
+    if (event.GetInt() > 0) {
+        SetStatusText(wxString::Format(wxT("已归档 %d 个长期未修改的会话"), event.GetInt()));
+    }
+}
+
+void MainFrame::OnSessionTreeGetTooltip(wxTreeEvent& event) {
+    wxTreeItemId itemId = event.GetItem();
+    if (!itemId.IsOk() || itemId == m_sessionTree->GetRootItem()) {
+        return;
+    }
+    
+    SessionTreeItemData* data = dynamic_cast<SessionTreeItemData*>(m_sessionTree->GetItemData(itemId));
+    if (!data || data->sessionName.IsEmpty()) {
+        return;
+    }
+    const wxString& sessionName = data->sessionName;
     
-    // 选择第一个会话（如果树为空）
-    if (m_sessionTree->GetChildrenCount(rootId) == 1) {
-        m_sessionTree->SelectItem(itemId);
+    for (const auto& session : m_sessions) {
+        if (session.name != sessionName) {
+            continue;
+        }
+        
+        long seconds = static_cast<long>(session.durationMs / 1000);
+        wxString tooltip = wxString::Format(
+            wxT("%s\n创建时间: %s\n时长: %ld:%02ld:%02ld\n消息: %zu 条\n大小: %s"),
+            session.name,
+            session.creationTime.IsValid() ? session.creationTime.Format(wxT("%Y-%m-%d %H:%M:%S")) : wxString(wxT("未知")),
+            seconds / 3600, (seconds / 60) % 60, seconds % 60,
+            session.messageCount,
+            wxFileName::GetHumanReadableSize(wxULongLong(static_cast<wxULongLong_t>(session.sizeBytes))));
+        if (!session.speakers.empty()) {
+            wxString speakers;
+            for (const auto& speaker : session.speakers) {
+                if (!speakers.IsEmpty()) {
+                    speakers += wxT("、");
+                }
+                speakers += speaker;
+            }
+            tooltip += wxT("\n发言人: ") + speakers;
+        }
+        if (MeetAnt::SessionArchive::Exists(session.path)) {
+            tooltip += wxT("\n已归档");
+        }
+        event.SetToolTip(tooltip);
+        break;
     }
 }
 
@@ -1961,29 +2882,54 @@ void MainFrame::OnSessionTreeContextMenu(wxTreeEvent& event) {
         return;
     }
     
-    // 当前选中的会话名称
-    wxString sessionName = m_sessionTree->GetItemText(item);
-    
-    // 如果会话名称前面有星号（表示活动会话），去掉星号和空格
-    if (sessionName.StartsWith(wxT("* "))) {
-        sessionName = sessionName.Mid(2);
-    }
+    // 右键点击的会话名称（分组节点为空）
+    SessionTreeItemData* data = dynamic_cast<SessionTreeItemData*>(m_sessionTree->GetItemData(item));
+    wxString sessionName = data ? data->sessionName : wxString();
     
     // 创建右键菜单
     wxMenu contextMenu;
-    contextMenu.Append(ID_SessionTreeContext_Remove, wxT("从列表中移除"));
-    
-    // 绑定菜单事件
-    contextMenu.Bind(wxEVT_COMMAND_MENU_SELECTED, 
-        [this, sessionName](wxCommandEvent& event) {
-            // 设置当前会话为右键点击的会话
-            m_currentSessionId = sessionName;
-            
-            // 转发到移除会话处理函数
-            wxCommandEvent removeEvent(wxEVT_COMMAND_MENU_SELECTED, ID_Menu_Remove_Session);
-            this->OnRemoveSession(removeEvent);
-        }, 
-        ID_SessionTreeContext_Remove);
+    if (!sessionName.IsEmpty()) {
+        contextMenu.Append(ID_SessionTreeContext_Remove, wxT("从列表中移除"));
+        contextMenu.AppendSeparator();
+        
+        // 绑定菜单事件
+        contextMenu.Bind(wxEVT_COMMAND_MENU_SELECTED, 
+            [this, sessionName](wxCommandEvent& event) {
+                // 设置当前会话为右键点击的会话（先保存原会话尚未写入的变化）
+                m_autosave->Flush();
+                m_currentSessionId = sessionName;
+                
+                // 转发到移除会话处理函数
+                wxCommandEvent removeEvent(wxEVT_COMMAND_MENU_SELECTED, ID_Menu_Remove_Session);
+                this->OnRemoveSession(removeEvent);
+            }, 
+            ID_SessionTreeContext_Remove);
+    }
+    
+    // 分组和排序方式
+    contextMenu.AppendRadioItem(ID_SessionTreeContext_GroupByMonth, wxT("按月分组"));
+    contextMenu.AppendRadioItem(ID_SessionTreeContext_GroupByWeek, wxT("按周分组"));
+    contextMenu.Check(m_sessionGrouping == SessionGrouping::Week ? ID_SessionTreeContext_GroupByWeek
+                                                                  : ID_SessionTreeContext_GroupByMonth, true);
+    contextMenu.AppendSeparator();
+    contextMenu.AppendRadioItem(ID_SessionTreeContext_SortByTime, wxT("按创建时间排序"));
+    contextMenu.AppendRadioItem(ID_SessionTreeContext_SortByDuration, wxT("按时长排序"));
+    contextMenu.AppendRadioItem(ID_SessionTreeContext_SortByMessages, wxT("按消息数排序"));
+    contextMenu.AppendRadioItem(ID_SessionTreeContext_SortBySize, wxT("按大小排序"));
+    contextMenu.Check(ID_SessionTreeContext_SortByTime + static_cast<int>(m_sessionSortKey), true);
+    
+    contextMenu.Bind(wxEVT_COMMAND_MENU_SELECTED,
+        [this](wxCommandEvent& event) {
+            if (event.GetId() == ID_SessionTreeContext_GroupByMonth) {
+                m_sessionGrouping = SessionGrouping::Month;
+            } else if (event.GetId() == ID_SessionTreeContext_GroupByWeek) {
+                m_sessionGrouping = SessionGrouping::Week;
+            } else {
+                m_sessionSortKey = static_cast<SessionSortKey>(event.GetId() - ID_SessionTreeContext_SortByTime);
+            }
+            RefreshSessionTree();
+        },
+        ID_SessionTreeContext_GroupByMonth, ID_SessionTreeContext_SortBySize);
     
     // 直接使用鼠标的当前位置，这是最可靠的方法
     wxPoint mousePos = wxGetMousePosition();
@@ -2047,6 +2993,16 @@ void MainFrame::SyncAnnotationScrollPosition(wxScrollWinEvent& event) {
     event.Skip();
 }
 
+// 批注在气泡中内联绘制：气泡控件绘制时只按可视时间段向批注管理器查询（见 InitAnnotationManager），
+// 这里只通知它批注有变化
+void MainFrame::SyncInlineAnnotations() {
+    if (!m_transcriptionBubbleCtrl) {
+        return;
+    }
+    
+    m_transcriptionBubbleCtrl->InvalidateAnnotations();
+}
+
 // 实现刷新批注函数
 void MainFrame::RefreshAnnotations() {
     if (!m_annotationManager || m_currentSessionId.IsEmpty() || !m_annotationTextCtrl) {
@@ -2146,48 +3102,381 @@ void MainFrame::SaveCurrentSession() {
         return;
     }
     
-    // 保存转录文本
-    wxString textContent = m_transcriptionBubbleCtrl->ExportAsText();
-    wxString textFilePath = wxFileName(m_currentSessionPath, wxT("transcript.txt")).GetFullPath();
+    // 立即保存全部内容
+    m_autosave->MarkDirty(MeetAnt::AutosaveAll);
+    m_autosave->Flush();
     
-    wxFile textFile;
-    if (!textFile.Open(textFilePath, wxFile::write)) {
-        wxLogError(wxT("无法打开转录文件进行写入: %s"), textFilePath);
+    SetStatusText(wxString::Format(wxT("会话已保存: %s"), m_currentSessionId));
+}
+
+void MainFrame::MarkSessionDirty(unsigned parts) {
+    if (m_currentSessionPath.IsEmpty()) {
+        return;
+    }
+    // 内容变化时会话信息中的修改时间也要更新，搜索索引和会话目录在下一次 Flush 时刷新
+    m_autosave->MarkDirty(parts | MeetAnt::AutosaveMetadata | MeetAnt::AutosaveIndexes);
+}
+
+void MainFrame::SaveSessionParts(unsigned parts) {
+    if (m_currentSessionPath.IsEmpty()) {
         return;
     }
     
-    if (!textFile.Write(textContent)) {
-        wxLogError(wxT("写入转录文件失败: %s"), textFilePath);
+    // 转录还在后台读取时控件中没有消息，不能据此改写转录和重建索引
+    // （读完之前追加消息会先等读取完成，所以此时转录也不会有新内容）
+    if (m_transcriptionBubbleCtrl->IsLoadPending()) {
+        parts &= ~(MeetAnt::AutosaveTranscript | MeetAnt::AutosaveIndexes);
     }
     
-    textFile.Close();
+    // 保存转录（只追加尚未写入的消息）
+    if (parts & MeetAnt::AutosaveTranscript) {
+        PersistTranscript();
+    }
     
     // 保存批注
-    if (m_annotationManager) {
-        m_annotationManager->SaveAnnotations(m_currentSessionPath);
+    if ((parts & MeetAnt::AutosaveAnnotations) && m_annotationManager) {
+        SaveSessionAnnotations();
     }
     
     // 保存会话信息文件（可选）
+    if (parts & MeetAnt::AutosaveMetadata) {
+        WriteSessionInfo();
+    }
+    
+    // 手动保存、停止录制和切换会话时在后台重建搜索索引、更新会话目录中的元数据
+    // 两者都要读取整个转录，自动保存时跳过；期间的搜索按转录文件的状态自行补建索引
+    if (parts & MeetAnt::AutosaveIndexes) {
+        if (m_sessionSearch) {
+            m_sessionSearch->UpdateSession(m_currentSessionId, m_currentSessionPath,
+                                           m_transcriptionBubbleCtrl->CopyMessages());
+        }
+        if (m_sessionCatalog) {
+            m_sessionCatalog->Update(m_currentSessionId, m_currentSessionPath, this);
+        }
+    }
+}
+
+bool MainFrame::WriteSessionInfo() {
     wxString infoFilePath = wxFileName(m_currentSessionPath, wxT("session.info")).GetFullPath();
+    wxString tempPath = infoFilePath + wxT(".tmp");
+    
+    wxDateTime now = wxDateTime::Now();
+    wxString lastModified = now.FormatISODate() + wxT(" ") + now.FormatISOTime();
+    wxString infoContent = wxString::Format(
+        wxT("Session-Name: %s\nLast-Modified: %s\n"),
+        m_currentSessionId,
+        lastModified
+    );
+    
+    // 先写临时文件再替换，写入中途出错时保留原文件
     wxFile infoFile;
-    if (!infoFile.Open(infoFilePath, wxFile::write)) {
-        wxLogWarning(wxT("无法打开会话信息文件进行写入: %s"), infoFilePath);
-    } else {
-        wxDateTime now = wxDateTime::Now();
-        wxString infoContent = wxString::Format(
-            wxT("Session-Name: %s\nLast-Modified: %s\n"),
-            m_currentSessionId,
-            now.FormatISODate() + wxT(" ") + now.FormatISOTime()
-        );
-        
-        if (!infoFile.Write(infoContent)) {
-            wxLogWarning(wxT("写入会话信息文件失败: %s"), infoFilePath);
+    bool success = infoFile.Open(tempPath, wxFile::write) && infoFile.Write(infoContent);
+    infoFile.Close();
+    if (!success) {
+        wxLogWarning(wxT("写入会话信息文件失败: %s"), tempPath);
+        return false;
+    }
+    if (!wxRenameFile(tempPath, infoFilePath, true)) {
+        wxLogWarning(wxT("无法替换会话信息文件: %s"), infoFilePath);
+        return false;
+    }
+    
+    if (OpenSessionStore()) {
+        m_sessionStore->SetInfo(wxT("Session-Name"), m_currentSessionId);
+        m_sessionStore->SetInfo(wxT("Last-Modified"), lastModified);
+    }
+    return true;
+}
+
+wxString MainFrame::GetConfigFilePath() {
+    // 使用与ConfigDialog相同的配置文件路径
+    wxString configPath;
+    
+#ifdef __WXMSW__
+    configPath = wxGetHomeDir() + wxT("\\MeetAntConfig");
+#else
+    configPath = wxGetHomeDir() + wxT("/.MeetAntConfig");
+#endif
+    
+    return configPath + wxFileName::GetPathSeparator() + wxT("config.json");
+}
+
+bool MainFrame::ReadConfigFile(nlohmann::json& config) {
+    wxString configFilePath = GetConfigFilePath();
+    if (!wxFile::Exists(configFilePath)) {
+        return false;
+    }
+    
+    wxFile file;
+    wxString content;
+    if (!file.Open(configFilePath, wxFile::read) || !file.ReadAll(&content, wxConvUTF8)) {
+        wxLogWarning(wxT("无法读取配置文件: %s"), configFilePath);
+        return false;
+    }
+    try {
+        config = nlohmann::json::parse(content.ToStdString(wxConvUTF8));
+    } catch (const nlohmann::json::exception& e) {
+        wxLogWarning(wxT("解析配置文件失败: %s"), wxString::FromUTF8(e.what()));
+        return false;
+    }
+    return true;
+}
+
+nlohmann::json MainFrame::ReadSystemConfig() {
+    nlohmann::json config;
+    if (ReadConfigFile(config) && config.contains("system") && config["system"].is_object()) {
+        return config["system"];
+    }
+    return nlohmann::json::object();
+}
+
+void MainFrame::LoadAutosaveConfig() {
+    // 默认值与设置对话框中的一致
+    bool enabled = true;
+    int intervalMinutes = 5;
+    
+    nlohmann::json system = ReadSystemConfig();
+    try {
+        enabled = system.value("autoSave", enabled);
+        intervalMinutes = system.value("autoSaveInterval", intervalMinutes);
+    } catch (const std::exception& e) {
+        wxLogWarning(wxT("读取自动保存设置失败: %s"), wxString(e.what()));
+    }
+    
+    m_autosave->Configure(enabled, intervalMinutes);
+    wxLogInfo(wxT("自动保存: %s，间隔 %d 分钟"), enabled ? wxT("启用") : wxT("禁用"), intervalMinutes);
+}
+
+void MainFrame::LoadArchiveConfig() {
+    // 默认值与设置对话框中的一致
+    MeetAnt::ArchivePolicy policy;
+    int sizeMB = 500;
+    
+    nlohmann::json system = ReadSystemConfig();
+    try {
+        policy.enabled = system.value("archiveEnabled", policy.enabled);
+        policy.afterDays = system.value("archiveAfterDays", policy.afterDays);
+        sizeMB = system.value("archiveSizeMB", sizeMB);
+    } catch (const std::exception& e) {
+        wxLogWarning(wxT("读取归档设置失败: %s"), wxString(e.what()));
+    }
+    policy.sizeThresholdBytes = static_cast<int64_t>(std::max(sizeMB, 0)) * 1024 * 1024;
+    
+    // 重新运行会取消上一次尚未完成的检查
+    std::vector<std::pair<wxString, wxString>> sessions;
+    sessions.reserve(m_sessions.size());
+    for (const auto& session : m_sessions) {
+        sessions.emplace_back(session.name, session.path);
+    }
+    m_sessionArchive->Run(sessions, policy, this);
+}
+
+void MainFrame::PersistTranscript() {
+    if (m_currentSessionPath.IsEmpty()) {
+        return;
+    }
+    
+    // 只复制尚未写入的消息；整体替换时才读取全部文本
+    size_t messageCount = m_transcriptionBubbleCtrl->GetMessageCount();
+    
+    // 启用会话数据库时消息写入数据库，不再写日志
+    if (OpenSessionStore()) {
+        size_t stored = m_sessionStore->GetMessageCount();
+        if (stored > messageCount) {
+            m_sessionStore->ReplaceMessages(m_transcriptionBubbleCtrl->CopyMessages());
+        } else if (stored < messageCount) {
+            m_sessionStore->AppendMessages(m_transcriptionBubbleCtrl->CopyMessages(stored));
         }
-        
-        infoFile.Close();
+        return;
     }
     
-    SetStatusText(wxString::Format(wxT("会话已保存: %s"), m_currentSessionId));
+    // 切换会话后换用新会话的日志，旧日志在析构时写完
+    if (!m_transcriptLog || m_transcriptLog->GetSessionPath() != m_currentSessionPath) {
+        m_transcriptLog.reset();
+        m_transcriptLog = std::make_unique<MeetAnt::TranscriptLog>(m_currentSessionPath);
+    }
+    
+    // 定稿的消息只会在末尾追加；只有转录文本的旧会话第一次保存时全部写入，完成迁移
+    size_t persisted = m_transcriptLog->GetMessageCount();
+    if (persisted > messageCount) {
+        m_transcriptLog->Rewrite(m_transcriptionBubbleCtrl->CopyMessages());
+    } else if (persisted < messageCount) {
+        m_transcriptLog->Append(m_transcriptionBubbleCtrl->CopyMessages(persisted));
+    }
+}
+
+bool MainFrame::OpenSessionStore() {
+    if (!MeetAnt::SessionStore::IsSupported() || m_currentSessionPath.IsEmpty()) {
+        return false;
+    }
+    if (m_sessionStore && m_sessionStore->GetSessionPath() == m_currentSessionPath) {
+        return m_sessionStore->IsOpen();
+    }
+    
+    // 切换会话后换用新会话的数据库，旧数据库在析构时提交已排队的写入
+    m_sessionStore.reset();
+    m_sessionStore = std::make_unique<MeetAnt::SessionStore>(m_currentSessionPath);
+    if (!m_sessionStore->IsOpen()) {
+        return false;
+    }
+    if (m_sessionStore->NeedsImport()) {
+        m_sessionStore->ImportFolder();
+        if (m_annotationManager) {
+            m_sessionStore->ReplaceAnnotations(m_annotationManager->GetSessionAnnotations(m_currentSessionId));
+        }
+    }
+    return true;
+}
+
+void MainFrame::SaveSessionAnnotations() {
+    m_annotationManager->SaveAnnotations(m_currentSessionPath);
+    // 修改已经逐条写入数据库；旧版本写入的数据库中批注的 id 不是编号，整体重写一次
+    if (OpenSessionStore() && m_sessionStore->NeedsAnnotationImport()) {
+        m_sessionStore->ReplaceAnnotations(m_annotationManager->GetSessionAnnotations(m_currentSessionId));
+    }
+}
+
+void MainFrame::FinishRecoveryLog(const wxString& sessionPath) {
+    if (m_recoveryLog && m_recoveryLog->GetSessionPath() == sessionPath) {
+        m_recoveryLog.reset();
+    }
+    
+    // 等转录和批注的写入落盘；有任何写入失败时保留恢复日志，下次启动时再补回
+    bool persisted = true;
+    if (m_transcriptLog && m_transcriptLog->GetSessionPath() == sessionPath) {
+        persisted = m_transcriptLog->Flush() && persisted;
+    }
+    if (m_sessionStore && m_sessionStore->GetSessionPath() == sessionPath) {
+        persisted = m_sessionStore->Flush() && persisted;
+    }
+    if (m_annotationManager) {
+        persisted = m_annotationManager->FlushAnnotations(sessionPath) && persisted;
+    }
+    if (!persisted) {
+        wxLogWarning(wxT("会话没有完整写入，保留恢复日志: %s"), MeetAnt::RecoveryLog::GetLogPath(sessionPath));
+        return;
+    }
+    
+    if (!MeetAnt::RecoveryLog::Remove(sessionPath)) {
+        wxLogWarning(wxT("无法删除恢复日志: %s"), MeetAnt::RecoveryLog::GetLogPath(sessionPath));
+    }
+}
+
+void MainFrame::RecoverUnfinishedSessions() {
+    // 会话目录中留有恢复日志，说明上次录制时程序没有正常退出
+    std::vector<SessionItem> unfinished;
+    for (const auto& session : m_sessions) {
+        if (MeetAnt::RecoveryLog::Exists(session.path)) {
+            unfinished.push_back(session);
+        }
+    }
+    if (unfinished.empty()) {
+        return;
+    }
+    
+    // 按时间顺序恢复，最后停在最近的会话上
+    auto timeOf = [](const SessionItem& session) {
+        return session.creationTime.IsValid() ? session.creationTime.GetValue() : wxLongLong(0);
+    };
+    std::stable_sort(unfinished.begin(), unfinished.end(), [&timeOf](const SessionItem& a, const SessionItem& b) {
+        return timeOf(a) < timeOf(b);
+    });
+    for (const auto& session : unfinished) {
+        if (!RecoverSession(session.name, session.path)) {
+            // 保留恢复日志，下次启动时再试
+            wxLogWarning(wxT("无法恢复会话: %s"), session.name);
+        }
+    }
+}
+
+bool MainFrame::RecoverSession(const wxString& sessionName, const wxString& sessionPath) {
+    MeetAnt::RecoveryLog::State state;
+    if (!MeetAnt::RecoveryLog::Read(sessionPath, state)) {
+        return false;
+    }
+    wxLogInfo(wxT("恢复上次未正常结束的会话: %s"), sessionName);
+    
+    // 录音数据在录制期间已写入文件，只有文件头中的长度没有更新
+    std::vector<wxString> recoveredAudio;
+    for (const auto& segment : state.audioSegments) {
+        wxString recoveredPath;
+        if (MeetAnt::RecoveryLog::RepairAudio(sessionPath, segment, &recoveredPath)) {
+            recoveredAudio.push_back(recoveredPath);
+        }
+    }
+    
+    // 打开会话，加载已保存的转录和批注
+    if (!SelectSessionInTree(sessionName) || m_currentSessionPath != sessionPath) {
+        return false;
+    }
+    
+    // 补上自动保存之前没来得及写入的消息（日志中记有每条消息在转录中的位置）
+    m_transcriptionBubbleCtrl->FinishLoad();
+    std::vector<TranscriptionMessage> messages = m_transcriptionBubbleCtrl->CopyMessages();
+    size_t savedCount = messages.size();
+    for (const auto& entry : state.messages) {
+        if (entry.first >= savedCount) {
+            messages.push_back(entry.second);
+        }
+    }
+    size_t recoveredMessages = messages.size() - savedCount;
+    if (recoveredMessages > 0) {
+        m_transcriptionBubbleCtrl->SetMessages(std::move(messages));
+        UpdateSpeakerFilterChoices();
+        if (m_semanticSearch) {
+            m_semanticSearch->OpenSession(m_currentSessionId, m_currentSessionPath,
+                                          m_transcriptionBubbleCtrl->CopyMessages());
+        }
+    }
+    
+    // 按顺序重做日志中的批注修改：编号压缩前后不变，已经保存过的修改重做后结果不变
+    if (!state.annotationChanges.empty() && m_annotationManager) {
+        for (const auto& record : state.annotationChanges) {
+            m_annotationManager->ApplyChange(record);
+        }
+        LoadBookmarks();
+        RefreshAnnotations();
+    }
+    
+    // 修复后的录音记入会话数据库
+    if (!recoveredAudio.empty() && OpenSessionStore()) {
+        for (const auto& path : recoveredAudio) {
+            m_sessionStore->AddAudioSegment(path);
+        }
+    }
+    
+    // 全部写回会话后删除恢复日志
+    SaveCurrentSession();
+    FinishRecoveryLog(sessionPath);
+    
+    SetStatusText(wxString::Format(wxT("已恢复上次未正常结束的会话: %s（补回 %zu 条消息，修复 %zu 段录音）"),
+                                   sessionName, recoveredMessages, recoveredAudio.size()));
+    return true;
+}
+
+// 在气泡控件的读取线程中解码会话的转录，读完后控件分批布局并发送 wxEVT_TRANSCRIPTION_LOADED
+void MainFrame::LoadSessionTranscript(const wxString& sessionPath) {
+    m_playbackControlBar->ClearSearchHits();
+    m_transcriptionBubbleCtrl->LoadMessages([sessionPath](std::vector<TranscriptionMessage>& messages) {
+        return MeetAnt::LoadTranscriptFile(sessionPath, messages);
+    });
+}
+
+void MainFrame::OnTranscriptionLoaded(wxCommandEvent& event) {
+    UpdateSpeakerFilterChoices();
+    
+    // 在后台为新会话中尚未编码的消息补算句向量
+    if (m_semanticSearch && !m_currentSessionPath.IsEmpty()) {
+        m_semanticSearch->OpenSession(m_currentSessionId, m_currentSessionPath,
+                                      m_transcriptionBubbleCtrl->CopyMessages());
+    }
+    
+    // 在新会话中重新执行会话内搜索
+    m_inSessionSearchKey.clear();
+    if (!m_searchAllSessionsCheckBox->GetValue() && !m_semanticSearchCheckBox->GetValue() &&
+        !m_searchCtrl->GetValue().IsEmpty()) {
+        StartInSessionSearch();
+    }
 }
 
 // 实现创建会话目录函数
@@ -3207,6 +4496,18 @@ bool MainFrame::InitializeAudioRecording() {
     m_totalAudioFrames = 0;
     m_audioDataBuffer.clear();
     
+    // 在恢复日志中记下正在写入的录音文件，异常退出后据此修复文件头
+    if (m_recoveryLog && m_recoveryLog->GetSessionPath() == m_currentSessionPath) {
+        MeetAnt::RecoveryLog::AudioSegment segment;
+        segment.fileName = wxFileName(m_currentAudioFilePath).GetFullName();
+        segment.dataFileName = m_isMP3Format ? wxFileName(GetMP3SpoolPath(m_currentAudioFilePath)).GetFullName()
+                                             : segment.fileName;
+        segment.sampleRate = m_actualSampleRate;
+        segment.channels = m_actualChannels;
+        segment.bitsPerSample = m_isMP3Format ? 16 : m_actualBitsPerSample;
+        m_recoveryLog->BeginAudio(segment);
+    }
+    
     wxLogInfo(wxT("音频录制初始化成功，格式: %s，文件: %s"), 
              m_isMP3Format ? wxT("MP3") : wxT("WAV"), 
              m_currentAudioFilePath);
@@ -3271,6 +4572,11 @@ void MainFrame::StopAudioRecording() {
         }
     }
     
+    // 在会话数据库中记下这段录音
+    if (!m_currentAudioFilePath.IsEmpty() && OpenSessionStore()) {
+        m_sessionStore->AddAudioSegment(m_currentAudioFilePath);
+    }
+    
     m_currentAudioFilePath.Clear();
 }
 
@@ -3571,10 +4877,20 @@ bool MainFrame::InitializeMP3Encoder() {
     }
     
     // 这里使用简化的实现，实际项目中可以集成LAME库
-    // 目前我们将音频数据缓存，然后在录制结束时转换为MP3
+    // 目前我们把16位PCM数据边录边写入临时WAV文件，然后在录制结束时转换为MP3
+    // （不在内存中缓存整段录音，异常退出后临时文件可以恢复）
+    wxString tempWavPath = GetMP3SpoolPath(m_currentAudioFilePath);
+    m_audioFile = new wxFile();
+    if (!m_audioFile->Create(tempWavPath, true) ||
+        !WriteWAVHeader(*m_audioFile, m_actualSampleRate, m_actualChannels, 16)) {
+        wxLogError(wxT("无法创建临时WAV文件: %s"), tempWavPath);
+        m_audioFile->Close();
+        delete m_audioFile;
+        m_audioFile = nullptr;
+        return false;
+    }
     
     m_mp3Buffer.clear();
-    m_mp3Buffer.reserve(1024 * 1024); // 预分配1MB缓冲区
     
     wxLogInfo(wxT("MP3编码器初始化成功，比特率: %d kbps"), m_mp3Bitrate);
     return true;
@@ -3597,9 +4913,14 @@ bool MainFrame::EncodeToMP3(const float* buffer, size_t bufferSize) {
         return false;
     }
     
-    // 简化实现：将float数据转换为16位整数并存储
+    if (!m_audioFile) {
+        return false;
+    }
+    
+    // 简化实现：将float数据转换为16位整数并写入临时WAV文件
     // 实际项目中应该直接调用LAME编码
     
+    m_mp3Buffer.clear();
     for (size_t i = 0; i < bufferSize; i++) {
         float sample = std::max(-1.0f, std::min(1.0f, buffer[i]));
         int16_t intSample = static_cast<int16_t>(sample * 32767.0f);
@@ -3609,7 +4930,7 @@ bool MainFrame::EncodeToMP3(const float* buffer, size_t bufferSize) {
         m_mp3Buffer.push_back(static_cast<unsigned char>((intSample >> 8) & 0xFF));
     }
     
-    return true;
+    return m_audioFile->Write(m_mp3Buffer.data(), m_mp3Buffer.size()) == m_mp3Buffer.size();
 }
 
 // 完成MP3编码
@@ -3619,35 +4940,18 @@ bool MainFrame::FinalizeMP3Encoding() {
     }
     
     // 简化实现：使用外部工具转换WAV到MP3
-    // 首先创建临时WAV文件
-    wxString tempWavPath = m_currentAudioFilePath + wxT(".temp.wav");
-    
-    // 创建临时WAV文件
-    wxFile tempWavFile;
-    if (!tempWavFile.Create(tempWavPath, true)) {
-        wxLogError(wxT("无法创建临时WAV文件: %s"), tempWavPath);
-        return false;
-    }
-    
-    // 写入WAV头
-    if (!WriteWAVHeader(tempWavFile, m_actualSampleRate, m_actualChannels, 16)) {
-        wxLogError(wxT("无法写入临时WAV文件头"));
-        tempWavFile.Close();
+    // 录制期间的数据已写入临时WAV文件，先补全文件头
+    wxString tempWavPath = GetMP3SpoolPath(m_currentAudioFilePath);
+    if (!m_audioFile) {
+        wxLogError(wxT("临时WAV文件未打开: %s"), tempWavPath);
         return false;
     }
     
-    // 写入音频数据
-    if (!m_mp3Buffer.empty()) {
-        size_t bytesWritten = tempWavFile.Write(m_mp3Buffer.data(), m_mp3Buffer.size());
-        if (bytesWritten != m_mp3Buffer.size()) {
-            wxLogError(wxT("写入临时WAV文件数据失败"));
-        }
-    }
-    
     // 更新WAV头
-    size_t totalFrames = m_mp3Buffer.size() / (m_actualChannels * 2); // 16位 = 2字节
-    UpdateWAVHeader(tempWavFile, totalFrames, m_actualSampleRate, m_actualChannels, 16);
-    tempWavFile.Close();
+    UpdateWAVHeader(*m_audioFile, m_totalAudioFrames, m_actualSampleRate, m_actualChannels, 16); // 16位
+    m_audioFile->Close();
+    delete m_audioFile;
+    m_audioFile = nullptr;
     
     // 使用FFmpeg转换WAV到MP3
     wxString ffmpegCmd = wxString::Format(
@@ -3697,70 +5001,31 @@ bool MainFrame::FinalizeMP3Encoding() {
 
 // 加载AI配置
 bool MainFrame::LoadAIConfig() {
-    // 使用与ConfigDialog相同的配置文件路径
-    wxString configPath;
-    
-#ifdef __WXMSW__
-    configPath = wxGetHomeDir() + wxT("\\MeetAntConfig");
-#else
-    configPath = wxGetHomeDir() + wxT("/.MeetAntConfig");
-#endif
-    
-    wxString configFilePath = configPath + wxFileName::GetPathSeparator() + wxT("config.json");
-    
+    wxString configFilePath = GetConfigFilePath();
     wxLogInfo(wxT("尝试加载AI配置文件: %s"), configFilePath);
     
+    // 创建AI配置对象并设置默认值
+    if (!m_aiConfig) {
+        m_aiConfig = new AIConfig();
+    }
+    m_aiConfig->apiKey = wxT("");
+    m_aiConfig->endpointURL = wxT("https://api.openai.com/v1/chat/completions");
+    m_aiConfig->modelName = wxT("gpt-3.5-turbo");
+    m_aiConfig->temperature = 0.7;
+    m_aiConfig->maxTokens = 1000;
+    m_aiConfig->promptTemplate = wxT("你是一个会议助手，请帮助用户处理会议相关的问题。");
+    
     if (!wxFile::Exists(configFilePath)) {
-        // 使用默认配置
-        if (!m_aiConfig) {
-            m_aiConfig = new AIConfig();
-        }
-        m_aiConfig->apiKey = wxT("");
-        m_aiConfig->endpointURL = wxT("https://api.openai.com/v1/chat/completions");
-        m_aiConfig->modelName = wxT("gpt-3.5-turbo");
-        m_aiConfig->temperature = 0.7;
-        m_aiConfig->maxTokens = 1000;
-        m_aiConfig->promptTemplate = wxT("你是一个会议助手，请帮助用户处理会议相关的问题。");
-        
         wxLogInfo(wxT("AI配置文件不存在，使用默认配置"));
         return true;
     }
     
+    nlohmann::json configJson;
+    if (!ReadConfigFile(configJson)) {
+        return false;
+    }
+    
     try {
-        wxFileInputStream input(configFilePath);
-        if (!input.IsOk()) {
-            wxLogWarning(wxT("无法打开AI配置文件: %s"), configFilePath);
-            return false;
-        }
-        
-        wxString jsonStr;
-        char buffer[1024];
-        while (!input.Eof()) {
-            input.Read(buffer, sizeof(buffer));
-            size_t bytesRead = input.LastRead();
-            jsonStr += wxString(buffer, wxConvUTF8, bytesRead);
-        }
-        
-        wxLogInfo(wxT("配置文件内容长度: %zu 字符"), jsonStr.length());
-        wxLogInfo(wxT("配置文件前200字符: %s"), jsonStr.Left(200));
-        
-        // 创建AI配置对象
-        if (!m_aiConfig) {
-            m_aiConfig = new AIConfig();
-        }
-        
-        // 设置默认值
-        m_aiConfig->apiKey = wxT("");
-        m_aiConfig->endpointURL = wxT("https://api.openai.com/v1/chat/completions");
-        m_aiConfig->modelName = wxT("gpt-3.5-turbo");
-        m_aiConfig->temperature = 0.7;
-        m_aiConfig->maxTokens = 1000;
-        m_aiConfig->promptTemplate = wxT("你是一个会议助手，请帮助用户处理会议相关的问题。");
-        
-        // 使用nlohmann/json解析配置文件
-        std::string jsonStrUtf8 = jsonStr.ToUTF8().data();
-        nlohmann::json configJson = nlohmann::json::parse(jsonStrUtf8);
-        
         // 查找AI配置段
         nlohmann::json aiConfig;
         if (configJson.contains("llm") && configJson["llm"].is_object()) {
@@ -4602,6 +5867,10 @@ void MainFrame::OnRecordToggle(wxCommandEvent& event)
         
         // 开始录制
         if (InitializeAudioInput()) {
+            // 录制期间把录音文件、定稿的消息和批注记入恢复日志
+            if (!m_currentSessionPath.IsEmpty()) {
+                m_recoveryLog = std::make_unique<MeetAnt::RecoveryLog>(m_currentSessionPath, m_currentSessionId);
+            }
             StartAudioCapture();
             StartAudioRecording(); // 开始音频保存
             m_isRecording = true;
@@ -4624,8 +5893,11 @@ void MainFrame::OnRecordToggle(wxCommandEvent& event)
         m_recordButton->SetBackgroundColour(wxNullColour);
         SetStatusText(wxT("录制停止"));
         
-        // 保存当前会话
+        // 保存当前会话，之后不再需要恢复日志
         SaveCurrentSession();
+        if (m_recoveryLog) {
+            FinishRecoveryLog(m_recoveryLog->GetSessionPath());
+        }
     }
     m_recordButton->Refresh();
     UpdateTaskBarIconState();
@@ -4641,6 +5913,8 @@ void MainFrame::OnShowConfigDialog(wxCommandEvent& event)
         
         // Reload AI configuration
         LoadAIConfig();
+        LoadAutosaveConfig();
+        LoadArchiveConfig();
     } else {
         SetStatusText(wxT("设置未更改"));
     }
@@ -4690,8 +5964,9 @@ void MainFrame::HandleRecognitionResult(const wxString& text, bool isFinal) {
     // 这个方法应该在UI线程中处理识别结果
     
     if (!isFinal) {
-        // 非最终结果，可以显示为临时文本
-        SetStatusText(wxString::Format(wxT("正在识别: %s"), text));
+        // 非最终结果，在转录末尾的实时气泡中原地更新
+        m_transcriptionBubbleCtrl->SetLiveMessage(wxT("发言人"), text);
+        SetStatusText(wxString::Format(wxT("正在识别: %s"), text.Left(30)));
     } else {
         // 最终结果，添加到转录
         wxRichTextAttr timeAttr;
@@ -4708,12 +5983,29 @@ void MainFrame::HandleRecognitionResult(const wxString& text, bool isFinal) {
         // 添加识别文本
         // m_transcriptionTextCtrl->AppendText(text + wxT("\n"));
         
-        SetStatusText(wxString::Format(wxT("识别文本: %s"), text.Left(30)));
+        // 实时气泡转为正式消息；没有中间结果时直接追加
+        if (m_transcriptionBubbleCtrl->CommitLiveMessage(text) < 0) {
+            m_transcriptionBubbleCtrl->AddMessage(wxT("发言人"), text, now);
+        }
+        
+        // 先记入恢复日志（成批写入），自动保存之前异常退出也不会丢失
+        size_t messageCount = m_transcriptionBubbleCtrl->GetMessageCount();
+        TranscriptionMessage last;
+        if (m_recoveryLog && m_recoveryLog->GetSessionPath() == m_currentSessionPath && messageCount > 0 &&
+            m_transcriptionBubbleCtrl->GetMessageAt(messageCount - 1, last)) {
+            m_recoveryLog->AppendMessage(messageCount - 1, last);
+        }
         
-        // 自动保存会话
-        if (!m_currentSessionPath.IsEmpty()) {
-            SaveCurrentSession();
+        // 定稿的消息在后台编码后加入语义索引
+        if (m_semanticSearch && !m_currentSessionPath.IsEmpty()) {
+            m_semanticSearch->AppendMessage(m_currentSessionId, m_currentSessionPath,
+                                            messageCount - 1, text);
         }
+        
+        SetStatusText(wxString::Format(wxT("识别文本: %s"), text.Left(30)));
+        
+        // 标记转录已变化，自动保存时把新消息追加到转录日志并更新搜索索引
+        MarkSessionDirty(MeetAnt::AutosaveTranscript);
     }
 }
 
@@ -4804,14 +6096,15 @@ void MainFrame::OnPlaybackPositionChanged(wxCommandEvent& event) {
     int positionMs = event.GetInt();
     
     // 根据播放位置滚动到对应的消息
-    const auto& messages = m_transcriptionBubbleCtrl->GetMessages();
-    for (const auto& msg : messages) {
+    size_t messageCount = m_transcriptionBubbleCtrl->GetMessageCount();
+    for (size_t i = 0; i < messageCount; ++i) {
         // 假设消息的时间戳是从录音开始的毫秒数
-        long msgTimeMs = (msg.timestamp.GetTicks() - m_recordingStartTime.GetTicks()) * 1000;
+        long msgTimeMs = (m_transcriptionBubbleCtrl->GetMessageTimestamp(i).GetTicks() -
+                          m_recordingStartTime.GetTicks()) * 1000;
         
         // 找到最接近当前播放位置的消息
         if (msgTimeMs <= positionMs && msgTimeMs + 5000 > positionMs) { // 5秒窗口
-            m_transcriptionBubbleCtrl->ScrollToMessage(msg.messageId);
+            m_transcriptionBubbleCtrl->ScrollToMessage(m_transcriptionBubbleCtrl->GetMessageId(i));
             break;
         }
     }
@@ -25,6 +25,7 @@
 #include <memory>
 #include <vector>
 #include <map>
+#include <unordered_set>
 #include "Annotation.h"
 #include "BookmarkDialog.h"
 #include <portaudio.h>
@@ -32,6 +33,14 @@
 #include "SSEClient.h"
 #include "TranscriptionBubbleCtrl.h"  // 添加新控件头文件
 #include "PlaybackControlBar.h"       // 添加播放控制条头文件
+#include "SessionSearch.h"
+#include "SemanticSearch.h"
+#include "TranscriptLog.h"
+#include "SessionStore.h"
+#include "SessionCatalog.h"
+#include "AutosaveScheduler.h"
+#include "RecoveryLog.h"
+#include "SessionArchive.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -86,6 +95,12 @@ enum {
     ID_Menu_Search,  // 添加搜索菜单ID
     // 新增右键菜单ID
     ID_SessionTreeContext_Remove,
+    ID_SessionTreeContext_GroupByMonth,
+    ID_SessionTreeContext_GroupByWeek,
+    ID_SessionTreeContext_SortByTime,
+    ID_SessionTreeContext_SortByDuration,
+    ID_SessionTreeContext_SortByMessages,
+    ID_SessionTreeContext_SortBySize,
     // 新增导航栏标签页ID
     ID_NavNotebook,
     ID_NavPage_Sessions,
@@ -98,7 +113,10 @@ enum {
     ID_Context_AddNote,
     ID_Context_Highlight,
     ID_Context_SetSpeaker,
-    ID_Context_Copy
+    ID_Context_Copy,
+    ID_SearchResultsTree, // 跨会话搜索结果树
+    ID_SearchPrevButton,  // 上一个搜索结果
+    ID_SearchNextButton   // 下一个搜索结果
 };
 
 // 定义会话数据结构
@@ -107,6 +125,25 @@ struct SessionItem {
     wxString path;
     wxDateTime creationTime;
     bool isActive;
+    // 以下来自会话目录（SessionCatalog），后台扫描完成前为 0
+    int64_t durationMs = 0;
+    size_t messageCount = 0;
+    std::vector<wxString> speakers;
+    int64_t sizeBytes = 0;
+};
+
+// 会话树的分组方式（按创建时间）
+enum class SessionGrouping {
+    Month,
+    Week
+};
+
+// 会话树中同一分组内的排序方式，均为降序
+enum class SessionSortKey {
+    CreationTime,
+    Duration,
+    MessageCount,
+    Size
 };
 
 // 定义发言者数据结构
@@ -130,6 +167,27 @@ public:
         : timestamp(ts), type(t), annotationPtr(ptr) {}
 };
 
+// 跨会话搜索结果树的节点数据
+class SearchResultItemData : public wxTreeItemData {
+public:
+    wxString sessionName;
+    int messageIndex;   // 消息在会话转录中的序号，会话节点为 -1
+
+    SearchResultItemData(const wxString& session, int message)
+        : sessionName(session), messageIndex(message) {}
+};
+
+// 会话树的节点数据：会话节点的 sessionName 非空，分组节点的 sessionName 为空
+class SessionTreeItemData : public wxTreeItemData {
+public:
+    wxString sessionName;
+    wxString groupKey;  // 分组节点的键：按月为 YYYY-MM，按周为该周周一的日期
+    bool populated;     // 分组节点的会话节点是否已创建（首次展开时创建）
+
+    SessionTreeItemData(const wxString& session, const wxString& group)
+        : sessionName(session), groupKey(group), populated(false) {}
+};
+
 // 音频格式枚举
 enum class AudioFormat {
     WAV_PCM16,      // WAV 16位PCM (无损)
@@ -155,6 +213,20 @@ public:
     void OnCreateSession(wxCommandEvent& event);
     void OnSearch(wxCommandEvent& event);
     void OnSearchCancel(wxCommandEvent& event); // 新增：搜索取消事件处理
+    void OnSessionSearchResult(wxThreadEvent& event);  // 跨会话搜索：某个会话的结果
+    void OnSessionSearchDone(wxThreadEvent& event);    // 跨会话搜索：全部完成
+    void OnSessionCatalogUpdated(wxThreadEvent& event); // 会话目录：某个会话的元数据已更新
+    void OnSessionCatalogDone(wxThreadEvent& event);    // 会话目录：后台刷新完成
+    void OnSessionArchived(wxThreadEvent& event);       // 会话归档：一个会话已归档
+    void OnSessionArchiveDone(wxThreadEvent& event);    // 会话归档：本次检查完成
+    void OnSemanticSearchResult(wxThreadEvent& event); // 会话内语义搜索的结果
+    void OnSearchResultSelected(wxTreeEvent& event);   // 选择跨会话搜索结果
+    void OnSearchTextChanged(wxCommandEvent& event);   // 边输入边搜索
+    void OnSearchOptionChanged(wxCommandEvent& event); // 正则/发言人选项变化时重新搜索
+    void OnSearchPrev(wxCommandEvent& event);
+    void OnSearchNext(wxCommandEvent& event);
+    void OnTranscriptionSearchUpdated(wxCommandEvent& event); // 会话内搜索结果更新
+    void OnTranscriptionLoaded(wxCommandEvent& event); // 会话的转录已在后台读完
     void OnHighlight(wxCommandEvent& event);
     void OnBookmark(wxCommandEvent& event);
     // void OnAddNote(wxCommandEvent& event);  // 新增：添加批注
@@ -165,6 +237,9 @@ public:
     
     // 新增：会话树右键菜单
     void OnSessionTreeContextMenu(wxTreeEvent& event);
+    void OnSessionTreeGetTooltip(wxTreeEvent& event);  // 会话树悬停提示：会话的元数据
+    void OnSessionTreeExpanding(wxTreeEvent& event);   // 展开分组时创建其中的会话节点
+    void OnSessionFilterChanged(wxCommandEvent& event); // 按名称或发言人过滤会话树
     
     // 文件操作
     void OnSaveSession(wxCommandEvent& event);
@@ -208,6 +283,7 @@ public:
     void ToggleAnnotationsDisplay(); // 新增：切换批注显示
     void SyncAnnotationScrollPosition(wxScrollWinEvent& event); // 新增：同步批注滚动位置
     void RefreshAnnotations(); // 新增：刷新批注显示
+    void SyncInlineAnnotations(); // 将当前会话的批注同步到转录气泡中内联显示
 
     // 转录消息相关
     int m_selectedTranscriptionMessageId;  // 当前选中的转录消息ID
@@ -219,6 +295,7 @@ public:
     // 播放控制事件处理
     void OnPlaybackPositionChanged(wxCommandEvent& event);
     void OnPlaybackStateChanged(wxCommandEvent& event);
+    void OnPlaybackDensityClicked(wxCommandEvent& event);
 
     // UI控件
     wxTreeCtrl* m_sessionTree;        // 会话树控件
@@ -231,9 +308,36 @@ private:
     void CreateMenuBar();
     void CreateToolBar();
     void LoadSessions();
-    void AddSessionToTree(const wxString& name, const wxString& path, const wxDateTime& creationTime, bool isActive = false);
     // void CreateNewSession(const wxString& name);
     void SaveCurrentSession();
+    // 标记当前会话中变化的部分（AutosavePart 组合），由自动保存合并写入
+    void MarkSessionDirty(unsigned parts);
+    // 保存当前会话中指定的部分（自动保存的保存函数）
+    void SaveSessionParts(unsigned parts);
+    // 用临时文件加重命名写入 session.info，启用会话数据库时同时写入数据库
+    bool WriteSessionInfo();
+    // 配置文件 config.json 的路径（与 ConfigDialog 相同）
+    static wxString GetConfigFilePath();
+    // 读取并解析配置文件；文件不存在时返回 false，无法读取或解析时另外记录警告
+    static bool ReadConfigFile(nlohmann::json& config);
+    // 配置文件中的系统设置（system 对象），没有时为空对象
+    static nlohmann::json ReadSystemConfig();
+    // 从配置文件读取系统设置中的自动保存开关和间隔
+    void LoadAutosaveConfig();
+    // 从配置文件读取系统设置中的归档策略，并在后台归档符合条件的会话
+    void LoadArchiveConfig();
+    // 把尚未写入的定稿消息追加到当前会话的数据库或转录日志
+    void PersistTranscript();
+    // 启用会话数据库时打开当前会话的数据库，新建的数据库导入会话目录中现有的文件
+    bool OpenSessionStore();
+    // 保存当前会话的批注；会话数据库随每次修改更新，这里只把旧数据库的批注整体重写一次
+    void SaveSessionAnnotations();
+    // 会话已保存：等转录日志、会话数据库和批注写完，全部成功后删除恢复日志
+    void FinishRecoveryLog(const wxString& sessionPath);
+    // 启动时检查上次没有正常结束录制的会话，修复录音并补回未保存的内容
+    void RecoverUnfinishedSessions();
+    bool RecoverSession(const wxString& sessionName, const wxString& sessionPath);
+    void LoadSessionTranscript(const wxString& sessionPath);
     wxString CreateSessionDirectory(const wxString& sessionName);
     wxString GetSessionsDirectory() const;
     
@@ -245,9 +349,23 @@ private:
     void CreateNote(const wxString& title, const wxString& content, MeetAnt::TimeStamp timestamp);
     void ApplyHighlight(const wxColour& color);
     void ShowNotePopup(MeetAnt::NoteAnnotation* note);
+    void SaveEditedNote(MeetAnt::NoteAnnotation* note); // 批注弹窗中修改了批注后保存
     
     // 新增：刷新会话树
+    // 只创建分组节点，会话节点在分组展开时创建；保留分组的展开状态和当前会话的选中状态
     void RefreshSessionTree();
+    // 按创建时间排序会话列表（最新的在前）
+    void SortSessions();
+    // 会话所在分组的键和显示名称
+    void GetSessionGroup(const SessionItem& session, wxString* key, wxString* label) const;
+    // 会话名称或发言人包含过滤文本（已转为小写）
+    bool SessionMatchesFilter(const SessionItem& session, const wxString& filter) const;
+    // 创建分组中的会话节点（只在第一次调用时创建）
+    void PopulateSessionGroup(const wxTreeItemId& groupId);
+    // 查找会话节点，必要时创建所在分组的会话节点；会话被过滤掉时返回无效节点
+    wxTreeItemId FindSessionTreeItem(const wxString& sessionName);
+    // 在会话树中选中会话（会触发加载），会话被过滤掉时先清除过滤
+    bool SelectSessionInTree(const wxString& sessionName);
     
     // 新增：添加测试转录数据
     void AddTestTranscriptionData();
@@ -268,6 +386,9 @@ private:
     wxTreeCtrl* m_bookmarkTree;          // 书签树
     wxSearchCtrl* m_searchCtrl;          // 搜索控件
     wxButton* m_createSessionButton;     // 创建会话按钮
+    wxSearchCtrl* m_sessionFilterCtrl;   // 会话树过滤
+    SessionGrouping m_sessionGrouping;   // 会话树的分组方式
+    SessionSortKey m_sessionSortKey;     // 分组内的排序方式
     
     // 主编辑器元素
     wxToolBar* m_editorToolbar;            // 编辑器工具栏
@@ -292,6 +413,9 @@ private:
     wxString m_currentSessionPath;        // 当前会话路径
     wxString m_currentSessionId;          // 当前会话ID
     std::vector<Speaker> m_speakers;      // 发言人列表
+    std::unique_ptr<MeetAnt::TranscriptLog> m_transcriptLog;  // 当前会话的转录日志，后台追加写入
+    std::unique_ptr<MeetAnt::SessionStore> m_sessionStore;    // 启用会话数据库时当前会话的数据库
+    std::unique_ptr<MeetAnt::RecoveryLog> m_recoveryLog;      // 录制中会话的恢复日志
     
     // 批注数据
     std::unique_ptr<MeetAnt::AnnotationManager> m_annotationManager;
@@ -321,13 +445,13 @@ private:
     std::vector<float> m_audioDataBuffer; // 音频数据缓冲区
     size_t m_totalAudioFrames;         // 总音频帧数
     wxTimer* m_audioSaveTimer;         // 音频保存定时器
-    static const size_t AUDIO_SAVE_INTERVAL = 5000; // 每5秒保存一次音频数据
+    static const size_t AUDIO_SAVE_INTERVAL = 1000; // 每秒写入一次音频数据，异常退出时最多丢失约1秒的录音
     static const size_t AUDIO_BUFFER_FRAMES = 48000 * 5; // 5秒的音频缓冲区（48kHz采样率）
     
     // MP3编码相关 - 新增
     AudioFormat m_audioFormat;         // 音频格式
     void* m_lameEncoder;               // LAME编码器句柄
-    std::vector<unsigned char> m_mp3Buffer; // MP3编码缓冲区
+    std::vector<unsigned char> m_mp3Buffer; // 16位PCM转换缓冲区，录制期间写入临时WAV文件，停止时转码
     bool m_isMP3Format;                // 是否使用MP3格式
     int m_mp3Bitrate;                  // MP3比特率
     
@@ -397,14 +521,41 @@ private:
     
     // 搜索控件
     wxCheckBox* m_useRegexCheckBox;      // 使用正则表达式复选框
+    wxCheckBox* m_fuzzySearchCheckBox;   // 拼音模糊匹配复选框
+    wxCheckBox* m_semanticSearchCheckBox; // 语义搜索复选框（需要本地句向量模型）
     wxComboBox* m_speakerFilterComboBox; // 发言人过滤下拉框
+    wxCheckBox* m_searchAllSessionsCheckBox; // 搜索所有会话复选框
+    wxTreeCtrl* m_searchResultsTree;     // 跨会话搜索结果（按会话分组）
+    std::unique_ptr<MeetAnt::SessionSearchManager> m_sessionSearch;  // 会话索引和并行搜索
+    std::unique_ptr<MeetAnt::SessionCatalog> m_sessionCatalog;       // 会话元数据缓存，后台刷新
+    std::unique_ptr<MeetAnt::AutosaveScheduler> m_autosave;          // 当前会话的脏标记和自动保存
+    std::unique_ptr<MeetAnt::SessionArchiveManager> m_sessionArchive; // 按策略在后台归档旧会话
+    bool m_rebuildingSessionTree;        // 重建会话树期间忽略选择变化，不重新加载会话
+    int m_sessionSearchRequest;          // 当前跨会话搜索的请求编号
+    size_t m_sessionSearchHitCount;      // 当前跨会话搜索已收到的命中数
+    std::unique_ptr<MeetAnt::SemanticSearchManager> m_semanticSearch;  // 消息句向量索引和语义搜索
+    int m_semanticSearchRequest;         // 当前语义搜索的请求编号
+    wxButton* m_searchPrevButton;        // 上一个/下一个会话内搜索结果
+    wxButton* m_searchNextButton;
+    wxString m_inSessionSearchKey;       // 当前会话内搜索的查询和选项，用于判断回车是跳到下一个还是重新搜索
+    void StartSessionSearch(const wxString& query, TranscriptionSearchMode mode, const wxString& speaker);
+    void StartInSessionSearch();         // 按搜索框和选项在当前会话中后台搜索
+    void StartSemanticSearch(const wxString& query);
+    wxString GetEmbeddingModelDirectory() const;
+    void UpdateInSessionSearchStatus();  // 在状态栏显示会话内搜索的结果数和当前位置
+    wxString FormatSearchFacets(const TranscriptionSearchFacets& facets) const;  // 发言人、时间段和批注分布摘要
+    void UpdateSearchHitDensity();       // 把会话内搜索的命中时间画到播放条的密度条上
+    TranscriptionSearchMode GetSearchMode() const;
+    wxString GetSearchSpeakerFilter() const;
+    void UpdateSpeakerFilterChoices();   // 用当前会话的发言人刷新发言人过滤下拉框
+    void ClearSessionSearchResults();
 
     // 新增：管理已移除会话的方法
     void SaveRemovedSessionsList();
     void LoadRemovedSessionsList();
     bool IsSessionRemoved(const wxString& sessionName) const;
     wxString GetRemovedSessionsFilePath() const;
-    std::vector<wxString> m_removedSessions; // 已移除会话列表
+    std::unordered_set<wxString> m_removedSessions; // 已移除会话列表（名称转为小写，比较时不区分大小写）
 
     // AI配置结构
     struct AIConfig {
@@ -126,6 +126,11 @@ void NotePopup::OnEdit(wxCommandEvent& event) {
         
         // 更新显示
         SetContent(newTitle, newContent);
+        
+        // 记录修改并保存
+        if (MainFrame* frame = dynamic_cast<MainFrame*>(GetParent())) {
+            frame->SaveEditedNote(m_note);
+        }
     }
 }
 
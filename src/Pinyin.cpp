@@ -0,0 +1,46 @@
+#include "Pinyin.h"
+
+namespace MeetAnt {
+
+namespace {
+#include "PinyinTable.inc"
+
+const wchar_t kFirstHan = 0x4E00;
+const wchar_t kLastHan = 0x9FFF;
+}
+
+const char* GetPinyinSyllable(wchar_t ch) {
+    if (ch < kFirstHan || ch > kLastHan) {
+        return nullptr;
+    }
+    uint16_t index = kPinyinIndex[ch - kFirstHan];
+    return index != 0 ? kPinyinSyllables[index] : nullptr;
+}
+
+std::string ToPinyinKey(const std::wstring& normalizedText, std::vector<uint32_t>* positions) {
+    std::string key;
+    key.reserve(normalizedText.length() * 3);
+    if (positions) {
+        positions->clear();
+        positions->reserve(normalizedText.length() * 3);
+    }
+
+    for (size_t i = 0; i < normalizedText.length(); ++i) {
+        wchar_t ch = normalizedText[i];
+        size_t before = key.length();
+        if ((ch >= L'a' && ch <= L'z') || (ch >= L'0' && ch <= L'9')) {
+            key.push_back(static_cast<char>(ch));
+        } else if (const char* syllable = GetPinyinSyllable(ch)) {
+            key.append(syllable);
+        } else {
+            continue;
+        }
+
+        if (positions) {
+            positions->insert(positions->end(), key.length() - before, static_cast<uint32_t>(i));
+        }
+    }
+    return key;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,19 @@
+#ifndef MEETANT_PINYIN_H
+#define MEETANT_PINYIN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MeetAnt {
+
+// 单个汉字的无声调拼音（小写 ASCII），不是汉字或没有读音时返回 nullptr
+const char* GetPinyinSyllable(wchar_t ch);
+
+// 把规范化后的文本转为拼音键：汉字替换为拼音，半角字母数字原样保留，其余字符丢弃
+// positions 非空时记录每个键字符对应的原文位置（字符）
+std::string ToPinyinKey(const std::wstring& normalizedText, std::vector<uint32_t>* positions = nullptr);
+
+} // namespace MeetAnt
+
+#endif // MEETANT_PINYIN_H
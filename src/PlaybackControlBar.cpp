@@ -1,9 +1,17 @@
 #include "PlaybackControlBar.h"
 #include <wx/dcbuffer.h>
+#include <algorithm>
 
 // 定义事件
 wxDEFINE_EVENT(wxEVT_PLAYBACK_POSITION_CHANGED, wxCommandEvent);
 wxDEFINE_EVENT(wxEVT_PLAYBACK_STATE_CHANGED, wxCommandEvent);
+wxDEFINE_EVENT(wxEVT_PLAYBACK_DENSITY_CLICKED, wxCommandEvent);
+
+namespace {
+    // 命中密度条的高度和每格宽度（像素）
+    const int kDensityStripHeight = 6;
+    const int kDensityCellWidth = 3;
+}
 
 // 事件表
 wxBEGIN_EVENT_TABLE(PlaybackControlBar, wxPanel)
@@ -27,7 +35,8 @@ PlaybackControlBar::PlaybackControlBar(wxWindow* parent, wxWindowID id,
       m_currentTimeLabel(nullptr),
       m_timeSlider(nullptr),
       m_totalTimeLabel(nullptr),
-      m_updateTimer(nullptr)
+      m_updateTimer(nullptr),
+      m_searchSpan(0)
 {
     SetBackgroundColour(wxColour(240, 240, 240));
     SetMinSize(wxSize(300, 80));
@@ -48,6 +57,7 @@ void PlaybackControlBar::CreateComponents() {
     if (m_markerPanel) {
         m_markerPanel->SetBackgroundColour(wxColour(255, 255, 255));
         m_markerPanel->Bind(wxEVT_PAINT, &PlaybackControlBar::OnMarkerPaint, this);
+        m_markerPanel->Bind(wxEVT_LEFT_DOWN, &PlaybackControlBar::OnMarkerLeftDown, this);
     }
     
     // 创建播放/暂停按钮
@@ -248,6 +258,25 @@ void PlaybackControlBar::ClearTimeMarkers() {
     }
 }
 
+void PlaybackControlBar::SetSearchHits(const std::vector<int>& hitTimesMs, int spanMs) {
+    m_searchHits = hitTimesMs;
+    m_searchSpan = spanMs;
+    if (m_markerPanel) {
+        m_markerPanel->Refresh();
+    }
+}
+
+void PlaybackControlBar::ClearSearchHits() {
+    if (m_searchHits.empty()) {
+        return;
+    }
+    m_searchHits.clear();
+    m_searchSpan = 0;
+    if (m_markerPanel) {
+        m_markerPanel->Refresh();
+    }
+}
+
 void PlaybackControlBar::OnPlayPauseButton(wxCommandEvent& event) {
     if (m_isPlaying) {
         Pause();
@@ -298,16 +327,21 @@ wxString PlaybackControlBar::FormatTime(int milliseconds) const {
 }
 
 void PlaybackControlBar::DrawTimeMarkers(wxDC& dc) {
-    if (m_duration <= 0) return;
-    
     wxSize panelSize = m_markerPanel->GetClientSize();
     int width = panelSize.GetWidth();
     int height = panelSize.GetHeight();
     
+    // 没有音频时仍可按转录的时间范围显示命中密度
+    if (m_duration <= 0) {
+        DrawHitDensity(dc, width, height);
+        return;
+    }
+    
     // 绘制背景
     dc.SetBrush(wxBrush(wxColour(250, 250, 250)));
     dc.SetPen(*wxTRANSPARENT_PEN);
     dc.DrawRectangle(0, 0, width, height);
+    DrawHitDensity(dc, width, height);
     
     // 绘制时间轴线
     dc.SetPen(wxPen(wxColour(200, 200, 200), 1));
@@ -342,6 +376,50 @@ void PlaybackControlBar::DrawTimeMarkers(wxDC& dc) {
     }
 }
 
+void PlaybackControlBar::DrawHitDensity(wxDC& dc, int width, int height) {
+    int span = GetTimelineSpan();
+    if (m_searchHits.empty() || span <= 0 || width <= 0) {
+        return;
+    }
+    
+    // 按格统计命中数，颜色深浅表示相对密度
+    int cellCount = std::max(1, width / kDensityCellWidth);
+    std::vector<int> cells(cellCount, 0);
+    int maxCount = 0;
+    for (int timeMs : m_searchHits) {
+        long long cell = static_cast<long long>(std::min(std::max(timeMs, 0), span)) * cellCount / (static_cast<long long>(span) + 1);
+        maxCount = std::max(maxCount, ++cells[static_cast<size_t>(cell)]);
+    }
+    
+    int top = height - kDensityStripHeight;
+    dc.SetPen(*wxTRANSPARENT_PEN);
+    for (int i = 0; i < cellCount; ++i) {
+        if (cells[i] == 0) {
+            continue;
+        }
+        // 最稀疏的格子也保持可见
+        double ratio = 0.25 + 0.75 * cells[i] / maxCount;
+        wxColour color(255, static_cast<unsigned char>(235 - 135 * ratio), static_cast<unsigned char>(200 - 200 * ratio));
+        dc.SetBrush(wxBrush(color));
+        dc.DrawRectangle(i * kDensityCellWidth, top, kDensityCellWidth, kDensityStripHeight);
+    }
+}
+
+void PlaybackControlBar::OnMarkerLeftDown(wxMouseEvent& event) {
+    int span = GetTimelineSpan();
+    int width = m_markerPanel ? m_markerPanel->GetClientSize().GetWidth() : 0;
+    if (m_searchHits.empty() || span <= 0 || width <= 0) {
+        event.Skip();
+        return;
+    }
+    
+    int x = std::min(std::max(event.GetX(), 0), width);
+    wxCommandEvent clickEvent(wxEVT_PLAYBACK_DENSITY_CLICKED, GetId());
+    clickEvent.SetEventObject(this);
+    clickEvent.SetInt(static_cast<int>(static_cast<long long>(x) * span / width));
+    ProcessWindowEvent(clickEvent);
+}
+
 void PlaybackControlBar::OnPaint(wxPaintEvent& event) {
     wxPaintDC dc(this);
     // 可以在这里添加自定义绘制
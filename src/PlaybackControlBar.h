@@ -34,6 +34,11 @@ public:
     void AddTimeMarker(int timeMs, const wxString& label);
     void ClearTimeMarkers();
     
+    // 设置搜索命中的时间（毫秒），在标记面板底部绘制命中密度条
+    // 没有设置总时长时按 spanMs 换算位置；点击密度条发送 wxEVT_PLAYBACK_DENSITY_CLICKED
+    void SetSearchHits(const std::vector<int>& hitTimesMs, int spanMs);
+    void ClearSearchHits();
+    
     // 设置播放速度
     void SetPlaybackSpeed(double speed) { m_playbackSpeed = speed; }
     double GetPlaybackSpeed() const { return m_playbackSpeed; }
@@ -47,6 +52,7 @@ protected:
     void OnSize(wxSizeEvent& event);
     void OnMouse(wxMouseEvent& event);
     void OnMarkerPaint(wxPaintEvent& event);
+    void OnMarkerLeftDown(wxMouseEvent& event);
     
     // 组件创建和布局
     void CreateComponents();
@@ -61,6 +67,12 @@ protected:
     // 绘制时间标记
     void DrawTimeMarkers(wxDC& dc);
     
+    // 绘制搜索命中密度条
+    void DrawHitDensity(wxDC& dc, int width, int height);
+    
+    // 密度条对应的时间范围（毫秒）
+    int GetTimelineSpan() const { return m_duration > 0 ? m_duration : m_searchSpan; }
+    
 private:
     // 控件
     wxButton* m_playPauseButton;
@@ -86,6 +98,10 @@ private:
     };
     std::vector<TimeMarker> m_timeMarkers;
     
+    // 搜索命中的时间（毫秒）和无音频时使用的时间范围
+    std::vector<int> m_searchHits;
+    int m_searchSpan;
+    
     // ID定义
     enum {
         ID_PlayPauseButton = 20000,
@@ -99,5 +115,7 @@ private:
 // 自定义事件
 wxDECLARE_EVENT(wxEVT_PLAYBACK_POSITION_CHANGED, wxCommandEvent);
 wxDECLARE_EVENT(wxEVT_PLAYBACK_STATE_CHANGED, wxCommandEvent);
+// 点击命中密度条，GetInt() 为点击处的时间（毫秒）
+wxDECLARE_EVENT(wxEVT_PLAYBACK_DENSITY_CLICKED, wxCommandEvent);
 
 #endif // PLAYBACK_CONTROL_BAR_H 
\ No newline at end of file
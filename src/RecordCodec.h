@@ -0,0 +1,179 @@
+#ifndef MEETANT_RECORD_CODEC_H
+#define MEETANT_RECORD_CODEC_H
+
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace MeetAnt {
+
+// 带长度前缀的二进制记录
+// 批注快照和日志、转录日志、恢复日志和会话归档的索引共用这套编码：
+// 整数按本机字节序，字符串为 4 字节长度加 UTF-8。
+// 记录文件以 16 字节文件头开始，之后是一串记录，每条为 4 字节长度加记录内容；
+// 追加时最后一条记录可能只写了一半，读取时读到最后一条完整的记录为止。
+
+struct RecordFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t value;             // 代数等，各文件自行定义，不用时写 0
+};
+static_assert(sizeof(RecordFileHeader) == 16, "RecordFileHeader layout");
+
+inline std::string MakeRecordFileHeader(const char* magic, uint32_t version, uint64_t value = 0) {
+    RecordFileHeader header;
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = version;
+    header.value = value;
+    return std::string(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+// 读取文件头，文件太短或标识不符时返回 false（不检查版本）
+inline bool ReadRecordFileHeader(const std::string& data, const char* magic, RecordFileHeader& header) {
+    if (data.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    return std::memcmp(header.magic, magic, sizeof(header.magic)) == 0;
+}
+
+template <typename T>
+inline void AppendValue(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void AppendBytes(std::string& out, const char* data, size_t size) {
+    AppendValue<uint32_t>(out, static_cast<uint32_t>(size));
+    out.append(data, size);
+}
+
+inline void AppendString(std::string& out, const wxString& text) {
+    wxScopedCharBuffer utf8 = text.utf8_str();
+    AppendBytes(out, utf8.data(), utf8.length());
+}
+
+// 开始一条记录，返回长度字段的位置；内容写完后用 EndRecord 填入长度
+inline size_t BeginRecord(std::string& out) {
+    size_t start = out.size();
+    AppendValue<uint32_t>(out, 0);
+    return start;
+}
+
+inline void EndRecord(std::string& out, size_t start) {
+    uint32_t size = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+    std::memcpy(&out[start], &size, sizeof(size));
+}
+
+inline void AppendRecord(std::string& out, const std::string& record) {
+    AppendBytes(out, record.data(), record.size());
+}
+
+// 依次回调文件头之后的完整记录 handler(data, size)，返回最后一条完整记录结束处的偏移
+template <typename Handler>
+size_t ForEachRecord(const std::string& data, Handler handler) {
+    size_t offset = sizeof(RecordFileHeader);
+    if (data.size() < offset) {
+        return data.size();
+    }
+    while (data.size() - offset >= sizeof(uint32_t)) {
+        uint32_t size;
+        std::memcpy(&size, data.data() + offset, sizeof(size));
+        if (size > data.size() - offset - sizeof(size)) {
+            break;
+        }
+        handler(data.data() + offset + sizeof(size), static_cast<size_t>(size));
+        offset += sizeof(size) + size;
+    }
+    return offset;
+}
+
+// 在编码数据上顺序读取，越界时返回 false
+class ByteReader {
+public:
+    ByteReader(const char* data, size_t size) : m_cursor(data), m_end(data + size) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        if (Remaining() < sizeof(value)) {
+            return false;
+        }
+        std::memcpy(&value, m_cursor, sizeof(value));
+        m_cursor += sizeof(value);
+        return true;
+    }
+
+    bool ReadBytes(std::string& bytes) {
+        uint32_t size;
+        if (!Read(size) || Remaining() < size) {
+            return false;
+        }
+        bytes.assign(m_cursor, size);
+        m_cursor += size;
+        return true;
+    }
+
+    bool ReadString(wxString& text) {
+        uint32_t size;
+        if (!Read(size) || Remaining() < size) {
+            return false;
+        }
+        text = wxString::FromUTF8(m_cursor, size);
+        m_cursor += size;
+        return true;
+    }
+
+    size_t Remaining() const { return static_cast<size_t>(m_end - m_cursor); }
+
+private:
+    const char* m_cursor;
+    const char* m_end;
+};
+
+// 读入整个文件，失败时记录警告
+inline bool ReadFileBytes(const wxString& path, std::string& data) {
+    wxFile file;
+    if (!file.Open(path)) {
+        wxLogWarning(wxT("无法打开文件: %s"), path);
+        return false;
+    }
+    wxFileOffset length = file.Length();
+    data.assign(length > 0 ? static_cast<size_t>(length) : 0, '\0');
+    if (!data.empty() && file.Read(&data[0], data.size()) != static_cast<ssize_t>(data.size())) {
+        wxLogWarning(wxT("读取文件失败: %s"), path);
+        return false;
+    }
+    return true;
+}
+
+inline bool WriteFileBytes(wxFile& file, const std::string& data) {
+    return file.Write(data.data(), data.size()) == data.size();
+}
+
+// 把记录文件截断到 length 字节（最后一条完整记录结束处），去掉上次退出时写了一半的记录
+// 先写临时文件并落盘再替换；文件已经是这个长度时什么也不做
+inline bool TrimRecordFile(const wxString& path, wxFileOffset length) {
+    if (wxFileName::GetSize(path) == wxULongLong(length)) {
+        return true;
+    }
+    wxFile source;
+    std::string data(static_cast<size_t>(length), '\0');
+    wxString tempPath = path + wxT(".tmp");
+    wxFile temp;
+    bool copied = source.Open(path) &&
+                  (data.empty() || source.Read(&data[0], data.size()) == static_cast<ssize_t>(data.size())) &&
+                  temp.Create(tempPath, true) && WriteFileBytes(temp, data) && temp.Flush();
+    source.Close();
+    temp.Close();
+    if (!copied || !wxRenameFile(tempPath, path, true)) {
+        wxRemoveFile(tempPath);
+        return false;
+    }
+    return true;
+}
+
+} // namespace MeetAnt
+
+#endif // MEETANT_RECORD_CODEC_H
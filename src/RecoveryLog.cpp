@@ -0,0 +1,248 @@
+#include "RecoveryLog.h"
+#include "RecordCodec.h"
+#include "TranscriptLog.h"
+#include <wx/filename.h>
+#include <algorithm>
+#include <memory>
+
+namespace MeetAnt {
+
+namespace {
+    // 文件格式：RecordCodec 的记录文件，文件头中的值保留，写 0
+    // 记录内容以 1 字节类型开头：
+    //   'S' 会话名
+    //   'A' 录音文件名、数据文件名、4 字节采样率、声道数、位深度
+    //   'M' 4 字节消息位置，之后与转录日志的消息记录相同（TranscriptLog::AppendMessageFields）
+    //   'C' 一次批注修改，内容与批注日志的记录相同（AnnotationManager::ChangeListener）
+    const char kLogMagic[4] = { 'M', 'A', 'R', 'L' };
+    const uint32_t kVersion = 1;
+
+    // 录音文件头的大小（与 MainFrame::WriteWAVHeader 写入的格式一致）
+    const wxFileOffset kWaveHeaderSize = 44;
+
+    // 开始一条记录，返回长度字段的位置
+    size_t BeginRecord(std::string& out, char type) {
+        size_t start = MeetAnt::BeginRecord(out);
+        AppendValue<char>(out, type);
+        return start;
+    }
+
+    bool ApplyRecord(const char* data, size_t size, RecoveryLog::State& state) {
+        ByteReader reader(data, size);
+        char type;
+        if (!reader.Read(type)) {
+            return false;
+        }
+        switch (type) {
+            case 'S':
+                return reader.ReadString(state.sessionName);
+            case 'A': {
+                RecoveryLog::AudioSegment segment;
+                if (!reader.ReadString(segment.fileName) || !reader.ReadString(segment.dataFileName) ||
+                    !reader.Read(segment.sampleRate) || !reader.Read(segment.channels) ||
+                    !reader.Read(segment.bitsPerSample)) {
+                    return false;
+                }
+                state.audioSegments.push_back(segment);
+                return true;
+            }
+            case 'M': {
+                uint32_t index;
+                TranscriptionMessage msg;
+                if (!reader.Read(index) || !TranscriptLog::ReadMessageFields(reader, msg)) {
+                    return false;
+                }
+                state.messages[index] = msg;
+                return true;
+            }
+            case 'C':
+                if (size <= sizeof(type)) {
+                    return false;
+                }
+                state.annotationChanges.emplace_back(data + sizeof(type), size - sizeof(type));
+                return true;
+            default:
+                return false;   // 更新版本的记录类型
+        }
+    }
+
+    // 写入完整的 WAV 文件头，数据大小取整到整帧
+    bool WriteWaveHeader(wxFile& file, const RecoveryLog::AudioSegment& segment, wxFileOffset dataBytes) {
+        uint16_t blockAlign = static_cast<uint16_t>(segment.channels * segment.bitsPerSample / 8);
+        uint32_t dataSize = static_cast<uint32_t>(dataBytes - dataBytes % blockAlign);
+
+        std::string header;
+        header.append("RIFF", 4);
+        AppendValue<uint32_t>(header, dataSize + 36);
+        header.append("WAVEfmt ", 8);
+        AppendValue<uint32_t>(header, 16);
+        AppendValue<uint16_t>(header, segment.bitsPerSample == 32 ? 3 : 1);    // IEEE float / PCM
+        AppendValue<uint16_t>(header, static_cast<uint16_t>(segment.channels));
+        AppendValue<uint32_t>(header, static_cast<uint32_t>(segment.sampleRate));
+        AppendValue<uint32_t>(header, static_cast<uint32_t>(segment.sampleRate) * blockAlign);
+        AppendValue<uint16_t>(header, blockAlign);
+        AppendValue<uint16_t>(header, static_cast<uint16_t>(segment.bitsPerSample));
+        header.append("data", 4);
+        AppendValue<uint32_t>(header, dataSize);
+
+        return file.Seek(0) == 0 && file.Write(header.data(), header.size()) == header.size();
+    }
+}
+
+RecoveryLog::RecoveryLog(const wxString& sessionPath, const wxString& sessionName)
+    : m_sessionPath(sessionPath),
+      m_failed(false),
+      m_writer(kGroupCommitMs, GroupCommitWriter::Task(), [this]() { Sync(); })
+{
+    std::string record;
+    size_t start = BeginRecord(record, 'S');
+    AppendString(record, sessionName);
+    EndRecord(record, start);
+    Post(record);
+}
+
+RecoveryLog::~RecoveryLog() {
+    m_writer.Stop();
+    m_log.Close();
+}
+
+wxString RecoveryLog::GetLogPath(const wxString& sessionPath) {
+    return wxFileName(sessionPath, wxT("recovery.wal")).GetFullPath();
+}
+
+bool RecoveryLog::Exists(const wxString& sessionPath) {
+    return wxFileExists(GetLogPath(sessionPath));
+}
+
+bool RecoveryLog::Remove(const wxString& sessionPath) {
+    wxString logPath = GetLogPath(sessionPath);
+    return !wxFileExists(logPath) || wxRemoveFile(logPath);
+}
+
+void RecoveryLog::BeginAudio(const AudioSegment& segment) {
+    std::string record;
+    size_t start = BeginRecord(record, 'A');
+    AppendString(record, segment.fileName);
+    AppendString(record, segment.dataFileName);
+    AppendValue<int32_t>(record, segment.sampleRate);
+    AppendValue<int32_t>(record, segment.channels);
+    AppendValue<int32_t>(record, segment.bitsPerSample);
+    EndRecord(record, start);
+    Post(record);
+}
+
+void RecoveryLog::AppendMessage(size_t index, const TranscriptionMessage& msg) {
+    std::string record;
+    size_t start = BeginRecord(record, 'M');
+    AppendValue<uint32_t>(record, static_cast<uint32_t>(index));
+    TranscriptLog::AppendMessageFields(record, msg);
+    EndRecord(record, start);
+    Post(record);
+}
+
+void RecoveryLog::AppendAnnotationChange(const std::string& change) {
+    std::string record;
+    size_t start = BeginRecord(record, 'C');
+    record.append(change);
+    EndRecord(record, start);
+    Post(record);
+}
+
+void RecoveryLog::Post(const std::string& record) {
+    auto data = std::make_shared<std::string>(record);
+    m_writer.Post([this, data]() {
+        m_pending.append(*data);
+    });
+}
+
+bool RecoveryLog::OpenLog() {
+    if (m_log.IsOpened()) {
+        return true;
+    }
+    if (m_failed) {
+        return false;
+    }
+
+    wxString logPath = GetLogPath(m_sessionPath);
+    if (!m_log.Create(logPath, true) || !WriteFileBytes(m_log, MakeRecordFileHeader(kLogMagic, kVersion))) {
+        wxLogWarning(wxT("无法创建恢复日志: %s"), logPath);
+        m_log.Close();
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+void RecoveryLog::Sync() {
+    if (m_pending.empty()) {
+        return;
+    }
+    if (OpenLog()) {
+        if (m_log.Write(m_pending.data(), m_pending.size()) != m_pending.size() || !m_log.Flush()) {
+            wxLogWarning(wxT("写入恢复日志失败: %s"), GetLogPath(m_sessionPath));
+        }
+    }
+    m_pending.clear();
+}
+
+bool RecoveryLog::Read(const wxString& sessionPath, State& state) {
+    wxString logPath = GetLogPath(sessionPath);
+    std::string data;
+    if (!wxFileExists(logPath) || !ReadFileBytes(logPath, data)) {
+        return false;
+    }
+
+    RecordFileHeader header;
+    if (!ReadRecordFileHeader(data, kLogMagic, header) || header.version != kVersion) {
+        wxLogWarning(wxT("无法识别的恢复日志: %s"), logPath);
+        return false;
+    }
+
+    // 最后一条记录可能只写了一半，读到最后一条完整记录为止
+    ForEachRecord(data, [&](const char* record, size_t size) {
+        if (!ApplyRecord(record, size, state)) {
+            wxLogWarning(wxT("跳过恢复日志中无法解析的记录: %s"), logPath);
+        }
+    });
+    return true;
+}
+
+bool RecoveryLog::RepairAudio(const wxString& sessionPath, const AudioSegment& segment, wxString* recoveredPath) {
+    wxString dataPath = wxFileName(sessionPath, segment.dataFileName).GetFullPath();
+    if (!wxFileExists(dataPath)) {
+        return false;   // 正常结束的录音（MP3 的数据文件已在转码后删除）或还没创建
+    }
+    if (segment.sampleRate <= 0 || segment.channels <= 0 ||
+        (segment.bitsPerSample != 16 && segment.bitsPerSample != 32)) {
+        wxLogWarning(wxT("恢复日志中的录音格式无效: %s"), dataPath);
+        return false;
+    }
+
+    wxFile file;
+    if (!file.Open(dataPath, wxFile::read_write)) {
+        wxLogWarning(wxT("无法打开录音文件: %s"), dataPath);
+        return false;
+    }
+    wxFileOffset dataBytes = std::max<wxFileOffset>(file.Length() - kWaveHeaderSize, 0);
+    bool repaired = WriteWaveHeader(file, segment, dataBytes) && file.Flush();
+    file.Close();
+    if (!repaired) {
+        wxLogWarning(wxT("修复录音文件头失败: %s"), dataPath);
+        return false;
+    }
+
+    // 没来得及转码的录音保留为 WAV
+    *recoveredPath = dataPath;
+    if (segment.dataFileName != segment.fileName) {
+        wxFileName target(sessionPath, segment.fileName);
+        target.SetExt(wxT("wav"));
+        if (!target.FileExists() && wxRenameFile(dataPath, target.GetFullPath(), false)) {
+            *recoveredPath = target.GetFullPath();
+        } else {
+            wxLogWarning(wxT("无法重命名恢复的录音文件: %s"), dataPath);
+        }
+    }
+    return true;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,90 @@
+#ifndef MEETANT_RECOVERY_LOG_H
+#define MEETANT_RECOVERY_LOG_H
+
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "GroupCommitWriter.h"
+#include "TranscriptionBubbleCtrl.h"
+
+namespace MeetAnt {
+
+// 录制中会话的预写恢复日志 recovery.wal
+// 录制开始时创建，记录正在写入的录音文件、每条定稿的消息和每次批注修改，
+// 正常停止并保存完会话后删除。启动时会话目录中仍有这个文件，说明上次录制没有正常结束：
+// 读出日志，修复录音文件头，把自动保存还没来得及写入的消息和批注补回会话。
+// 文件是 RecordCodec 的记录文件，与转录日志相同：16 字节文件头之后是一串以 4 字节长度开头的记录，
+// 消息记录的内容也与转录日志相同（另加消息位置）。
+// 记录在调用线程中编码，由后台线程（GroupCommitWriter）按 kGroupCommitMs 成批写入，每批只写一次、fsync 一次。
+class RecoveryLog {
+public:
+    // 录制中的录音文件
+    struct AudioSegment {
+        wxString fileName;      // 录音完成后的文件名（会话目录中）
+        wxString dataFileName;  // 录制期间实际写入 PCM 数据的 WAV 文件名，MP3 录音停止时才转码
+        int32_t sampleRate;
+        int32_t channels;
+        int32_t bitsPerSample;
+
+        AudioSegment() : sampleRate(0), channels(0), bitsPerSample(0) {}
+    };
+
+    // 从日志中读出的内容
+    struct State {
+        wxString sessionName;
+        std::vector<AudioSegment> audioSegments;
+        std::map<size_t, TranscriptionMessage> messages;    // 消息在转录中的位置 -> 消息
+        std::vector<std::string> annotationChanges;         // 按顺序的批注修改，每项为批注日志的一条记录
+    };
+
+    // 在会话目录中新建日志（覆盖残留的旧日志）并启动写入线程
+    RecoveryLog(const wxString& sessionPath, const wxString& sessionName);
+    // 写完已提交的记录并 fsync 后停止写入线程，日志文件保留
+    ~RecoveryLog();
+
+    const wxString& GetSessionPath() const { return m_sessionPath; }
+
+    // 以下方法立即返回
+    void BeginAudio(const AudioSegment& segment);
+    void AppendMessage(size_t index, const TranscriptionMessage& msg);
+    // change 为 AnnotationManager 的日志记录，按批注编号引用批注
+    void AppendAnnotationChange(const std::string& change);
+
+    static wxString GetLogPath(const wxString& sessionPath);
+    static bool Exists(const wxString& sessionPath);
+    static bool Remove(const wxString& sessionPath);
+
+    // 读取日志到最后一条完整的记录，日志不存在或文件头无效时返回 false
+    static bool Read(const wxString& sessionPath, State& state);
+
+    // 按文件大小修复录制中断的 WAV 文件头；数据文件不是最终文件时改名为同名的 .wav
+    // 成功时 recoveredPath 为修复后的文件路径
+    static bool RepairAudio(const wxString& sessionPath, const AudioSegment& segment, wxString* recoveredPath);
+
+    // 同一批记录最多等待这么久（毫秒）再写入
+    static const long kGroupCommitMs = 1000;
+
+private:
+    void Post(const std::string& record);
+
+    // 以下方法只在写入线程中调用
+    bool OpenLog();
+    void Sync();
+
+    wxString m_sessionPath;
+
+    // 写入线程独占的状态
+    wxFile m_log;
+    bool m_failed;              // 无法创建日志后不再重试
+    std::string m_pending;      // 本批尚未写入的记录
+
+    // 最后构造：写入线程启动时其他成员都已初始化
+    GroupCommitWriter m_writer;
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_RECOVERY_LOG_H
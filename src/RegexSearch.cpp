@@ -0,0 +1,298 @@
+#include "RegexSearch.h"
+#include <re2/re2.h>
+
+namespace MeetAnt {
+
+namespace {
+    // 宽字符串转 UTF-8
+    std::string ToUtf8(const std::wstring& text) {
+        std::string utf8;
+        utf8.reserve(text.length() * 3);
+
+        size_t i = 0;
+        while (i < text.length()) {
+            uint32_t cp = static_cast<uint32_t>(text[i++]);
+            // wchar_t 为 16 位时组合代理对
+            if (cp >= 0xD800 && cp <= 0xDBFF && i < text.length()) {
+                uint32_t low = static_cast<uint32_t>(text[i]);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i++;
+                }
+            }
+            if (cp >= 0xD800 && cp <= 0xDFFF) {
+                cp = 0xFFFD;    // 孤立的代理项
+            }
+
+            if (cp < 0x80) {
+                utf8.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                utf8.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                utf8.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x10000) {
+                utf8.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                utf8.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                utf8.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else {
+                utf8.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                utf8.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                utf8.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                utf8.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+        }
+        return utf8;
+    }
+
+    // 把 ToUtf8 结果中递增的字节位置换算为原文中的字符位置，每次从上一次的位置继续数
+    class CharCursor {
+    public:
+        explicit CharCursor(const std::string& utf8) : m_utf8(utf8), m_byte(0), m_char(0) {}
+
+        size_t ToChar(size_t byte) {
+            for (; m_byte < byte; ++m_byte) {
+                unsigned char lead = static_cast<unsigned char>(m_utf8[m_byte]);
+                if ((lead & 0xC0) != 0x80) {
+                    // 四字节序列在 16 位 wchar_t 中是一对代理项
+                    m_char += (lead >= 0xF0 && sizeof(wchar_t) == 2) ? 2 : 1;
+                }
+            }
+            return m_char;
+        }
+
+    private:
+        const std::string& m_utf8;
+        size_t m_byte;
+        size_t m_char;
+    };
+
+    bool IsHighSurrogate(wchar_t ch) { return ch >= 0xD800 && ch <= 0xDBFF; }
+    bool IsLowSurrogate(wchar_t ch) { return ch >= 0xDC00 && ch <= 0xDFFF; }
+
+    // 去掉字面串末尾的一个字符（量词使其变为可选）
+    void DropLastChar(std::wstring& run) {
+        if (run.empty()) {
+            return;
+        }
+        bool pair = run.length() >= 2 && IsLowSurrogate(run.back()) && IsHighSurrogate(run[run.length() - 2]);
+        run.erase(run.length() - (pair ? 2 : 1));
+    }
+
+    // 跳过字符类 [...]，返回 ']' 之后的位置
+    size_t SkipClass(const std::wstring& pattern, size_t pos) {
+        size_t i = pos + 1;
+        if (i < pattern.length() && pattern[i] == L'^') {
+            i++;
+        }
+        if (i < pattern.length() && pattern[i] == L']') {
+            i++;    // 紧跟在开头的 ']' 是字面字符
+        }
+        while (i < pattern.length() && pattern[i] != L']') {
+            if (pattern[i] == L'\\') {
+                i++;
+            } else if (pattern[i] == L'[' && i + 1 < pattern.length() && pattern[i + 1] == L':') {
+                // POSIX 类 [:alpha:]
+                size_t end = pattern.find(L":]", i + 2);
+                if (end != std::wstring::npos) {
+                    i = end + 1;
+                }
+            }
+            i++;
+        }
+        return std::min(i + 1, pattern.length());
+    }
+
+    // 跳过分组 (...)，返回 ')' 之后的位置
+    size_t SkipGroup(const std::wstring& pattern, size_t pos) {
+        int depth = 0;
+        size_t i = pos;
+        while (i < pattern.length()) {
+            wchar_t ch = pattern[i];
+            if (ch == L'\\') {
+                i += 2;
+                continue;
+            }
+            if (ch == L'[') {
+                i = SkipClass(pattern, i);
+                continue;
+            }
+            if (ch == L'(') {
+                depth++;
+            } else if (ch == L')') {
+                if (--depth == 0) {
+                    return i + 1;
+                }
+            }
+            i++;
+        }
+        return pattern.length();
+    }
+}
+
+RegexQuery::RegexQuery() {
+}
+
+RegexQuery::~RegexQuery() {
+}
+
+bool RegexQuery::Compile(const std::wstring& pattern, bool caseSensitive) {
+    m_regex.reset();
+    m_error.clear();
+    m_literals.clear();
+
+    RE2::Options options;
+    options.set_case_sensitive(caseSensitive);
+    options.set_log_errors(false);
+
+    std::unique_ptr<RE2> regex(new RE2(ToUtf8(pattern), options));
+    if (!regex->ok()) {
+        const std::string& error = regex->error();
+        m_error.assign(error.begin(), error.end());
+        return false;
+    }
+
+    m_regex = std::move(regex);
+    for (const auto& literal : ExtractRequiredLiterals(pattern)) {
+        m_literals.push_back(SearchIndex::Normalize(literal));
+    }
+    return true;
+}
+
+bool RegexQuery::Match(const std::wstring& text, size_t document, std::vector<SearchHit>& hits, size_t maxHits) const {
+    if (!m_regex) {
+        return false;
+    }
+
+    // 字符位置只在命中时换算，不为每篇文档建立字节到字符的对照表
+    std::string utf8 = ToUtf8(text);
+    re2::StringPiece input(utf8);
+    CharCursor cursor(utf8);
+
+    bool matched = false;
+    size_t pos = 0;
+    re2::StringPiece match;
+    while (pos <= utf8.size() &&
+           m_regex->Match(input, pos, utf8.size(), RE2::UNANCHORED, &match, 1)) {
+        size_t begin = static_cast<size_t>(match.data() - utf8.data());
+        size_t end = begin + match.size();
+
+        if (end > begin) {
+            matched = true;
+            size_t offset = cursor.ToChar(begin);
+            hits.push_back(SearchHit{document, offset, cursor.ToChar(end) - offset});
+            if (maxHits > 0 && hits.size() >= maxHits) {
+                break;
+            }
+            pos = end;
+        } else {
+            // 空匹配：前进到下一个字符的起始字节
+            pos = begin + 1;
+            while (pos < utf8.size() && (static_cast<unsigned char>(utf8[pos]) & 0xC0) == 0x80) {
+                pos++;
+            }
+        }
+    }
+    return matched;
+}
+
+std::vector<std::wstring> RegexQuery::ExtractRequiredLiterals(const std::wstring& pattern) {
+    std::vector<std::wstring> literals;
+    std::wstring run;
+
+    auto flush = [&literals, &run]() {
+        if (!run.empty()) {
+            literals.push_back(run);
+            run.clear();
+        }
+    };
+
+    size_t i = 0;
+    while (i < pattern.length()) {
+        wchar_t ch = pattern[i];
+        switch (ch) {
+            case L'|':
+                // 顶层分支：任何一段都不是必然出现的
+                return std::vector<std::wstring>();
+
+            case L'\\': {
+                if (i + 1 >= pattern.length()) {
+                    flush();
+                    i++;
+                    break;
+                }
+                wchar_t next = pattern[i + 1];
+                if (next == L'n') {
+                    run.push_back(L'\n');
+                } else if (next == L't') {
+                    run.push_back(L'\t');
+                } else if ((next >= L'a' && next <= L'z') || (next >= L'A' && next <= L'Z') ||
+                           (next >= L'0' && next <= L'9')) {
+                    // \d \w \b \p{..} 反向引用等都不是字面字符
+                    flush();
+                    if ((next == L'p' || next == L'P') && i + 2 < pattern.length() && pattern[i + 2] == L'{') {
+                        size_t end = pattern.find(L'}', i + 3);
+                        i = (end == std::wstring::npos) ? pattern.length() : end + 1;
+                        break;
+                    }
+                } else {
+                    run.push_back(next);    // 转义的标点
+                }
+                i += 2;
+                break;
+            }
+
+            case L'[':
+                flush();
+                i = SkipClass(pattern, i);
+                break;
+
+            case L'(':
+                // 分组内容可能含分支或本身可选，保守地整体跳过
+                flush();
+                i = SkipGroup(pattern, i);
+                break;
+
+            case L'*':
+            case L'?':
+                DropLastChar(run);
+                flush();
+                i++;
+                break;
+
+            case L'{': {
+                size_t end = pattern.find(L'}', i);
+                if (end == std::wstring::npos) {
+                    run.push_back(ch);      // 不构成重复次数，按字面处理
+                    i++;
+                    break;
+                }
+                // {0} {0,n} 使前一个字符可选；否则前一个字符至少出现一次
+                bool optional = pattern[i + 1] == L'0' && (i + 2 == end || pattern[i + 2] == L',');
+                if (optional) {
+                    DropLastChar(run);
+                }
+                flush();
+                i = end + 1;
+                break;
+            }
+
+            case L'+':
+            case L'.':
+            case L'^':
+            case L'$':
+            case L')':
+                flush();
+                i++;
+                break;
+
+            default:
+                run.push_back(ch);
+                i++;
+                break;
+        }
+    }
+    flush();
+
+    return literals;
+}
+
+} // namespace MeetAnt
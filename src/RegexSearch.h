@@ -0,0 +1,97 @@
+#ifndef MEETANT_REGEX_SEARCH_H
+#define MEETANT_REGEX_SEARCH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include "SearchIndex.h"
+
+namespace re2 {
+class RE2;
+}
+
+namespace MeetAnt {
+
+// 编译一次、可在多篇文档上重复匹配的正则查询
+// 先从模式中提取匹配结果必然包含的字面子串，通过倒排索引筛选候选文档，
+// 再用 RE2（线性时间、不回溯）只在候选文档上匹配。编译后的对象可被多个线程同时使用。
+class RegexQuery {
+public:
+    RegexQuery();
+    ~RegexQuery();
+
+    // 编译模式，失败时返回 false，错误信息见 GetError
+    bool Compile(const std::wstring& pattern, bool caseSensitive);
+    bool IsValid() const { return m_regex != nullptr; }
+    const std::wstring& GetError() const { return m_error; }
+
+    // 必然出现在匹配结果中的字面子串（已规范化）
+    const std::vector<std::wstring>& GetRequiredLiterals() const { return m_literals; }
+
+    // 用索引筛选可能匹配的文档（已排序）
+    // Index 需提供 FindCandidates(normalizedQuery, wholeWords, usedIndex) 和 GetDocumentCount()
+    // 没有字面串或字面串不够有区分度时不查索引，返回全部文档，由调用者逐篇匹配
+    template <typename Index>
+    std::vector<uint32_t> FindCandidates(const Index& index) const;
+
+    // 一个字面串的候选超过全部文档的 1/kSelectiveDivisor 时不用它筛选：
+    // 省下的匹配抵不上求交集和按候选跳读的开销
+    static const size_t kSelectiveDivisor = 4;
+
+    // 在原文中查找所有不重叠的非空匹配，位置以字符计；maxHits 为 hits 的总数上限（0 不限）
+    // 返回本篇文档是否有匹配
+    bool Match(const std::wstring& text, size_t document, std::vector<SearchHit>& hits, size_t maxHits) const;
+
+    // 从模式的顶层提取必然出现的字面子串；含顶层分支（|）时返回空
+    static std::vector<std::wstring> ExtractRequiredLiterals(const std::wstring& pattern);
+
+private:
+    std::unique_ptr<re2::RE2> m_regex;
+    std::wstring m_error;
+    std::vector<std::wstring> m_literals;
+
+    RegexQuery(const RegexQuery&) = delete;
+    RegexQuery& operator=(const RegexQuery&) = delete;
+};
+
+template <typename Index>
+std::vector<uint32_t> RegexQuery::FindCandidates(const Index& index) const {
+    std::vector<uint32_t> result;
+    bool filtered = false;
+    size_t documentCount = index.GetDocumentCount();
+
+    for (const auto& literal : m_literals) {
+        bool usedIndex = false;
+        std::vector<uint32_t> list = index.FindCandidates(literal, false, &usedIndex);
+        if (!usedIndex || list.size() > documentCount / kSelectiveDivisor) {
+            continue;   // 字面串中没有可索引的字符，或几乎每篇都有
+        }
+        if (!filtered) {
+            result = std::move(list);
+            filtered = true;
+        } else {
+            std::vector<uint32_t> merged;
+            std::set_intersection(result.begin(), result.end(), list.begin(), list.end(),
+                                  std::back_inserter(merged));
+            result.swap(merged);
+        }
+        if (result.empty()) {
+            return result;
+        }
+    }
+
+    if (!filtered) {
+        result.resize(documentCount);
+        for (size_t i = 0; i < result.size(); ++i) {
+            result[i] = static_cast<uint32_t>(i);
+        }
+    }
+    return result;
+}
+
+} // namespace MeetAnt
+
+#endif // MEETANT_REGEX_SEARCH_H
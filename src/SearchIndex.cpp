@@ -0,0 +1,611 @@
+#include "SearchIndex.h"
+#include "Pinyin.h"
+#include <algorithm>
+
+namespace MeetAnt {
+
+namespace {
+    // 拼音键的字符集：小写字母和数字
+    const int kPinyinAlphabet = 36;
+
+    int PinyinCharSlot(char ch) {
+        if (ch >= 'a' && ch <= 'z') {
+            return ch - 'a';
+        }
+        if (ch >= '0' && ch <= '9') {
+            return 26 + (ch - '0');
+        }
+        return -1;
+    }
+
+    size_t PopCount(uint64_t bits) {
+        size_t count = 0;
+        for (; bits != 0; bits &= bits - 1) {
+            count++;
+        }
+        return count;
+    }
+}
+
+SearchIndex::SearchIndex(bool keepTexts)
+    : m_keepTexts(keepTexts),
+      m_documentCount(0) {
+}
+
+size_t SearchIndex::AddDocument(const std::wstring& text) {
+    uint32_t document = static_cast<uint32_t>(m_documentCount);
+    std::wstring normalized = Normalize(text);
+    size_t length = normalized.length();
+
+    size_t i = 0;
+    while (i < length) {
+        wchar_t ch = normalized[i];
+        if (IsCjkChar(ch)) {
+            // 单字和与下一个字组成的双字
+            AppendPosting(m_grams[MakeGramKey(ch, 0)], document);
+            if (i + 1 < length && IsCjkChar(normalized[i + 1])) {
+                AppendPosting(m_grams[MakeGramKey(ch, normalized[i + 1])], document);
+            }
+            i++;
+        } else if (IsWordChar(ch)) {
+            size_t end = i + 1;
+            while (end < length && IsWordChar(normalized[end])) {
+                end++;
+            }
+            AppendPosting(m_words[normalized.substr(i, end - i)], document);
+            i = end;
+        } else {
+            i++;
+        }
+    }
+
+    std::string key = ToPinyinKey(normalized);
+    if (m_pinyinBigrams.empty()) {
+        m_pinyinBigrams.resize(kPinyinAlphabet * kPinyinAlphabet);
+    }
+    const size_t word = document / 64;
+    const uint64_t bit = uint64_t(1) << (document % 64);
+    for (size_t k = 0; k + 1 < key.length(); ++k) {
+        int slot = PinyinBigramSlot(key[k], key[k + 1]);
+        if (slot >= 0) {
+            DocumentBitmap& bitmap = m_pinyinBigrams[slot];
+            if (bitmap.size() <= word) {
+                bitmap.resize(word + 1, 0);
+            }
+            bitmap[word] |= bit;
+        }
+    }
+
+    if (m_keepTexts) {
+        m_pinyinKeys.push_back(std::move(key));
+        m_texts.push_back(std::move(normalized));
+    }
+    m_documentCount++;
+    return document;
+}
+
+void SearchIndex::Clear() {
+    m_documentCount = 0;
+    m_texts.clear();
+    m_pinyinKeys.clear();
+    m_grams.clear();
+    m_words.clear();
+    m_pinyinBigrams.clear();
+}
+
+std::vector<SearchHit> SearchIndex::Search(const std::wstring& query, size_t maxHits) const {
+    std::vector<SearchHit> hits;
+
+    std::wstring normalized;
+    bool phrase = false;
+    if (!m_keepTexts || !PrepareQuery(query, &normalized, &phrase)) {
+        return hits;
+    }
+
+    std::vector<std::wstring> segments;
+    if (phrase) {
+        segments = SplitPhrase(normalized);
+        if (segments.empty()) {
+            return hits;
+        }
+    }
+
+    std::vector<uint32_t> candidates = FindCandidates(normalized, phrase);
+    for (uint32_t document : candidates) {
+        FindInText(m_texts[document], document, normalized, phrase ? &segments : nullptr, hits, maxHits);
+        if (maxHits > 0 && hits.size() >= maxHits) {
+            break;
+        }
+    }
+
+    return hits;
+}
+
+bool SearchIndex::PrepareQuery(const std::wstring& query, std::wstring* normalized, bool* phrase) {
+    *normalized = Normalize(query);
+    *phrase = false;
+    if (normalized->length() >= 2 && normalized->front() == L'"' && normalized->back() == L'"') {
+        *phrase = true;
+        *normalized = normalized->substr(1, normalized->length() - 2);
+    }
+    return !normalized->empty();
+}
+
+std::vector<std::wstring> SearchIndex::SplitPhrase(const std::wstring& normalized) {
+    std::vector<std::wstring> segments;
+    size_t i = 0;
+    while (i < normalized.length()) {
+        if (!IsWordChar(normalized[i]) && !IsCjkChar(normalized[i])) {
+            i++;
+            continue;
+        }
+        size_t end = i;
+        while (end < normalized.length() && (IsWordChar(normalized[end]) || IsCjkChar(normalized[end]))) {
+            end++;
+        }
+        segments.push_back(normalized.substr(i, end - i));
+        i = end;
+    }
+    return segments;
+}
+
+void SearchIndex::FindInText(const std::wstring& text, size_t document, const std::wstring& normalizedQuery,
+                             const std::vector<std::wstring>* phraseSegments,
+                             std::vector<SearchHit>& hits, size_t maxHits) {
+    if (phraseSegments) {
+        VerifyPhrase(text, document, *phraseSegments, hits, maxHits);
+    } else {
+        VerifySubstring(text, document, normalizedQuery, hits, maxHits);
+    }
+}
+
+std::vector<uint32_t> SearchIndex::FindCandidates(const std::wstring& normalizedQuery, bool wholeWords,
+                                                  bool* usedIndex) const {
+    std::vector<QueryTerm> terms = ParseQuery(normalizedQuery, wholeWords);
+
+    if (terms.empty()) {
+        // 没有可索引的字符（例如只有标点），只能逐篇校验
+        if (usedIndex) {
+            *usedIndex = false;
+        }
+        return AllDocuments();
+    }
+
+    if (usedIndex) {
+        *usedIndex = true;
+    }
+
+    // 整字和整词的倒排表不复制，只复制求交集的起点
+    std::vector<PostingList> merged(terms.size());
+    std::vector<const PostingList*> lists;
+    lists.reserve(terms.size());
+    for (size_t i = 0; i < terms.size(); ++i) {
+        const PostingList* list = LookupTerm(terms[i], merged[i]);
+        if (!list || list->empty()) {
+            return PostingList();
+        }
+        lists.push_back(list);
+    }
+
+    // 从最短的倒排表开始求交集
+    std::sort(lists.begin(), lists.end(),
+              [](const PostingList* a, const PostingList* b) { return a->size() < b->size(); });
+
+    PostingList result = *lists[0];
+    for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+        result = Intersect(result, *lists[i]);
+    }
+    return result;
+}
+
+size_t SearchIndex::CountPinyinCandidates(const std::string& piece) const {
+    DocumentBitmap bitmap;
+    if (!MatchPinyinPiece(piece, bitmap)) {
+        return m_documentCount;
+    }
+    size_t count = 0;
+    for (uint64_t bits : bitmap) {
+        count += PopCount(bits);
+    }
+    return count;
+}
+
+std::vector<uint32_t> SearchIndex::FindPinyinCandidates(const std::vector<std::string>& pieces) const {
+    DocumentBitmap merged;
+    DocumentBitmap bitmap;
+    for (const auto& piece : pieces) {
+        if (!MatchPinyinPiece(piece, bitmap)) {
+            return AllDocuments();
+        }
+        if (merged.size() < bitmap.size()) {
+            merged.resize(bitmap.size(), 0);
+        }
+        for (size_t i = 0; i < bitmap.size(); ++i) {
+            merged[i] |= bitmap[i];
+        }
+    }
+
+    std::vector<uint32_t> result;
+    for (size_t i = 0; i < merged.size(); ++i) {
+        if (merged[i] == 0) {
+            continue;
+        }
+        for (size_t b = 0; b < 64; ++b) {
+            if (merged[i] & (uint64_t(1) << b)) {
+                result.push_back(static_cast<uint32_t>(i * 64 + b));
+            }
+        }
+    }
+    return result;
+}
+
+bool SearchIndex::MatchPinyinPiece(const std::string& piece, DocumentBitmap& bitmap) const {
+    if (piece.length() < 2) {
+        return false;
+    }
+    bitmap.clear();
+    for (size_t k = 0; k + 1 < piece.length(); ++k) {
+        int slot = PinyinBigramSlot(piece[k], piece[k + 1]);
+        if (slot < 0) {
+            return false;
+        }
+        if (m_pinyinBigrams.empty()) {
+            // 还没有文档
+            continue;
+        }
+        const DocumentBitmap& other = m_pinyinBigrams[slot];
+        if (k == 0) {
+            bitmap = other;
+        } else {
+            // 位图只延伸到最后一篇含该字母对的文档，缺少的部分视为 0
+            if (bitmap.size() > other.size()) {
+                bitmap.resize(other.size());
+            }
+            for (size_t i = 0; i < bitmap.size(); ++i) {
+                bitmap[i] &= other[i];
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<uint32_t> SearchIndex::AllDocuments() const {
+    std::vector<uint32_t> all(m_documentCount);
+    for (size_t i = 0; i < all.size(); ++i) {
+        all[i] = static_cast<uint32_t>(i);
+    }
+    return all;
+}
+
+std::wstring SearchIndex::Normalize(const std::wstring& text) {
+    std::wstring normalized(text);
+    for (auto& ch : normalized) {
+        ch = NormalizeChar(ch);
+    }
+    return normalized;
+}
+
+wchar_t SearchIndex::NormalizeChar(wchar_t ch) {
+    if (ch < 0x80) {
+        return (ch >= L'A' && ch <= L'Z') ? static_cast<wchar_t>(ch + 32) : ch;
+    }
+
+    // 全角数字和字母
+    if (ch >= 0xFF10 && ch <= 0xFF19) {
+        return static_cast<wchar_t>(L'0' + (ch - 0xFF10));
+    }
+    if (ch >= 0xFF21 && ch <= 0xFF3A) {
+        return static_cast<wchar_t>(L'a' + (ch - 0xFF21));
+    }
+    if (ch >= 0xFF41 && ch <= 0xFF5A) {
+        return static_cast<wchar_t>(L'a' + (ch - 0xFF41));
+    }
+
+    // 拉丁字母补充
+    if (ch >= 0xC0 && ch <= 0xDE && ch != 0xD7) {
+        return static_cast<wchar_t>(ch + 32);
+    }
+
+    // 拉丁字母扩展A中大小写成对排列的部分
+    if (((ch >= 0x100 && ch <= 0x137) || (ch >= 0x14A && ch <= 0x177)) && (ch % 2 == 0)) {
+        return static_cast<wchar_t>(ch + 1);
+    }
+
+    // 希腊字母和西里尔字母
+    if (ch >= 0x391 && ch <= 0x3A9 && ch != 0x3A2) {
+        return static_cast<wchar_t>(ch + 32);
+    }
+    if (ch >= 0x410 && ch <= 0x42F) {
+        return static_cast<wchar_t>(ch + 32);
+    }
+    if (ch >= 0x400 && ch <= 0x40F) {
+        return static_cast<wchar_t>(ch + 80);
+    }
+
+    return ch;
+}
+
+bool SearchIndex::IsCjkChar(wchar_t ch) {
+    return (ch >= 0x3040 && ch <= 0x30FF) ||   // 平假名、片假名
+           (ch >= 0x3400 && ch <= 0x4DBF) ||   // CJK 扩展A
+           (ch >= 0x4E00 && ch <= 0x9FFF) ||   // CJK 统一汉字
+           (ch >= 0xAC00 && ch <= 0xD7A3) ||   // 谚文音节
+           (ch >= 0xD800 && ch <= 0xDFFF) ||   // 代理对（扩展区汉字）
+           (ch >= 0xF900 && ch <= 0xFAFF);     // CJK 兼容汉字
+}
+
+bool SearchIndex::IsWordChar(wchar_t ch) {
+    if (ch < 0x80) {
+        return (ch >= L'0' && ch <= L'9') || (ch >= L'a' && ch <= L'z') ||
+               (ch >= L'A' && ch <= L'Z') || ch == L'_';
+    }
+    // 拉丁、希腊、西里尔等字母文字
+    return ch >= 0xC0 && ch < 0x2000 && ch != 0xD7 && ch != 0xF7;
+}
+
+size_t SearchIndex::GetMemoryUsage() const {
+    size_t bytes = m_texts.capacity() * sizeof(std::wstring);
+    for (const auto& text : m_texts) {
+        bytes += text.capacity() * sizeof(wchar_t);
+    }
+    bytes += m_pinyinKeys.capacity() * sizeof(std::string);
+    for (const auto& key : m_pinyinKeys) {
+        bytes += key.capacity();
+    }
+    for (const auto& entry : m_grams) {
+        bytes += sizeof(entry) + sizeof(void*) * 2 + entry.second.capacity() * sizeof(uint32_t);
+    }
+    for (const auto& entry : m_words) {
+        bytes += sizeof(entry) + sizeof(void*) * 4 +
+                 entry.first.capacity() * sizeof(wchar_t) + entry.second.capacity() * sizeof(uint32_t);
+    }
+    bytes += m_pinyinBigrams.capacity() * sizeof(DocumentBitmap);
+    for (const auto& bitmap : m_pinyinBigrams) {
+        bytes += bitmap.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+int SearchIndex::PinyinBigramSlot(char first, char second) {
+    int a = PinyinCharSlot(first);
+    int b = PinyinCharSlot(second);
+    return (a < 0 || b < 0) ? -1 : a * kPinyinAlphabet + b;
+}
+
+uint64_t SearchIndex::MakeGramKey(wchar_t first, wchar_t second) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(first)) << 32) |
+           static_cast<uint64_t>(static_cast<uint32_t>(second));
+}
+
+std::vector<SearchIndex::QueryTerm> SearchIndex::ParseQuery(const std::wstring& query, bool wholeWords) {
+    std::vector<QueryTerm> terms;
+    size_t length = query.length();
+
+    size_t i = 0;
+    while (i < length) {
+        wchar_t ch = query[i];
+        if (IsCjkChar(ch)) {
+            size_t end = i + 1;
+            while (end < length && IsCjkChar(query[end])) {
+                end++;
+            }
+
+            QueryTerm term;
+            term.kind = QueryTerm::CjkGram;
+            if (end - i == 1) {
+                term.gramKey = MakeGramKey(ch, 0);
+                terms.push_back(term);
+            } else {
+                for (size_t k = i; k + 1 < end; ++k) {
+                    term.gramKey = MakeGramKey(query[k], query[k + 1]);
+                    terms.push_back(term);
+                }
+            }
+            i = end;
+        } else if (IsWordChar(ch)) {
+            size_t end = i + 1;
+            while (end < length && IsWordChar(query[end])) {
+                end++;
+            }
+
+            // 位于查询串两端的词可能只是文档中某个词的一部分
+            bool leftOpen = !wholeWords && i == 0;
+            bool rightOpen = !wholeWords && end == length;
+
+            QueryTerm term;
+            term.gramKey = 0;
+            term.word = query.substr(i, end - i);
+            if (leftOpen && rightOpen) {
+                term.kind = QueryTerm::WordInfix;
+            } else if (leftOpen) {
+                term.kind = QueryTerm::WordSuffix;
+            } else if (rightOpen) {
+                term.kind = QueryTerm::WordPrefix;
+            } else {
+                term.kind = QueryTerm::Word;
+            }
+            terms.push_back(term);
+            i = end;
+        } else {
+            i++;
+        }
+    }
+
+    return terms;
+}
+
+const SearchIndex::PostingList* SearchIndex::LookupTerm(const QueryTerm& term, PostingList& merged) const {
+    switch (term.kind) {
+        case QueryTerm::CjkGram: {
+            auto it = m_grams.find(term.gramKey);
+            return it != m_grams.end() ? &it->second : nullptr;
+        }
+        case QueryTerm::Word: {
+            auto it = m_words.find(term.word);
+            return it != m_words.end() ? &it->second : nullptr;
+        }
+        default:
+            break;
+    }
+
+    // 部分词：合并所有匹配词的倒排表
+    merged.clear();
+    size_t matchedWords = 0;
+    auto append = [&merged, &matchedWords](const PostingList& list) {
+        merged.insert(merged.end(), list.begin(), list.end());
+        matchedWords++;
+    };
+
+    if (term.kind == QueryTerm::WordPrefix) {
+        for (auto it = m_words.lower_bound(term.word);
+             it != m_words.end() && it->first.compare(0, term.word.length(), term.word) == 0; ++it) {
+            append(it->second);
+        }
+    } else {
+        // 后缀和任意片段只能遍历词表；词表规模远小于文档总字数
+        for (const auto& entry : m_words) {
+            const std::wstring& word = entry.first;
+            if (word.length() < term.word.length()) {
+                continue;
+            }
+            bool matched = (term.kind == QueryTerm::WordSuffix)
+                ? word.compare(word.length() - term.word.length(), term.word.length(), term.word) == 0
+                : word.find(term.word) != std::wstring::npos;
+            if (matched) {
+                append(entry.second);
+            }
+        }
+    }
+
+    MergePostings(merged, matchedWords, m_documentCount);
+    return &merged;
+}
+
+void SearchIndex::MergePostings(PostingList& merged, size_t listCount, size_t documentCount) {
+    // 单个倒排表本身已有序
+    if (listCount <= 1) {
+        return;
+    }
+    // 常见的词片段（如单个字母）会匹配上千个词，合并结果接近文档总数：
+    // 这时用文档位图去重排序，代价与总数成正比而不是 n log n
+    if (merged.size() * 8 < documentCount) {
+        std::sort(merged.begin(), merged.end());
+        merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+        return;
+    }
+    std::vector<uint64_t> bits((documentCount + 63) / 64);
+    for (uint32_t document : merged) {
+        bits[document >> 6] |= uint64_t(1) << (document & 63);
+    }
+    merged.clear();
+    for (size_t word = 0; word < bits.size(); ++word) {
+        uint64_t value = bits[word];
+        for (unsigned bit = 0; value != 0; ++bit, value >>= 1) {
+            if (value & 1) {
+                merged.push_back(static_cast<uint32_t>(word * 64 + bit));
+            }
+        }
+    }
+}
+
+void SearchIndex::VerifySubstring(const std::wstring& text, size_t document, const std::wstring& query,
+                                  std::vector<SearchHit>& hits, size_t maxHits) {
+    size_t pos = text.find(query);
+    while (pos != std::wstring::npos) {
+        hits.push_back(SearchHit{document, pos, query.length()});
+        if (maxHits > 0 && hits.size() >= maxHits) {
+            return;
+        }
+        pos = text.find(query, pos + query.length());
+    }
+}
+
+void SearchIndex::VerifyPhrase(const std::wstring& text, size_t document,
+                               const std::vector<std::wstring>& segments,
+                               std::vector<SearchHit>& hits, size_t maxHits) {
+    size_t pos = text.find(segments[0]);
+    while (pos != std::wstring::npos) {
+        size_t length = MatchPhraseAt(text, pos, segments);
+        if (length > 0) {
+            hits.push_back(SearchHit{document, pos, length});
+            if (maxHits > 0 && hits.size() >= maxHits) {
+                return;
+            }
+            pos = text.find(segments[0], pos + length);
+        } else {
+            pos = text.find(segments[0], pos + 1);
+        }
+    }
+}
+
+size_t SearchIndex::MatchPhraseAt(const std::wstring& text, size_t pos,
+                                  const std::vector<std::wstring>& segments) {
+    size_t length = text.length();
+
+    // 左边界：以字母数字开头的短语不能从词的中间开始
+    if (IsWordChar(segments[0][0]) && pos > 0 && IsWordChar(text[pos - 1])) {
+        return 0;
+    }
+
+    size_t p = pos;
+    for (size_t k = 0; k < segments.size(); ++k) {
+        const std::wstring& segment = segments[k];
+
+        if (k > 0) {
+            size_t start = p;
+            while (p < length && !IsWordChar(text[p]) && !IsCjkChar(text[p])) {
+                p++;
+            }
+            // 两个字母数字段之间必须有分隔符，涉及汉字时可以直接相连
+            bool needsSeparator = IsWordChar(segments[k - 1].back()) && IsWordChar(segment[0]);
+            if (needsSeparator && p == start) {
+                return 0;
+            }
+        }
+
+        if (text.compare(p, segment.length(), segment) != 0) {
+            return 0;
+        }
+        p += segment.length();
+    }
+
+    // 右边界
+    if (IsWordChar(segments.back().back()) && p < length && IsWordChar(text[p])) {
+        return 0;
+    }
+
+    return p - pos;
+}
+
+void SearchIndex::AppendPosting(PostingList& list, uint32_t document) {
+    // 文档按序追加，同一文档只记录一次
+    if (list.empty() || list.back() != document) {
+        list.push_back(document);
+    }
+}
+
+SearchIndex::PostingList SearchIndex::Intersect(const PostingList& a, const PostingList& b) {
+    PostingList result;
+    const PostingList& small = a.size() <= b.size() ? a : b;
+    const PostingList& large = a.size() <= b.size() ? b : a;
+
+    // 长度悬殊时在长表中二分查找，否则线性归并
+    if (small.size() * 16 < large.size()) {
+        auto it = large.begin();
+        for (uint32_t document : small) {
+            it = std::lower_bound(it, large.end(), document);
+            if (it == large.end()) {
+                break;
+            }
+            if (*it == document) {
+                result.push_back(document);
+            }
+        }
+    } else {
+        std::set_intersection(small.begin(), small.end(), large.begin(), large.end(),
+                              std::back_inserter(result));
+    }
+    return result;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,153 @@
+#ifndef MEETANT_SEARCH_INDEX_H
+#define MEETANT_SEARCH_INDEX_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MeetAnt {
+
+// 一次命中：文档（消息）序号、在文档中的起始位置和长度（以字符计）
+struct SearchHit {
+    size_t document;
+    size_t offset;
+    size_t length;
+};
+
+// 增量维护的倒排索引
+// 中日韩文字按单字和相邻双字（bigram）建索引，拉丁文字、数字等按整词建索引。
+// 文档只能追加，文档序号即追加顺序；查询结果按文档序号和文档内位置排序。
+// 查询不区分大小写，全角字母数字视同半角。用双引号括起的查询为短语查询，
+// 要求两端落在词边界上，词与词之间允许任意分隔符。
+// 每篇文档同时保存其拼音键，供 FuzzyQuery 做同音/近音匹配；拼音键中相邻的两个字母另按文档位图建索引
+// （每对字母一张位图，每篇文档占一位），供 FuzzyQuery 筛选候选。
+// 原文另有存处的调用者可以只保存倒排表（keepTexts 为 false）：这时没有文档文本和拼音键（拼音双字母位图仍然保存），
+// 不能调用 Search、GetNormalizedText 和 GetPinyinKey，由调用者用 FindCandidates 筛选后自行校验。
+class SearchIndex {
+public:
+    explicit SearchIndex(bool keepTexts = true);
+
+    // 追加一篇文档，返回其序号
+    size_t AddDocument(const std::wstring& text);
+
+    // 清空索引
+    void Clear();
+
+    size_t GetDocumentCount() const { return m_documentCount; }
+
+    // 是否保存了文档文本和拼音键
+    bool KeepsTexts() const { return m_keepTexts; }
+
+    // 文档规范化后的文本（与原文等长，位置一一对应）
+    const std::wstring& GetNormalizedText(size_t document) const { return m_texts[document]; }
+
+    // 文档的无声调拼音键（见 ToPinyinKey），供拼音模糊查询使用
+    const std::string& GetPinyinKey(size_t document) const { return m_pinyinKeys[document]; }
+
+    // 子串或短语查询，maxHits 为 0 时不限制命中数
+    std::vector<SearchHit> Search(const std::wstring& query, size_t maxHits = 0) const;
+
+    // 返回可能包含规范化查询串的候选文档（已排序），只用索引过滤不做逐字校验
+    // 查询串中没有可索引的字符时 usedIndex 为 false，此时返回全部文档
+    std::vector<uint32_t> FindCandidates(const std::wstring& normalizedQuery, bool wholeWords,
+                                         bool* usedIndex = nullptr) const;
+
+    // 拼音键含有片段 piece 中每一对相邻字母的文档数，即 FindPinyinCandidates({piece}) 的候选数；
+    // 片段不足两个字母或含有小写字母、数字以外的字符时返回文档总数
+    size_t CountPinyinCandidates(const std::string& piece) const;
+
+    // 返回拼音键原样包含 pieces 中任一片段的候选文档（已排序），只用索引过滤不做逐字校验
+    // 每个片段按其中各对相邻字母的位图求交集，各片段再求并集；有片段无法查索引时返回全部文档
+    std::vector<uint32_t> FindPinyinCandidates(const std::vector<std::string>& pieces) const;
+
+    // 规范化查询并识别短语查询（双引号括起），查询为空时返回 false
+    static bool PrepareQuery(const std::wstring& query, std::wstring* normalized, bool* phrase);
+
+    // 把规范化后的短语按分隔符切分为若干段
+    static std::vector<std::wstring> SplitPhrase(const std::wstring& normalized);
+
+    // 在一篇规范化文本中查找查询，phraseSegments 非空时按短语匹配
+    static void FindInText(const std::wstring& text, size_t document, const std::wstring& normalizedQuery,
+                           const std::vector<std::wstring>* phraseSegments,
+                           std::vector<SearchHit>& hits, size_t maxHits);
+
+    // 规范化：大小写折叠、全角字母数字转半角，不改变长度
+    static std::wstring Normalize(const std::wstring& text);
+    static wchar_t NormalizeChar(wchar_t ch);
+
+    // 字符分类
+    static bool IsCjkChar(wchar_t ch);
+    static bool IsWordChar(wchar_t ch);
+
+    // 估算索引占用的内存（字节）
+    size_t GetMemoryUsage() const;
+
+private:
+    friend class SessionSearchFile;
+
+    typedef std::vector<uint32_t> PostingList;
+    typedef std::vector<uint64_t> DocumentBitmap;
+
+    // 查询中的一个索引项
+    struct QueryTerm {
+        enum Kind {
+            CjkGram,      // 中日韩单字或双字
+            Word,         // 完整的词
+            WordPrefix,   // 词的前缀（查询串末尾未闭合）
+            WordSuffix,   // 词的后缀（查询串开头未闭合）
+            WordInfix     // 词的任意片段（查询串两端都未闭合）
+        };
+        Kind kind;
+        uint64_t gramKey;
+        std::wstring word;
+    };
+
+    static uint64_t MakeGramKey(wchar_t first, wchar_t second);
+
+    // 拼音双字母在 m_pinyinBigrams 中的位置，字符不是小写字母或数字时返回 -1
+    static int PinyinBigramSlot(char first, char second);
+
+    // 将含有 piece 中每一对相邻字母的文档写入 bitmap，片段无法查索引时返回 false
+    bool MatchPinyinPiece(const std::string& piece, DocumentBitmap& bitmap) const;
+
+    // 全部文档的序号
+    std::vector<uint32_t> AllDocuments() const;
+
+    // 将规范化后的查询拆分为索引项
+    static std::vector<QueryTerm> ParseQuery(const std::wstring& query, bool wholeWords);
+
+    // 单个索引项对应的文档列表（已排序、去重），没有时返回 nullptr
+    // 整字和整词直接指向索引中的倒排表，部分词的合并结果放在 merged 中
+    const PostingList* LookupTerm(const QueryTerm& term, PostingList& merged) const;
+
+    // 在文本中校验查询并收集命中位置
+    static void VerifySubstring(const std::wstring& text, size_t document, const std::wstring& query,
+                                std::vector<SearchHit>& hits, size_t maxHits);
+    static void VerifyPhrase(const std::wstring& text, size_t document,
+                             const std::vector<std::wstring>& segments,
+                             std::vector<SearchHit>& hits, size_t maxHits);
+
+    // 从 pos 开始匹配短语，成功时返回匹配长度，失败返回 0
+    static size_t MatchPhraseAt(const std::wstring& text, size_t pos,
+                                const std::vector<std::wstring>& segments);
+
+    // 合并首尾相接的多个倒排表（排序去重），documentCount 为文档总数
+    static void MergePostings(PostingList& merged, size_t listCount, size_t documentCount);
+
+    static void AppendPosting(PostingList& list, uint32_t document);
+    static PostingList Intersect(const PostingList& a, const PostingList& b);
+
+    bool m_keepTexts;
+    size_t m_documentCount;
+    std::vector<std::wstring> m_texts;                        // 规范化后的文档，只在 m_keepTexts 时保存
+    std::vector<std::string> m_pinyinKeys;                    // 文档的拼音键，同上
+    std::unordered_map<uint64_t, PostingList> m_grams;        // 中日韩单字/双字倒排表
+    std::map<std::wstring, PostingList> m_words;              // 词倒排表（有序，支持前缀查找）
+    std::vector<DocumentBitmap> m_pinyinBigrams;              // 拼音键双字母的文档位图，按 PinyinBigramSlot 编号
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_SEARCH_INDEX_H
@@ -0,0 +1,307 @@
+#include "SemanticSearch.h"
+#include <wx/filename.h>
+#include <wx/file.h>
+#include <algorithm>
+#include <cmath>
+
+wxDEFINE_EVENT(wxEVT_SEMANTIC_SEARCH_RESULT, wxThreadEvent);
+
+namespace MeetAnt {
+
+// 唯一的工作线程，从任务队列中取任务执行，取到空任务时退出
+class SemanticSearchManager::Worker : public wxThread {
+public:
+    explicit Worker(SemanticSearchManager* owner)
+        : wxThread(wxTHREAD_JOINABLE),
+          m_owner(owner) {
+    }
+
+protected:
+    ExitCode Entry() override {
+        for (;;) {
+            Task task;
+            if (m_owner->m_tasks.Receive(task) != wxMSGQUEUE_NO_ERROR || !task) {
+                break;
+            }
+            task();
+        }
+        return (ExitCode)0;
+    }
+
+private:
+    SemanticSearchManager* m_owner;
+};
+
+SemanticSearchManager::SemanticSearchManager(const wxString& modelDir)
+    : m_modelDir(modelDir),
+      m_worker(nullptr),
+      m_searchGeneration(0),
+      m_modelTried(false),
+      m_unsavedCount(0),
+      m_clusteredCount(0)
+{
+    if (!IsAvailable()) {
+        return;
+    }
+
+    m_worker = new Worker(this);
+    if (m_worker->Run() != wxTHREAD_NO_ERROR) {
+        wxLogWarning(wxT("无法启动语义搜索线程"));
+        delete m_worker;
+        m_worker = nullptr;
+    }
+}
+
+SemanticSearchManager::~SemanticSearchManager() {
+    Shutdown();
+}
+
+bool SemanticSearchManager::IsAvailable() const {
+    return EmbeddingModel::IsSupported() &&
+           wxFileName::FileExists(GetModelPath(m_modelDir)) &&
+           wxFileName::FileExists(GetVocabularyPath(m_modelDir));
+}
+
+void SemanticSearchManager::Shutdown() {
+    m_searchGeneration++;
+    if (!m_worker) {
+        return;
+    }
+
+    Post([this]() {
+        SaveVectors();
+    });
+    m_tasks.Post(Task());
+    m_worker->Wait();
+    delete m_worker;
+    m_worker = nullptr;
+}
+
+void SemanticSearchManager::Post(const Task& task) {
+    // 模型不可用时不启动线程，所有请求直接忽略
+    if (m_worker) {
+        m_tasks.Post(task);
+    }
+}
+
+void SemanticSearchManager::OpenSession(const wxString& name, const wxString& path,
+                                        const std::vector<TranscriptionMessage>& messages) {
+    if (!m_worker) {
+        return;
+    }
+
+    // 只需要消息内容，复制一份交给工作线程
+    auto contents = std::make_shared<std::vector<wxString>>();
+    contents->reserve(messages.size());
+    for (const auto& message : messages) {
+        contents->push_back(message.content);
+    }
+
+    Post([this, name, path, contents]() {
+        if (!EnsureModel()) {
+            return;
+        }
+        SwitchSession(name, path);
+
+        // 向量文件中有已不存在的消息（转录被编辑过）时整体重建
+        for (size_t row = 0; row < m_index.GetCount(); ++row) {
+            if (m_index.GetId(row) >= contents->size()) {
+                m_index.Reset(m_model.GetDimension());
+                m_embedded.clear();
+                m_clusteredCount = 0;
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < contents->size(); ++i) {
+            if (i >= m_embedded.size() || !m_embedded[i]) {
+                EmbedMessage(i, (*contents)[i]);
+            }
+        }
+        SaveVectors();
+    });
+}
+
+void SemanticSearchManager::AppendMessage(const wxString& name, const wxString& path,
+                                          size_t index, const wxString& content) {
+    Post([this, name, path, index, content]() {
+        if (!EnsureModel()) {
+            return;
+        }
+        SwitchSession(name, path);
+        if (index < m_embedded.size() && m_embedded[index]) {
+            return;
+        }
+        EmbedMessage(index, content);
+        if (m_unsavedCount >= kSaveInterval) {
+            SaveVectors();
+        }
+    });
+}
+
+int SemanticSearchManager::SearchAsync(const wxString& query, size_t maxResults, wxEvtHandler* handler) {
+    int requestId = ++m_searchGeneration;
+
+    auto result = std::make_shared<SemanticSearchResult>();
+    result->requestId = requestId;
+    result->failed = true;
+
+    if (!m_worker) {
+        wxThreadEvent event(wxEVT_SEMANTIC_SEARCH_RESULT);
+        event.SetPayload(result);
+        wxQueueEvent(handler, event.Clone());
+        return requestId;
+    }
+
+    Post([this, requestId, query, maxResults, handler, result]() {
+        if (m_searchGeneration != requestId) {
+            return;
+        }
+
+        result->sessionName = m_sessionName;
+        if (EnsureModel()) {
+            std::vector<float> embedding = m_model.Embed(query.ToStdWstring());
+            if (!embedding.empty()) {
+                result->failed = false;
+                for (const auto& match : m_index.Search(embedding.data(), maxResults)) {
+                    result->hits.push_back(SemanticSearchHit{match.id, match.score});
+                }
+            }
+        }
+
+        if (m_searchGeneration == requestId) {
+            wxThreadEvent event(wxEVT_SEMANTIC_SEARCH_RESULT);
+            event.SetPayload(result);
+            wxQueueEvent(handler, event.Clone());
+        }
+    });
+    return requestId;
+}
+
+void SemanticSearchManager::CancelSearch() {
+    m_searchGeneration++;
+}
+
+wxString SemanticSearchManager::GetModelPath(const wxString& modelDir) {
+    return wxFileName(modelDir, wxT("model.onnx")).GetFullPath();
+}
+
+wxString SemanticSearchManager::GetVocabularyPath(const wxString& modelDir) {
+    return wxFileName(modelDir, wxT("vocab.txt")).GetFullPath();
+}
+
+wxString SemanticSearchManager::GetVectorFilePath(const wxString& sessionPath) {
+    return wxFileName(sessionPath, wxT("embeddings.vec")).GetFullPath();
+}
+
+bool SemanticSearchManager::EnsureModel() {
+    if (!m_modelTried) {
+        m_modelTried = true;
+        m_model.Load(GetModelPath(m_modelDir), GetVocabularyPath(m_modelDir));
+    }
+    return m_model.IsLoaded();
+}
+
+void SemanticSearchManager::SwitchSession(const wxString& name, const wxString& path) {
+    if (name == m_sessionName && path == m_sessionPath) {
+        return;
+    }
+
+    SaveVectors();
+    m_sessionName = name;
+    m_sessionPath = path;
+    LoadVectors();
+}
+
+void SemanticSearchManager::LoadVectors() {
+    m_index.Reset(m_model.GetDimension());
+    m_embedded.clear();
+    m_unsavedCount = 0;
+    m_clusteredCount = 0;
+
+    wxString filePath = GetVectorFilePath(m_sessionPath);
+    if (m_sessionPath.IsEmpty() || !wxFileName::FileExists(filePath)) {
+        return;
+    }
+
+    wxFile file;
+    if (!file.Open(filePath, wxFile::read)) {
+        return;
+    }
+    wxFileOffset length = file.Length();
+    std::string data(length > 0 ? static_cast<size_t>(length) : 0, '\0');
+    if (length <= 0 || file.Read(&data[0], data.size()) != static_cast<ssize_t>(data.size())) {
+        return;
+    }
+    file.Close();
+
+    // 模型更换后旧向量不可比较，丢弃后由 OpenSession 重新编码
+    uint64_t tag = 0;
+    if (!m_index.Deserialize(data.data(), data.size(), &tag) ||
+        tag != m_model.GetModelTag() || m_index.GetDimension() != m_model.GetDimension()) {
+        wxLogInfo(wxT("会话向量文件已过期，将重新编码: %s"), filePath);
+        m_index.Reset(m_model.GetDimension());
+        return;
+    }
+
+    for (size_t row = 0; row < m_index.GetCount(); ++row) {
+        uint32_t id = m_index.GetId(row);
+        if (id >= m_embedded.size()) {
+            m_embedded.resize(id + 1, false);
+        }
+        m_embedded[id] = true;
+    }
+    m_clusteredCount = m_index.HasClusters() ? m_index.GetCount() : 0;
+}
+
+void SemanticSearchManager::SaveVectors() {
+    if (m_unsavedCount == 0 || m_sessionPath.IsEmpty() || !wxFileName::DirExists(m_sessionPath)) {
+        return;
+    }
+
+    std::string data;
+    m_index.Serialize(data, m_model.GetModelTag());
+
+    wxString filePath = GetVectorFilePath(m_sessionPath);
+    wxString tempPath = filePath + wxT(".tmp");
+    wxFile file;
+    bool success = file.Open(tempPath, wxFile::write) && file.Write(data.data(), data.size()) == data.size();
+    file.Close();
+    if (!success) {
+        wxLogWarning(wxT("写入会话向量文件失败: %s"), tempPath);
+        wxRemoveFile(tempPath);
+    } else if (!wxRenameFile(tempPath, filePath, true)) {
+        wxLogWarning(wxT("无法替换会话向量文件: %s"), filePath);
+        wxRemoveFile(tempPath);
+    } else {
+        m_unsavedCount = 0;
+    }
+}
+
+void SemanticSearchManager::EmbedMessage(size_t index, const wxString& content) {
+    std::vector<float> embedding = m_model.Embed(content.ToStdWstring());
+    if (embedding.empty()) {
+        return;
+    }
+
+    m_index.Add(static_cast<uint32_t>(index), embedding.data());
+    if (index >= m_embedded.size()) {
+        m_embedded.resize(index + 1, false);
+    }
+    m_embedded[index] = true;
+    m_unsavedCount++;
+    UpdateClusters();
+}
+
+void SemanticSearchManager::UpdateClusters() {
+    size_t count = m_index.GetCount();
+    if (count < kClusterThreshold || count < m_clusteredCount * 2) {
+        return;
+    }
+
+    size_t listCount = static_cast<size_t>(std::sqrt(static_cast<double>(count)));
+    m_index.BuildClusters(listCount);
+    m_clusteredCount = count;
+}
+
+} // namespace MeetAnt
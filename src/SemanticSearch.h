@@ -0,0 +1,104 @@
+#ifndef MEETANT_SEMANTIC_SEARCH_H
+#define MEETANT_SEMANTIC_SEARCH_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <wx/msgqueue.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "EmbeddingModel.h"
+#include "VectorIndex.h"
+#include "TranscriptionBubbleCtrl.h"
+
+// 语义搜索结果，payload 为 std::shared_ptr<MeetAnt::SemanticSearchResult>
+wxDECLARE_EVENT(wxEVT_SEMANTIC_SEARCH_RESULT, wxThreadEvent);
+
+namespace MeetAnt {
+
+// 语义搜索的一条结果
+struct SemanticSearchHit {
+    size_t message;     // 消息在转录中的序号
+    float score;        // 余弦相似度
+};
+
+struct SemanticSearchResult {
+    int requestId;
+    wxString sessionName;
+    bool failed;                            // 模型不可用或查询无法编码
+    std::vector<SemanticSearchHit> hits;    // 按相似度降序
+};
+
+// 会话内语义搜索
+// 消息定稿后在后台线程用本地句向量模型编码，追加到当前会话的向量索引，
+// 索引保存在会话目录的 embeddings.vec 中。模型文件放在配置目录的
+// models/embedding/ 下（model.onnx 和 vocab.txt），首次使用时才加载。
+// 所有编码、索引和查询任务都在同一个工作线程中按提交顺序执行。
+class SemanticSearchManager {
+public:
+    explicit SemanticSearchManager(const wxString& modelDir);
+    ~SemanticSearchManager();
+
+    // 编译支持 ONNX Runtime 且模型文件存在
+    bool IsAvailable() const;
+
+    // 保存当前会话的向量并停止工作线程
+    void Shutdown();
+
+    // 切换到某个会话：载入其向量文件，为尚未编码的消息补算向量
+    void OpenSession(const wxString& name, const wxString& path,
+                     const std::vector<TranscriptionMessage>& messages);
+
+    // 会话中新增一条定稿消息
+    void AppendMessage(const wxString& name, const wxString& path, size_t index, const wxString& content);
+
+    // 在当前会话中搜索与 query 语义最接近的消息，返回请求编号；之前未完成的搜索被取消
+    int SearchAsync(const wxString& query, size_t maxResults, wxEvtHandler* handler);
+
+    void CancelSearch();
+
+    static wxString GetModelPath(const wxString& modelDir);
+    static wxString GetVocabularyPath(const wxString& modelDir);
+    static wxString GetVectorFilePath(const wxString& sessionPath);
+
+    // 每编码这么多条新消息写一次向量文件
+    static const size_t kSaveInterval = 32;
+    // 向量数达到该值后建立 IVF 聚类，之后每翻一倍重建一次
+    static const size_t kClusterThreshold = 20000;
+
+private:
+    class Worker;
+    friend class Worker;
+
+    typedef std::function<void()> Task;
+
+    void Post(const Task& task);
+
+    // 以下方法只在工作线程中调用
+    bool EnsureModel();
+    void SwitchSession(const wxString& name, const wxString& path);
+    void LoadVectors();
+    void SaveVectors();
+    void EmbedMessage(size_t index, const wxString& content);
+    void UpdateClusters();
+
+    wxString m_modelDir;
+    wxMessageQueue<Task> m_tasks;
+    Worker* m_worker;
+    std::atomic<int> m_searchGeneration;
+
+    // 工作线程独占的状态
+    EmbeddingModel m_model;
+    bool m_modelTried;
+    wxString m_sessionName;
+    wxString m_sessionPath;
+    VectorIndex m_index;
+    std::vector<bool> m_embedded;       // 消息序号 -> 是否已有向量
+    size_t m_unsavedCount;
+    size_t m_clusteredCount;            // 上次建立聚类时的向量数
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_SEMANTIC_SEARCH_H
@@ -0,0 +1,760 @@
+#include "SessionArchive.h"
+#include "RecoveryLog.h"
+#include "RecordCodec.h"
+#include "SessionStore.h"
+#include "TranscriptFile.h"
+#include "TranscriptLog.h"
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <algorithm>
+#include <cstring>
+
+#ifdef MEETANT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef MEETANT_HAVE_FLAC
+#include <FLAC/metadata.h>
+#include <FLAC/stream_encoder.h>
+#endif
+
+wxDEFINE_EVENT(wxEVT_SESSION_ARCHIVED, wxThreadEvent);
+wxDEFINE_EVENT(wxEVT_SESSION_ARCHIVE_DONE, wxThreadEvent);
+
+namespace MeetAnt {
+
+namespace {
+    // 文件格式：文件头（与 RecordCodec 的记录文件相同，值保留为 0），各成员的帧，索引，文件尾
+    // 索引按 RecordCodec 编码：4 字节成员数，之后每个成员依次为名称、1 字节存放方式、
+    // 8 字节原始大小、8 字节修改时间、8 字节录音时长、4 字节帧数，
+    // 以及每帧的 8 字节位置、4 字节存放大小、4 字节原始大小
+    struct FileFooter {
+        uint64_t indexOffset;
+        uint64_t indexSize;
+        char magic[4];          // "MAAI"
+        uint32_t reserved;      // 保留，写 0
+    };
+    static_assert(sizeof(FileFooter) == 24, "FileFooter layout");
+
+    const char kArchiveMagic[4] = { 'M', 'A', 'A', 'R' };
+    const char kIndexMagic[4] = { 'M', 'A', 'A', 'I' };
+    const uint32_t kVersion = 1;
+
+    // 规范化的转录成员
+    const wxChar* const kTranscriptMember = wxT("archive/transcript.log");
+
+#ifdef MEETANT_HAVE_FLAC
+    // WAV 文件头只在前面这么多字节中查找 fmt 和 data 块
+    const size_t kWavProbeBytes = 4096;
+    // FLAC 编码级别（0-8）和每次送入编码器的采样帧数
+    const unsigned kFlacCompressionLevel = 5;
+    const size_t kFlacBlockFrames = 4096;
+    // 每隔这么多秒一个查找点
+    const unsigned kSeekPointSeconds = 10;
+#endif
+
+    int64_t ToSeconds(const wxDateTime& time) {
+        return time.IsValid() ? static_cast<int64_t>(time.GetTicks()) : 0;
+    }
+
+    // 不打包的文件：归档本身、派生的索引、恢复日志和临时文件
+    bool IsSkippedFile(const wxString& fileName) {
+        return fileName == wxT("session.archive") || fileName == wxT("search.idx") ||
+               fileName == wxT("embeddings.vec") || fileName == wxT("recovery.wal") ||
+               fileName.EndsWith(wxT(".tmp")) || fileName.EndsWith(wxT("-shm"));
+    }
+
+    // 顺序写入归档：成员的帧依次写在文件头之后，Finish 时写入索引和文件尾
+    class ArchiveWriter {
+    public:
+        ArchiveWriter(int compressionLevel, const std::function<bool()>& isCancelled)
+            : m_compressionLevel(compressionLevel),
+              m_isCancelled(isCancelled),
+              m_offset(0)
+#ifdef MEETANT_HAVE_ZSTD
+            , m_context(ZSTD_createCCtx())
+#endif
+        {
+        }
+
+        ~ArchiveWriter() {
+#ifdef MEETANT_HAVE_ZSTD
+            ZSTD_freeCCtx(m_context);
+#endif
+        }
+
+        bool Open(const wxString& path) {
+            if (!m_file.Create(path, true)) {
+                return false;
+            }
+            std::string header = MakeRecordFileHeader(kArchiveMagic, kVersion);
+            return Write(header.data(), header.size());
+        }
+
+        bool AddData(const wxString& name, const std::string& data, int64_t modified) {
+            SessionArchive::Member member;
+            member.name = name;
+            member.storage = SessionArchive::Zstd;
+            member.modified = modified;
+            for (size_t offset = 0; offset < data.size(); offset += SessionArchive::kFrameSize) {
+                size_t size = std::min<size_t>(SessionArchive::kFrameSize, data.size() - offset);
+                if (!AddFrame(member, data.data() + offset, size)) {
+                    return false;
+                }
+            }
+            m_members.push_back(member);
+            return true;
+        }
+
+        bool AddFile(const wxString& name, const wxString& filePath, uint8_t storage, int64_t modified,
+                     int64_t durationMs) {
+            wxFile input;
+            if (!input.Open(filePath)) {
+                return false;
+            }
+            SessionArchive::Member member;
+            member.name = name;
+            member.storage = storage;
+            member.modified = modified;
+            member.durationMs = durationMs;
+            std::string chunk(SessionArchive::kFrameSize, '\0');
+            for (;;) {
+                ssize_t read = input.Read(&chunk[0], chunk.size());
+                if (read == wxInvalidOffset) {
+                    return false;
+                }
+                if (read == 0) {
+                    break;
+                }
+                if (!AddFrame(member, chunk.data(), static_cast<size_t>(read))) {
+                    return false;
+                }
+            }
+            m_members.push_back(member);
+            return true;
+        }
+
+        bool Finish() {
+            std::string index;
+            AppendValue<uint32_t>(index, static_cast<uint32_t>(m_members.size()));
+            for (const auto& member : m_members) {
+                AppendString(index, member.name);
+                AppendValue<uint8_t>(index, member.storage);
+                AppendValue<uint64_t>(index, member.size);
+                AppendValue<int64_t>(index, member.modified);
+                AppendValue<int64_t>(index, member.durationMs);
+                AppendValue<uint32_t>(index, static_cast<uint32_t>(member.frames.size()));
+                for (const auto& frame : member.frames) {
+                    AppendValue<uint64_t>(index, frame.offset);
+                    AppendValue<uint32_t>(index, frame.storedSize);
+                    AppendValue<uint32_t>(index, frame.size);
+                }
+            }
+
+            FileFooter footer;
+            footer.indexOffset = m_offset;
+            footer.indexSize = index.size();
+            std::memcpy(footer.magic, kIndexMagic, sizeof(footer.magic));
+            footer.reserved = 0;
+            bool ok = Write(index.data(), index.size()) && Write(&footer, sizeof(footer)) && m_file.Flush();
+            return m_file.Close() && ok;
+        }
+
+        size_t GetMemberCount() const { return m_members.size(); }
+
+    private:
+        bool Write(const void* data, size_t size) {
+            if (m_file.Write(data, size) != size) {
+                return false;
+            }
+            m_offset += size;
+            return true;
+        }
+
+        bool AddFrame(SessionArchive::Member& member, const char* data, size_t size) {
+            if (m_isCancelled()) {
+                return false;
+            }
+            SessionArchive::Frame frame;
+            frame.offset = m_offset;
+            frame.size = static_cast<uint32_t>(size);
+            frame.storedSize = frame.size;
+            if (member.storage == SessionArchive::Zstd) {
+#ifdef MEETANT_HAVE_ZSTD
+                m_buffer.resize(ZSTD_compressBound(size));
+                size_t compressed = ZSTD_compressCCtx(m_context, &m_buffer[0], m_buffer.size(), data, size,
+                                                      m_compressionLevel);
+                if (ZSTD_isError(compressed) || !Write(m_buffer.data(), compressed)) {
+                    return false;
+                }
+                frame.storedSize = static_cast<uint32_t>(compressed);
+#else
+                return false;
+#endif
+            } else if (!Write(data, size)) {
+                return false;
+            }
+            member.frames.push_back(frame);
+            member.size += size;
+            return true;
+        }
+
+        int m_compressionLevel;
+        std::function<bool()> m_isCancelled;
+        wxFile m_file;
+        uint64_t m_offset;
+        std::vector<SessionArchive::Member> m_members;
+        std::string m_buffer;
+#ifdef MEETANT_HAVE_ZSTD
+        ZSTD_CCtx* m_context;
+#endif
+    };
+
+#ifdef MEETANT_HAVE_FLAC
+    // WAV 文件的格式和 PCM 数据范围
+    struct WaveInfo {
+        int format = 0;
+        int channels = 0;
+        int sampleRate = 0;
+        int bitsPerSample = 0;
+        wxFileOffset dataOffset = 0;
+        wxFileOffset dataBytes = 0;
+    };
+
+    // 依次查找 fmt 和 data 块；录制中断过的文件头中数据大小不可靠，按文件大小计算
+    bool ReadWaveInfo(wxFile& file, WaveInfo& info) {
+        std::string header(kWavProbeBytes, '\0');
+        ssize_t read = file.Read(&header[0], header.size());
+        if (read < 12 || header.compare(0, 4, "RIFF") != 0 || header.compare(8, 4, "WAVE") != 0) {
+            return false;
+        }
+        header.resize(static_cast<size_t>(read));
+        for (size_t offset = 12; offset + 8 <= header.size(); ) {
+            uint32_t chunkSize;
+            std::memcpy(&chunkSize, &header[offset + 4], sizeof(chunkSize));
+            if (header.compare(offset, 4, "fmt ") == 0 && offset + 8 + 16 <= header.size()) {
+                uint16_t format, channels, bitsPerSample;
+                uint32_t sampleRate;
+                std::memcpy(&format, &header[offset + 8], sizeof(format));
+                std::memcpy(&channels, &header[offset + 10], sizeof(channels));
+                std::memcpy(&sampleRate, &header[offset + 12], sizeof(sampleRate));
+                std::memcpy(&bitsPerSample, &header[offset + 22], sizeof(bitsPerSample));
+                info.format = format;
+                info.channels = channels;
+                info.sampleRate = static_cast<int>(sampleRate);
+                info.bitsPerSample = bitsPerSample;
+            } else if (header.compare(offset, 4, "data") == 0) {
+                wxFileOffset available = file.Length() - static_cast<wxFileOffset>(offset + 8);
+                info.dataOffset = static_cast<wxFileOffset>(offset + 8);
+                info.dataBytes = chunkSize > 0 && chunkSize <= available ? chunkSize : available;
+                return info.channels > 0;
+            }
+            offset += 8 + chunkSize + (chunkSize & 1);
+        }
+        return false;
+    }
+
+    // 把 16 位 PCM 的 WAV 录音转码为带查找表的 FLAC，其他格式返回 false
+    bool EncodeFlac(const wxString& wavPath, const wxString& flacPath, const std::function<bool()>& isCancelled) {
+        wxFile input;
+        WaveInfo info;
+        if (!input.Open(wavPath) || !ReadWaveInfo(input, info) || info.format != 1 || info.bitsPerSample != 16 ||
+            info.channels > 8 || info.sampleRate <= 0) {
+            return false;
+        }
+        const size_t frameBytes = static_cast<size_t>(info.channels) * 2;
+        uint64_t totalFrames = static_cast<uint64_t>(info.dataBytes) / frameBytes;
+
+        // 编码器在 finish 时关闭输出文件，并把查找点填成实际位置
+        FILE* output = wxFopen(flacPath, wxT("w+b"));
+        if (!output) {
+            return false;
+        }
+        FLAC__StreamEncoder* encoder = FLAC__stream_encoder_new();
+        FLAC__StreamMetadata* seekTable = FLAC__metadata_object_new(FLAC__METADATA_TYPE_SEEKTABLE);
+        bool ok = encoder && seekTable &&
+                  FLAC__stream_encoder_set_channels(encoder, info.channels) &&
+                  FLAC__stream_encoder_set_bits_per_sample(encoder, 16) &&
+                  FLAC__stream_encoder_set_sample_rate(encoder, info.sampleRate) &&
+                  FLAC__stream_encoder_set_compression_level(encoder, kFlacCompressionLevel) &&
+                  FLAC__stream_encoder_set_total_samples_estimate(encoder, totalFrames);
+        if (ok && totalFrames > 0) {
+            ok = FLAC__metadata_object_seektable_template_append_spaced_points_by_samples(
+                     seekTable, info.sampleRate * kSeekPointSeconds, totalFrames) &&
+                 FLAC__metadata_object_seektable_template_sort(seekTable, true) &&
+                 FLAC__stream_encoder_set_metadata(encoder, &seekTable, 1);
+        }
+        bool initialized = ok &&
+            FLAC__stream_encoder_init_FILE(encoder, output, nullptr, nullptr) == FLAC__STREAM_ENCODER_INIT_STATUS_OK;
+        ok = initialized && input.Seek(info.dataOffset) != wxInvalidOffset;
+
+        std::vector<char> buffer(kFlacBlockFrames * frameBytes);
+        std::vector<FLAC__int32> samples(kFlacBlockFrames * info.channels);
+        for (uint64_t remaining = totalFrames; ok && remaining > 0; ) {
+            if (isCancelled()) {
+                ok = false;
+                break;
+            }
+            size_t frames = static_cast<size_t>(std::min<uint64_t>(remaining, kFlacBlockFrames));
+            size_t bytes = frames * frameBytes;
+            if (input.Read(buffer.data(), bytes) != static_cast<ssize_t>(bytes)) {
+                ok = false;
+                break;
+            }
+            for (size_t i = 0; i < frames * info.channels; ++i) {
+                int16_t sample;
+                std::memcpy(&sample, &buffer[i * 2], sizeof(sample));
+                samples[i] = sample;
+            }
+            ok = FLAC__stream_encoder_process_interleaved(encoder, samples.data(), static_cast<unsigned>(frames));
+            remaining -= frames;
+        }
+
+        if (initialized) {
+            ok = FLAC__stream_encoder_finish(encoder) && ok;
+        } else {
+            fclose(output);
+        }
+        if (encoder) {
+            FLAC__stream_encoder_delete(encoder);
+        }
+        if (seekTable) {
+            FLAC__metadata_object_delete(seekTable);
+        }
+        if (!ok) {
+            wxRemoveFile(flacPath);
+        }
+        return ok;
+    }
+#endif
+}
+
+bool SessionArchive::IsSupported() {
+#ifdef MEETANT_HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+wxString SessionArchive::GetArchivePath(const wxString& sessionPath) {
+    return wxFileName(sessionPath, wxT("session.archive")).GetFullPath();
+}
+
+bool SessionArchive::Exists(const wxString& sessionPath) {
+    return wxFileName::FileExists(GetArchivePath(sessionPath));
+}
+
+bool SessionArchive::Open(const wxString& sessionPath) {
+    return OpenFile(GetArchivePath(sessionPath));
+}
+
+bool SessionArchive::OpenFile(const wxString& archivePath) {
+    m_members.clear();
+    if (m_file.IsOpened()) {
+        m_file.Close();
+    }
+    if (!wxFileName::FileExists(archivePath) || !m_file.Open(archivePath)) {
+        return false;
+    }
+
+    RecordFileHeader header;
+    FileFooter footer;
+    wxFileOffset length = m_file.Length();
+    if (length < static_cast<wxFileOffset>(sizeof(header) + sizeof(footer)) ||
+        m_file.Read(&header, sizeof(header)) != sizeof(header) ||
+        std::memcmp(header.magic, kArchiveMagic, sizeof(header.magic)) != 0) {
+        wxLogWarning(wxT("无法识别的会话归档: %s"), archivePath);
+        return false;
+    }
+    if (header.version != kVersion) {
+        wxLogWarning(wxT("不支持的会话归档版本: %s"), archivePath);
+        return false;
+    }
+
+    // 索引紧接在文件尾之前
+    uint64_t footerOffset = static_cast<uint64_t>(length) - sizeof(footer);
+    std::string index;
+    bool ok = m_file.Seek(static_cast<wxFileOffset>(footerOffset)) != wxInvalidOffset &&
+              m_file.Read(&footer, sizeof(footer)) == sizeof(footer) &&
+              std::memcmp(footer.magic, kIndexMagic, sizeof(footer.magic)) == 0 &&
+              footer.indexOffset >= sizeof(header) && footer.indexSize <= footerOffset - footer.indexOffset &&
+              footer.indexOffset + footer.indexSize == footerOffset;
+    if (ok) {
+        index.resize(static_cast<size_t>(footer.indexSize));
+        ok = m_file.Seek(static_cast<wxFileOffset>(footer.indexOffset)) != wxInvalidOffset &&
+             m_file.Read(&index[0], index.size()) == static_cast<ssize_t>(index.size());
+    }
+
+    ByteReader reader(index.data(), index.size());
+    uint32_t memberCount = 0;
+    ok = ok && reader.Read(memberCount);
+    for (uint32_t i = 0; ok && i < memberCount; ++i) {
+        Member member;
+        uint64_t size = 0;
+        uint32_t frameCount = 0;
+        ok = reader.ReadString(member.name) && reader.Read(member.storage) && reader.Read(size) &&
+             reader.Read(member.modified) && reader.Read(member.durationMs) && reader.Read(frameCount) &&
+             (member.storage == Stored || member.storage == Zstd);
+        for (uint32_t j = 0; ok && j < frameCount; ++j) {
+            Frame frame;
+            ok = reader.Read(frame.offset) && reader.Read(frame.storedSize) && reader.Read(frame.size) &&
+                 frame.offset >= sizeof(header) && frame.storedSize <= footer.indexOffset - frame.offset &&
+                 (member.storage == Zstd || frame.storedSize == frame.size);
+            if (ok) {
+                member.frameStarts.push_back(member.size);
+                member.frames.push_back(frame);
+                member.size += frame.size;
+            }
+        }
+        ok = ok && member.size == size;
+        if (ok) {
+            m_members.push_back(member);
+        }
+    }
+    if (!ok) {
+        wxLogWarning(wxT("会话归档的索引已损坏: %s"), archivePath);
+        m_members.clear();
+        m_file.Close();
+    }
+    return ok;
+}
+
+const SessionArchive::Member* SessionArchive::FindMember(const wxString& name) const {
+    for (const auto& member : m_members) {
+        if (member.name == name) {
+            return &member;
+        }
+    }
+    return nullptr;
+}
+
+bool SessionArchive::ReadFrame(const Frame& frame, uint8_t storage, std::string& data) {
+    std::string stored(frame.storedSize, '\0');
+    if (m_file.Seek(static_cast<wxFileOffset>(frame.offset)) == wxInvalidOffset ||
+        m_file.Read(&stored[0], stored.size()) != static_cast<ssize_t>(stored.size())) {
+        return false;
+    }
+    if (storage == Stored) {
+        data.swap(stored);
+        return true;
+    }
+#ifdef MEETANT_HAVE_ZSTD
+    data.resize(frame.size);
+    size_t size = ZSTD_decompress(&data[0], data.size(), stored.data(), stored.size());
+    return !ZSTD_isError(size) && size == frame.size;
+#else
+    return false;
+#endif
+}
+
+bool SessionArchive::Read(const Member& member, uint64_t offset, size_t size, std::string& data) {
+    data.clear();
+    if (!m_file.IsOpened() || offset > member.size) {
+        return false;
+    }
+    uint64_t end = std::min<uint64_t>(member.size, offset + size);
+
+    // 从覆盖 offset 的帧开始；原样存放的成员直接读取需要的范围
+    size_t index = std::upper_bound(member.frameStarts.begin(), member.frameStarts.end(), offset) -
+                   member.frameStarts.begin();
+    index = index > 0 ? index - 1 : 0;
+    std::string frameData;
+    for (; index < member.frames.size() && member.frameStarts[index] < end; ++index) {
+        const Frame& frame = member.frames[index];
+        uint64_t frameStart = member.frameStarts[index];
+        uint64_t start = std::max(offset, frameStart) - frameStart;
+        uint64_t stop = std::min<uint64_t>(end, frameStart + frame.size) - frameStart;
+        if (member.storage == Stored) {
+            size_t done = data.size();
+            data.resize(done + static_cast<size_t>(stop - start));
+            if (m_file.Seek(static_cast<wxFileOffset>(frame.offset + start)) == wxInvalidOffset ||
+                m_file.Read(&data[done], static_cast<size_t>(stop - start)) != static_cast<ssize_t>(stop - start)) {
+                return false;
+            }
+            continue;
+        }
+        if (!ReadFrame(frame, member.storage, frameData)) {
+            return false;
+        }
+        data.append(frameData, static_cast<size_t>(start), static_cast<size_t>(stop - start));
+    }
+    return true;
+}
+
+bool SessionArchive::ReadAll(const Member& member, std::string& data) {
+    return Read(member, 0, static_cast<size_t>(member.size), data);
+}
+
+bool SessionArchive::ReadTranscript(const wxString& sessionPath, std::vector<TranscriptionMessage>& messages) {
+    SessionArchive archive;
+    if (!archive.Open(sessionPath)) {
+        return false;
+    }
+    const Member* member = archive.FindMember(kTranscriptMember);
+    std::string data;
+    return member && archive.ReadAll(*member, data) && TranscriptLog::Parse(data, messages);
+}
+
+bool SessionArchive::ReadMember(const wxString& sessionPath, const wxString& name, std::string& data) {
+    SessionArchive archive;
+    if (!Exists(sessionPath) || !archive.Open(sessionPath)) {
+        return false;
+    }
+    const Member* member = archive.FindMember(name);
+    return member && archive.ReadAll(*member, data);
+}
+
+bool SessionArchive::Build(const wxString& sessionPath, int compressionLevel,
+                           const std::function<bool()>& isCancelled, std::vector<wxString>* archivedFiles) {
+    archivedFiles->clear();
+    wxDir dir(sessionPath);
+    if (!IsSupported() || !dir.IsOpened()) {
+        return false;
+    }
+    std::vector<wxString> fileNames;
+    wxString fileName;
+    for (bool more = dir.GetFirst(&fileName, wxEmptyString, wxDIR_FILES); more; more = dir.GetNext(&fileName)) {
+        if (!IsSkippedFile(fileName)) {
+            fileNames.push_back(fileName);
+        }
+    }
+    std::sort(fileNames.begin(), fileNames.end());
+
+    wxString tempPath = GetArchivePath(sessionPath) + wxT(".tmp");
+    ArchiveWriter writer(compressionLevel, isCancelled);
+    if (!writer.Open(tempPath)) {
+        wxLogWarning(wxT("无法创建会话归档: %s"), tempPath);
+        return false;
+    }
+
+    // 不管转录存在数据库、日志还是文本中，都另存一份日志格式的副本供直接读取
+    bool ok = true;
+    std::vector<TranscriptionMessage> messages;
+    if (LoadTranscriptFile(sessionPath, messages)) {
+        ok = writer.AddData(kTranscriptMember, TranscriptLog::Encode(messages), ToSeconds(wxDateTime::Now()));
+    }
+
+    for (size_t i = 0; ok && i < fileNames.size(); ++i) {
+        wxFileName file(sessionPath, fileNames[i]);
+        wxString filePath = file.GetFullPath();
+        int64_t modified = ToSeconds(file.GetModificationTime());
+        if (!fileNames[i].StartsWith(wxT("audio_"))) {
+            ok = writer.AddFile(fileNames[i], filePath, Zstd, modified, -1);
+        } else {
+            SessionStore::AudioSegment segment;
+            SessionStore::ProbeAudioFile(filePath, segment);
+            bool isWave = file.GetExt().Lower() == wxT("wav");
+            bool encoded = false;
+#ifdef MEETANT_HAVE_FLAC
+            // WAV 录音转码为 FLAC 后原样存放，其他 WAV（如 8 位或浮点）按帧压缩
+            if (isWave) {
+                wxString flacPath = wxFileName(sessionPath, file.GetName() + wxT(".flac.tmp")).GetFullPath();
+                if (EncodeFlac(filePath, flacPath, isCancelled)) {
+                    ok = writer.AddFile(file.GetName() + wxT(".flac"), flacPath, Stored, modified, segment.durationMs);
+                    wxRemoveFile(flacPath);
+                    encoded = true;
+                }
+            }
+#endif
+            if (!encoded) {
+                ok = writer.AddFile(fileNames[i], filePath, isWave ? Zstd : Stored, modified, segment.durationMs);
+            }
+        }
+        archivedFiles->push_back(filePath);
+    }
+
+    size_t memberCount = writer.GetMemberCount();
+    ok = writer.Finish() && ok;
+    if (ok) {
+        SessionArchive check;
+        ok = check.OpenFile(tempPath) && check.m_members.size() == memberCount;
+    }
+    if (!ok) {
+        archivedFiles->clear();
+        Discard(sessionPath);
+    }
+    return ok;
+}
+
+bool SessionArchive::Commit(const wxString& sessionPath, const std::vector<wxString>& archivedFiles) {
+    wxString archivePath = GetArchivePath(sessionPath);
+    if (!wxRenameFile(archivePath + wxT(".tmp"), archivePath, false)) {
+        wxLogWarning(wxT("无法保存会话归档: %s"), archivePath);
+        return false;
+    }
+    for (const auto& filePath : archivedFiles) {
+        if (!wxRemoveFile(filePath)) {
+            wxLogWarning(wxT("无法删除已归档的文件: %s"), filePath);
+        }
+    }
+    return true;
+}
+
+void SessionArchive::Discard(const wxString& sessionPath) {
+    wxString tempPath = GetArchivePath(sessionPath) + wxT(".tmp");
+    if (wxFileName::FileExists(tempPath)) {
+        wxRemoveFile(tempPath);
+    }
+}
+
+class SessionArchiveManager::Worker : public wxThread {
+public:
+    explicit Worker(SessionArchiveManager* owner)
+        : wxThread(wxTHREAD_JOINABLE),
+          m_owner(owner) {
+    }
+
+protected:
+    ExitCode Entry() override {
+        for (;;) {
+            Task task;
+            if (m_owner->m_tasks.Receive(task) != wxMSGQUEUE_NO_ERROR || !task) {
+                break;
+            }
+            task();
+        }
+        return (ExitCode)0;
+    }
+
+private:
+    SessionArchiveManager* m_owner;
+};
+
+SessionArchiveManager::SessionArchiveManager()
+    : m_worker(nullptr),
+      m_generation(0)
+{
+    m_worker = new Worker(this);
+    if (m_worker->Run() != wxTHREAD_NO_ERROR) {
+        wxLogWarning(wxT("无法启动会话归档线程"));
+        delete m_worker;
+        m_worker = nullptr;
+    }
+}
+
+SessionArchiveManager::~SessionArchiveManager() {
+    Shutdown();
+}
+
+void SessionArchiveManager::Shutdown() {
+    ++m_generation;
+    if (m_worker) {
+        m_tasks.Post(Task());
+        m_worker->Wait();
+        delete m_worker;
+        m_worker = nullptr;
+    }
+}
+
+void SessionArchiveManager::Post(const Task& task) {
+    // 归档很慢，工作线程没有启动时不在界面线程中归档
+    if (m_worker) {
+        m_tasks.Post(task);
+    }
+}
+
+void SessionArchiveManager::Run(const std::vector<std::pair<wxString, wxString>>& sessions,
+                                const ArchivePolicy& policy, wxEvtHandler* handler) {
+    int generation = ++m_generation;
+    if (!SessionArchive::IsSupported() || !policy.enabled) {
+        return;
+    }
+
+    Post([this, sessions, policy, handler, generation]() {
+        auto isCancelled = [this, generation]() { return m_generation != generation; };
+        int archivedCount = 0;
+        for (const auto& session : sessions) {
+            if (isCancelled()) {
+                return;
+            }
+            if (!ShouldArchive(session.second, policy)) {
+                continue;
+            }
+            std::vector<wxString> archivedFiles;
+            if (!SessionArchive::Build(session.second, policy.compressionLevel, isCancelled, &archivedFiles)) {
+                continue;
+            }
+
+            // 界面可能在打包期间打开了这个会话，检查排除和删除原文件在同一把锁内完成
+            bool committed = false;
+            {
+                wxCriticalSectionLocker lock(m_critSect);
+                if (!isCancelled() && m_excluded.count(session.second) == 0) {
+                    committed = SessionArchive::Commit(session.second, archivedFiles);
+                }
+            }
+            if (!committed) {
+                SessionArchive::Discard(session.second);
+                continue;
+            }
+            ++archivedCount;
+
+            wxThreadEvent event(wxEVT_SESSION_ARCHIVED);
+            event.SetString(session.first);
+            wxQueueEvent(handler, event.Clone());
+        }
+
+        wxThreadEvent event(wxEVT_SESSION_ARCHIVE_DONE);
+        event.SetInt(archivedCount);
+        wxQueueEvent(handler, event.Clone());
+    });
+}
+
+void SessionArchiveManager::ExcludeSession(const wxString& sessionPath) {
+    wxCriticalSectionLocker lock(m_critSect);
+    m_excluded.insert(sessionPath);
+}
+
+bool SessionArchiveManager::IsExcluded(const wxString& sessionPath) {
+    wxCriticalSectionLocker lock(m_critSect);
+    return m_excluded.count(sessionPath) != 0;
+}
+
+bool SessionArchiveManager::ShouldArchive(const wxString& sessionPath, const ArchivePolicy& policy) {
+    // 已归档、上次录制没有正常结束或当前打开的会话不归档
+    if (SessionArchive::Exists(sessionPath) || RecoveryLog::Exists(sessionPath) || IsExcluded(sessionPath)) {
+        return false;
+    }
+    wxDateTime lastModified;
+    int64_t sizeBytes = 0;
+    if (!GetSessionUsage(sessionPath, &lastModified, &sizeBytes) || !lastModified.IsValid()) {
+        return false;
+    }
+    int idleDays = (wxDateTime::Now() - lastModified).GetDays();
+    if (idleDays >= policy.afterDays) {
+        return true;
+    }
+    return policy.sizeThresholdBytes > 0 && sizeBytes >= policy.sizeThresholdBytes &&
+           idleDays >= ArchivePolicy::kMinIdleDays;
+}
+
+bool SessionArchiveManager::GetSessionUsage(const wxString& sessionPath, wxDateTime* lastModified,
+                                            int64_t* sizeBytes) {
+    wxDir dir(sessionPath);
+    if (!dir.IsOpened()) {
+        return false;
+    }
+    *lastModified = wxDateTime();
+    *sizeBytes = 0;
+
+    // 派生的索引会在浏览时重建，不算作会话的修改
+    wxString fileName;
+    for (bool more = dir.GetFirst(&fileName, wxEmptyString, wxDIR_FILES); more; more = dir.GetNext(&fileName)) {
+        wxFileName file(sessionPath, fileName);
+        wxULongLong size = file.GetSize();
+        if (size != wxInvalidSize) {
+            *sizeBytes += static_cast<int64_t>(size.GetValue());
+        }
+        if (IsSkippedFile(fileName)) {
+            continue;
+        }
+        wxDateTime modified = file.GetModificationTime();
+        if (modified.IsValid() && (!lastModified->IsValid() || modified.IsLaterThan(*lastModified))) {
+            *lastModified = modified;
+        }
+    }
+    return true;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,161 @@
+#ifndef MEETANT_SESSION_ARCHIVE_H
+#define MEETANT_SESSION_ARCHIVE_H
+
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <wx/thread.h>
+#include <wx/msgqueue.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+#include "TranscriptionBubbleCtrl.h"
+
+// 一个会话已归档，GetString() 为会话名
+wxDECLARE_EVENT(wxEVT_SESSION_ARCHIVED, wxThreadEvent);
+// 一次归档检查完了所有会话，GetInt() 为本次归档的会话数
+wxDECLARE_EVENT(wxEVT_SESSION_ARCHIVE_DONE, wxThreadEvent);
+
+namespace MeetAnt {
+
+// 会话归档 session.archive
+// 把长期不用的会话目录打包为一个文件：WAV 录音转码为 FLAC（无损，带查找表）原样存放，
+// 转录、批注和其他文件切成 kFrameSize 的帧，每帧用 zstd 单独压缩。
+// 文件末尾是索引，记录每个成员每一帧的位置和大小，读取成员的一段内容时只解压覆盖它的帧；
+// 转码后的录音不再压缩，可以直接按偏移读取播放。
+// 转录另存一个规范化的成员 archive/transcript.log（TranscriptLog 格式），搜索和会话目录直接读取它；
+// 以 archive/ 开头的成员只供归档自身使用。
+// 打开已归档的会话时不还原：转录和批注直接从归档中读取，录音留在归档中。之后写入的转录、批注等
+// 文件照常写在会话目录中，目录中的文件优先于归档中的同名成员，已有这些文件的会话不再归档。
+// 搜索索引和句向量是派生数据，留在目录中不归档。
+// 编译时未启用 zstd（MEETANT_HAVE_ZSTD）时 IsSupported 返回 false，不做归档；
+// 未启用 libFLAC（MEETANT_HAVE_FLAC）时 WAV 录音也按帧压缩。
+class SessionArchive {
+public:
+    enum Storage {
+        Stored = 0,     // 原样存放（已压缩的录音）
+        Zstd = 1        // 按帧压缩
+    };
+
+    struct Frame {
+        uint64_t offset;            // 在归档文件中的位置
+        uint32_t storedSize;        // 存放的字节数
+        uint32_t size;              // 原始字节数
+    };
+
+    struct Member {
+        wxString name;              // 会话目录中的文件名
+        uint8_t storage;
+        uint64_t size;              // 原始大小
+        int64_t modified;           // 归档时的修改时间（秒）
+        int64_t durationMs;         // 录音时长，不是录音或无法确定时为 -1
+        std::vector<Frame> frames;
+        std::vector<uint64_t> frameStarts;  // 每帧在成员中的起始位置（读取索引时计算）
+
+        Member() : storage(Stored), size(0), modified(0), durationMs(-1) {}
+    };
+
+    SessionArchive() {}
+
+    // 是否编译了 zstd 支持
+    static bool IsSupported();
+
+    static wxString GetArchivePath(const wxString& sessionPath);
+    static bool Exists(const wxString& sessionPath);
+
+    // 打开会话的归档并读取索引
+    bool Open(const wxString& sessionPath);
+    const std::vector<Member>& GetMembers() const { return m_members; }
+    const Member* FindMember(const wxString& name) const;
+
+    // 读取成员中从 offset 开始的 size 个字节，只读取和解压覆盖这段范围的帧
+    bool Read(const Member& member, uint64_t offset, size_t size, std::string& data);
+    bool ReadAll(const Member& member, std::string& data);
+
+    // 读取归档中的转录，不依赖界面，可在工作线程中调用
+    static bool ReadTranscript(const wxString& sessionPath, std::vector<TranscriptionMessage>& messages);
+
+    // 读取会话归档中的一个成员（如批注文件），会话没有归档或归档中没有这个成员时返回 false
+    static bool ReadMember(const wxString& sessionPath, const wxString& name, std::string& data);
+
+    // 把会话目录打包为临时归档 session.archive.tmp，写完后重新打开核对索引
+    // isCancelled 在处理每个文件和每一帧之前调用，返回 true 时中止；archivedFiles 为打包进去的文件
+    static bool Build(const wxString& sessionPath, int compressionLevel,
+                      const std::function<bool()>& isCancelled, std::vector<wxString>* archivedFiles);
+    // 把临时归档改名为 session.archive 并删除已归档的文件
+    static bool Commit(const wxString& sessionPath, const std::vector<wxString>& archivedFiles);
+    // 放弃临时归档
+    static void Discard(const wxString& sessionPath);
+
+    // 压缩帧的原始大小
+    static const uint32_t kFrameSize = 256 * 1024;
+
+private:
+    bool OpenFile(const wxString& archivePath);
+    bool ReadFrame(const Frame& frame, uint8_t storage, std::string& data);
+
+    wxFile m_file;
+    std::vector<Member> m_members;
+
+    SessionArchive(const SessionArchive&) = delete;
+    SessionArchive& operator=(const SessionArchive&) = delete;
+};
+
+// 归档策略，取自系统设置
+struct ArchivePolicy {
+    bool enabled;
+    int afterDays;                  // 这么多天没有变化的会话归档
+    int64_t sizeThresholdBytes;     // 大于这个大小、且至少 kMinIdleDays 天没有变化的会话也归档，0 为不按大小
+    int compressionLevel;           // zstd 压缩级别
+
+    ArchivePolicy() : enabled(false), afterDays(90), sizeThresholdBytes(0), compressionLevel(9) {}
+
+    static const int kMinIdleDays = 1;
+};
+
+// 后台归档
+// 按策略检查会话（名称、路径），符合条件的在工作线程中逐个打包，
+// 每归档一个会话以事件形式通知界面，全部检查完后再发一个完成事件。
+// 当前打开的会话由界面用 ExcludeSession 排除；排除和删除原文件互斥，
+// ExcludeSession 返回后该会话要么已经归档完毕，要么不会再被归档。
+class SessionArchiveManager {
+public:
+    SessionArchiveManager();
+    ~SessionArchiveManager();
+
+    // 停止工作线程（正在打包的会话放弃归档）
+    void Shutdown();
+
+    // 在后台按策略检查这些会话，之前未完成的检查被取消
+    void Run(const std::vector<std::pair<wxString, wxString>>& sessions, const ArchivePolicy& policy,
+             wxEvtHandler* handler);
+
+    // 本次运行期间不归档这个会话目录
+    void ExcludeSession(const wxString& sessionPath);
+
+    // 会话目录中文件的最晚修改时间和总大小，目录不存在时返回 false
+    static bool GetSessionUsage(const wxString& sessionPath, wxDateTime* lastModified, int64_t* sizeBytes);
+
+private:
+    class Worker;
+    friend class Worker;
+
+    typedef std::function<void()> Task;
+
+    void Post(const Task& task);
+    bool ShouldArchive(const wxString& sessionPath, const ArchivePolicy& policy);
+    bool IsExcluded(const wxString& sessionPath);
+
+    wxMessageQueue<Task> m_tasks;
+    Worker* m_worker;
+    std::atomic<int> m_generation;          // 最新的检查编号
+
+    wxCriticalSection m_critSect;           // 保护 m_excluded，删除原文件期间一直持有
+    std::set<wxString> m_excluded;
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_SESSION_ARCHIVE_H
@@ -0,0 +1,392 @@
+#include "SessionCatalog.h"
+#include "SessionArchive.h"
+#include "SessionStore.h"
+#include "TranscriptFile.h"
+#include <wx/dir.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <set>
+
+wxDEFINE_EVENT(wxEVT_SESSION_CATALOG_UPDATED, wxThreadEvent);
+wxDEFINE_EVENT(wxEVT_SESSION_CATALOG_DONE, wxThreadEvent);
+
+namespace MeetAnt {
+
+namespace {
+    const int kCatalogVersion = 1;
+
+    int64_t ToMilliseconds(const wxDateTime& time) {
+        return time.IsValid() ? time.GetValue().GetValue() : 0;
+    }
+
+    wxDateTime FromMilliseconds(int64_t ms) {
+        return ms != 0 ? wxDateTime(wxLongLong(ms)) : wxDateTime();
+    }
+
+    int64_t ToSeconds(const wxDateTime& time) {
+        return time.IsValid() ? static_cast<int64_t>(time.GetTicks()) : 0;
+    }
+
+    // 取较早的有效时间
+    void KeepEarliest(wxDateTime& earliest, const wxDateTime& candidate) {
+        if (candidate.IsValid() && (!earliest.IsValid() || candidate.IsEarlierThan(earliest))) {
+            earliest = candidate;
+        }
+    }
+}
+
+// 后台线程，从任务队列中取任务执行，取到空任务时退出
+class SessionCatalog::Worker : public wxThread {
+public:
+    explicit Worker(SessionCatalog* owner)
+        : wxThread(wxTHREAD_JOINABLE),
+          m_owner(owner) {
+    }
+
+protected:
+    ExitCode Entry() override {
+        for (;;) {
+            Task task;
+            if (m_owner->m_tasks.Receive(task) != wxMSGQUEUE_NO_ERROR || !task) {
+                break;
+            }
+            task();
+        }
+        return (ExitCode)0;
+    }
+
+private:
+    SessionCatalog* m_owner;
+};
+
+SessionCatalog::SessionCatalog(const wxString& sessionsDir)
+    : m_sessionsDir(sessionsDir),
+      m_worker(nullptr),
+      m_dirty(false),
+      m_refreshGeneration(0)
+{
+    Load();
+
+    m_worker = new Worker(this);
+    if (m_worker->Run() != wxTHREAD_NO_ERROR) {
+        wxLogWarning(wxT("无法启动会话目录线程"));
+        delete m_worker;
+        m_worker = nullptr;
+    }
+}
+
+SessionCatalog::~SessionCatalog() {
+    Shutdown();
+}
+
+void SessionCatalog::Shutdown() {
+    m_refreshGeneration++;
+    if (m_worker) {
+        m_tasks.Post(Task());
+        m_worker->Wait();
+        delete m_worker;
+        m_worker = nullptr;
+    }
+    Save();
+}
+
+void SessionCatalog::Post(const Task& task) {
+    if (m_worker) {
+        m_tasks.Post(task);
+    } else {
+        task();
+    }
+}
+
+bool SessionCatalog::Lookup(const wxString& name, SessionMetadata& metadata) const {
+    wxCriticalSectionLocker lock(m_critSect);
+    auto it = m_entries.find(name);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    metadata = it->second;
+    return true;
+}
+
+void SessionCatalog::Refresh(const std::vector<std::pair<wxString, wxString>>& sessions, wxEvtHandler* handler) {
+    int generation = ++m_refreshGeneration;
+    auto list = std::make_shared<std::vector<std::pair<wxString, wxString>>>(sessions);
+    Post([this, list, handler, generation]() {
+        int rescanned = 0;
+        for (const auto& session : *list) {
+            if (m_refreshGeneration != generation) {
+                return;     // 已有更新的刷新
+            }
+            if (RefreshSession(session.first, session.second, handler)) {
+                rescanned++;
+            }
+        }
+        PruneEntries(*list);
+        Save();
+
+        wxThreadEvent event(wxEVT_SESSION_CATALOG_DONE);
+        event.SetInt(rescanned);
+        wxQueueEvent(handler, event.Clone());
+    });
+}
+
+void SessionCatalog::Update(const wxString& name, const wxString& path, wxEvtHandler* handler) {
+    Post([this, name, path, handler]() {
+        RefreshSession(name, path, handler);
+    });
+}
+
+void SessionCatalog::Remove(const wxString& name) {
+    wxCriticalSectionLocker lock(m_critSect);
+    if (m_entries.erase(name) > 0) {
+        m_dirty = true;
+    }
+}
+
+void SessionCatalog::PruneEntries(const std::vector<std::pair<wxString, wxString>>& sessions) {
+    std::set<wxString> names;
+    for (const auto& session : sessions) {
+        names.insert(session.first);
+    }
+    wxCriticalSectionLocker lock(m_critSect);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (names.count(it->first) == 0) {
+            it = m_entries.erase(it);
+            m_dirty = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool SessionCatalog::RefreshSession(const wxString& name, const wxString& path, wxEvtHandler* handler) {
+    int64_t directoryModified = 0;
+    int64_t transcriptModified = 0;
+    if (!GetSessionState(path, &directoryModified, &transcriptModified)) {
+        return false;
+    }
+    {
+        wxCriticalSectionLocker lock(m_critSect);
+        auto it = m_entries.find(name);
+        if (it != m_entries.end() && it->second.path == path &&
+            it->second.directoryModified == directoryModified &&
+            it->second.transcriptModified == transcriptModified) {
+            return false;
+        }
+    }
+
+    auto metadata = std::make_shared<SessionMetadata>();
+    if (!ScanSession(name, path, *metadata)) {
+        return false;
+    }
+    {
+        wxCriticalSectionLocker lock(m_critSect);
+        m_entries[name] = *metadata;
+        m_dirty = true;
+    }
+
+    wxThreadEvent event(wxEVT_SESSION_CATALOG_UPDATED);
+    event.SetPayload(metadata);
+    wxQueueEvent(handler, event.Clone());
+    return true;
+}
+
+bool SessionCatalog::GetSessionState(const wxString& path, int64_t* directoryModified, int64_t* transcriptModified) {
+    wxFileName directory = wxFileName::DirName(path);
+    if (!directory.DirExists()) {
+        return false;
+    }
+    *directoryModified = ToSeconds(directory.GetModificationTime());
+    *transcriptModified = 0;
+    for (const auto& source : GetTranscriptSourcePaths(path)) {
+        *transcriptModified = std::max(*transcriptModified, ToSeconds(wxFileName(source).GetModificationTime()));
+    }
+    return true;
+}
+
+bool SessionCatalog::ScanSession(const wxString& name, const wxString& path, SessionMetadata& metadata) {
+    wxDir dir(path);
+    if (!dir.IsOpened() || !GetSessionState(path, &metadata.directoryModified, &metadata.transcriptModified)) {
+        return false;
+    }
+    metadata.name = name;
+    metadata.path = path;
+
+    // 目录中的文件：总大小，录音的时长和开始时间
+    wxDateTime created;
+    int64_t audioMs = 0;
+    wxString fileName;
+    for (bool more = dir.GetFirst(&fileName, wxEmptyString, wxDIR_FILES); more; more = dir.GetNext(&fileName)) {
+        wxString filePath = wxFileName(path, fileName).GetFullPath();
+        if (fileName.StartsWith(wxT("audio_")) && !fileName.EndsWith(wxT(".temp.wav"))) {
+            SessionStore::AudioSegment segment;
+            if (SessionStore::ProbeAudioFile(filePath, segment)) {
+                metadata.sizeBytes += segment.bytes;
+                audioMs += std::max<int64_t>(segment.durationMs, 0);
+                KeepEarliest(created, segment.startTime);
+                continue;
+            }
+        }
+        wxULongLong size = wxFileName::GetSize(filePath);
+        if (size != wxInvalidSize) {
+            metadata.sizeBytes += static_cast<int64_t>(size.GetValue());
+        }
+    }
+
+    // 已归档的录音：时长记在归档索引中，开始时间取自文件名
+    SessionArchive archive;
+    if (SessionArchive::Exists(path) && archive.Open(path)) {
+        for (const auto& member : archive.GetMembers()) {
+            wxString stamp;
+            if (!wxFileName(member.name).GetName().StartsWith(wxT("audio_"), &stamp)) {
+                continue;
+            }
+            audioMs += std::max<int64_t>(member.durationMs, 0);
+            wxDateTime startTime;
+            wxString::const_iterator end;
+            if (startTime.ParseFormat(stamp, wxT("%Y%m%d_%H%M%S"), &end)) {
+                KeepEarliest(created, startTime);
+            }
+        }
+    }
+
+    // 转录：消息数、发言人和首尾时间
+    std::vector<TranscriptionMessage> messages;
+    LoadTranscriptFile(path, messages);
+    metadata.messageCount = messages.size();
+    std::set<wxString> seen;
+    for (const auto& msg : messages) {
+        if (seen.insert(msg.speakerName).second) {
+            metadata.speakers.push_back(msg.speakerName);
+        }
+    }
+    if (!messages.empty()) {
+        KeepEarliest(created, messages.front().timestamp);
+    }
+
+    // 目录的创建时间（复制过的会话目录会比内容晚，所以取几者中最早的）
+    wxDateTime directoryCreated;
+    wxDateTime directoryModified;
+    if (wxFileName::DirName(path).GetTimes(nullptr, &directoryModified, &directoryCreated)) {
+        KeepEarliest(created, directoryCreated);
+        KeepEarliest(created, directoryModified);
+    }
+    metadata.creationTime = created;
+
+    if (audioMs > 0) {
+        metadata.durationMs = audioMs;
+    } else if (messages.size() > 1 && messages.front().timestamp.IsValid() && messages.back().timestamp.IsValid()) {
+        metadata.durationMs = std::max<int64_t>(0, ToMilliseconds(messages.back().timestamp) -
+                                                   ToMilliseconds(messages.front().timestamp));
+    }
+    return true;
+}
+
+wxString SessionCatalog::GetCatalogPath() const {
+    return wxFileName(m_sessionsDir, wxT("session_catalog.json")).GetFullPath();
+}
+
+bool SessionCatalog::Load() {
+    wxString catalogPath = GetCatalogPath();
+    if (m_sessionsDir.IsEmpty() || !wxFileExists(catalogPath)) {
+        return false;
+    }
+
+    wxFile file;
+    wxString content;
+    if (!file.Open(catalogPath, wxFile::read) || !file.ReadAll(&content, wxConvUTF8)) {
+        wxLogWarning(wxT("无法读取会话目录: %s"), catalogPath);
+        return false;
+    }
+
+    try {
+        nlohmann::json catalog = nlohmann::json::parse(content.ToStdString(wxConvUTF8));
+        if (catalog.value("version", 0) != kCatalogVersion || !catalog.contains("sessions")) {
+            return false;
+        }
+
+        wxCriticalSectionLocker lock(m_critSect);
+        for (auto it = catalog["sessions"].begin(); it != catalog["sessions"].end(); ++it) {
+            const auto& value = it.value();
+            SessionMetadata entry;
+            entry.name = wxString::FromUTF8(it.key().c_str());
+            entry.path = wxString::FromUTF8(value.value("path", std::string()).c_str());
+            entry.creationTime = FromMilliseconds(value.value("created", static_cast<int64_t>(0)));
+            entry.durationMs = value.value("duration", static_cast<int64_t>(0));
+            entry.messageCount = value.value("messages", static_cast<size_t>(0));
+            entry.sizeBytes = value.value("size", static_cast<int64_t>(0));
+            entry.directoryModified = value.value("directoryModified", static_cast<int64_t>(0));
+            entry.transcriptModified = value.value("transcriptModified", static_cast<int64_t>(0));
+            if (value.contains("speakers")) {
+                for (const auto& speaker : value["speakers"]) {
+                    entry.speakers.push_back(wxString::FromUTF8(speaker.get<std::string>().c_str()));
+                }
+            }
+            m_entries[entry.name] = entry;
+        }
+    } catch (const std::exception& e) {
+        // 目录损坏时重新扫描全部会话
+        wxLogWarning(wxT("解析会话目录失败: %s"), wxString(e.what()));
+        return false;
+    }
+    return true;
+}
+
+bool SessionCatalog::Save() {
+    if (m_sessionsDir.IsEmpty()) {
+        return false;
+    }
+
+    nlohmann::json catalog;
+    {
+        wxCriticalSectionLocker lock(m_critSect);
+        if (!m_dirty) {
+            return true;
+        }
+        catalog["version"] = kCatalogVersion;
+        nlohmann::json sessions = nlohmann::json::object();
+        for (const auto& entry : m_entries) {
+            nlohmann::json speakers = nlohmann::json::array();
+            for (const auto& speaker : entry.second.speakers) {
+                speakers.push_back(speaker.ToStdString(wxConvUTF8));
+            }
+            sessions[entry.first.ToStdString(wxConvUTF8)] = {
+                {"path", entry.second.path.ToStdString(wxConvUTF8)},
+                {"created", ToMilliseconds(entry.second.creationTime)},
+                {"duration", entry.second.durationMs},
+                {"messages", entry.second.messageCount},
+                {"speakers", speakers},
+                {"size", entry.second.sizeBytes},
+                {"directoryModified", entry.second.directoryModified},
+                {"transcriptModified", entry.second.transcriptModified}
+            };
+        }
+        catalog["sessions"] = sessions;
+        m_dirty = false;
+    }
+
+    wxString catalogPath = GetCatalogPath();
+    wxString tempPath = catalogPath + wxT(".tmp");
+    std::string data = catalog.dump(1);
+
+    wxFile file;
+    bool success = file.Open(tempPath, wxFile::write) && file.Write(data.c_str(), data.size());
+    file.Close();
+    if (!success) {
+        wxLogWarning(wxT("写入会话目录失败: %s"), tempPath);
+    } else if (!wxRenameFile(tempPath, catalogPath, true)) {
+        wxLogWarning(wxT("无法替换会话目录: %s"), catalogPath);
+        success = false;
+    }
+
+    if (!success) {
+        // 下次再试
+        wxCriticalSectionLocker lock(m_critSect);
+        m_dirty = true;
+    }
+    return success;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,104 @@
+#ifndef MEETANT_SESSION_CATALOG_H
+#define MEETANT_SESSION_CATALOG_H
+
+#include <wx/wx.h>
+#include <wx/datetime.h>
+#include <wx/thread.h>
+#include <wx/msgqueue.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+// 一个会话的元数据已重新扫描，payload 为 std::shared_ptr<MeetAnt::SessionMetadata>
+wxDECLARE_EVENT(wxEVT_SESSION_CATALOG_UPDATED, wxThreadEvent);
+// 一次刷新检查完了所有会话，GetInt() 为重新扫描的会话数
+wxDECLARE_EVENT(wxEVT_SESSION_CATALOG_DONE, wxThreadEvent);
+
+namespace MeetAnt {
+
+// 会话列表中显示和排序用的元数据
+struct SessionMetadata {
+    wxString name;
+    wxString path;
+    wxDateTime creationTime;        // 目录创建时间、最早的录音和第一条消息中最早的一个
+    int64_t durationMs;             // 录音总时长；没有可读的录音时为首尾消息的间隔
+    size_t messageCount;
+    std::vector<wxString> speakers; // 按首次发言的顺序
+    int64_t sizeBytes;              // 会话目录中文件的总大小
+
+    // 扫描时的目录状态，用于判断缓存是否过期
+    int64_t directoryModified;      // 会话目录的修改时间（秒）
+    int64_t transcriptModified;     // 转录文件的最晚修改时间（秒）
+
+    SessionMetadata() : durationMs(0), messageCount(0), sizeBytes(0),
+                        directoryModified(0), transcriptModified(0) {}
+};
+
+// 会话目录（会话根目录下的 session_catalog.json）
+// 缓存每个会话的元数据，启动时直接用缓存填充会话列表，不读取会话内容。
+// 刷新在后台线程中进行：会话目录或转录文件的修改时间与缓存不同的会话重新扫描，
+// 每扫描完一个会话以事件形式回传给界面，全部检查完后把目录写回磁盘。
+// 追加写入转录不改变目录的修改时间，所以同时比较转录文件的修改时间。
+class SessionCatalog {
+public:
+    explicit SessionCatalog(const wxString& sessionsDir);
+    ~SessionCatalog();
+
+    // 停止后台线程（正在扫描的会话完成后退出）并保存目录
+    void Shutdown();
+
+    // 缓存中的元数据，没有缓存时返回 false
+    bool Lookup(const wxString& name, SessionMetadata& metadata) const;
+
+    // 在后台检查这些会话（名称、路径），缓存缺失或过期的重新扫描，
+    // 全部检查完后去掉缓存中不在列表里的会话；之前未完成的刷新被取消
+    void Refresh(const std::vector<std::pair<wxString, wxString>>& sessions, wxEvtHandler* handler);
+
+    // 会话内容已变化，在后台重新扫描（不取消正在进行的刷新）
+    void Update(const wxString& name, const wxString& path, wxEvtHandler* handler);
+
+    // 会话已从列表移除，不再缓存其元数据（下次保存时从文件中去掉）
+    void Remove(const wxString& name);
+
+    // 把目录写回磁盘（未变化时不写）
+    bool Save();
+
+    // 读取会话目录，计算元数据（不依赖界面，可在工作线程中调用）
+    static bool ScanSession(const wxString& name, const wxString& path, SessionMetadata& metadata);
+
+    // 会话目录和转录文件的修改时间，目录不存在时返回 false
+    static bool GetSessionState(const wxString& path, int64_t* directoryModified, int64_t* transcriptModified);
+
+private:
+    class Worker;
+    friend class Worker;
+
+    typedef std::function<void()> Task;
+
+    void Post(const Task& task);
+    bool Load();
+    wxString GetCatalogPath() const;
+
+    // 去掉不在这次刷新列表中的会话（已删除或已移除），在工作线程中调用
+    void PruneEntries(const std::vector<std::pair<wxString, wxString>>& sessions);
+
+    // 缓存过期时重新扫描并通知界面，返回是否重新扫描（在工作线程中调用）
+    bool RefreshSession(const wxString& name, const wxString& path, wxEvtHandler* handler);
+
+    wxString m_sessionsDir;
+    wxMessageQueue<Task> m_tasks;
+    Worker* m_worker;
+
+    mutable wxCriticalSection m_critSect;       // 保护以下成员
+    std::map<wxString, SessionMetadata> m_entries;
+    bool m_dirty;
+
+    std::atomic<int> m_refreshGeneration;       // 最新的刷新编号
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_SESSION_CATALOG_H
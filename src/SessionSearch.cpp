@@ -0,0 +1,859 @@
+#include "SessionSearch.h"
+#include "TranscriptFile.h"
+#include "Pinyin.h"
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstring>
+
+wxDEFINE_EVENT(wxEVT_SESSION_SEARCH_RESULT, wxThreadEvent);
+wxDEFINE_EVENT(wxEVT_SESSION_SEARCH_DONE, wxThreadEvent);
+
+namespace MeetAnt {
+
+namespace {
+    const char kIndexMagic[4] = { 'M', 'A', 'S', 'I' };
+    const uint32_t kIndexVersion = 1;
+    const size_t kMaxHitsPerSession = 50;     // 每个会话最多回传的命中数
+    const size_t kSnippetBefore = 16;         // 摘要中命中之前保留的字符数
+    const size_t kSnippetAfter = 32;          // 摘要中命中之后保留的字符数
+    const int kManifestVersion = 1;
+}
+
+// 索引文件格式（小端，所有字符以 uint32 存储）：
+//   FileHeader | DocEntry[docCount] | GramEntry[gramCount] | WordEntry[wordCount]
+//   | uint32 postings[postingCount] | uint32 chars[charCount]
+// GramEntry 按键排序，WordEntry 按词排序，均可二分查找。
+struct SessionSearchFile::FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t docCount;
+    uint32_t gramCount;
+    uint32_t wordCount;
+    uint32_t postingCount;
+    uint32_t charCount;
+    uint32_t reserved;
+    uint8_t padding[32];
+};
+
+struct SessionSearchFile::DocEntry {
+    uint32_t speakerOffset;
+    uint32_t speakerLength;
+    uint32_t contentOffset;
+    uint32_t contentLength;
+    int64_t timestamp;        // 毫秒
+};
+
+struct SessionSearchFile::GramEntry {
+    uint64_t key;
+    uint32_t postingOffset;
+    uint32_t postingCount;
+};
+
+struct SessionSearchFile::WordEntry {
+    uint32_t charOffset;
+    uint32_t charLength;
+    uint32_t postingOffset;
+    uint32_t postingCount;
+};
+
+SessionSearchFile::SessionSearchFile()
+    : m_header(nullptr),
+      m_docs(nullptr),
+      m_grams(nullptr),
+      m_words(nullptr),
+      m_postings(nullptr),
+      m_chars(nullptr)
+{
+}
+
+SessionSearchFile::~SessionSearchFile() {
+    Close();
+}
+
+bool SessionSearchFile::Write(const wxString& filePath, const std::vector<TranscriptionMessage>& messages) {
+    // 文件中保存原文，建索引时只需要倒排表
+    SearchIndex index(false);
+    for (const auto& msg : messages) {
+        index.AddDocument(msg.content.ToStdWstring());
+    }
+
+    std::vector<DocEntry> docs;
+    std::vector<GramEntry> grams;
+    std::vector<WordEntry> words;
+    std::vector<uint32_t> postings;
+    std::vector<uint32_t> chars;
+
+    auto appendChars = [&chars](const std::wstring& text) {
+        uint32_t offset = static_cast<uint32_t>(chars.size());
+        for (wchar_t ch : text) {
+            chars.push_back(static_cast<uint32_t>(ch));
+        }
+        return offset;
+    };
+
+    docs.reserve(messages.size());
+    for (const auto& msg : messages) {
+        std::wstring speaker = msg.speakerName.ToStdWstring();
+        std::wstring content = msg.content.ToStdWstring();
+
+        DocEntry doc;
+        doc.speakerOffset = appendChars(speaker);
+        doc.speakerLength = static_cast<uint32_t>(speaker.length());
+        doc.contentOffset = appendChars(content);
+        doc.contentLength = static_cast<uint32_t>(content.length());
+        doc.timestamp = msg.timestamp.IsValid() ? msg.timestamp.GetValue().GetValue() : 0;
+        docs.push_back(doc);
+    }
+
+    std::vector<uint64_t> gramKeys;
+    gramKeys.reserve(index.m_grams.size());
+    for (const auto& entry : index.m_grams) {
+        gramKeys.push_back(entry.first);
+    }
+    std::sort(gramKeys.begin(), gramKeys.end());
+    for (uint64_t key : gramKeys) {
+        const auto& list = index.m_grams.at(key);
+        grams.push_back(GramEntry{ key, static_cast<uint32_t>(postings.size()), static_cast<uint32_t>(list.size()) });
+        postings.insert(postings.end(), list.begin(), list.end());
+    }
+
+    // std::map 已按词排序
+    for (const auto& entry : index.m_words) {
+        WordEntry word;
+        word.charLength = static_cast<uint32_t>(entry.first.length());
+        word.charOffset = appendChars(entry.first);
+        word.postingOffset = static_cast<uint32_t>(postings.size());
+        word.postingCount = static_cast<uint32_t>(entry.second.size());
+        words.push_back(word);
+        postings.insert(postings.end(), entry.second.begin(), entry.second.end());
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kIndexMagic, sizeof(header.magic));
+    header.version = kIndexVersion;
+    header.docCount = static_cast<uint32_t>(docs.size());
+    header.gramCount = static_cast<uint32_t>(grams.size());
+    header.wordCount = static_cast<uint32_t>(words.size());
+    header.postingCount = static_cast<uint32_t>(postings.size());
+    header.charCount = static_cast<uint32_t>(chars.size());
+
+    // 多个线程可能同时重建同一会话的索引，临时文件名带上线程ID
+    wxString tempPath = wxString::Format(wxT("%s.%lu.tmp"), filePath,
+                                         static_cast<unsigned long>(wxThread::GetCurrentId()));
+    wxFile file;
+    if (!file.Open(tempPath, wxFile::write)) {
+        wxLogWarning(wxT("无法创建搜索索引文件: %s"), tempPath);
+        return false;
+    }
+
+    bool success = file.Write(&header, sizeof(header)) == sizeof(header);
+    auto writeArray = [&file, &success](const void* data, size_t bytes) {
+        if (success && bytes > 0) {
+            success = file.Write(data, bytes) == bytes;
+        }
+    };
+    writeArray(docs.data(), docs.size() * sizeof(DocEntry));
+    writeArray(grams.data(), grams.size() * sizeof(GramEntry));
+    writeArray(words.data(), words.size() * sizeof(WordEntry));
+    writeArray(postings.data(), postings.size() * sizeof(uint32_t));
+    writeArray(chars.data(), chars.size() * sizeof(uint32_t));
+    file.Close();
+
+    if (!success) {
+        wxLogWarning(wxT("写入搜索索引文件失败: %s"), tempPath);
+        wxRemoveFile(tempPath);
+        return false;
+    }
+
+    // Windows 上目标文件正被映射时无法替换，留待下次保存或搜索时重建
+    if (!wxRenameFile(tempPath, filePath, true)) {
+        wxLogWarning(wxT("无法替换搜索索引文件: %s"), filePath);
+        wxRemoveFile(tempPath);
+        return false;
+    }
+    return true;
+}
+
+bool SessionSearchFile::Open(const wxString& filePath) {
+    Close();
+
+    if (!m_mapping.Open(filePath) || m_mapping.GetSize() < sizeof(FileHeader)) {
+        Close();
+        return false;
+    }
+    if (!Validate(m_mapping.GetSize())) {
+        wxLogWarning(wxT("搜索索引文件已损坏或版本不符: %s"), filePath);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void SessionSearchFile::Close() {
+    m_mapping.Close();
+    m_header = nullptr;
+    m_docs = nullptr;
+    m_grams = nullptr;
+    m_words = nullptr;
+    m_postings = nullptr;
+    m_chars = nullptr;
+}
+
+bool SessionSearchFile::Validate(size_t fileSize) {
+    const char* base = m_mapping.GetData();
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(base);
+    if (std::memcmp(header->magic, kIndexMagic, sizeof(header->magic)) != 0 ||
+        header->version != kIndexVersion) {
+        return false;
+    }
+
+    uint64_t expected = sizeof(FileHeader) +
+                        static_cast<uint64_t>(header->docCount) * sizeof(DocEntry) +
+                        static_cast<uint64_t>(header->gramCount) * sizeof(GramEntry) +
+                        static_cast<uint64_t>(header->wordCount) * sizeof(WordEntry) +
+                        static_cast<uint64_t>(header->postingCount) * sizeof(uint32_t) +
+                        static_cast<uint64_t>(header->charCount) * sizeof(uint32_t);
+    if (expected != fileSize) {
+        return false;
+    }
+
+    const char* p = base + sizeof(FileHeader);
+    m_header = header;
+    m_docs = reinterpret_cast<const DocEntry*>(p);
+    p += header->docCount * sizeof(DocEntry);
+    m_grams = reinterpret_cast<const GramEntry*>(p);
+    p += header->gramCount * sizeof(GramEntry);
+    m_words = reinterpret_cast<const WordEntry*>(p);
+    p += header->wordCount * sizeof(WordEntry);
+    m_postings = reinterpret_cast<const uint32_t*>(p);
+    p += header->postingCount * sizeof(uint32_t);
+    m_chars = reinterpret_cast<const uint32_t*>(p);
+
+    // 逐项检查引用范围，避免损坏的文件导致越界读取
+    for (uint32_t i = 0; i < header->docCount; ++i) {
+        const DocEntry& doc = m_docs[i];
+        if (static_cast<uint64_t>(doc.speakerOffset) + doc.speakerLength > header->charCount ||
+            static_cast<uint64_t>(doc.contentOffset) + doc.contentLength > header->charCount) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->gramCount; ++i) {
+        if (static_cast<uint64_t>(m_grams[i].postingOffset) + m_grams[i].postingCount > header->postingCount) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->wordCount; ++i) {
+        const WordEntry& word = m_words[i];
+        if (static_cast<uint64_t>(word.charOffset) + word.charLength > header->charCount ||
+            static_cast<uint64_t>(word.postingOffset) + word.postingCount > header->postingCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t SessionSearchFile::GetDocumentCount() const {
+    return m_header ? m_header->docCount : 0;
+}
+
+std::wstring SessionSearchFile::GetContent(size_t document) const {
+    return ReadChars(m_docs[document].contentOffset, m_docs[document].contentLength);
+}
+
+std::wstring SessionSearchFile::GetSpeaker(size_t document) const {
+    return ReadChars(m_docs[document].speakerOffset, m_docs[document].speakerLength);
+}
+
+wxDateTime SessionSearchFile::GetTimestamp(size_t document) const {
+    return wxDateTime(wxLongLong(m_docs[document].timestamp));
+}
+
+std::vector<SearchHit> SessionSearchFile::Search(const std::wstring& query, size_t maxHits,
+                                                 const std::wstring* speaker) const {
+    std::vector<SearchHit> hits;
+    if (!IsOpen()) {
+        return hits;
+    }
+
+    std::wstring normalized;
+    bool phrase = false;
+    if (!SearchIndex::PrepareQuery(query, &normalized, &phrase)) {
+        return hits;
+    }
+
+    std::vector<std::wstring> segments;
+    if (phrase) {
+        segments = SearchIndex::SplitPhrase(normalized);
+        if (segments.empty()) {
+            return hits;
+        }
+    }
+
+    std::vector<uint32_t> candidates = FindCandidates(normalized, phrase);
+    for (uint32_t document : candidates) {
+        if (speaker && !IsSpeaker(document, *speaker)) {
+            continue;
+        }
+        std::wstring text = SearchIndex::Normalize(GetContent(document));
+        SearchIndex::FindInText(text, document, normalized, phrase ? &segments : nullptr, hits, maxHits);
+        if (maxHits > 0 && hits.size() >= maxHits) {
+            break;
+        }
+    }
+    return hits;
+}
+
+std::vector<SearchHit> SessionSearchFile::SearchRegex(const RegexQuery& regex, size_t maxHits,
+                                                      const std::wstring* speaker) const {
+    std::vector<SearchHit> hits;
+    if (!IsOpen() || !regex.IsValid()) {
+        return hits;
+    }
+
+    for (uint32_t document : regex.FindCandidates(*this)) {
+        if (speaker && !IsSpeaker(document, *speaker)) {
+            continue;
+        }
+        regex.Match(GetContent(document), document, hits, maxHits);
+        if (maxHits > 0 && hits.size() >= maxHits) {
+            break;
+        }
+    }
+    return hits;
+}
+
+std::vector<SearchHit> SessionSearchFile::SearchFuzzy(const FuzzyQuery& fuzzy, size_t maxHits,
+                                                      const std::wstring* speaker) const {
+    std::vector<SearchHit> hits;
+    if (!IsOpen() || !fuzzy.IsValid()) {
+        return hits;
+    }
+
+    size_t count = GetDocumentCount();
+    for (size_t document = 0; document < count; ++document) {
+        if (speaker && !IsSpeaker(document, *speaker)) {
+            continue;
+        }
+        std::wstring normalized = SearchIndex::Normalize(GetContent(document));
+        fuzzy.Match(normalized, ToPinyinKey(normalized), document, hits, maxHits);
+        if (maxHits > 0 && hits.size() >= maxHits) {
+            break;
+        }
+    }
+    return hits;
+}
+
+std::vector<uint32_t> SessionSearchFile::FindCandidates(const std::wstring& normalizedQuery, bool wholeWords,
+                                                        bool* usedIndex) const {
+    std::vector<SearchIndex::QueryTerm> terms = SearchIndex::ParseQuery(normalizedQuery, wholeWords);
+    if (usedIndex) {
+        *usedIndex = !terms.empty();
+    }
+
+    if (terms.empty()) {
+        std::vector<uint32_t> all(GetDocumentCount());
+        for (size_t i = 0; i < all.size(); ++i) {
+            all[i] = static_cast<uint32_t>(i);
+        }
+        return all;
+    }
+
+    std::vector<std::vector<uint32_t>> lists;
+    lists.reserve(terms.size());
+    for (const auto& term : terms) {
+        std::vector<uint32_t> list = LookupTerm(term);
+        if (list.empty()) {
+            return std::vector<uint32_t>();
+        }
+        lists.push_back(std::move(list));
+    }
+
+    std::sort(lists.begin(), lists.end(),
+              [](const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) { return a.size() < b.size(); });
+
+    std::vector<uint32_t> result = std::move(lists[0]);
+    for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+        result = SearchIndex::Intersect(result, lists[i]);
+    }
+    return result;
+}
+
+std::vector<uint32_t> SessionSearchFile::LookupTerm(const SearchIndex::QueryTerm& term) const {
+    const GramEntry* gramsEnd = m_grams + m_header->gramCount;
+    const WordEntry* wordsEnd = m_words + m_header->wordCount;
+
+    switch (term.kind) {
+        case SearchIndex::QueryTerm::CjkGram: {
+            const GramEntry* it = std::lower_bound(m_grams, gramsEnd, term.gramKey,
+                [](const GramEntry& entry, uint64_t key) { return entry.key < key; });
+            if (it == gramsEnd || it->key != term.gramKey) {
+                return std::vector<uint32_t>();
+            }
+            return ReadPostings(it->postingOffset, it->postingCount);
+        }
+        case SearchIndex::QueryTerm::Word: {
+            const WordEntry* it = std::lower_bound(m_words, wordsEnd, term.word,
+                [this](const WordEntry& entry, const std::wstring& word) { return CompareWord(entry, word, SIZE_MAX) < 0; });
+            if (it == wordsEnd || CompareWord(*it, term.word, SIZE_MAX) != 0) {
+                return std::vector<uint32_t>();
+            }
+            return ReadPostings(it->postingOffset, it->postingCount);
+        }
+        default:
+            break;
+    }
+
+    std::vector<uint32_t> merged;
+    size_t matchedWords = 0;
+    auto append = [this, &merged, &matchedWords](const WordEntry& entry) {
+        std::vector<uint32_t> list = ReadPostings(entry.postingOffset, entry.postingCount);
+        merged.insert(merged.end(), list.begin(), list.end());
+        matchedWords++;
+    };
+
+    if (term.kind == SearchIndex::QueryTerm::WordPrefix) {
+        const WordEntry* it = std::lower_bound(m_words, wordsEnd, term.word,
+            [this](const WordEntry& entry, const std::wstring& word) { return CompareWord(entry, word, SIZE_MAX) < 0; });
+        for (; it != wordsEnd && CompareWord(*it, term.word, term.word.length()) == 0; ++it) {
+            append(*it);
+        }
+    } else {
+        for (const WordEntry* it = m_words; it != wordsEnd; ++it) {
+            if (it->charLength < term.word.length()) {
+                continue;
+            }
+            std::wstring word = ReadChars(it->charOffset, it->charLength);
+            bool matched = (term.kind == SearchIndex::QueryTerm::WordSuffix)
+                ? word.compare(word.length() - term.word.length(), term.word.length(), term.word) == 0
+                : word.find(term.word) != std::wstring::npos;
+            if (matched) {
+                append(*it);
+            }
+        }
+    }
+
+    SearchIndex::MergePostings(merged, matchedWords, GetDocumentCount());
+    return merged;
+}
+
+std::vector<uint32_t> SessionSearchFile::ReadPostings(uint32_t offset, uint32_t count) const {
+    return std::vector<uint32_t>(m_postings + offset, m_postings + offset + count);
+}
+
+std::wstring SessionSearchFile::ReadChars(uint32_t offset, uint32_t length) const {
+    std::wstring text(length, L'\0');
+    for (uint32_t i = 0; i < length; ++i) {
+        text[i] = static_cast<wchar_t>(m_chars[offset + i]);
+    }
+    return text;
+}
+
+int SessionSearchFile::CompareWord(const WordEntry& entry, const std::wstring& word, size_t prefixLength) const {
+    // prefixLength 限定只比较词条的前若干个字符，用于前缀匹配
+    size_t length = std::min<size_t>(entry.charLength, prefixLength);
+    size_t common = std::min(length, word.length());
+    const uint32_t* chars = m_chars + entry.charOffset;
+    for (size_t i = 0; i < common; ++i) {
+        uint32_t a = chars[i];
+        uint32_t b = static_cast<uint32_t>(word[i]);
+        if (a != b) {
+            return a < b ? -1 : 1;
+        }
+    }
+    if (length == word.length()) {
+        return 0;
+    }
+    return length < word.length() ? -1 : 1;
+}
+
+bool SessionSearchFile::IsSpeaker(size_t document, const std::wstring& speaker) const {
+    const DocEntry& doc = m_docs[document];
+    if (doc.speakerLength != speaker.length()) {
+        return false;
+    }
+    const uint32_t* chars = m_chars + doc.speakerOffset;
+    for (size_t i = 0; i < speaker.length(); ++i) {
+        if (chars[i] != static_cast<uint32_t>(speaker[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// --- SessionSearchManager ---
+
+// 线程池中的工作线程，从任务队列中取任务执行，取到空任务时退出
+class SessionSearchManager::Worker : public wxThread {
+public:
+    explicit Worker(SessionSearchManager* owner)
+        : wxThread(wxTHREAD_JOINABLE),
+          m_owner(owner) {
+    }
+
+protected:
+    ExitCode Entry() override {
+        for (;;) {
+            Task task;
+            if (m_owner->m_tasks.Receive(task) != wxMSGQUEUE_NO_ERROR || !task) {
+                break;
+            }
+            task();
+        }
+        return (ExitCode)0;
+    }
+
+private:
+    SessionSearchManager* m_owner;
+};
+
+SessionSearchManager::SessionSearchManager(const wxString& sessionsDir, size_t threadCount)
+    : m_sessionsDir(sessionsDir),
+      m_writeGeneration(0),
+      m_manifestDirty(false),
+      m_searchGeneration(0)
+{
+    LoadManifest();
+
+    if (threadCount == 0) {
+        int cpus = wxThread::GetCPUCount();
+        threadCount = static_cast<size_t>(std::max(1, std::min(cpus > 0 ? cpus : 2, 8)));
+    }
+
+    for (size_t i = 0; i < threadCount; ++i) {
+        Worker* worker = new Worker(this);
+        if (worker->Run() != wxTHREAD_NO_ERROR) {
+            wxLogWarning(wxT("无法启动搜索线程"));
+            delete worker;
+            break;
+        }
+        m_workers.push_back(worker);
+    }
+}
+
+SessionSearchManager::~SessionSearchManager() {
+    Shutdown();
+}
+
+void SessionSearchManager::Shutdown() {
+    m_searchGeneration++;
+    if (!m_workers.empty()) {
+        // 每个线程取到一个空任务后退出；之前排队的写入任务会先执行完
+        for (size_t i = 0; i < m_workers.size(); ++i) {
+            m_tasks.Post(Task());
+        }
+        for (Worker* worker : m_workers) {
+            worker->Wait();
+            delete worker;
+        }
+        m_workers.clear();
+    }
+    SaveManifest();
+}
+
+void SessionSearchManager::Post(const Task& task) {
+    if (m_workers.empty()) {
+        // 线程池不可用时同步执行
+        task();
+        return;
+    }
+    m_tasks.Post(task);
+}
+
+void SessionSearchManager::UpdateSession(const wxString& name, const wxString& path,
+                                         const std::vector<TranscriptionMessage>& messages) {
+    unsigned generation;
+    {
+        wxCriticalSectionLocker lock(m_critSect);
+        generation = ++m_writeGeneration;
+        m_pendingWrites[name] = generation;
+    }
+
+    // 消息快照交给后台线程，界面可以继续追加消息
+    auto snapshot = std::make_shared<std::vector<TranscriptionMessage>>(messages);
+    Post([this, name, path, snapshot, generation]() {
+        {
+            wxCriticalSectionLocker lock(m_critSect);
+            auto it = m_pendingWrites.find(name);
+            if (it == m_pendingWrites.end() || it->second != generation) {
+                return;   // 已有更新的写入排队
+            }
+        }
+        IndexSession(name, path, *snapshot);
+        {
+            wxCriticalSectionLocker lock(m_critSect);
+            auto it = m_pendingWrites.find(name);
+            if (it != m_pendingWrites.end() && it->second == generation) {
+                m_pendingWrites.erase(it);
+            }
+        }
+    });
+}
+
+void SessionSearchManager::RemoveSession(const wxString& name) {
+    wxCriticalSectionLocker lock(m_critSect);
+    m_pendingWrites.erase(name);
+    if (m_manifest.erase(name) > 0) {
+        m_manifestDirty = true;
+    }
+}
+
+int SessionSearchManager::SearchAsync(const SessionSearchQuery& query,
+                                      const std::vector<std::pair<wxString, wxString>>& sessions,
+                                      wxEvtHandler* handler) {
+    int requestId = ++m_searchGeneration;
+
+    if (sessions.empty()) {
+        wxThreadEvent* doneEvent = new wxThreadEvent(wxEVT_SESSION_SEARCH_DONE);
+        doneEvent->SetInt(requestId);
+        wxQueueEvent(handler, doneEvent);
+        return requestId;
+    }
+
+    // 最后一个完成的会话任务负责发送完成事件
+    auto remaining = std::make_shared<std::atomic<size_t>>(sessions.size());
+    for (const auto& session : sessions) {
+        wxString name = session.first;
+        wxString path = session.second;
+        Post([this, requestId, query, name, path, handler, remaining]() {
+            if (m_searchGeneration == requestId) {
+                SearchSession(requestId, query, name, path, handler);
+            }
+            if (--(*remaining) == 0) {
+                wxThreadEvent* doneEvent = new wxThreadEvent(wxEVT_SESSION_SEARCH_DONE);
+                doneEvent->SetInt(requestId);
+                wxQueueEvent(handler, doneEvent);
+            }
+        });
+    }
+    return requestId;
+}
+
+void SessionSearchManager::CancelSearch() {
+    m_searchGeneration++;
+}
+
+void SessionSearchManager::SearchSession(int requestId, const SessionSearchQuery& query, const wxString& name,
+                                         const wxString& path, wxEvtHandler* handler) {
+    if (!EnsureIndexed(name, path)) {
+        return;
+    }
+
+    SessionSearchFile file;
+    if (!file.Open(GetIndexFilePath(path))) {
+        return;
+    }
+
+    std::wstring speaker = query.speaker.ToStdWstring();
+    const std::wstring* speakerFilter = speaker.empty() ? nullptr : &speaker;
+    std::vector<SearchHit> hits;
+    if (query.fuzzy) {
+        hits = file.SearchFuzzy(*query.fuzzy, kMaxHitsPerSession, speakerFilter);
+    } else if (query.regex) {
+        hits = file.SearchRegex(*query.regex, kMaxHitsPerSession, speakerFilter);
+    } else {
+        hits = file.Search(query.text.ToStdWstring(), kMaxHitsPerSession, speakerFilter);
+    }
+    if (hits.empty() || m_searchGeneration != requestId) {
+        return;
+    }
+
+    auto result = std::make_shared<SessionSearchResult>();
+    result->requestId = requestId;
+    result->sessionName = name;
+    result->sessionPath = path;
+    result->hits.reserve(hits.size());
+    for (const auto& hit : hits) {
+        SessionSearchHit item;
+        item.message = hit.document;
+        item.offset = hit.offset;
+        item.length = hit.length;
+        item.speaker = wxString(file.GetSpeaker(hit.document));
+        item.snippet = MakeSnippet(file.GetContent(hit.document), hit.offset, hit.length);
+        item.timestamp = file.GetTimestamp(hit.document);
+        result->hits.push_back(item);
+    }
+
+    wxThreadEvent event(wxEVT_SESSION_SEARCH_RESULT);
+    event.SetInt(requestId);
+    event.SetPayload(result);
+    wxQueueEvent(handler, event.Clone());
+}
+
+bool SessionSearchManager::IndexSession(const wxString& name, const wxString& path,
+                                        const std::vector<TranscriptionMessage>& messages) {
+    int64_t modified = 0;
+    int64_t size = 0;
+    GetTranscriptState(path, &modified, &size);
+
+    if (!SessionSearchFile::Write(GetIndexFilePath(path), messages)) {
+        return false;
+    }
+
+    wxCriticalSectionLocker lock(m_critSect);
+    ManifestEntry& entry = m_manifest[name];
+    entry.path = path;
+    entry.transcriptModified = modified;
+    entry.transcriptSize = size;
+    entry.messageCount = messages.size();
+    m_manifestDirty = true;
+    return true;
+}
+
+bool SessionSearchManager::EnsureIndexed(const wxString& name, const wxString& path) {
+    int64_t modified = 0;
+    int64_t size = 0;
+    if (!GetTranscriptState(path, &modified, &size)) {
+        return false;   // 会话还没有转录内容
+    }
+
+    bool upToDate = false;
+    {
+        wxCriticalSectionLocker lock(m_critSect);
+        // 排队中的写入会带来最新内容，先用现有索引
+        if (m_pendingWrites.count(name) > 0) {
+            return wxFileName::FileExists(GetIndexFilePath(path));
+        }
+        auto it = m_manifest.find(name);
+        upToDate = it != m_manifest.end() && it->second.path == path &&
+                   it->second.transcriptModified == modified && it->second.transcriptSize == size;
+    }
+    if (upToDate && wxFileName::FileExists(GetIndexFilePath(path))) {
+        return true;
+    }
+
+    std::vector<TranscriptionMessage> messages;
+    if (!LoadTranscriptFile(path, messages)) {
+        return false;
+    }
+    return IndexSession(name, path, messages);
+}
+
+bool SessionSearchManager::GetTranscriptState(const wxString& path, int64_t* modified, int64_t* size) {
+    // 转录可能分在几个文件中（数据库和它的 WAL 文件），取最晚的修改时间和大小之和
+    std::vector<wxString> sources = GetTranscriptSourcePaths(path);
+    if (sources.empty()) {
+        return false;
+    }
+    *modified = 0;
+    *size = 0;
+    for (const auto& source : sources) {
+        wxFileName transcript(source);
+        wxDateTime modTime = transcript.GetModificationTime();
+        if (modTime.IsValid()) {
+            *modified = std::max(*modified, static_cast<int64_t>(modTime.GetTicks()));
+        }
+        *size += static_cast<int64_t>(transcript.GetSize().GetValue());
+    }
+    return true;
+}
+
+wxString SessionSearchManager::MakeSnippet(const std::wstring& content, size_t offset, size_t length) {
+    size_t begin = offset > kSnippetBefore ? offset - kSnippetBefore : 0;
+    size_t end = std::min(content.length(), offset + length + kSnippetAfter);
+    wxString snippet(content.substr(begin, end - begin));
+    snippet.Replace(wxT("\n"), wxT(" "));
+    if (begin > 0) {
+        snippet.Prepend(wxT("…"));
+    }
+    if (end < content.length()) {
+        snippet.Append(wxT("…"));
+    }
+    return snippet;
+}
+
+wxString SessionSearchManager::GetIndexFilePath(const wxString& sessionPath) {
+    return wxFileName(sessionPath, wxT("search.idx")).GetFullPath();
+}
+
+wxString SessionSearchManager::GetManifestPath() const {
+    return wxFileName(m_sessionsDir, wxT("search_manifest.json")).GetFullPath();
+}
+
+bool SessionSearchManager::LoadManifest() {
+    wxString manifestPath = GetManifestPath();
+    if (m_sessionsDir.IsEmpty() || !wxFileExists(manifestPath)) {
+        return false;
+    }
+
+    wxFile file;
+    wxString content;
+    if (!file.Open(manifestPath, wxFile::read) || !file.ReadAll(&content, wxConvUTF8)) {
+        wxLogWarning(wxT("无法读取搜索索引清单: %s"), manifestPath);
+        return false;
+    }
+
+    try {
+        nlohmann::json manifest = nlohmann::json::parse(content.ToStdString(wxConvUTF8));
+        if (manifest.value("version", 0) != kManifestVersion || !manifest.contains("sessions")) {
+            return false;
+        }
+
+        wxCriticalSectionLocker lock(m_critSect);
+        for (auto it = manifest["sessions"].begin(); it != manifest["sessions"].end(); ++it) {
+            const auto& value = it.value();
+            ManifestEntry entry;
+            entry.path = wxString::FromUTF8(value.value("path", std::string()).c_str());
+            entry.transcriptModified = value.value("transcriptModified", static_cast<int64_t>(0));
+            entry.transcriptSize = value.value("transcriptSize", static_cast<int64_t>(0));
+            entry.messageCount = value.value("messages", static_cast<size_t>(0));
+            m_manifest[wxString::FromUTF8(it.key().c_str())] = entry;
+        }
+    } catch (const std::exception& e) {
+        // 清单损坏时重新建立，索引会在搜索时按需重建
+        wxLogWarning(wxT("解析搜索索引清单失败: %s"), wxString(e.what()));
+        return false;
+    }
+    return true;
+}
+
+bool SessionSearchManager::SaveManifest() {
+    if (m_sessionsDir.IsEmpty()) {
+        return false;
+    }
+
+    nlohmann::json manifest;
+    {
+        wxCriticalSectionLocker lock(m_critSect);
+        if (!m_manifestDirty) {
+            return true;
+        }
+        manifest["version"] = kManifestVersion;
+        nlohmann::json sessions = nlohmann::json::object();
+        for (const auto& entry : m_manifest) {
+            sessions[entry.first.ToStdString(wxConvUTF8)] = {
+                {"path", entry.second.path.ToStdString(wxConvUTF8)},
+                {"transcriptModified", entry.second.transcriptModified},
+                {"transcriptSize", entry.second.transcriptSize},
+                {"messages", entry.second.messageCount}
+            };
+        }
+        manifest["sessions"] = sessions;
+        m_manifestDirty = false;
+    }
+
+    wxString manifestPath = GetManifestPath();
+    wxString tempPath = manifestPath + wxT(".tmp");
+    std::string data = manifest.dump(4);
+
+    wxFile file;
+    bool success = file.Open(tempPath, wxFile::write) && file.Write(data.c_str(), data.size());
+    file.Close();
+    if (!success) {
+        wxLogWarning(wxT("写入搜索索引清单失败: %s"), tempPath);
+    } else if (!wxRenameFile(tempPath, manifestPath, true)) {
+        wxLogWarning(wxT("无法替换搜索索引清单: %s"), manifestPath);
+        success = false;
+    }
+
+    if (!success) {
+        // 下次再试
+        wxCriticalSectionLocker lock(m_critSect);
+        m_manifestDirty = true;
+    }
+    return success;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,195 @@
+#ifndef MEETANT_SESSION_SEARCH_H
+#define MEETANT_SESSION_SEARCH_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <wx/msgqueue.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+#include "FileMapping.h"
+#include "SearchIndex.h"
+#include "RegexSearch.h"
+#include "FuzzySearch.h"
+#include "TranscriptionBubbleCtrl.h"
+
+// 某个会话的搜索结果，payload 为 std::shared_ptr<MeetAnt::SessionSearchResult>
+wxDECLARE_EVENT(wxEVT_SESSION_SEARCH_RESULT, wxThreadEvent);
+// 一次跨会话搜索的所有会话都已完成，GetInt() 为请求编号
+wxDECLARE_EVENT(wxEVT_SESSION_SEARCH_DONE, wxThreadEvent);
+
+namespace MeetAnt {
+
+// 跨会话搜索的一条命中
+struct SessionSearchHit {
+    size_t message;         // 消息在转录中的序号
+    size_t offset;          // 命中在消息内容中的位置（字符）
+    size_t length;
+    wxString speaker;
+    wxString snippet;       // 命中附近的上下文
+    wxDateTime timestamp;
+};
+
+// 跨会话搜索的查询条件
+struct SessionSearchQuery {
+    wxString text;                              // 查询文本（非正则时使用）
+    std::shared_ptr<const RegexQuery> regex;    // 已编译的正则，非空时按正则匹配
+    std::shared_ptr<const FuzzyQuery> fuzzy;    // 已编译的拼音模糊查询，非空时按拼音匹配
+    wxString speaker;                           // 只搜索该发言人的消息，为空时不过滤
+};
+
+// 单个会话的搜索结果
+struct SessionSearchResult {
+    int requestId;
+    wxString sessionName;
+    wxString sessionPath;
+    std::vector<SessionSearchHit> hits;
+};
+
+// 会话的持久化搜索索引文件（search.idx）
+// 文件由固定长度的头部和若干定长记录数组组成，打开时整体映射到内存，
+// 查询直接在映射区上二分查找和读取倒排表，无需把索引载入堆内存。
+// 索引结构与 SearchIndex 相同：中日韩单字/双字和拉丁词的倒排表。
+class SessionSearchFile {
+public:
+    SessionSearchFile();
+    ~SessionSearchFile();
+
+    // 为一组消息建立索引并写入文件（先写临时文件再替换）
+    static bool Write(const wxString& filePath, const std::vector<TranscriptionMessage>& messages);
+
+    bool Open(const wxString& filePath);
+    void Close();
+    bool IsOpen() const { return m_header != nullptr; }
+
+    size_t GetDocumentCount() const;
+    std::wstring GetContent(size_t document) const;
+    std::wstring GetSpeaker(size_t document) const;
+    wxDateTime GetTimestamp(size_t document) const;
+
+    // 与 SearchIndex::Search 语义相同的查询，命中位置以字符计；speaker 非空时只搜索该发言人的消息
+    std::vector<SearchHit> Search(const std::wstring& query, size_t maxHits,
+                                  const std::wstring* speaker = nullptr) const;
+
+    // 正则查询：先用字面子串筛选候选文档，再在原文上匹配
+    std::vector<SearchHit> SearchRegex(const RegexQuery& regex, size_t maxHits,
+                                       const std::wstring* speaker = nullptr) const;
+
+    // 拼音模糊查询：索引文件不保存拼音，逐条消息现算拼音键后匹配
+    std::vector<SearchHit> SearchFuzzy(const FuzzyQuery& fuzzy, size_t maxHits,
+                                       const std::wstring* speaker = nullptr) const;
+
+    // 与 SearchIndex::FindCandidates 语义相同
+    std::vector<uint32_t> FindCandidates(const std::wstring& normalizedQuery, bool wholeWords,
+                                         bool* usedIndex = nullptr) const;
+
+private:
+    struct FileHeader;
+    struct DocEntry;
+    struct GramEntry;
+    struct WordEntry;
+
+    std::vector<uint32_t> LookupTerm(const SearchIndex::QueryTerm& term) const;
+    std::vector<uint32_t> ReadPostings(uint32_t offset, uint32_t count) const;
+    std::wstring ReadChars(uint32_t offset, uint32_t length) const;
+    int CompareWord(const WordEntry& entry, const std::wstring& word, size_t prefixLength) const;
+    bool IsSpeaker(size_t document, const std::wstring& speaker) const;
+
+    bool Validate(size_t fileSize);
+
+    FileMapping m_mapping;
+    const FileHeader* m_header;
+    const DocEntry* m_docs;
+    const GramEntry* m_grams;
+    const WordEntry* m_words;
+    const uint32_t* m_postings;
+    const uint32_t* m_chars;
+
+    SessionSearchFile(const SessionSearchFile&) = delete;
+    SessionSearchFile& operator=(const SessionSearchFile&) = delete;
+};
+
+// 跨会话搜索
+// 每个会话目录保存一份 search.idx，会话根目录下的 search_manifest.json 记录
+// 各会话索引对应的转录文件状态。保存会话时在后台重建索引；查询时把每个会话
+// 作为一个任务投递到线程池并行执行，结果按会话逐个以事件形式回传给界面。
+class SessionSearchManager {
+public:
+    SessionSearchManager(const wxString& sessionsDir, size_t threadCount = 0);
+    ~SessionSearchManager();
+
+    // 停止线程池（等待正在执行的任务结束）并保存清单
+    void Shutdown();
+
+    // 会话内容已保存，在后台重建其索引；同一会话连续多次更新只写最后一次
+    void UpdateSession(const wxString& name, const wxString& path,
+                       const std::vector<TranscriptionMessage>& messages);
+
+    // 会话已从列表移除，不再记录其索引状态
+    void RemoveSession(const wxString& name);
+
+    // 在给定会话（名称、路径）中并行搜索，返回请求编号；之前未完成的搜索被取消
+    int SearchAsync(const SessionSearchQuery& query,
+                    const std::vector<std::pair<wxString, wxString>>& sessions,
+                    wxEvtHandler* handler);
+
+    // 取消正在进行的搜索
+    void CancelSearch();
+
+    // 把索引清单写回磁盘（清单未变化时不写）
+    bool SaveManifest();
+
+    // 会话索引文件路径
+    static wxString GetIndexFilePath(const wxString& sessionPath);
+
+private:
+    class Worker;
+    friend class Worker;
+
+    typedef std::function<void()> Task;
+
+    // 清单中一个会话的记录
+    struct ManifestEntry {
+        wxString path;
+        int64_t transcriptModified;   // 建索引时转录文件的修改时间（秒）
+        int64_t transcriptSize;       // 建索引时转录文件的大小
+        size_t messageCount;
+    };
+
+    void Post(const Task& task);
+    bool LoadManifest();
+    wxString GetManifestPath() const;
+
+    // 建立索引并更新清单
+    bool IndexSession(const wxString& name, const wxString& path,
+                      const std::vector<TranscriptionMessage>& messages);
+
+    // 索引缺失或转录文件已变化时重建索引（在工作线程中调用）
+    bool EnsureIndexed(const wxString& name, const wxString& path);
+
+    // 在一个会话中搜索（在工作线程中调用）
+    void SearchSession(int requestId, const SessionSearchQuery& query, const wxString& name,
+                       const wxString& path, wxEvtHandler* handler);
+
+    static bool GetTranscriptState(const wxString& path, int64_t* modified, int64_t* size);
+    static wxString MakeSnippet(const std::wstring& content, size_t offset, size_t length);
+
+    wxString m_sessionsDir;
+    wxMessageQueue<Task> m_tasks;
+    std::vector<Worker*> m_workers;
+
+    wxCriticalSection m_critSect;                         // 保护以下成员
+    std::map<wxString, ManifestEntry> m_manifest;
+    std::map<wxString, unsigned> m_pendingWrites;         // 会话 -> 最新排队的写入代号
+    unsigned m_writeGeneration;
+    bool m_manifestDirty;
+
+    std::atomic<int> m_searchGeneration;                  // 最新的搜索请求编号
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_SESSION_SEARCH_H
@@ -0,0 +1,714 @@
+#include "SessionStore.h"
+#include "TranscriptFile.h"
+#include "TranscriptLog.h"
+#include <wx/dir.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/textfile.h>
+#include <cstring>
+#include <unordered_map>
+
+#ifdef MEETANT_HAVE_SQLITE3
+#include <sqlite3.h>
+#endif
+
+namespace MeetAnt {
+
+namespace {
+    // 数据库结构的版本，记在 PRAGMA user_version 中；更新版本的数据库只读不写
+    const int kSchemaVersion = 1;
+
+    // 写入事务进行时，读取方和写入方最多等待这么久（毫秒）
+    const int kBusyTimeoutMs = 5000;
+
+    // WAV 文件头只在前面这么多字节中查找 fmt 和 data 块
+    const size_t kWavProbeBytes = 4096;
+
+    // 在调用线程中编码好的行，写入线程只接触这些数据
+    struct MessageRow {
+        int64_t timestamp;
+        std::string speaker;
+        std::string content;
+    };
+
+    // id 为批注在 AnnotationManager 中的编号；删除时只用到 id
+    struct AnnotationRow {
+        int64_t id;
+        bool deleted;
+        int type;
+        int64_t timestamp;
+        std::string data;
+    };
+
+    AnnotationRow MakeAnnotationRow(const Annotation* annotation) {
+        AnnotationRow row;
+        row.id = static_cast<int64_t>(annotation->GetId());
+        row.deleted = false;
+        row.type = static_cast<int>(annotation->GetType());
+        row.timestamp = annotation->GetTimestamp();
+        annotation->Encode(row.data);
+        return row;
+    }
+
+    std::string ToUTF8(const wxString& text) {
+        wxScopedCharBuffer utf8 = text.utf8_str();
+        return std::string(utf8.data(), utf8.length());
+    }
+
+    std::shared_ptr<std::vector<MessageRow>> MakeMessageRows(const std::vector<TranscriptionMessage>& messages) {
+        auto rows = std::make_shared<std::vector<MessageRow>>();
+        rows->reserve(messages.size());
+        for (const auto& msg : messages) {
+            MessageRow row;
+            row.timestamp = msg.timestamp.IsValid() ? msg.timestamp.GetValue().GetValue() : 0;
+            row.speaker = ToUTF8(msg.speakerName);
+            row.content = ToUTF8(msg.content);
+            rows->push_back(std::move(row));
+        }
+        return rows;
+    }
+
+    uint16_t ReadU16(const char* data) {
+        uint16_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint32_t ReadU32(const char* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+#ifdef MEETANT_HAVE_SQLITE3
+    // 预编译语句，析构时释放
+    class Statement {
+    public:
+        Statement(sqlite3* db, const char* sql) : m_statement(nullptr) {
+            if (sqlite3_prepare_v2(db, sql, -1, &m_statement, nullptr) != SQLITE_OK) {
+                wxLogWarning(wxT("会话数据库语句无效: %s"), wxString::FromUTF8(sqlite3_errmsg(db)));
+                m_statement = nullptr;
+            }
+        }
+        ~Statement() { sqlite3_finalize(m_statement); }
+
+        bool IsValid() const { return m_statement != nullptr; }
+
+        void Bind(int index, int64_t value) { sqlite3_bind_int64(m_statement, index, value); }
+        void BindNull(int index) { sqlite3_bind_null(m_statement, index); }
+        void BindText(int index, const std::string& text) {
+            sqlite3_bind_text(m_statement, index, text.data(), static_cast<int>(text.size()), SQLITE_TRANSIENT);
+        }
+        void BindBlob(int index, const std::string& data) {
+            sqlite3_bind_blob(m_statement, index, data.data(), static_cast<int>(data.size()), SQLITE_TRANSIENT);
+        }
+
+        // 还有结果行时返回 true
+        bool Step() { return m_statement && sqlite3_step(m_statement) == SQLITE_ROW; }
+        // 执行不返回结果的语句，之后可以重新绑定再执行
+        bool Run() {
+            bool done = m_statement && sqlite3_step(m_statement) == SQLITE_DONE;
+            sqlite3_reset(m_statement);
+            return done;
+        }
+
+        int64_t GetInt(int column) const { return sqlite3_column_int64(m_statement, column); }
+        bool IsNull(int column) const { return sqlite3_column_type(m_statement, column) == SQLITE_NULL; }
+        wxString GetString(int column) const {
+            const char* text = reinterpret_cast<const char*>(sqlite3_column_text(m_statement, column));
+            return text ? wxString::FromUTF8(text, sqlite3_column_bytes(m_statement, column)) : wxString();
+        }
+        const char* GetBlob(int column, size_t* size) const {
+            const char* data = static_cast<const char*>(sqlite3_column_blob(m_statement, column));
+            *size = static_cast<size_t>(sqlite3_column_bytes(m_statement, column));
+            return data;
+        }
+
+    private:
+        sqlite3_stmt* m_statement;
+
+        Statement(const Statement&) = delete;
+        Statement& operator=(const Statement&) = delete;
+    };
+
+    bool Exec(sqlite3* db, const char* sql) {
+        char* error = nullptr;
+        if (sqlite3_exec(db, sql, nullptr, nullptr, &error) != SQLITE_OK) {
+            wxLogWarning(wxT("会话数据库操作失败: %s"), wxString::FromUTF8(error ? error : "?"));
+            sqlite3_free(error);
+            return false;
+        }
+        return true;
+    }
+
+    sqlite3* OpenConnection(const wxString& path, bool readOnly) {
+        sqlite3* db = nullptr;
+        int flags = readOnly ? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+        if (sqlite3_open_v2(path.utf8_str(), &db, flags, nullptr) != SQLITE_OK) {
+            wxLogWarning(wxT("无法打开会话数据库: %s"), path);
+            sqlite3_close(db);
+            return nullptr;
+        }
+        sqlite3_busy_timeout(db, kBusyTimeoutMs);
+        return db;
+    }
+
+    // 只读连接，析构时关闭
+    class ReadConnection {
+    public:
+        explicit ReadConnection(const wxString& path) : m_db(OpenConnection(path, true)) {}
+        ~ReadConnection() { sqlite3_close(m_db); }
+        sqlite3* Get() const { return m_db; }
+
+    private:
+        sqlite3* m_db;
+    };
+
+    const char* const kCreateSchema =
+        "CREATE TABLE IF NOT EXISTS meta ("
+        "    key TEXT PRIMARY KEY,"
+        "    value TEXT NOT NULL);"
+        "CREATE TABLE IF NOT EXISTS speakers ("
+        "    id INTEGER PRIMARY KEY,"
+        "    name TEXT NOT NULL UNIQUE);"
+        "CREATE TABLE IF NOT EXISTS messages ("
+        "    seq INTEGER PRIMARY KEY,"                  // 消息在转录中的位置，从 0 开始
+        "    timestamp INTEGER NOT NULL,"               // 毫秒
+        "    speaker INTEGER NOT NULL REFERENCES speakers(id),"
+        "    content TEXT NOT NULL);"
+        "CREATE INDEX IF NOT EXISTS messages_by_time ON messages(timestamp);"
+        "CREATE INDEX IF NOT EXISTS messages_by_speaker ON messages(speaker, timestamp);"
+        "CREATE TABLE IF NOT EXISTS annotations ("
+        "    id INTEGER PRIMARY KEY,"                   // AnnotationManager 中的编号（见 meta 中的 annotation_ids）
+        "    type INTEGER NOT NULL,"
+        "    timestamp INTEGER NOT NULL,"               // 关联的音频时间戳（毫秒）
+        "    data BLOB NOT NULL);"                      // Annotation::Encode 的编码
+        "CREATE INDEX IF NOT EXISTS annotations_by_time ON annotations(timestamp);"
+        "CREATE INDEX IF NOT EXISTS annotations_by_type ON annotations(type, timestamp);"
+        "CREATE TABLE IF NOT EXISTS audio_segments ("
+        "    file TEXT PRIMARY KEY,"
+        "    start_time INTEGER,"                       // 毫秒，无法确定时为 NULL
+        "    duration_ms INTEGER NOT NULL,"
+        "    sample_rate INTEGER NOT NULL,"
+        "    channels INTEGER NOT NULL,"
+        "    bits_per_sample INTEGER NOT NULL,"
+        "    bytes INTEGER NOT NULL);"
+        "CREATE INDEX IF NOT EXISTS audio_segments_by_time ON audio_segments(start_time);";
+#endif
+}
+
+#ifdef MEETANT_HAVE_SQLITE3
+// 写入连接和发言人编号的缓存，打开后只在写入线程中使用
+struct SessionStore::Database {
+    sqlite3* db;
+    std::unordered_map<std::string, int64_t> speakerIds;
+    int64_t nextSeq;
+
+    explicit Database(sqlite3* connection) : db(connection), nextSeq(0) {}
+    ~Database() { sqlite3_close(db); }
+
+    int64_t GetSpeakerId(const std::string& name) {
+        auto it = speakerIds.find(name);
+        if (it != speakerIds.end()) {
+            return it->second;
+        }
+        Statement insert(db, "INSERT OR IGNORE INTO speakers(name) VALUES(?)");
+        insert.BindText(1, name);
+        insert.Run();
+        Statement select(db, "SELECT id FROM speakers WHERE name = ?");
+        select.BindText(1, name);
+        int64_t id = select.Step() ? select.GetInt(0) : 0;
+        speakerIds[name] = id;
+        return id;
+    }
+
+    bool InsertMessages(const std::vector<MessageRow>& rows) {
+        Statement insert(db, "INSERT OR REPLACE INTO messages(seq, timestamp, speaker, content) VALUES(?, ?, ?, ?)");
+        for (const auto& row : rows) {
+            insert.Bind(1, nextSeq++);
+            insert.Bind(2, row.timestamp);
+            insert.Bind(3, GetSpeakerId(row.speaker));
+            insert.BindText(4, row.content);
+            if (!insert.Run()) {
+                wxLogWarning(wxT("写入会话数据库失败: %s"), wxString::FromUTF8(sqlite3_errmsg(db)));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 按编号写入或删除批注
+    bool WriteAnnotations(const std::vector<AnnotationRow>& rows) {
+        Statement upsert(db, "INSERT OR REPLACE INTO annotations(id, type, timestamp, data) VALUES(?, ?, ?, ?)");
+        Statement remove(db, "DELETE FROM annotations WHERE id = ?");
+        for (const auto& row : rows) {
+            bool written;
+            if (row.deleted) {
+                remove.Bind(1, row.id);
+                written = remove.Run();
+            } else {
+                upsert.Bind(1, row.id);
+                upsert.Bind(2, row.type);
+                upsert.Bind(3, row.timestamp);
+                upsert.BindBlob(4, row.data);
+                written = upsert.Run();
+            }
+            if (!written) {
+                wxLogWarning(wxT("写入会话数据库失败: %s"), wxString::FromUTF8(sqlite3_errmsg(db)));
+                return false;
+            }
+        }
+        return true;
+    }
+};
+#else
+struct SessionStore::Database {
+};
+#endif
+
+SessionStore::SessionStore(const wxString& sessionPath)
+    : m_sessionPath(sessionPath),
+      m_messageCount(0),
+      m_needsImport(false),
+      m_needsAnnotationImport(false),
+      m_failed(false)
+{
+#ifdef MEETANT_HAVE_SQLITE3
+    wxString path = GetDatabasePath(m_sessionPath);
+    sqlite3* db = OpenConnection(path, false);
+    if (!db) {
+        return;
+    }
+    std::unique_ptr<Database> database(new Database(db));
+
+    // WAL 模式下读取不阻塞写入；每次提交不等待 fsync，检查点时落盘
+    if (!Exec(db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL; PRAGMA foreign_keys=ON;")) {
+        return;
+    }
+    int version = 0;
+    {
+        Statement query(db, "PRAGMA user_version");
+        if (query.Step()) {
+            version = static_cast<int>(query.GetInt(0));
+        }
+    }
+    if (version > kSchemaVersion) {
+        wxLogWarning(wxT("不支持的会话数据库版本 %d: %s"), version, path);
+        return;
+    }
+    if (version < kSchemaVersion) {
+        std::string sql = std::string("BEGIN;") + kCreateSchema +
+                          "PRAGMA user_version = " + std::to_string(kSchemaVersion) + ";COMMIT;";
+        if (!Exec(db, sql.c_str())) {
+            Exec(db, "ROLLBACK");
+            return;
+        }
+    }
+
+    {
+        Statement query(db, "SELECT COUNT(*), IFNULL(MAX(seq) + 1, 0) FROM messages");
+        if (query.Step()) {
+            m_messageCount = static_cast<size_t>(query.GetInt(0));
+            database->nextSeq = query.GetInt(1);
+        }
+    }
+    {
+        Statement query(db, "SELECT value FROM meta WHERE key = 'imported'");
+        m_needsImport = !query.Step();
+    }
+    {
+        // 没有这个标记的数据库中批注的 id 是自动分配的，与 AnnotationManager 的编号对不上
+        Statement query(db, "SELECT value FROM meta WHERE key = 'annotation_ids'");
+        m_needsAnnotationImport = !query.Step();
+    }
+    m_database = std::move(database);
+
+    // kGroupCommitMs 内陆续提交的写入放在同一个事务中
+    m_writer.reset(new GroupCommitWriter(kGroupCommitMs,
+                                         [this]() { BeginBatch(); },
+                                         [this]() { CommitBatch(); }));
+#endif
+}
+
+SessionStore::~SessionStore() {
+    if (m_writer) {
+        m_writer->Stop();
+    }
+}
+
+bool SessionStore::IsSupported() {
+#ifdef MEETANT_HAVE_SQLITE3
+    return true;
+#else
+    return false;
+#endif
+}
+
+wxString SessionStore::GetDatabasePath(const wxString& sessionPath) {
+    return wxFileName(sessionPath, wxT("session.db")).GetFullPath();
+}
+
+bool SessionStore::Exists(const wxString& sessionPath) {
+    return IsSupported() && wxFileName::FileExists(GetDatabasePath(sessionPath));
+}
+
+void SessionStore::Post(const GroupCommitWriter::Task& task) {
+    if (m_writer) {
+        m_writer->Post(task);
+    }
+}
+
+bool SessionStore::Flush() {
+    // 写入线程在 Flush 返回前已经结束，这里读取它的状态是安全的
+    if (m_writer) {
+        m_writer->Flush();
+    }
+    return !m_failed;
+}
+
+void SessionStore::BeginBatch() {
+#ifdef MEETANT_HAVE_SQLITE3
+    Exec(m_database->db, "BEGIN");
+#endif
+}
+
+void SessionStore::CommitBatch() {
+#ifdef MEETANT_HAVE_SQLITE3
+    if (!Exec(m_database->db, "COMMIT")) {
+        Exec(m_database->db, "ROLLBACK");
+        m_failed = true;
+    }
+#endif
+}
+
+void SessionStore::AppendMessages(const std::vector<TranscriptionMessage>& messages) {
+    if (messages.empty() || !m_database) {
+        return;
+    }
+    auto rows = MakeMessageRows(messages);
+    m_messageCount += messages.size();
+#ifdef MEETANT_HAVE_SQLITE3
+    Post([this, rows]() {
+        if (!m_database->InsertMessages(*rows)) {
+            m_failed = true;
+        }
+    });
+#endif
+}
+
+void SessionStore::ReplaceMessages(const std::vector<TranscriptionMessage>& messages) {
+    if (!m_database) {
+        return;
+    }
+    auto rows = MakeMessageRows(messages);
+    m_messageCount = messages.size();
+#ifdef MEETANT_HAVE_SQLITE3
+    Post([this, rows]() {
+        m_database->nextSeq = 0;
+        if (!Exec(m_database->db, "DELETE FROM messages") || !m_database->InsertMessages(*rows)) {
+            m_failed = true;
+        }
+    });
+#endif
+}
+
+void SessionStore::ReplaceAnnotations(const std::vector<Annotation*>& annotations) {
+    if (!m_database) {
+        return;
+    }
+    auto rows = std::make_shared<std::vector<AnnotationRow>>();
+    rows->reserve(annotations.size());
+    for (const Annotation* annotation : annotations) {
+        rows->push_back(MakeAnnotationRow(annotation));
+    }
+    m_needsAnnotationImport = false;
+#ifdef MEETANT_HAVE_SQLITE3
+    Post([this, rows]() {
+        sqlite3* db = m_database->db;
+        if (!Exec(db, "DELETE FROM annotations") || !m_database->WriteAnnotations(*rows) ||
+            !Exec(db, "INSERT OR REPLACE INTO meta(key, value) VALUES('annotation_ids', '1')")) {
+            m_failed = true;
+        }
+    });
+#endif
+}
+
+void SessionStore::ApplyAnnotationChanges(const std::vector<std::string>& records) {
+    if (records.empty() || !m_database) {
+        return;
+    }
+    auto rows = std::make_shared<std::vector<AnnotationRow>>();
+    rows->reserve(records.size());
+    for (const auto& record : records) {
+        char operation;
+        unsigned long id;
+        std::unique_ptr<Annotation> annotation;
+        if (!AnnotationManager::DecodeRecord(record.data(), record.size(), operation, id, annotation)) {
+            continue;
+        }
+        if (annotation) {
+            rows->push_back(MakeAnnotationRow(annotation.get()));
+        } else {
+            AnnotationRow row;
+            row.id = static_cast<int64_t>(id);
+            row.deleted = true;
+            row.type = 0;
+            row.timestamp = 0;
+            rows->push_back(std::move(row));
+        }
+    }
+#ifdef MEETANT_HAVE_SQLITE3
+    Post([this, rows]() {
+        if (!m_database->WriteAnnotations(*rows)) {
+            m_failed = true;
+        }
+    });
+#endif
+}
+
+void SessionStore::AddAudioSegment(const wxString& filePath) {
+    if (!m_database) {
+        return;
+    }
+#ifdef MEETANT_HAVE_SQLITE3
+    Post([this, filePath]() {
+        AudioSegment segment;
+        if (!ProbeAudioFile(filePath, segment)) {
+            return;
+        }
+        Statement insert(m_database->db,
+                         "INSERT OR REPLACE INTO audio_segments(file, start_time, duration_ms, sample_rate,"
+                         " channels, bits_per_sample, bytes) VALUES(?, ?, ?, ?, ?, ?, ?)");
+        insert.BindText(1, ToUTF8(segment.fileName));
+        if (segment.startTime.IsValid()) {
+            insert.Bind(2, segment.startTime.GetValue().GetValue());
+        } else {
+            insert.BindNull(2);
+        }
+        insert.Bind(3, segment.durationMs);
+        insert.Bind(4, segment.sampleRate);
+        insert.Bind(5, segment.channels);
+        insert.Bind(6, segment.bitsPerSample);
+        insert.Bind(7, segment.bytes);
+        insert.Run();
+    });
+#endif
+}
+
+void SessionStore::SetInfo(const wxString& key, const wxString& value) {
+    if (!m_database) {
+        return;
+    }
+#ifdef MEETANT_HAVE_SQLITE3
+    std::string keyUtf8 = ToUTF8(key);
+    std::string valueUtf8 = ToUTF8(value);
+    Post([this, keyUtf8, valueUtf8]() {
+        Statement insert(m_database->db, "INSERT OR REPLACE INTO meta(key, value) VALUES(?, ?)");
+        insert.BindText(1, keyUtf8);
+        insert.BindText(2, valueUtf8);
+        insert.Run();
+    });
+#endif
+}
+
+void SessionStore::ImportFolder() {
+    if (!m_database) {
+        return;
+    }
+
+    // 转录：优先读取追加式日志，旧会话读取转录文本
+    std::vector<TranscriptionMessage> messages;
+    if (!TranscriptLog::Read(m_sessionPath, messages)) {
+        LoadTranscriptText(m_sessionPath, messages);
+    }
+    ReplaceMessages(messages);
+
+    // 会话信息：每行 "键: 值"
+    wxString infoPath = wxFileName(m_sessionPath, wxT("session.info")).GetFullPath();
+    wxTextFile info;
+    if (wxFileName::FileExists(infoPath) && info.Open(infoPath, wxConvUTF8)) {
+        for (size_t i = 0; i < info.GetLineCount(); ++i) {
+            const wxString& line = info[i];
+            int separator = line.Find(wxT(": "));
+            if (separator != wxNOT_FOUND) {
+                SetInfo(line.Left(separator), line.Mid(separator + 2));
+            }
+        }
+    }
+
+    // 录音文件（跳过转码时的临时文件）
+    wxDir dir(m_sessionPath);
+    wxString fileName;
+    if (dir.IsOpened()) {
+        for (bool more = dir.GetFirst(&fileName, wxT("audio_*"), wxDIR_FILES); more; more = dir.GetNext(&fileName)) {
+            if (!fileName.EndsWith(wxT(".temp.wav"))) {
+                AddAudioSegment(wxFileName(m_sessionPath, fileName).GetFullPath());
+            }
+        }
+    }
+
+    // 标记放在最后：导入中途退出时下次重新导入，以上写入都可以重复执行
+    SetInfo(wxT("imported"), wxDateTime::Now().FormatISOCombined(' '));
+    m_needsImport = false;
+}
+
+bool SessionStore::ReadMessages(const wxString& sessionPath, std::vector<TranscriptionMessage>& messages) {
+#ifdef MEETANT_HAVE_SQLITE3
+    if (!Exists(sessionPath)) {
+        return false;
+    }
+    ReadConnection connection(GetDatabasePath(sessionPath));
+    if (!connection.Get()) {
+        return false;
+    }
+    Statement query(connection.Get(),
+                    "SELECT m.timestamp, s.id, s.name, m.content FROM messages m"
+                    " JOIN speakers s ON s.id = m.speaker ORDER BY m.seq");
+    if (!query.IsValid()) {
+        return false;
+    }
+    while (query.Step()) {
+        TranscriptionMessage msg;
+        msg.timestamp = wxDateTime(wxLongLong(query.GetInt(0)));
+        msg.speakerId = static_cast<int>(query.GetInt(1));
+        msg.speakerName = query.GetString(2);
+        msg.content = query.GetString(3);
+        messages.push_back(msg);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SessionStore::ReadAnnotations(const wxString& sessionPath, std::vector<std::unique_ptr<Annotation>>& annotations) {
+#ifdef MEETANT_HAVE_SQLITE3
+    if (!Exists(sessionPath)) {
+        return false;
+    }
+    ReadConnection connection(GetDatabasePath(sessionPath));
+    if (!connection.Get()) {
+        return false;
+    }
+    Statement query(connection.Get(), "SELECT data FROM annotations ORDER BY timestamp, id");
+    if (!query.IsValid()) {
+        return false;
+    }
+    while (query.Step()) {
+        size_t size;
+        const char* data = query.GetBlob(0, &size);
+        std::unique_ptr<Annotation> annotation = Annotation::Decode(data, size);
+        if (annotation) {
+            annotations.push_back(std::move(annotation));
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SessionStore::ReadAudioSegments(const wxString& sessionPath, std::vector<AudioSegment>& segments) {
+#ifdef MEETANT_HAVE_SQLITE3
+    if (!Exists(sessionPath)) {
+        return false;
+    }
+    ReadConnection connection(GetDatabasePath(sessionPath));
+    if (!connection.Get()) {
+        return false;
+    }
+    Statement query(connection.Get(),
+                    "SELECT file, start_time, duration_ms, sample_rate, channels, bits_per_sample, bytes"
+                    " FROM audio_segments ORDER BY start_time, file");
+    if (!query.IsValid()) {
+        return false;
+    }
+    while (query.Step()) {
+        AudioSegment segment;
+        segment.fileName = query.GetString(0);
+        if (!query.IsNull(1)) {
+            segment.startTime = wxDateTime(wxLongLong(query.GetInt(1)));
+        }
+        segment.durationMs = query.GetInt(2);
+        segment.sampleRate = static_cast<int>(query.GetInt(3));
+        segment.channels = static_cast<int>(query.GetInt(4));
+        segment.bitsPerSample = static_cast<int>(query.GetInt(5));
+        segment.bytes = query.GetInt(6);
+        segments.push_back(segment);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SessionStore::ProbeAudioFile(const wxString& filePath, AudioSegment& segment) {
+    wxFile file;
+    if (!wxFileName::FileExists(filePath) || !file.Open(filePath)) {
+        return false;
+    }
+    wxFileName name(filePath);
+    segment.fileName = name.GetFullName();
+    segment.bytes = static_cast<int64_t>(file.Length());
+
+    // 录音文件名中记有开始时间：audio_YYYYMMDD_HHMMSS.ext
+    wxString stamp;
+    wxString::const_iterator end;
+    if (name.GetName().StartsWith(wxT("audio_"), &stamp) &&
+        !segment.startTime.ParseFormat(stamp, wxT("%Y%m%d_%H%M%S"), &end)) {
+        segment.startTime = wxDateTime();
+    }
+
+    // FLAC（归档时由 WAV 转码）：第一个元数据块 STREAMINFO 的第 10 字节起依次为
+    // 20 位采样率、3 位声道数减一、5 位位深度减一、36 位总采样数
+    if (name.GetExt().Lower() == wxT("flac")) {
+        char info[8 + 34];
+        if (file.Read(info, sizeof(info)) == static_cast<ssize_t>(sizeof(info)) &&
+            std::memcmp(info, "fLaC", 4) == 0 && (info[4] & 0x7f) == 0) {
+            uint64_t bits = 0;
+            for (size_t i = 8 + 10; i < sizeof(info); ++i) {
+                bits = (bits << 8) | static_cast<unsigned char>(info[i]);
+            }
+            segment.sampleRate = static_cast<int>(bits >> 44);
+            segment.channels = static_cast<int>((bits >> 41) & 0x7) + 1;
+            segment.bitsPerSample = static_cast<int>((bits >> 36) & 0x1f) + 1;
+            int64_t totalSamples = static_cast<int64_t>(bits & 0xFFFFFFFFFULL);
+            if (segment.sampleRate > 0 && totalSamples > 0) {
+                segment.durationMs = totalSamples * 1000 / segment.sampleRate;
+            }
+        }
+        return true;
+    }
+    if (name.GetExt().Lower() != wxT("wav")) {
+        return true;
+    }
+
+    // 依次查找 fmt 和 data 块；录音中途退出时文件头中的数据大小还没有更新，按文件大小计算
+    std::string header(kWavProbeBytes, '\0');
+    ssize_t read = file.Read(&header[0], header.size());
+    if (read < 12 || header.compare(0, 4, "RIFF") != 0 || header.compare(8, 4, "WAVE") != 0) {
+        return true;
+    }
+    header.resize(static_cast<size_t>(read));
+    int blockBytes = 0;
+    for (size_t offset = 12; offset + 8 <= header.size(); ) {
+        uint32_t chunkSize = ReadU32(&header[offset + 4]);
+        if (header.compare(offset, 4, "fmt ") == 0 && offset + 8 + 16 <= header.size()) {
+            segment.channels = ReadU16(&header[offset + 10]);
+            segment.sampleRate = static_cast<int>(ReadU32(&header[offset + 12]));
+            segment.bitsPerSample = ReadU16(&header[offset + 22]);
+            blockBytes = segment.channels * segment.bitsPerSample / 8;
+        } else if (header.compare(offset, 4, "data") == 0) {
+            int64_t available = segment.bytes - static_cast<int64_t>(offset + 8);
+            int64_t dataBytes = chunkSize > 0 && chunkSize <= available ? chunkSize : available;
+            if (blockBytes > 0 && segment.sampleRate > 0) {
+                segment.durationMs = dataBytes / blockBytes * 1000 / segment.sampleRate;
+            }
+            break;
+        }
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+    return true;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,112 @@
+#ifndef MEETANT_SESSION_STORE_H
+#define MEETANT_SESSION_STORE_H
+
+#include <wx/wx.h>
+#include <wx/datetime.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Annotation.h"
+#include "GroupCommitWriter.h"
+#include "TranscriptionBubbleCtrl.h"
+
+namespace MeetAnt {
+
+// 单文件的会话数据库 session.db（SQLite，WAL 模式）
+// 消息、发言人、批注和录音文件的元数据各占一张表，消息按时间和发言人建有索引。
+// 写入只通过一个 SessionStore 对象：所有写入在它的后台线程中按提交顺序执行，
+// kGroupCommitMs 内提交的写入合并为一个事务。读取用各自的只读连接（静态 Read* 方法），
+// 界面、搜索线程和导出可以在录音写入的同时读取，读到的是最近一次提交的内容。
+// 编译时未启用 SQLite（MEETANT_HAVE_SQLITE3）时 IsSupported 返回 false，
+// 会话仍然使用目录中的各个文件。
+class SessionStore {
+public:
+    // 会话目录中一个录音文件的元数据
+    struct AudioSegment {
+        wxString fileName;      // 会话目录中的文件名
+        wxDateTime startTime;   // 取自文件名（audio_YYYYMMDD_HHMMSS），无法解析时无效
+        int64_t durationMs;     // 无法确定时为 -1
+        int sampleRate;         // 以下三项只有 WAV 和 FLAC 文件有，其他格式为 0
+        int channels;
+        int bitsPerSample;
+        int64_t bytes;          // 文件大小
+
+        AudioSegment() : durationMs(-1), sampleRate(0), channels(0), bitsPerSample(0), bytes(0) {}
+    };
+
+    // 打开或创建会话目录中的数据库
+    explicit SessionStore(const wxString& sessionPath);
+    // 提交已排队的写入后关闭数据库
+    ~SessionStore();
+
+    // 是否编译了 SQLite 支持
+    static bool IsSupported();
+
+    bool IsOpen() const { return m_database != nullptr; }
+    const wxString& GetSessionPath() const { return m_sessionPath; }
+
+    // 数据库是新建的，还没有导入会话目录中的文件
+    bool NeedsImport() const { return m_needsImport; }
+    // 数据库中批注的 id 不是 AnnotationManager 的编号（旧版本写入的），需要用 ReplaceAnnotations 重写一次
+    bool NeedsAnnotationImport() const { return m_needsAnnotationImport; }
+
+    // 数据库中的消息数（包括已提交、尚未写入的）
+    size_t GetMessageCount() const { return m_messageCount; }
+
+    // 以下写入立即返回，在后台线程中执行
+    void AppendMessages(const std::vector<TranscriptionMessage>& messages);
+    void ReplaceMessages(const std::vector<TranscriptionMessage>& messages);
+    void ReplaceAnnotations(const std::vector<Annotation*>& annotations);
+    // 按 AnnotationManager 的日志记录（见 AnnotationManager::ChangeListener）逐条添加、修改或删除批注
+    void ApplyAnnotationChanges(const std::vector<std::string>& records);
+    void AddAudioSegment(const wxString& filePath);
+    void SetInfo(const wxString& key, const wxString& value);
+
+    // 等已提交的写入完成并提交事务后返回；打开以来的写入全部成功时返回 true
+    // 数据库没有打开时没有写入任何内容，返回 true
+    bool Flush();
+
+    // 导入会话目录中现有的文件：转录（日志或文本）、session.info 和录音文件
+    // 批注由调用者用 ReplaceAnnotations 写入
+    void ImportFolder();
+
+    static wxString GetDatabasePath(const wxString& sessionPath);
+    // 支持 SQLite 且会话目录中有数据库
+    static bool Exists(const wxString& sessionPath);
+
+    // 只读连接上的查询，可在任意线程中调用；数据库不存在或无法读取时返回 false
+    static bool ReadMessages(const wxString& sessionPath, std::vector<TranscriptionMessage>& messages);
+    static bool ReadAnnotations(const wxString& sessionPath, std::vector<std::unique_ptr<Annotation>>& annotations);
+    static bool ReadAudioSegments(const wxString& sessionPath, std::vector<AudioSegment>& segments);
+
+    // 读取录音文件的大小，WAV 文件另外读取格式和时长
+    static bool ProbeAudioFile(const wxString& filePath, AudioSegment& segment);
+
+    // 同一批写入最多等待这么久（毫秒）再提交事务
+    static const long kGroupCommitMs = 200;
+
+private:
+    struct Database;
+
+    void Post(const GroupCommitWriter::Task& task);
+
+    // 以下方法只在写入线程中调用
+    void BeginBatch();
+    void CommitBatch();
+
+    wxString m_sessionPath;
+    std::unique_ptr<Database> m_database;    // 打开后只在写入线程中使用
+    size_t m_messageCount;
+    bool m_needsImport;
+    bool m_needsAnnotationImport;
+    bool m_failed;                              // 写入线程中有语句或提交失败
+    std::unique_ptr<GroupCommitWriter> m_writer;    // 数据库打开后才创建
+
+    SessionStore(const SessionStore&) = delete;
+    SessionStore& operator=(const SessionStore&) = delete;
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_SESSION_STORE_H
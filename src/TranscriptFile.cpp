@@ -0,0 +1,94 @@
+#include "TranscriptFile.h"
+#include "TranscriptLog.h"
+#include "SessionStore.h"
+#include "SessionArchive.h"
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/tokenzr.h>
+
+namespace MeetAnt {
+
+wxString GetTranscriptFilePath(const wxString& sessionPath) {
+    return wxFileName(sessionPath, wxT("transcript.txt")).GetFullPath();
+}
+
+std::vector<wxString> GetTranscriptSourcePaths(const wxString& sessionPath) {
+    std::vector<wxString> paths;
+    if (SessionStore::Exists(sessionPath)) {
+        // WAL 模式下新提交的内容先写入 -wal 文件，检查点之后才并入数据库文件
+        wxString databasePath = SessionStore::GetDatabasePath(sessionPath);
+        paths.push_back(databasePath);
+        if (wxFileName::FileExists(databasePath + wxT("-wal"))) {
+            paths.push_back(databasePath + wxT("-wal"));
+        }
+        return paths;
+    }
+    
+    wxString logPath = TranscriptLog::GetLogPath(sessionPath);
+    wxString textFilePath = GetTranscriptFilePath(sessionPath);
+    if (wxFileName::FileExists(logPath)) {
+        paths.push_back(logPath);
+    } else if (wxFileName::FileExists(textFilePath)) {
+        paths.push_back(textFilePath);
+    } else if (SessionArchive::Exists(sessionPath)) {
+        paths.push_back(SessionArchive::GetArchivePath(sessionPath));
+    }
+    return paths;
+}
+
+bool LoadTranscriptFile(const wxString& sessionPath, std::vector<TranscriptionMessage>& messages) {
+    if (SessionStore::ReadMessages(sessionPath, messages) || TranscriptLog::Read(sessionPath, messages)) {
+        return true;
+    }
+    return LoadTranscriptText(sessionPath, messages) || SessionArchive::ReadTranscript(sessionPath, messages);
+}
+
+bool LoadTranscriptText(const wxString& sessionPath, std::vector<TranscriptionMessage>& messages) {
+    wxString textFilePath = GetTranscriptFilePath(sessionPath);
+    if (!wxFileName::FileExists(textFilePath)) {
+        return false;
+    }
+    
+    wxFile textFile;
+    wxString textContent;
+    if (!textFile.Open(textFilePath, wxFile::read) || !textFile.ReadAll(&textContent, wxConvUTF8)) {
+        wxLogWarning(wxT("无法读取转录文件: %s"), textFilePath);
+        return false;
+    }
+    textFile.Close();
+    
+    // 转录文件只记录时分秒，日期取自转录文件的修改日期
+    wxDateTime baseDate = wxFileName(textFilePath).GetModificationTime();
+    if (!baseDate.IsValid()) {
+        baseDate = wxDateTime::Now();
+    }
+    baseDate.ResetTime();
+    
+    wxStringTokenizer lines(textContent, wxT("\n"), wxTOKEN_STRTOK);
+    while (lines.HasMoreTokens()) {
+        wxString line = lines.GetNextToken();
+        line.Trim();
+        if (line.length() < 11 || line[0] != wxT('[') || line[9] != wxT(']')) {
+            continue;
+        }
+        
+        int separator = line.find(wxT(": "), 11);
+        if (separator == wxNOT_FOUND) {
+            continue;
+        }
+        
+        TranscriptionMessage msg;
+        msg.timestamp = baseDate;
+        wxString::const_iterator end;
+        if (!msg.timestamp.ParseTime(line.Mid(1, 8), &end)) {
+            msg.timestamp = baseDate;
+        }
+        msg.speakerName = line.Mid(11, separator - 11);
+        msg.content = line.Mid(separator + 2);
+        messages.push_back(msg);
+    }
+    
+    return true;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,26 @@
+#ifndef MEETANT_TRANSCRIPT_FILE_H
+#define MEETANT_TRANSCRIPT_FILE_H
+
+#include <wx/wx.h>
+#include <vector>
+#include "TranscriptionBubbleCtrl.h"
+
+namespace MeetAnt {
+
+// 会话目录中转录文件的完整路径
+wxString GetTranscriptFilePath(const wxString& sessionPath);
+
+// 读取会话的转录：启用会话数据库时优先读取 session.db（见 SessionStore），其次是
+// 追加式日志 transcript.log（见 TranscriptLog），再次是旧会话的转录文本，最后是会话归档（见 SessionArchive）
+// 不依赖界面，可在工作线程中调用。都不存在或无法读取时返回 false
+bool LoadTranscriptFile(const wxString& sessionPath, std::vector<TranscriptionMessage>& messages);
+
+// 只解析转录文本，行格式: [HH:MM:SS] 发言人: 内容
+bool LoadTranscriptText(const wxString& sessionPath, std::vector<TranscriptionMessage>& messages);
+
+// 会话当前保存转录的文件：数据库（连同 WAL 文件）、日志、转录文本或归档，只列出存在的文件
+std::vector<wxString> GetTranscriptSourcePaths(const wxString& sessionPath);
+
+} // namespace MeetAnt
+
+#endif // MEETANT_TRANSCRIPT_FILE_H
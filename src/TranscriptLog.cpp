@@ -0,0 +1,232 @@
+#include "TranscriptLog.h"
+#include <wx/filename.h>
+#include <memory>
+
+namespace MeetAnt {
+
+namespace {
+    // 文件格式：RecordCodec 的记录文件，文件头中的值保留，写 0
+    // 记录内容：8 字节时间戳（毫秒）、4 字节发言人编号、发言人、内容
+    const char kLogMagic[4] = { 'M', 'A', 'T', 'L' };
+    const uint32_t kVersion = 1;
+
+    enum class HeaderState {
+        Valid,
+        Invalid,        // 不是转录日志或文件头不完整
+        Unsupported     // 更新版本的格式
+    };
+
+    HeaderState ReadHeader(const std::string& data) {
+        RecordFileHeader header;
+        if (!ReadRecordFileHeader(data, kLogMagic, header)) {
+            return HeaderState::Invalid;
+        }
+        return header.version == kVersion ? HeaderState::Valid : HeaderState::Unsupported;
+    }
+
+    // 追加一条带长度前缀的消息记录
+    void AppendMessage(std::string& out, const TranscriptionMessage& msg) {
+        size_t start = BeginRecord(out);
+        TranscriptLog::AppendMessageFields(out, msg);
+        EndRecord(out, start);
+    }
+}
+
+TranscriptLog::TranscriptLog(const wxString& sessionPath)
+    : m_sessionPath(sessionPath),
+      m_messageCount(0),
+      m_writable(true),
+      m_logCurrent(false),
+      m_logLength(0),
+      m_needsSync(false),
+      m_failed(false),
+      m_writer(kGroupCommitMs, GroupCommitWriter::Task(), [this]() { Sync(); })
+{
+    // 只统计记录数，不解码消息
+    std::string data;
+    wxString logPath = GetLogPath(m_sessionPath);
+    if (wxFileExists(logPath) && ReadFileBytes(logPath, data)) {
+        switch (ReadHeader(data)) {
+            case HeaderState::Valid:
+                m_logLength = static_cast<wxFileOffset>(ForEachRecord(data, [this](const char*, size_t) {
+                    m_messageCount++;
+                }));
+                m_logCurrent = true;
+                break;
+            case HeaderState::Unsupported:
+                wxLogWarning(wxT("不支持的转录日志版本: %s"), logPath);
+                m_writable = false;
+                break;
+            case HeaderState::Invalid:
+                break;
+        }
+    }
+}
+
+TranscriptLog::~TranscriptLog() {
+    m_writer.Stop();
+    m_log.Close();
+}
+
+wxString TranscriptLog::GetLogPath(const wxString& sessionPath) {
+    return wxFileName(sessionPath, wxT("transcript.log")).GetFullPath();
+}
+
+bool TranscriptLog::Read(const wxString& sessionPath, std::vector<TranscriptionMessage>& messages) {
+    wxString logPath = GetLogPath(sessionPath);
+    std::string data;
+    if (!wxFileExists(logPath) || !ReadFileBytes(logPath, data)) {
+        return false;
+    }
+    if (ReadHeader(data) == HeaderState::Unsupported) {
+        wxLogWarning(wxT("不支持的转录日志版本: %s"), logPath);
+    }
+    return Parse(data, messages);
+}
+
+void TranscriptLog::AppendMessageFields(std::string& out, const TranscriptionMessage& msg) {
+    AppendValue<int64_t>(out, msg.timestamp.IsValid() ? msg.timestamp.GetValue().GetValue() : 0);
+    AppendValue<int32_t>(out, msg.speakerId);
+    AppendString(out, msg.speakerName);
+    AppendString(out, msg.content);
+}
+
+bool TranscriptLog::ReadMessageFields(ByteReader& reader, TranscriptionMessage& msg) {
+    int64_t timestamp;
+    int32_t speakerId;
+    if (!reader.Read(timestamp) || !reader.Read(speakerId) ||
+        !reader.ReadString(msg.speakerName) || !reader.ReadString(msg.content)) {
+        return false;
+    }
+    msg.timestamp = wxDateTime(wxLongLong(timestamp));
+    msg.speakerId = speakerId;
+    return true;
+}
+
+std::string TranscriptLog::Encode(const std::vector<TranscriptionMessage>& messages) {
+    std::string data = MakeRecordFileHeader(kLogMagic, kVersion);
+    for (const auto& msg : messages) {
+        AppendMessage(data, msg);
+    }
+    return data;
+}
+
+bool TranscriptLog::Parse(const std::string& data, std::vector<TranscriptionMessage>& messages) {
+    if (ReadHeader(data) != HeaderState::Valid) {
+        return false;
+    }
+
+    // 最后一条记录可能只写了一半，读到最后一条完整记录为止
+    ForEachRecord(data, [&](const char* record, size_t size) {
+        ByteReader reader(record, size);
+        TranscriptionMessage msg;
+        if (ReadMessageFields(reader, msg)) {
+            messages.push_back(msg);
+        }
+    });
+    return true;
+}
+
+void TranscriptLog::Append(const std::vector<TranscriptionMessage>& messages) {
+    if (messages.empty()) {
+        return;
+    }
+    // 在调用线程中编码，写入线程只接触字节
+    auto data = std::make_shared<std::string>();
+    for (const auto& msg : messages) {
+        AppendMessage(*data, msg);
+    }
+    m_messageCount += messages.size();
+    m_writer.Post([this, data]() {
+        WriteRecords(*data);
+    });
+}
+
+void TranscriptLog::Rewrite(const std::vector<TranscriptionMessage>& messages) {
+    auto data = std::make_shared<std::string>(Encode(messages));
+    m_messageCount = messages.size();
+    m_writer.Post([this, data]() {
+        WriteLog(*data);
+    });
+}
+
+bool TranscriptLog::Flush() {
+    // 写入线程在 Flush 返回前已经结束，这里读取它的状态是安全的
+    m_writer.Flush();
+    return !m_failed;
+}
+
+bool TranscriptLog::OpenLog() {
+    if (m_log.IsOpened()) {
+        return true;
+    }
+
+    wxString logPath = GetLogPath(m_sessionPath);
+    if (m_logCurrent) {
+        // 上次退出时最后一条记录只写了一半：去掉它再继续追加
+        if (!TrimRecordFile(logPath, m_logLength)) {
+            m_logCurrent = false;
+        }
+        if (m_logCurrent && m_log.Open(logPath, wxFile::write_append)) {
+            return true;
+        }
+    }
+
+    // 日志不存在或已损坏：重新开始
+    if (!m_log.Create(logPath, true) ||
+        !WriteFileBytes(m_log, MakeRecordFileHeader(kLogMagic, kVersion))) {
+        wxLogWarning(wxT("无法创建转录日志: %s"), logPath);
+        m_log.Close();
+        m_failed = true;
+        return false;
+    }
+    m_logCurrent = true;
+    m_needsSync = true;
+    return true;
+}
+
+void TranscriptLog::WriteRecords(const std::string& data) {
+    if (!m_writable || !OpenLog()) {
+        m_failed = true;
+        return;
+    }
+    if (!WriteFileBytes(m_log, data)) {
+        wxLogWarning(wxT("写入转录日志失败: %s"), GetLogPath(m_sessionPath));
+        m_failed = true;
+    }
+    m_needsSync = true;
+}
+
+void TranscriptLog::WriteLog(const std::string& data) {
+    if (!m_writable) {
+        m_failed = true;
+        return;
+    }
+
+    // 先写临时文件并落盘再替换，任何时刻磁盘上都有一份完整的日志
+    wxString logPath = GetLogPath(m_sessionPath);
+    wxString tempPath = logPath + wxT(".tmp");
+    m_log.Close();
+    wxFile file;
+    bool written = file.Create(tempPath, true) && WriteFileBytes(file, data) && file.Flush();
+    file.Close();
+    if (!written || !wxRenameFile(tempPath, logPath, true)) {
+        wxLogWarning(wxT("重写转录日志失败: %s"), logPath);
+        wxRemoveFile(tempPath);
+        m_failed = true;
+        return;     // 原来的日志仍然完整，之后的追加接在它后面
+    }
+    m_logCurrent = true;
+    m_logLength = static_cast<wxFileOffset>(data.size());
+    OpenLog();
+}
+
+void TranscriptLog::Sync() {
+    if (m_needsSync && m_log.IsOpened() && !m_log.Flush()) {
+        wxLogWarning(wxT("转录日志落盘失败: %s"), GetLogPath(m_sessionPath));
+        m_failed = true;
+    }
+    m_needsSync = false;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,82 @@
+#ifndef MEETANT_TRANSCRIPT_LOG_H
+#define MEETANT_TRANSCRIPT_LOG_H
+
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <string>
+#include <vector>
+#include "GroupCommitWriter.h"
+#include "RecordCodec.h"
+#include "TranscriptionBubbleCtrl.h"
+
+namespace MeetAnt {
+
+// 会话转录的追加式日志 transcript.log
+// 每条定稿的消息是一条记录：完整的时间戳（毫秒）、发言人编号、发言人和内容。
+// 文件是带版本号的二进制格式：16 字节文件头之后是一串以 4 字节长度开头的记录。
+// 录音过程中每条消息只追加一次，不再整体重写转录文件；文本和 JSON 只在导出时生成。
+// 所有文件写入都在一个后台线程（GroupCommitWriter）中按提交顺序执行，kGroupCommitMs 内的追加只做一次 fsync。
+class TranscriptLog {
+public:
+    // 打开会话目录中的日志并统计已有的完整记录数
+    explicit TranscriptLog(const wxString& sessionPath);
+    // 写完已提交的记录并 fsync 后停止写入线程
+    ~TranscriptLog();
+
+    const wxString& GetSessionPath() const { return m_sessionPath; }
+
+    // 日志中的消息数（包括已提交、尚未写入的）
+    size_t GetMessageCount() const { return m_messageCount; }
+
+    // 追加消息，立即返回
+    void Append(const std::vector<TranscriptionMessage>& messages);
+
+    // 用 messages 替换整个日志
+    void Rewrite(const std::vector<TranscriptionMessage>& messages);
+
+    // 等已提交的写入完成并落盘后返回；打开日志以来的写入全部成功时返回 true
+    bool Flush();
+
+    static wxString GetLogPath(const wxString& sessionPath);
+
+    // 读取日志中的全部消息，不依赖界面，可在工作线程中调用
+    // 日志不存在、无法读取或是不支持的版本时返回 false
+    static bool Read(const wxString& sessionPath, std::vector<TranscriptionMessage>& messages);
+
+    // 在内存中编码和解析完整的日志（文件头加全部记录），用于会话归档
+    static std::string Encode(const std::vector<TranscriptionMessage>& messages);
+    static bool Parse(const std::string& data, std::vector<TranscriptionMessage>& messages);
+
+    // 一条消息记录的内容（不含长度前缀）：8 字节时间戳（毫秒）、4 字节发言人编号、发言人、内容
+    // 恢复日志的消息记录也用这个编码
+    static void AppendMessageFields(std::string& out, const TranscriptionMessage& msg);
+    static bool ReadMessageFields(ByteReader& reader, TranscriptionMessage& msg);
+
+    // 同一批追加最多等待这么久（毫秒）再 fsync
+    static const long kGroupCommitMs = 200;
+
+private:
+    // 以下方法只在写入线程中调用
+    bool OpenLog();
+    void WriteRecords(const std::string& data);
+    void WriteLog(const std::string& data);
+    void Sync();
+
+    wxString m_sessionPath;
+    size_t m_messageCount;
+
+    // 写入线程独占的状态（构造时确定初值）
+    wxFile m_log;
+    bool m_writable;                // 文件是更新版本的格式时不写入，避免覆盖
+    bool m_logCurrent;              // 日志文件存在且文件头有效
+    wxFileOffset m_logLength;       // 日志中完整记录的字节数，之后是写了一半的记录
+    bool m_needsSync;
+    bool m_failed;                  // 有写入失败或因版本不符没有写入
+
+    // 最后构造：写入线程启动时其他成员都已初始化
+    GroupCommitWriter m_writer;
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_TRANSCRIPT_LOG_H
@@ -0,0 +1,146 @@
+#include "TranscriptPageFile.h"
+#include <wx/filename.h>
+#include <cstring>
+
+namespace MeetAnt {
+
+namespace {
+    // 临时文件名前缀，文件建在系统临时目录中
+    const wxChar* const kTempPrefix = wxT("MeetAntPages");
+}
+
+TranscriptPageFile::TranscriptPageFile()
+    : m_length(0),
+      m_failed(false) {
+}
+
+TranscriptPageFile::~TranscriptPageFile() {
+    Clear();
+}
+
+void TranscriptPageFile::Clear() {
+    wxCriticalSectionLocker lock(m_critSect);
+    m_pages.clear();
+    m_length = 0;
+    m_failed = false;
+    m_mapping.Close();
+    if (m_file.IsOpened()) {
+        m_file.Close();
+    }
+    if (!m_path.IsEmpty()) {
+        wxRemoveFile(m_path);
+        m_path.clear();
+    }
+}
+
+bool TranscriptPageFile::HasPage(size_t page) const {
+    wxCriticalSectionLocker lock(m_critSect);
+    return page < m_pages.size() && m_pages[page].offset >= 0;
+}
+
+bool TranscriptPageFile::OpenFile() {
+    if (m_file.IsOpened()) {
+        return true;
+    }
+    if (m_failed) {
+        return false;
+    }
+
+    // CreateTempFileName 打开的文件只能写，建好后重新以读写方式打开
+    m_path = wxFileName::CreateTempFileName(kTempPrefix);
+    if (m_path.IsEmpty() || !m_file.Open(m_path, wxFile::read_write)) {
+        wxLogWarning(wxT("无法创建转录分页文件: %s"), m_path);
+        m_failed = true;
+        if (!m_path.IsEmpty()) {
+            wxRemoveFile(m_path);
+            m_path.clear();
+        }
+        return false;
+    }
+    m_length = 0;
+    return true;
+}
+
+bool TranscriptPageFile::WritePage(size_t page, const std::vector<wxString>& contents) {
+    // 在锁外编码，写入时才持锁
+    std::string data;
+    for (const wxString& content : contents) {
+        uint32_t length = static_cast<uint32_t>(content.length());
+        data.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        data.append(reinterpret_cast<const char*>(content.wc_str()), length * sizeof(wchar_t));
+    }
+
+    wxCriticalSectionLocker lock(m_critSect);
+    if (page < m_pages.size() && m_pages[page].offset >= 0) {
+        return true;
+    }
+    if (!OpenFile()) {
+        return false;
+    }
+    if (m_file.Seek(m_length) == wxInvalidOffset ||
+        m_file.Write(data.data(), data.size()) != data.size()) {
+        wxLogWarning(wxT("写入转录分页文件失败: %s"), m_path);
+        return false;
+    }
+
+    // 数据写完后才登记，其他线程看到的页总是完整的
+    if (page >= m_pages.size()) {
+        m_pages.resize(page + 1);
+    }
+    m_pages[page].offset = m_length;
+    m_pages[page].size = static_cast<uint32_t>(data.size());
+    m_pages[page].count = static_cast<uint32_t>(contents.size());
+    m_length += static_cast<wxFileOffset>(data.size());
+    return true;
+}
+
+bool TranscriptPageFile::MapPage(const PageEntry& entry) const {
+    uint64_t end = static_cast<uint64_t>(entry.offset) + entry.size;
+    if (m_mapping.IsOpen() && end <= m_mapping.GetSize()) {
+        return true;
+    }
+    // 映射之后又追加了页，重新映射到当前长度
+    return m_mapping.Open(m_path) && end <= m_mapping.GetSize();
+}
+
+bool TranscriptPageFile::ReadPage(size_t page, std::vector<std::wstring>& contents) const {
+    wxCriticalSectionLocker lock(m_critSect);
+    if (page >= m_pages.size() || m_pages[page].offset < 0) {
+        return false;
+    }
+    const PageEntry& entry = m_pages[page];
+    contents.clear();
+    if (entry.count == 0) {
+        return true;
+    }
+    if (!MapPage(entry)) {
+        wxLogWarning(wxT("读取转录分页文件失败: %s"), m_path);
+        return false;
+    }
+
+    // 直接从映射区解码到结果中，不另外复制整页
+    const char* data = m_mapping.GetData() + entry.offset;
+    size_t size = entry.size;
+    contents.reserve(entry.count);
+    size_t pos = 0;
+    for (uint32_t i = 0; i < entry.count; ++i) {
+        uint32_t length = 0;
+        if (size - pos < sizeof(length)) {
+            return false;
+        }
+        std::memcpy(&length, data + pos, sizeof(length));
+        pos += sizeof(length);
+        if ((size - pos) / sizeof(wchar_t) < length) {
+            return false;
+        }
+        std::wstring text(length, L'\0');
+        if (length > 0) {
+            std::memcpy(&text[0], data + pos, length * sizeof(wchar_t));
+        }
+        pos += length * sizeof(wchar_t);
+        contents.push_back(std::move(text));
+    }
+    return true;
+}
+
+} // namespace MeetAnt
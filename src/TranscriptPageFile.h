@@ -0,0 +1,64 @@
+#ifndef MEETANT_TRANSCRIPT_PAGE_FILE_H
+#define MEETANT_TRANSCRIPT_PAGE_FILE_H
+
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <wx/thread.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FileMapping.h"
+
+namespace MeetAnt {
+
+// 转录分页文件
+// 转录控件把暂时不显示的消息文本按页（连续的若干条消息）写入一个临时文件，需要时整页读回。
+// 消息只会追加或整体替换，页写入后不再改变，同一页只写一次；整体替换时调用 Clear。
+// 文件只在本进程内使用，文本按本机 wchar_t 原样存放：每条为 4 字节字符数加字符。
+// 写入用 wxFile 追加，读取在文件的只读映射上直接解码，页不在映射范围内时重新映射整个文件。
+// 读写都持有内部锁，后台线程可以同时读取；临时文件在第一次写入时创建，对象销毁时删除。
+class TranscriptPageFile {
+public:
+    TranscriptPageFile();
+    ~TranscriptPageFile();
+
+    // 丢弃所有页并删除临时文件
+    void Clear();
+
+    // 该页是否已写入
+    bool HasPage(size_t page) const;
+
+    // 写入一页消息文本，页已存在时直接返回 true
+    bool WritePage(size_t page, const std::vector<wxString>& contents);
+
+    // 读取一页，页不存在或读取失败时返回 false；可在工作线程中调用
+    bool ReadPage(size_t page, std::vector<std::wstring>& contents) const;
+
+private:
+    struct PageEntry {
+        wxFileOffset offset;        // 在文件中的位置，-1 表示尚未写入
+        uint32_t size;              // 字节数
+        uint32_t count;             // 消息数
+
+        PageEntry() : offset(-1), size(0), count(0) {}
+    };
+
+    bool OpenFile();
+    // 确保页所在的范围已映射，调用者持有 m_critSect
+    bool MapPage(const PageEntry& entry) const;
+
+    mutable wxCriticalSection m_critSect;
+    wxFile m_file;
+    mutable FileMapping m_mapping;  // 文件已写入部分的只读映射，只在读取时建立
+    wxString m_path;
+    wxFileOffset m_length;          // 已写入的字节数
+    bool m_failed;                  // 无法创建临时文件后不再重试，直到 Clear
+    std::vector<PageEntry> m_pages;
+
+    TranscriptPageFile(const TranscriptPageFile&) = delete;
+    TranscriptPageFile& operator=(const TranscriptPageFile&) = delete;
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_TRANSCRIPT_PAGE_FILE_H
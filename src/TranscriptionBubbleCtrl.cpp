@@ -1,12 +1,416 @@
 #include "TranscriptionBubbleCtrl.h"
+#include "Pinyin.h"
 #include <wx/dcbuffer.h>
 #include <wx/graphics.h>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <iterator>
+#include <limits>
 
 // 定义事件
 wxDEFINE_EVENT(wxEVT_TRANSCRIPTION_MESSAGE_CLICKED, wxCommandEvent);
 wxDEFINE_EVENT(wxEVT_TRANSCRIPTION_MESSAGE_RIGHT_CLICKED, wxCommandEvent);
+wxDEFINE_EVENT(wxEVT_TRANSCRIPTION_SEARCH_UPDATED, wxCommandEvent);
+wxDEFINE_EVENT(wxEVT_TRANSCRIPTION_LOADED, wxCommandEvent);
+
+// 后台读取线程读完消息的内部事件
+wxDEFINE_EVENT(wxEVT_TRANSCRIPTION_LOAD_DONE, wxThreadEvent);
+
+// 后台布局线程发回结果的内部事件
+wxDEFINE_EVENT(wxEVT_TRANSCRIPTION_LAYOUT_CHUNK, wxThreadEvent);
+
+// 后台搜索线程发回结果的内部事件
+wxDEFINE_EVENT(wxEVT_TRANSCRIPTION_SEARCH_CHUNK, wxThreadEvent);
+
+namespace {
+
+// 不超过此数量的消息直接在UI线程中布局
+const size_t kSyncLayoutLimit = 200;
+
+// 后台布局线程每批处理的消息数
+const size_t kLayoutChunkSize = 256;
+
+// 气泡左侧留给发言人和时间的宽度
+const int kLeftMargin = 150;
+
+// 气泡最小高度
+const int kMinBubbleHeight = 40;
+
+// 平滑滚动的帧间隔（毫秒）
+const int kSmoothScrollInterval = 15;
+
+// 距底部不超过此像素数时视为位于底部
+const int kFollowTailSlack = 4;
+
+// 后台搜索线程每批校验的候选消息数（每批持锁一次）
+const size_t kSearchChunkSize = 256;
+
+// 消息文本按页换入换出：每页的消息数，以及文本常驻内存的最多页数
+const size_t kPageMessages = 256;
+const size_t kResidentPages = 8;
+
+// 内联批注按可视消息前后各多出这么多条消息的时间段查询
+const size_t kAnnotationWindowMargin = 256;
+
+// 尚未读取任何页
+const size_t kNoPage = std::numeric_limits<size_t>::max();
+
+// 后台布局线程产出的一批测量结果
+struct LayoutChunk {
+    int generation;                           // 对应的布局代数
+    size_t firstIndex;                        // 本批第一条消息的索引
+    std::vector<int> heights;                 // 气泡高度
+    std::vector<std::vector<int>> lineStarts; // 每条消息的换行偏移
+    std::vector<bool> estimated;              // 是否使用了估算字宽
+    bool isLast;                              // 是否为最后一批
+};
+
+// 后台搜索线程产出的一批命中
+struct SearchChunk {
+    int generation;                           // 对应的搜索代数
+    std::vector<int> messageIds;              // 命中的消息ID，按位置排序
+    TranscriptionSearchFacets facets;         // 本批命中的分面统计
+    bool isLast;                              // 是否为最后一批
+};
+
+} // namespace
+
+TranscriptionSearchFacets::TranscriptionSearchFacets() {
+    Clear();
+}
+
+void TranscriptionSearchFacets::Clear() {
+    speakerHits.clear();
+    timeBucketHits.clear();
+    std::fill(std::begin(annotationHits), std::end(annotationHits), 0);
+    unannotatedHits = 0;
+    hitOffsets.clear();
+}
+
+void TranscriptionSearchFacets::Merge(const TranscriptionSearchFacets& other) {
+    if (speakerHits.size() < other.speakerHits.size()) {
+        speakerHits.resize(other.speakerHits.size(), 0);
+    }
+    for (size_t i = 0; i < other.speakerHits.size(); ++i) {
+        speakerHits[i] += other.speakerHits[i];
+    }
+    if (timeBucketHits.size() < other.timeBucketHits.size()) {
+        timeBucketHits.resize(other.timeBucketHits.size(), 0);
+    }
+    for (size_t i = 0; i < other.timeBucketHits.size(); ++i) {
+        timeBucketHits[i] += other.timeBucketHits[i];
+    }
+    for (size_t type = 0; type < MeetAnt::kAnnotationTypeCount; ++type) {
+        annotationHits[type] += other.annotationHits[type];
+    }
+    unannotatedHits += other.unannotatedHits;
+    hitOffsets.insert(hitOffsets.end(), other.hitOffsets.begin(), other.hitOffsets.end());
+}
+
+// 后台读取线程：运行读取函数，读完后通知控件；控件在UI线程中等线程结束后取走消息
+class TranscriptionBubbleCtrl::LoadWorker : public wxThread {
+public:
+    LoadWorker(TranscriptionBubbleCtrl* owner, int generation, const MessageLoader& loader)
+        : wxThread(wxTHREAD_JOINABLE),
+          m_owner(owner),
+          m_generation(generation),
+          m_loader(loader),
+          m_loaded(false) {
+    }
+    
+    // 以下方法在线程结束后调用
+    bool IsLoaded() const { return m_loaded; }
+    std::vector<TranscriptionMessage>& GetMessages() { return m_messages; }
+    
+protected:
+    ExitCode Entry() override {
+        m_loaded = m_loader(m_messages);
+        
+        wxThreadEvent* event = new wxThreadEvent(wxEVT_TRANSCRIPTION_LOAD_DONE);
+        event->SetInt(m_generation);
+        wxQueueEvent(m_owner, event);
+        return (ExitCode)0;
+    }
+    
+private:
+    TranscriptionBubbleCtrl* m_owner;
+    int m_generation;
+    MessageLoader m_loader;
+    bool m_loaded;
+    std::vector<TranscriptionMessage> m_messages;
+};
+
+// 后台布局线程：只读取字体度量缓存，消息文本逐页读取（见 ReadPageText），按批次把结果投递回UI线程
+class TranscriptionBubbleCtrl::LayoutWorker : public wxThread {
+public:
+    LayoutWorker(TranscriptionBubbleCtrl* owner, int generation, int textWidth,
+                 int lineHeight, int padding,
+                 std::vector<std::pair<size_t, size_t>> ranges)
+        : wxThread(wxTHREAD_JOINABLE),
+          m_owner(owner),
+          m_generation(generation),
+          m_textWidth(textWidth),
+          m_lineHeight(lineHeight),
+          m_padding(padding),
+          m_ranges(std::move(ranges)),
+          m_stopRequested(false) {
+    }
+    
+    void RequestStop() { m_stopRequested = true; }
+    
+protected:
+    ExitCode Entry() override {
+        std::vector<std::wstring> page;
+        size_t loadedPage = kNoPage;
+        for (size_t r = 0; r < m_ranges.size(); ++r) {
+            size_t rangeBegin = m_ranges[r].first;
+            size_t rangeEnd = m_ranges[r].second;
+            
+            for (size_t chunkBegin = rangeBegin; chunkBegin < rangeEnd; chunkBegin += kLayoutChunkSize) {
+                if (m_stopRequested || TestDestroy()) {
+                    return (ExitCode)0;
+                }
+                
+                size_t chunkEnd = std::min(rangeEnd, chunkBegin + kLayoutChunkSize);
+                auto chunk = std::make_shared<LayoutChunk>();
+                chunk->generation = m_generation;
+                chunk->firstIndex = chunkBegin;
+                chunk->isLast = (r + 1 == m_ranges.size() && chunkEnd == rangeEnd);
+                chunk->heights.reserve(chunkEnd - chunkBegin);
+                chunk->lineStarts.reserve(chunkEnd - chunkBegin);
+                chunk->estimated.reserve(chunkEnd - chunkBegin);
+                
+                for (size_t i = chunkBegin; i < chunkEnd; ++i) {
+                    const std::wstring& text = m_owner->ReadMessageText(i, page, loadedPage);
+                    bool estimated = false;
+                    std::vector<int> lines = m_owner->m_metricsCache.WrapText(
+                        text.c_str(), text.length(), m_textWidth, nullptr, &estimated);
+                    
+                    int height = static_cast<int>(lines.size()) * m_lineHeight + m_padding * 2;
+                    chunk->heights.push_back(std::max(height, kMinBubbleHeight));
+                    chunk->lineStarts.push_back(std::move(lines));
+                    chunk->estimated.push_back(estimated);
+                }
+                
+                wxThreadEvent* event = new wxThreadEvent(wxEVT_TRANSCRIPTION_LAYOUT_CHUNK);
+                event->SetPayload(chunk);
+                wxQueueEvent(m_owner, event);
+            }
+        }
+        
+        return (ExitCode)0;
+    }
+    
+private:
+    TranscriptionBubbleCtrl* m_owner;
+    int m_generation;
+    int m_textWidth;
+    int m_lineHeight;
+    int m_padding;
+    std::vector<std::pair<size_t, size_t>> m_ranges;   // 需要测量的索引区间，按顺序处理
+    std::atomic<bool> m_stopRequested;
+};
+
+// 编译好的会话内查询：后台搜索线程和常驻查询共用同一份，编译后只读，可在多个线程中同时匹配
+class TranscriptionBubbleCtrl::CompiledQuery {
+public:
+    CompiledQuery(const wxString& searchText, bool caseSensitive, int speakerId)
+        : m_searchText(searchText.ToStdWstring()),
+          m_caseSensitive(caseSensitive),
+          m_speakerId(speakerId),
+          m_phrase(false) {
+    }
+    
+    // 按搜索方式编译；查询不可能有结果时返回 false，正则无效时同时给出错误信息
+    bool Compile(TranscriptionSearchMode mode, wxString* error) {
+        if (mode == TranscriptionSearchMode::Regex) {
+            m_regex.reset(new MeetAnt::RegexQuery());
+            if (!m_regex->Compile(m_searchText, m_caseSensitive)) {
+                *error = wxString(m_regex->GetError());
+                return false;
+            }
+            return true;
+        }
+        if (mode == TranscriptionSearchMode::Fuzzy) {
+            // 同音字在拼音键上完全相同，近音字在允许的编辑距离内
+            m_fuzzy.reset(new MeetAnt::FuzzyQuery());
+            return m_fuzzy->Compile(m_searchText);
+        }
+        if (!MeetAnt::SearchIndex::PrepareQuery(m_searchText, &m_normalized, &m_phrase)) {
+            return false;
+        }
+        if (m_phrase) {
+            m_segments = MeetAnt::SearchIndex::SplitPhrase(m_normalized);
+            return !m_segments.empty();
+        }
+        return true;
+    }
+    
+    // 用索引筛选前 documentLimit 条消息中的候选，按文档序号排序
+    std::vector<uint32_t> FindCandidates(const MeetAnt::SearchIndex& index, size_t documentLimit) const {
+        std::vector<uint32_t> candidates;
+        if (m_fuzzy) {
+            // 拼音双字母的位图筛选出可能的近似匹配，再逐条运行自动机
+            candidates = m_fuzzy->FindCandidates(index);
+        } else if (m_regex) {
+            candidates = m_regex->FindCandidates(index);
+        } else {
+            candidates = index.FindCandidates(m_normalized, m_phrase);
+        }
+        candidates.erase(std::lower_bound(candidates.begin(), candidates.end(),
+                                          static_cast<uint32_t>(documentLimit)),
+                         candidates.end());
+        return candidates;
+    }
+    
+    // 发言人过滤，校验原文之前先排除
+    bool MatchesSpeaker(int speakerId) const {
+        return m_speakerId < 0 || speakerId == m_speakerId;
+    }
+    
+    // 校验一条消息，content 为消息原文，hits 用作暂存
+    // 索引不保存文本，规范化和拼音键都在这里现算
+    bool Match(const std::wstring& content, size_t document, std::vector<MeetAnt::SearchHit>& hits) const {
+        hits.clear();
+        if (m_regex) {
+            return m_regex->Match(content, document, hits, 1);
+        }
+        
+        std::wstring normalized = MeetAnt::SearchIndex::Normalize(content);
+        if (m_fuzzy) {
+            return m_fuzzy->Match(normalized, MeetAnt::ToPinyinKey(normalized), document, hits, 1);
+        }
+        
+        MeetAnt::SearchIndex::FindInText(normalized, document, m_normalized,
+                                         m_phrase ? &m_segments : nullptr, hits, 0);
+        // 索引不区分大小写，区分大小写时再用原文校验
+        if (m_caseSensitive && !m_phrase && !hits.empty()) {
+            hits.erase(std::remove_if(hits.begin(), hits.end(),
+                [&content, this](const MeetAnt::SearchHit& hit) {
+                    return content.compare(hit.offset, hit.length, m_searchText) != 0;
+                }), hits.end());
+        }
+        return !hits.empty();
+    }
+    
+private:
+    std::wstring m_searchText;
+    bool m_caseSensitive;
+    int m_speakerId;                                // 发言人过滤，-1 表示不过滤
+    std::unique_ptr<MeetAnt::RegexQuery> m_regex;   // 已编译的正则
+    std::unique_ptr<MeetAnt::FuzzyQuery> m_fuzzy;   // 已编译的拼音模糊查询；两者都为空时按子串/短语搜索
+    std::wstring m_normalized;
+    bool m_phrase;
+    std::vector<std::wstring> m_segments;           // 短语按通配分隔后的片段
+};
+
+// 后台搜索线程：用索引筛选候选消息后分批读出原文校验，命中按批投递回UI线程
+class TranscriptionBubbleCtrl::SearchWorker : public wxThread {
+public:
+    SearchWorker(TranscriptionBubbleCtrl* owner, int generation,
+                 std::shared_ptr<const CompiledQuery> query, size_t documentLimit)
+        : wxThread(wxTHREAD_JOINABLE),
+          m_owner(owner),
+          m_generation(generation),
+          m_query(std::move(query)),
+          m_documentLimit(documentLimit),
+          m_stopRequested(false) {
+    }
+    
+    void RequestStop() { m_stopRequested = true; }
+    
+protected:
+    ExitCode Entry() override {
+        // 只搜索开始时已有的消息，之后追加的由常驻查询在UI线程中求值
+        // 分面中的时间以首条消息为起点
+        // 索引还没有包含这些消息时先在这里补齐，UI线程不等待建立索引
+        if (!m_owner->ExtendSearchIndex(m_documentLimit, [this]() { return m_stopRequested || TestDestroy(); })) {
+            return (ExitCode)0;
+        }
+        
+        std::vector<uint32_t> candidates;
+        MeetAnt::TimeStamp origin = 0;
+        {
+            wxCriticalSectionLocker lock(m_owner->m_searchLock);
+            candidates = m_query->FindCandidates(m_owner->m_searchIndex, m_documentLimit);
+            if (m_documentLimit > 0) {
+                origin = GetMessageTime(m_owner->m_messages[0]);
+            }
+        }
+        
+        std::vector<MeetAnt::SearchHit> hits;
+        std::vector<std::wstring> page;
+        size_t loadedPage = kNoPage;
+        for (size_t chunkBegin = 0; chunkBegin < candidates.size(); chunkBegin += kSearchChunkSize) {
+            if (m_stopRequested || TestDestroy()) {
+                return (ExitCode)0;
+            }
+            
+            size_t chunkEnd = std::min(candidates.size(), chunkBegin + kSearchChunkSize);
+            
+            // 索引不保存文本，先逐页读出本批候选的原文，换出的页直接读分页文件，不换入内存
+            std::vector<std::wstring> contents;
+            contents.reserve(chunkEnd - chunkBegin);
+            for (size_t i = chunkBegin; i < chunkEnd; ++i) {
+                contents.push_back(m_owner->ReadMessageText(candidates[i], page, loadedPage));
+            }
+            
+            // 消息追加后元数据不再修改，持锁期间可以安全读取；校验原文不持锁
+            std::vector<int> speakerIds;
+            speakerIds.reserve(chunkEnd - chunkBegin);
+            {
+                wxCriticalSectionLocker lock(m_owner->m_searchLock);
+                for (size_t i = chunkBegin; i < chunkEnd; ++i) {
+                    speakerIds.push_back(m_owner->m_messages[candidates[i]].speakerId);
+                }
+            }
+            std::vector<uint32_t> matched;
+            for (size_t i = chunkBegin; i < chunkEnd; ++i) {
+                if (m_query->MatchesSpeaker(speakerIds[i - chunkBegin]) &&
+                    m_query->Match(contents[i - chunkBegin], candidates[i], hits)) {
+                    matched.push_back(candidates[i]);
+                }
+            }
+            
+            std::vector<int> messageIds;
+            TranscriptionSearchFacets facets;
+            if (!matched.empty()) {
+                wxCriticalSectionLocker lock(m_owner->m_searchLock);
+                for (uint32_t document : matched) {
+                    messageIds.push_back(m_owner->m_messages[document].messageId);
+                    m_owner->AccumulateSearchFacets(document, origin, facets);
+                }
+            }
+            
+            if (!messageIds.empty()) {
+                PostChunk(std::move(messageIds), std::move(facets), false);
+            }
+        }
+        
+        PostChunk(std::vector<int>(), TranscriptionSearchFacets(), true);
+        return (ExitCode)0;
+    }
+    
+private:
+    void PostChunk(std::vector<int> messageIds, TranscriptionSearchFacets facets, bool isLast) {
+        auto chunk = std::make_shared<SearchChunk>();
+        chunk->generation = m_generation;
+        chunk->messageIds = std::move(messageIds);
+        chunk->facets = std::move(facets);
+        chunk->isLast = isLast;
+        
+        wxThreadEvent* event = new wxThreadEvent(wxEVT_TRANSCRIPTION_SEARCH_CHUNK);
+        event->SetPayload(chunk);
+        wxQueueEvent(m_owner, event);
+    }
+    
+    TranscriptionBubbleCtrl* m_owner;
+    int m_generation;
+    std::shared_ptr<const CompiledQuery> m_query;
+    size_t m_documentLimit;                         // 开始搜索时的消息数
+    std::atomic<bool> m_stopRequested;
+};
 
 // 事件表
 wxBEGIN_EVENT_TABLE(TranscriptionBubbleCtrl, wxScrolledWindow)
@@ -17,6 +421,8 @@ wxBEGIN_EVENT_TABLE(TranscriptionBubbleCtrl, wxScrolledWindow)
     EVT_RIGHT_DOWN(TranscriptionBubbleCtrl::OnMouseRightDown)
     EVT_MOTION(TranscriptionBubbleCtrl::OnMouseMotion)
     EVT_ERASE_BACKGROUND(TranscriptionBubbleCtrl::OnEraseBackground)
+    EVT_SCROLLWIN(TranscriptionBubbleCtrl::OnScrollWin)
+    EVT_TIMER(wxID_ANY, TranscriptionBubbleCtrl::OnSmoothScrollTimer)
 wxEND_EVENT_TABLE()
 
 // 默认颜色列表
@@ -35,17 +441,34 @@ TranscriptionBubbleCtrl::TranscriptionBubbleCtrl(wxWindow* parent, wxWindowID id
                                                const wxPoint& pos, const wxSize& size,
                                                long style)
     : wxScrolledWindow(parent, id, pos, size, style | wxFULL_REPAINT_ON_RESIZE),
+      m_pageClock(0),
+      m_evictPending(false),
+      m_annotationWindowValid(false),
+      m_annotationWindowBegin(0),
+      m_annotationWindowEnd(0),
+      m_hasLiveMessage(false),
+      m_loadWorker(nullptr),
+      m_loadGeneration(0),
+      m_layoutWorker(nullptr),
+      m_layoutGeneration(0),
+      m_layoutWidth(0),
       m_showTimestamps(true),
       m_autoScroll(true),
+      m_followTail(true),
       m_bubbleMargin(10),
       m_bubblePadding(12),
       m_maxBubbleWidth(400),
       m_avatarSize(40),
       m_hoveredMessage(-1),
       m_selectedMessage(-1),
+      m_searchIndex(false),
       m_currentSearchIndex(-1),
+      m_searchWorker(nullptr),
+      m_searchGeneration(0),
       m_nextMessageId(1),
-      m_virtualHeight(0)
+      m_virtualHeight(0),
+      m_smoothScrollTimer(this),
+      m_smoothScrollTarget(0)
 {
     // 设置背景色
     m_backgroundColor = wxColour(255, 255, 255);
@@ -64,47 +487,264 @@ TranscriptionBubbleCtrl::TranscriptionBubbleCtrl(wxWindow* parent, wxWindowID id
     m_speakerFont = wxFont(10, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_BOLD);
     m_timestampFont = wxFont(8, wxFONTFAMILY_DEFAULT, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL);
     
-    // 设置滚动速率
-    SetScrollRate(10, 10);
+    // 按像素滚动，避免滚动位置被量化
+    SetScrollRate(1, 1);
     
     // 启用双缓冲
     SetBackgroundStyle(wxBG_STYLE_PAINT);
+    
+    // 接收后台读取、布局和搜索结果
+    Bind(wxEVT_TRANSCRIPTION_LOAD_DONE, &TranscriptionBubbleCtrl::OnLoadDone, this);
+    Bind(wxEVT_TRANSCRIPTION_LAYOUT_CHUNK, &TranscriptionBubbleCtrl::OnLayoutChunk, this);
+    Bind(wxEVT_TRANSCRIPTION_SEARCH_CHUNK, &TranscriptionBubbleCtrl::OnSearchChunk, this);
 }
 
 TranscriptionBubbleCtrl::~TranscriptionBubbleCtrl() {
-    // 清理资源
+    // 先停止后台线程，它们持有对本控件的引用
+    StopSearchWorker();
+    StopLayoutWorker();
+    StopLoadWorker();
 }
 
 void TranscriptionBubbleCtrl::AddMessage(const wxString& speaker, const wxString& content,
                                         const wxDateTime& timestamp) {
+    // 后台读取的消息排在前面
+    FinishLoad();
+    
     TranscriptionMessage msg;
     msg.speakerName = speaker;
     msg.content = content;
     msg.timestamp = timestamp;
     msg.messageId = m_nextMessageId++;
     
-    // 获取或生成发言人颜色
-    msg.speakerColor = GetSpeakerColor(speaker);
+    // 登记发言人，颜色在绘制时通过样式表解析
+    msg.speakerId = InternSpeaker(speaker);
     
-    m_messages.push_back(msg);
+    AppendMessage(msg);
     
-    // 重新计算布局
-    CalculateLayout();
+    // 只测量新消息；宽度变化时才需要整体重新布局
+    EnsureMetricsCache();
+    if (m_layoutWidth != GetContentAreaWidth() || m_layouts.size() + 1 != m_messages.size()) {
+        CalculateLayout();
+    } else {
+        MessageLayout layout;
+        layout.messageId = msg.messageId;
+        m_layouts.push_back(layout);
+        MeasureMessage(m_layouts.size() - 1);
+        RecomputePositions(m_layouts.size() - 1);
+    }
     
-    // 如果启用了自动滚动，滚动到底部
-    if (m_autoScroll) {
-        ScrollToMessage(msg.messageId);
+    // 跟随尾部时把已有内容上移新气泡的高度，只重绘露出的部分
+    if (IsFollowingTail()) {
+        ScrollToBottom();
+    }
+    RefreshBubbleRow(m_layouts.back().bubbleRect);
+    if (m_hasLiveMessage) {
+        RefreshBubbleRow(m_liveLayout.bubbleRect);
     }
     
+    EvaluateStandingQuery(m_messages.size() - 1);
+    EvictPages();
+}
+
+void TranscriptionBubbleCtrl::AppendMessage(const TranscriptionMessage& msg) {
+    {
+        // 后台搜索线程可能正在读取消息和补齐索引；索引还缺之前的消息时由下一次搜索一并补齐
+        wxCriticalSectionLocker lock(m_searchLock);
+        m_messages.push_back(msg);
+        if (m_searchIndex.GetDocumentCount() + 1 == m_messages.size()) {
+            m_searchIndex.AddDocument(msg.content.ToStdWstring());
+        }
+    }
+    m_highlighted.push_back(false);
+    
+    // 新消息所在的页总是在内存中，末页不会被换出
+    size_t page = (m_messages.size() - 1) / kPageMessages;
+    if (page >= m_pageLastUse.size()) {
+        m_pageLastUse.resize(page + 1, 0);
+    }
+    m_pageLastUse[page] = ++m_pageClock;
+}
+
+void TranscriptionBubbleCtrl::SetLiveMessage(const wxString& speaker, const wxString& content,
+                                            const wxDateTime& timestamp) {
+    // 载入读到的消息会清掉实时气泡，先等读取完成
+    FinishLoad();
+    
+    EnsureMetricsCache();
+    if (m_layoutWidth != GetContentAreaWidth()) {
+        CalculateLayout();
+    }
+    
+    wxRect oldRect = m_liveLayout.bubbleRect;
+    bool wasLive = m_hasLiveMessage;
+    
+    // 同一句话的多次中间结果沿用首次出现的时间
+    if (!wasLive) {
+        m_liveMessage.timestamp = timestamp;
+    }
+    m_liveMessage.speakerName = speaker;
+    m_liveMessage.content = content;
+    m_liveMessage.speakerId = InternSpeaker(speaker);
+    m_hasLiveMessage = true;
+    
+    MeasureLiveMessage();
+    m_liveLayout.bubbleRect.y = m_layouts.empty() ? m_bubbleMargin
+                                                  : m_layouts.back().bubbleRect.GetBottom() + 1 + m_bubbleMargin;
+    
+    // 高度不变时滚动范围不变，只需重绘这一个气泡
+    if (!wasLive || oldRect.height != m_liveLayout.bubbleRect.height) {
+        bool following = IsFollowingTail();
+        m_virtualHeight = m_liveLayout.bubbleRect.GetBottom() + 1 + m_bubbleMargin;
+        SetVirtualSize(GetClientSize().GetWidth(), m_virtualHeight);
+        
+        if (following) {
+            ScrollToBottom();
+        }
+    }
+    
+    if (wasLive) {
+        RefreshBubbleRow(oldRect);
+    }
+    RefreshBubbleRow(m_liveLayout.bubbleRect);
+}
+
+int TranscriptionBubbleCtrl::CommitLiveMessage(const wxString& finalContent) {
+    if (!m_hasLiveMessage) {
+        return -1;
+    }
+    
+    TranscriptionMessage msg = m_liveMessage;
+    if (!finalContent.IsEmpty()) {
+        msg.content = finalContent;
+    }
+    msg.messageId = m_nextMessageId++;
+    
+    wxRect liveRect = m_liveLayout.bubbleRect;
+    m_hasLiveMessage = false;
+    m_liveLayout = MessageLayout();
+    
+    AppendMessage(msg);
+    
+    if (m_layoutWidth != GetContentAreaWidth() || m_layouts.size() + 1 != m_messages.size()) {
+        CalculateLayout();
+        Refresh();
+        EvaluateStandingQuery(m_messages.size() - 1);
+        EvictPages();
+        return msg.messageId;
+    }
+    
+    // 正式消息占据实时气泡原来的位置，只有文本变化时才需要重新测量
+    MessageLayout layout;
+    layout.messageId = msg.messageId;
+    layout.bubbleRect.y = liveRect.y;
+    m_layouts.push_back(layout);
+    MeasureMessage(m_layouts.size() - 1);
+    RecomputePositions(m_layouts.size() - 1);
+    
+    if (IsFollowingTail()) {
+        ScrollToBottom();
+    }
+    RefreshBubbleRow(liveRect);
+    RefreshBubbleRow(m_layouts.back().bubbleRect);
+    EvaluateStandingQuery(m_messages.size() - 1);
+    EvictPages();
+    return msg.messageId;
+}
+
+void TranscriptionBubbleCtrl::ClearLiveMessage() {
+    if (!m_hasLiveMessage) {
+        return;
+    }
+    
+    wxRect liveRect = m_liveLayout.bubbleRect;
+    m_hasLiveMessage = false;
+    m_liveLayout = MessageLayout();
+    
+    RecomputePositions(m_layouts.size());
+    RefreshBubbleRow(liveRect);
+}
+
+void TranscriptionBubbleCtrl::MeasureLiveMessage() {
+    int textWidth = m_layoutWidth - m_bubblePadding * 2;
+    m_liveLayout.lineStarts = m_metricsCache.WrapText(m_liveMessage.content.wc_str(),
+                                                      m_liveMessage.content.length(), textWidth);
+    
+    int height = static_cast<int>(m_liveLayout.lineStarts.size()) * m_metricsCache.GetLineHeight() +
+                 m_bubblePadding * 2;
+    m_liveLayout.bubbleRect = wxRect(kLeftMargin, m_liveLayout.bubbleRect.y, m_layoutWidth,
+                                     std::max(height, kMinBubbleHeight));
+    m_liveLayout.measured = true;
+}
+
+void TranscriptionBubbleCtrl::RefreshBubbleRow(const wxRect& bubbleRect) {
+    if (bubbleRect.IsEmpty()) {
+        return;
+    }
+    
+    int x, y;
+    CalcScrolledPosition(0, bubbleRect.y, &x, &y);
+    RefreshRect(wxRect(0, y, GetClientSize().GetWidth(), bubbleRect.height + 1), false);
+}
+
+void TranscriptionBubbleCtrl::SetMessages(std::vector<TranscriptionMessage> messages) {
+    StopLoadWorker();
+    StopSearchWorker();
+    StopLayoutWorker();
+    
+    m_pageFile.Clear();
+    m_messages = std::move(messages);
+    for (auto& msg : m_messages) {
+        msg.messageId = m_nextMessageId++;
+        msg.speakerId = InternSpeaker(msg.speakerName);
+    }
+    m_highlighted.assign(m_messages.size(), false);
+    
+    // 所有页先留在内存中供估算高度，布局之后只保留可视区域附近的页
+    m_pageLastUse.assign((m_messages.size() + kPageMessages - 1) / kPageMessages, ++m_pageClock);
+    
+    // 全文索引由搜索线程在搜索前重新建立
+    m_searchIndex.Clear();
+    
+    m_annotationWindowValid = false;
+    m_inlineAnnotations.clear();
+    m_annotationIndex.Clear();
+    
+    m_layouts.clear();
+    m_hasLiveMessage = false;
+    m_liveLayout = MessageLayout();
+    m_hoveredMessage = -1;
+    m_selectedMessage = -1;
+    ResetStandingQuery();
+    m_searchResults.clear();
+    m_currentSearchIndex = -1;
+    
+    CalculateLayout();
+    TrimToVisiblePages();
     Refresh();
 }
 
 void TranscriptionBubbleCtrl::Clear() {
+    StopLoadWorker();
+    StopSearchWorker();
+    StopLayoutWorker();
+    m_layoutGeneration++;
+    
     m_messages.clear();
+    m_highlighted.clear();
+    m_pageFile.Clear();
+    m_pageLastUse.clear();
+    m_searchIndex.Clear();
+    m_annotationWindowValid = false;
+    m_inlineAnnotations.clear();
+    m_annotationIndex.Clear();
     m_layouts.clear();
+    m_hasLiveMessage = false;
+    m_liveLayout = MessageLayout();
     m_virtualHeight = 0;
     m_hoveredMessage = -1;
     m_selectedMessage = -1;
+    ResetStandingQuery();
     m_searchResults.clear();
     m_currentSearchIndex = -1;
     
@@ -112,92 +752,734 @@ void TranscriptionBubbleCtrl::Clear() {
     Refresh();
 }
 
-void TranscriptionBubbleCtrl::SetSpeakerColor(const wxString& speaker, const wxColour& color) {
-    m_speakerColors[speaker] = color;
+void TranscriptionBubbleCtrl::LoadMessages(const MessageLoader& loader) {
+    Clear();
     
-    // 更新现有消息的颜色
-    for (auto& msg : m_messages) {
-        if (msg.speakerName == speaker) {
-            msg.speakerColor = color;
+    m_loadWorker = new LoadWorker(this, m_loadGeneration, loader);
+    if (m_loadWorker->Run() != wxTHREAD_NO_ERROR) {
+        wxLogError(wxT("无法启动读取线程"));
+        delete m_loadWorker;
+        m_loadWorker = nullptr;
+        
+        // 退化为同步读取
+        std::vector<TranscriptionMessage> messages;
+        bool loaded = loader(messages);
+        if (loaded) {
+            SetMessages(std::move(messages));
         }
+        NotifyLoaded(loaded);
+    }
+}
+
+void TranscriptionBubbleCtrl::FinishLoad() {
+    if (!m_loadWorker) {
+        return;
     }
     
-    Refresh();
+    // 读取线程已经或即将结束；之后到达的完成通知因代数不符而丢弃
+    m_loadWorker->Wait();
+    LoadWorker* worker = m_loadWorker;
+    m_loadWorker = nullptr;
+    m_loadGeneration++;
+    
+    bool loaded = worker->IsLoaded();
+    if (loaded) {
+        SetMessages(std::move(worker->GetMessages()));
+    }
+    delete worker;
+    NotifyLoaded(loaded);
+}
+
+void TranscriptionBubbleCtrl::StopLoadWorker() {
+    // 代数递增后，已投递但尚未处理的完成通知都会被丢弃
+    m_loadGeneration++;
+    if (m_loadWorker) {
+        m_loadWorker->Wait();
+        delete m_loadWorker;
+        m_loadWorker = nullptr;
+    }
+}
+
+void TranscriptionBubbleCtrl::OnLoadDone(wxThreadEvent& event) {
+    if (event.GetInt() == m_loadGeneration) {
+        FinishLoad();
+    }
+}
+
+void TranscriptionBubbleCtrl::NotifyLoaded(bool loaded) {
+    wxCommandEvent event(wxEVT_TRANSCRIPTION_LOADED, GetId());
+    event.SetEventObject(this);
+    event.SetInt(loaded ? 1 : 0);
+    ProcessWindowEvent(event);
+}
+
+void TranscriptionBubbleCtrl::SetSpeakerColor(const wxString& speaker, const wxColour& color) {
+    int speakerId = InternSpeaker(speaker);
+    if (m_speakerStyles[speakerId].color == color) {
+        return;
+    }
+    
+    // 只改样式表，消息本身不需要更新
+    m_speakerStyles[speakerId].color = color;
+    RefreshSpeakerRows(speakerId);
 }
 
 wxColour TranscriptionBubbleCtrl::GetSpeakerColor(const wxString& speaker) const {
-    auto it = m_speakerColors.find(speaker);
-    if (it != m_speakerColors.end()) {
-        return it->second;
+    auto it = m_speakerIds.find(speaker);
+    if (it != m_speakerIds.end()) {
+        return m_speakerStyles[it->second].color;
     }
     
     // 生成默认颜色
-    return const_cast<TranscriptionBubbleCtrl*>(this)->GenerateSpeakerColor(speaker);
+    return GenerateSpeakerColor(speaker);
 }
 
-wxColour TranscriptionBubbleCtrl::GenerateSpeakerColor(const wxString& speaker) {
+wxColour TranscriptionBubbleCtrl::GenerateSpeakerColor(const wxString& speaker) const {
     // 基于发言人名称的哈希值选择颜色
     size_t hash = std::hash<std::wstring>{}(speaker.ToStdWstring());
     size_t colorIndex = hash % s_defaultColors.size();
     
-    wxColour color = s_defaultColors[colorIndex];
-    m_speakerColors[speaker] = color;
+    return s_defaultColors[colorIndex];
+}
+
+int TranscriptionBubbleCtrl::InternSpeaker(const wxString& speaker) {
+    auto it = m_speakerIds.find(speaker);
+    if (it != m_speakerIds.end()) {
+        return it->second;
+    }
+    
+    int speakerId = static_cast<int>(m_speakerStyles.size());
+    SpeakerStyle style;
+    style.name = speaker;
+    style.color = GenerateSpeakerColor(speaker);
+    m_speakerStyles.push_back(style);
+    m_speakerIds[speaker] = speakerId;
+    return speakerId;
+}
+
+int TranscriptionBubbleCtrl::FindMessageIndex(int messageId) const {
+    if (m_messages.empty()) {
+        return -1;
+    }
+    
+    // 消息只会追加或整体替换，列表中的ID连续递增
+    long index = static_cast<long>(messageId) - m_messages.front().messageId;
+    if (index < 0 || index >= static_cast<long>(m_messages.size()) ||
+        m_messages[index].messageId != messageId) {
+        return -1;
+    }
+    return static_cast<int>(index);
+}
+
+void TranscriptionBubbleCtrl::RefreshSpeakerRows(int speakerId) {
+    int viewTop = GetScrollTop();
+    int viewBottom = viewTop + GetClientSize().GetHeight();
+    
+    // 不在可视区域内的气泡会在滚动到时按新颜色绘制
+    for (size_t i = FindFirstLayoutAt(viewTop); i < m_layouts.size(); ++i) {
+        if (m_layouts[i].bubbleRect.GetTop() > viewBottom) {
+            break;
+        }
+        if (m_messages[i].speakerId == speakerId) {
+            RefreshBubbleRow(m_layouts[i].bubbleRect);
+        }
+    }
+    
+    if (m_hasLiveMessage && m_liveMessage.speakerId == speakerId) {
+        RefreshBubbleRow(m_liveLayout.bubbleRect);
+    }
+}
+
+void TranscriptionBubbleCtrl::LoadMessageRange(size_t begin, size_t end) {
+    m_pageClock++;
+    if (begin < end) {
+        size_t lastPage = std::min((end - 1) / kPageMessages + 1, m_pageLastUse.size());
+        for (size_t page = begin / kPageMessages; page < lastPage; ++page) {
+            if (!IsPageResident(page)) {
+                LoadPage(page);
+            }
+            m_pageLastUse[page] = m_pageClock;
+        }
+    }
+}
+
+void TranscriptionBubbleCtrl::TrimToVisiblePages() {
+    int viewTop = GetScrollTop();
+    int viewBottom = viewTop + GetClientSize().GetHeight();
+    size_t first = FindFirstLayoutAt(viewTop);
+    size_t last = first;
+    while (last < m_layouts.size() && m_layouts[last].bubbleRect.GetTop() <= viewBottom) {
+        ++last;
+    }
+    LoadMessageRange(first, last);
+    EvictPages();
+}
+
+void TranscriptionBubbleCtrl::LoadPage(size_t page) {
+    // 读取失败时文本留空（分页文件已记录警告），仍记为在内存中，避免每次绘制都重试
+    std::vector<std::wstring> contents;
+    m_pageFile.ReadPage(page, contents);
+    
+    size_t begin = page * kPageMessages;
+    size_t end = std::min(m_messages.size(), begin + contents.size());
+    {
+        wxCriticalSectionLocker lock(m_searchLock);
+        for (size_t i = begin; i < end; ++i) {
+            m_messages[i].content = wxString(contents[i - begin]);
+        }
+    }
+    
+    // 换出时丢弃了换行结果，按当前宽度重新换行；高度不变，其他气泡的位置也就不变
+    if (m_layoutWidth > 0) {
+        for (size_t i = begin; i < end && i < m_layouts.size(); ++i) {
+            WrapMessage(i);
+        }
+    }
+}
+
+void TranscriptionBubbleCtrl::EvictPages() {
+    size_t resident = 0;
+    for (uint64_t lastUse : m_pageLastUse) {
+        if (lastUse != 0) {
+            resident++;
+        }
+    }
+    
+    while (resident > kResidentPages) {
+        // 最久未用的页；末页还在追加消息，刚用到的页正在显示，都不换出
+        size_t victim = kNoPage;
+        uint64_t oldest = m_pageClock;
+        for (size_t page = 0; page + 1 < m_pageLastUse.size(); ++page) {
+            if (m_pageLastUse[page] != 0 && m_pageLastUse[page] < oldest) {
+                oldest = m_pageLastUse[page];
+                victim = page;
+            }
+        }
+        if (victim == kNoPage) {
+            break;
+        }
+        
+        size_t begin = victim * kPageMessages;
+        size_t end = std::min(m_messages.size(), begin + kPageMessages);
+        if (!m_pageFile.HasPage(victim)) {
+            std::vector<wxString> contents;
+            contents.reserve(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                contents.push_back(m_messages[i].content);
+            }
+            // 写不进分页文件时文本留在内存中
+            if (!m_pageFile.WritePage(victim, contents)) {
+                break;
+            }
+        }
+        
+        {
+            // 页已写入分页文件，后台线程从此只从文件读取这一页
+            wxCriticalSectionLocker lock(m_searchLock);
+            for (size_t i = begin; i < end; ++i) {
+                wxString().swap(m_messages[i].content);
+            }
+        }
+        for (size_t i = begin; i < end && i < m_layouts.size(); ++i) {
+            std::vector<int>().swap(m_layouts[i].lineStarts);
+        }
+        m_pageLastUse[victim] = 0;
+        resident--;
+    }
+}
+
+void TranscriptionBubbleCtrl::ScheduleEvictPages() {
+    // 写分页文件留到绘制完成之后，连续多次绘制只换出一次
+    if (m_evictPending) {
+        return;
+    }
+    m_evictPending = true;
+    CallAfter([this]() {
+        m_evictPending = false;
+        EvictPages();
+    });
+}
+
+bool TranscriptionBubbleCtrl::ReadPageText(size_t page, std::vector<std::wstring>& contents) const {
+    {
+        // 页还没写入分页文件时文本一定在内存中：换出总是先写文件再在锁内清空文本
+        wxCriticalSectionLocker lock(m_searchLock);
+        if (!m_pageFile.HasPage(page)) {
+            size_t begin = page * kPageMessages;
+            size_t end = std::min(m_messages.size(), begin + kPageMessages);
+            contents.clear();
+            for (size_t i = begin; i < end; ++i) {
+                contents.push_back(m_messages[i].content.ToStdWstring());
+            }
+            return begin < end;
+        }
+    }
+    return m_pageFile.ReadPage(page, contents);
+}
+
+const std::wstring& TranscriptionBubbleCtrl::ReadMessageText(size_t index, std::vector<std::wstring>& page,
+                                                             size_t& loadedPage) const {
+    static const std::wstring empty;
+    size_t pageIndex = index / kPageMessages;
+    if (pageIndex != loadedPage) {
+        if (!ReadPageText(pageIndex, page)) {
+            page.clear();
+        }
+        loadedPage = pageIndex;
+    }
+    size_t offset = index % kPageMessages;
+    return offset < page.size() ? page[offset] : empty;
+}
+
+bool TranscriptionBubbleCtrl::ExtendSearchIndex(size_t limit, const std::function<bool()>& stopRequested) {
+    std::vector<std::wstring> page;
+    size_t loadedPage = kNoPage;
+    for (;;) {
+        size_t begin;
+        {
+            wxCriticalSectionLocker lock(m_searchLock);
+            begin = m_searchIndex.GetDocumentCount();
+        }
+        if (begin >= limit) {
+            return true;
+        }
+        if (stopRequested()) {
+            return false;
+        }
+        
+        // 每次补一页：不持锁读出这一页，持锁加入索引（这一页已读出，ReadMessageText 不再加锁）
+        // 期间UI线程不会改动索引：索引还缺消息时它不追加文档
+        size_t end = std::min(limit, (begin / kPageMessages + 1) * kPageMessages);
+        ReadMessageText(begin, page, loadedPage);
+        wxCriticalSectionLocker lock(m_searchLock);
+        for (size_t i = begin; i < end && m_searchIndex.GetDocumentCount() == i; ++i) {
+            m_searchIndex.AddDocument(ReadMessageText(i, page, loadedPage));
+        }
+    }
+}
+
+void TranscriptionBubbleCtrl::HighlightMessage(int messageId, bool highlight) {
+    int index = FindMessageIndex(messageId);
+    if (index < 0 || m_highlighted[index] == highlight) {
+        return;
+    }
+    
+    m_highlighted[index] = highlight;
+    if (index < static_cast<int>(m_layouts.size())) {
+        RefreshBubbleRow(m_layouts[index].bubbleRect);
+    }
+}
+
+bool TranscriptionBubbleCtrl::IsMessageHighlighted(int messageId) const {
+    int index = FindMessageIndex(messageId);
+    return index >= 0 && m_highlighted[index];
+}
+
+std::vector<int> TranscriptionBubbleCtrl::SearchText(const wxString& searchText, bool caseSensitive,
+                                                     TranscriptionSearchMode mode, const wxString& speaker) {
+    StopSearchWorker();
+    ResetStandingQuery();
+    m_searchResults.clear();
+    m_currentSearchIndex = -1;
+    m_lastSearchError.clear();
+    m_searchFacets.Clear();
+    
+    std::shared_ptr<const CompiledQuery> query = CompileQuery(searchText, caseSensitive, mode, speaker);
+    if (!query) {
+        return m_searchResults;
+    }
+    ExtendSearchIndex(m_messages.size(), []() { return false; });
+    
+    MeetAnt::TimeStamp origin = m_messages.empty() ? 0 : GetMessageTime(m_messages[0]);
+    std::vector<MeetAnt::SearchHit> hits;
+    std::vector<std::wstring> page;
+    size_t loadedPage = kNoPage;
+    for (uint32_t document : query->FindCandidates(m_searchIndex, m_messages.size())) {
+        const TranscriptionMessage& msg = m_messages[document];
+        if (query->MatchesSpeaker(msg.speakerId) &&
+            query->Match(ReadMessageText(document, page, loadedPage), document, hits)) {
+            m_searchResults.push_back(msg.messageId);
+            AccumulateSearchFacets(document, origin, m_searchFacets);
+        }
+    }
+    
+    m_standingQuery = query;
+    return m_searchResults;
+}
+
+void TranscriptionBubbleCtrl::StartSearch(const wxString& searchText, bool caseSensitive,
+                                          TranscriptionSearchMode mode, const wxString& speaker) {
+    StopSearchWorker();
+    if (m_currentSearchIndex >= 0) {
+        // 当前命中的高亮随结果一起清除
+        int index = FindMessageIndex(m_searchResults[m_currentSearchIndex]);
+        if (index >= 0 && index < static_cast<int>(m_layouts.size())) {
+            RefreshBubbleRow(m_layouts[index].bubbleRect);
+        }
+    }
+    ResetStandingQuery();
+    m_searchResults.clear();
+    m_currentSearchIndex = -1;
+    m_lastSearchError.clear();
+    m_searchFacets.Clear();
+    
+    // 查询在UI线程编译，错误可以立即反馈；编译本身与消息数量无关
+    std::shared_ptr<const CompiledQuery> query = CompileQuery(searchText, caseSensitive, mode, speaker);
+    if (!query) {
+        NotifySearchUpdated(true);
+        return;
+    }
+    
+    // 后台线程补齐索引并搜索已有的消息，之后追加的消息由常驻查询逐条求值
+    m_standingQuery = query;
+    m_searchWorker = new SearchWorker(this, m_searchGeneration, query, m_messages.size());
+    if (m_searchWorker->Run() != wxTHREAD_NO_ERROR) {
+        wxLogError(wxT("无法启动搜索线程"));
+        delete m_searchWorker;
+        m_searchWorker = nullptr;
+        
+        // 退化为同步搜索
+        SearchText(searchText, caseSensitive, mode, speaker);
+        GotoSearchResult(0);
+        NotifySearchUpdated(true);
+    }
+}
+
+void TranscriptionBubbleCtrl::CancelSearch() {
+    StopSearchWorker();
+    if (m_currentSearchIndex >= 0) {
+        int index = FindMessageIndex(m_searchResults[m_currentSearchIndex]);
+        if (index >= 0 && index < static_cast<int>(m_layouts.size())) {
+            RefreshBubbleRow(m_layouts[index].bubbleRect);
+        }
+    }
+    ResetStandingQuery();
+    m_searchResults.clear();
+    m_currentSearchIndex = -1;
+    m_lastSearchError.clear();
+    m_searchFacets.Clear();
+}
+
+std::shared_ptr<const TranscriptionBubbleCtrl::CompiledQuery> TranscriptionBubbleCtrl::CompileQuery(
+        const wxString& searchText, bool caseSensitive, TranscriptionSearchMode mode, const wxString& speaker) {
+    if (searchText.IsEmpty()) {
+        return nullptr;
+    }
+    
+    // 发言人过滤只比较整数ID；没有这个发言人时不可能有结果
+    int speakerId = -1;
+    if (!speaker.IsEmpty()) {
+        auto it = m_speakerIds.find(speaker);
+        if (it == m_speakerIds.end()) {
+            return nullptr;
+        }
+        speakerId = it->second;
+    }
+    
+    std::shared_ptr<CompiledQuery> query = std::make_shared<CompiledQuery>(searchText, caseSensitive, speakerId);
+    if (!query->Compile(mode, &m_lastSearchError)) {
+        return nullptr;
+    }
+    return query;
+}
+
+void TranscriptionBubbleCtrl::ResetStandingQuery() {
+    m_standingQuery.reset();
+    m_standingHits.clear();
+    m_standingFacets.Clear();
+}
+
+void TranscriptionBubbleCtrl::EvaluateStandingQuery(size_t index) {
+    // 新消息所在的页在内存中
+    std::vector<MeetAnt::SearchHit> hits;
+    if (!m_standingQuery || !m_standingQuery->MatchesSpeaker(m_messages[index].speakerId) ||
+        !m_standingQuery->Match(m_messages[index].content.ToStdWstring(), index, hits)) {
+        return;
+    }
+    
+    int messageId = m_messages[index].messageId;
+    MeetAnt::TimeStamp origin = GetMessageTime(m_messages[0]);
+    if (m_searchWorker) {
+        // 后台搜索的结果都在这条消息之前，先暂存，最后一批到达后再追加
+        m_standingHits.push_back(messageId);
+        AccumulateSearchFacets(index, origin, m_standingFacets);
+        return;
+    }
+    
+    m_searchResults.push_back(messageId);
+    AccumulateSearchFacets(index, origin, m_searchFacets);
+    
+    // 之前没有命中时把新消息设为当前命中，只重绘不滚动，不打断跟随尾部
+    if (m_currentSearchIndex < 0) {
+        m_currentSearchIndex = static_cast<int>(m_searchResults.size()) - 1;
+        if (index < m_layouts.size()) {
+            RefreshBubbleRow(m_layouts[index].bubbleRect);
+        }
+    }
+    NotifySearchUpdated(true);
+}
+
+int TranscriptionBubbleCtrl::GotoNextSearchResult() {
+    if (m_searchResults.empty()) {
+        return -1;
+    }
+    int count = static_cast<int>(m_searchResults.size());
+    return GotoSearchResult((m_currentSearchIndex + 1) % count);
+}
+
+int TranscriptionBubbleCtrl::GotoPreviousSearchResult() {
+    if (m_searchResults.empty()) {
+        return -1;
+    }
+    int count = static_cast<int>(m_searchResults.size());
+    return GotoSearchResult(m_currentSearchIndex <= 0 ? count - 1 : m_currentSearchIndex - 1);
+}
+
+int TranscriptionBubbleCtrl::GotoSearchResultAt(MeetAnt::TimeStamp offset) {
+    if (m_searchResults.empty() || m_messages.empty()) {
+        return -1;
+    }
+    
+    // 结果按消息位置排序，消息时间随位置递增，可以二分查找
+    MeetAnt::TimeStamp target = GetMessageTime(m_messages[0]) + offset;
+    auto it = std::lower_bound(m_searchResults.begin(), m_searchResults.end(), target,
+        [this](int messageId, MeetAnt::TimeStamp time) {
+            int index = FindMessageIndex(messageId);
+            return index >= 0 && GetMessageTime(m_messages[index]) < time;
+        });
+    if (it == m_searchResults.end()) {
+        --it;
+    }
+    return GotoSearchResult(static_cast<int>(it - m_searchResults.begin()));
+}
+
+int TranscriptionBubbleCtrl::GotoSearchResult(int resultIndex) {
+    if (resultIndex < 0 || resultIndex >= static_cast<int>(m_searchResults.size())) {
+        return -1;
+    }
+    
+    // 重绘前后两个命中所在的行，当前命中以高亮样式绘制
+    if (m_currentSearchIndex >= 0) {
+        int index = FindMessageIndex(m_searchResults[m_currentSearchIndex]);
+        if (index >= 0 && index < static_cast<int>(m_layouts.size())) {
+            RefreshBubbleRow(m_layouts[index].bubbleRect);
+        }
+    }
+    m_currentSearchIndex = resultIndex;
+    
+    int messageId = m_searchResults[resultIndex];
+    int index = FindMessageIndex(messageId);
+    if (index >= 0 && index < static_cast<int>(m_layouts.size())) {
+        RefreshBubbleRow(m_layouts[index].bubbleRect);
+    }
+    ScrollToMessage(messageId);
+    return messageId;
+}
+
+void TranscriptionBubbleCtrl::NotifySearchUpdated(bool finished) {
+    wxCommandEvent event(wxEVT_TRANSCRIPTION_SEARCH_UPDATED, GetId());
+    event.SetEventObject(this);
+    event.SetInt(static_cast<int>(m_searchResults.size()));
+    event.SetExtraLong(finished ? 1 : 0);
+    event.SetString(m_lastSearchError);
+    ProcessWindowEvent(event);
+}
+
+void TranscriptionBubbleCtrl::StopSearchWorker() {
+    // 代数递增后，已投递但尚未处理的结果都会被丢弃
+    m_searchGeneration++;
+    if (m_searchWorker) {
+        m_searchWorker->RequestStop();
+        m_searchWorker->Wait();
+        delete m_searchWorker;
+        m_searchWorker = nullptr;
+    }
+}
+
+void TranscriptionBubbleCtrl::OnSearchChunk(wxThreadEvent& event) {
+    auto chunk = event.GetPayload<std::shared_ptr<SearchChunk>>();
+    if (!chunk || chunk->generation != m_searchGeneration) {
+        return;
+    }
+    
+    bool first = m_searchResults.empty();
+    m_searchResults.insert(m_searchResults.end(), chunk->messageIds.begin(), chunk->messageIds.end());
+    m_searchFacets.Merge(chunk->facets);
+    if (first && !m_searchResults.empty()) {
+        GotoSearchResult(0);
+    }
+    
+    if (chunk->isLast) {
+        // 最后一批发出后线程随即退出，这里只需回收
+        if (m_searchWorker) {
+            m_searchWorker->Wait();
+            delete m_searchWorker;
+            m_searchWorker = nullptr;
+        }
+        
+        // 搜索期间追加的消息中的命中排在最后
+        m_searchResults.insert(m_searchResults.end(), m_standingHits.begin(), m_standingHits.end());
+        m_searchFacets.Merge(m_standingFacets);
+        m_standingHits.clear();
+        m_standingFacets.Clear();
+        if (m_currentSearchIndex < 0 && !m_searchResults.empty()) {
+            GotoSearchResult(0);
+        }
+    }
+    NotifySearchUpdated(chunk->isLast);
+}
+
+wxString TranscriptionBubbleCtrl::GetSpeakerName(int speakerId) const {
+    if (speakerId < 0 || speakerId >= static_cast<int>(m_speakerStyles.size())) {
+        return wxEmptyString;
+    }
+    return m_speakerStyles[speakerId].name;
+}
+
+std::vector<wxString> TranscriptionBubbleCtrl::GetSpeakerNames() const {
+    std::vector<wxString> names;
+    std::vector<bool> seen(m_speakerStyles.size(), false);
+    for (const auto& msg : m_messages) {
+        if (msg.speakerId >= 0 && msg.speakerId < static_cast<int>(seen.size()) && !seen[msg.speakerId]) {
+            seen[msg.speakerId] = true;
+            names.push_back(m_speakerStyles[msg.speakerId].name);
+        }
+    }
+    return names;
+}
+
+void TranscriptionBubbleCtrl::ScrollToMessage(int messageId) {
+    int index = FindMessageIndex(messageId);
+    if (index >= 0 && index < static_cast<int>(m_layouts.size())) {
+        // 消息顶部留出一个边距
+        SmoothScrollTo(m_layouts[index].bubbleRect.GetTop() - m_bubbleMargin);
+    }
+}
+
+void TranscriptionBubbleCtrl::SetAutoScroll(bool autoScroll) {
+    m_autoScroll = autoScroll;
+    m_followTail = autoScroll && IsScrolledToBottom();
+}
+
+int TranscriptionBubbleCtrl::GetScrollTop() const {
+    int viewStartX = 0, viewStartY = 0;
+    GetViewStart(&viewStartX, &viewStartY);
+    int pixelsPerUnitX = 1, pixelsPerUnitY = 1;
+    GetScrollPixelsPerUnit(&pixelsPerUnitX, &pixelsPerUnitY);
+    return viewStartY * std::max(pixelsPerUnitY, 1);
+}
+
+int TranscriptionBubbleCtrl::GetMaxScrollTop() const {
+    return std::max(0, m_virtualHeight - GetClientSize().GetHeight());
+}
+
+bool TranscriptionBubbleCtrl::IsScrolledToBottom() const {
+    return GetScrollTop() >= GetMaxScrollTop() - kFollowTailSlack;
+}
+
+void TranscriptionBubbleCtrl::ScrollToPixel(int y) {
+    int pixelsPerUnitX = 1, pixelsPerUnitY = 1;
+    GetScrollPixelsPerUnit(&pixelsPerUnitX, &pixelsPerUnitY);
+    y = std::max(0, std::min(y, GetMaxScrollTop()));
     
-    return color;
+    // Scroll 内部通过 ScrollWindow 移动已有内容，只使露出的区域失效
+    Scroll(-1, y / std::max(pixelsPerUnitY, 1));
 }
 
-void TranscriptionBubbleCtrl::HighlightMessage(int messageId, bool highlight) {
-    for (auto& msg : m_messages) {
-        if (msg.messageId == messageId) {
-            msg.isHighlighted = highlight;
-            Refresh();
-            break;
-        }
-    }
+void TranscriptionBubbleCtrl::ScrollToBottom() {
+    m_smoothScrollTimer.Stop();
+    ScrollToPixel(GetMaxScrollTop());
+    m_followTail = m_autoScroll;
 }
 
-std::vector<int> TranscriptionBubbleCtrl::SearchText(const wxString& searchText, bool caseSensitive) {
-    m_searchResults.clear();
-    
-    if (searchText.IsEmpty()) {
-        return m_searchResults;
+void TranscriptionBubbleCtrl::SmoothScrollTo(int y) {
+    m_smoothScrollTarget = std::max(0, std::min(y, GetMaxScrollTop()));
+    if (m_smoothScrollTarget == GetScrollTop()) {
+        return;
     }
     
-    wxString searchStr = caseSensitive ? searchText : searchText.Lower();
+    if (!m_smoothScrollTimer.IsRunning()) {
+        m_smoothScrollTimer.Start(kSmoothScrollInterval);
+    }
+}
+
+void TranscriptionBubbleCtrl::UpdateFollowTail() {
+    // 用户向上滚动时退出跟随，回到底部时重新跟随
+    m_followTail = m_autoScroll && IsScrolledToBottom();
+}
+
+void TranscriptionBubbleCtrl::OnSmoothScrollTimer(wxTimerEvent& event) {
+    int current = GetScrollTop();
+    int remaining = m_smoothScrollTarget - current;
     
-    for (const auto& msg : m_messages) {
-        wxString content = caseSensitive ? msg.content : msg.content.Lower();
-        if (content.Contains(searchStr)) {
-            m_searchResults.push_back(msg.messageId);
-        }
+    // 每帧移动剩余距离的三分之一，形成减速效果
+    int step = remaining / 3;
+    if (step == 0) {
+        step = remaining;
     }
+    ScrollToPixel(current + step);
     
-    return m_searchResults;
+    if (GetScrollTop() == current || GetScrollTop() == m_smoothScrollTarget) {
+        m_smoothScrollTimer.Stop();
+    }
+    UpdateFollowTail();
 }
 
-void TranscriptionBubbleCtrl::ScrollToMessage(int messageId) {
-    for (const auto& layout : m_layouts) {
-        if (layout.messageId == messageId) {
-            int y = layout.bubbleRect.GetTop();
-            Scroll(-1, y / 10);  // 除以滚动速率
-            break;
-        }
-    }
+void TranscriptionBubbleCtrl::OnScrollWin(wxScrollWinEvent& event) {
+    // 滚动条拖动等由基类处理，处理完成后再判断是否仍在底部
+    event.Skip();
+    m_smoothScrollTimer.Stop();
+    CallAfter(&TranscriptionBubbleCtrl::UpdateFollowTail);
 }
 
 wxString TranscriptionBubbleCtrl::ExportAsText() const {
     wxString text;
     
-    for (const auto& msg : m_messages) {
+    // 换出的页直接从分页文件读取
+    std::vector<std::wstring> page;
+    size_t loadedPage = kNoPage;
+    for (size_t i = 0; i < m_messages.size(); ++i) {
+        const TranscriptionMessage& msg = m_messages[i];
         text += wxString::Format(wxT("[%s] %s: %s\n"),
                                msg.timestamp.Format(wxT("%H:%M:%S")),
                                msg.speakerName,
-                               msg.content);
+                               wxString(ReadMessageText(i, page, loadedPage)));
     }
     
     return text;
 }
 
+bool TranscriptionBubbleCtrl::GetMessageAt(size_t index, TranscriptionMessage& msg) const {
+    if (index >= m_messages.size()) {
+        return false;
+    }
+    
+    msg = m_messages[index];
+    if (!IsPageResident(index / kPageMessages)) {
+        std::vector<std::wstring> page;
+        size_t loadedPage = kNoPage;
+        msg.content = wxString(ReadMessageText(index, page, loadedPage));
+    }
+    return true;
+}
+
+std::vector<TranscriptionMessage> TranscriptionBubbleCtrl::CopyMessages(size_t begin) const {
+    std::vector<TranscriptionMessage> messages;
+    if (begin >= m_messages.size()) {
+        return messages;
+    }
+    
+    messages.assign(m_messages.begin() + begin, m_messages.end());
+    std::vector<std::wstring> page;
+    size_t loadedPage = kNoPage;
+    for (size_t i = begin; i < m_messages.size(); ++i) {
+        if (!IsPageResident(i / kPageMessages)) {
+            messages[i - begin].content = wxString(ReadMessageText(i, page, loadedPage));
+        }
+    }
+    return messages;
+}
+
 void TranscriptionBubbleCtrl::OnPaint(wxPaintEvent& event) {
     wxAutoBufferedPaintDC dc(this);
     DoPrepareDC(dc);
@@ -213,21 +1495,48 @@ void TranscriptionBubbleCtrl::OnPaint(wxPaintEvent& event) {
     viewRect.x = viewX;
     viewRect.y = viewY;
     
-    // 绘制每个消息气泡
-    for (size_t i = 0; i < m_layouts.size(); ++i) {
+    // 布局按纵坐标有序，二分定位第一条可见消息，只绘制可见的消息
+    // 可见消息的文本先换入内存；批注只查询与可见消息时间段相交的部分
+    size_t first = FindFirstLayoutAt(viewRect.GetTop());
+    size_t last = first;
+    while (last < m_layouts.size() && m_layouts[last].bubbleRect.GetTop() <= viewRect.GetBottom()) {
+        ++last;
+    }
+    if (first < last) {
+        LoadMessageRange(first, last);
+        ScheduleEvictPages();
+        EnsureAnnotationWindow(first, last);
+    }
+    
+    std::vector<const InlineAnnotation*> annotations;
+    int currentHitId = m_currentSearchIndex >= 0 ? m_searchResults[m_currentSearchIndex] : -1;
+    for (size_t i = first; i < last; ++i) {
         const MessageLayout& layout = m_layouts[i];
         
-        // 只绘制可见的消息
-        if (layout.bubbleRect.Intersects(viewRect)) {
+        // 书签标签画在气泡右侧，判断可见性时一并计入
+        wxRect paintRect(0, layout.bubbleRect.y, GetClientSize().GetWidth(), layout.bubbleRect.height);
+        if (paintRect.Intersects(viewRect)) {
             const TranscriptionMessage& msg = m_messages[i];
+            CollectMessageAnnotations(i, annotations);
             bool isHovered = (m_hoveredMessage == static_cast<int>(i));
-            DrawMessageBubble(&dc, msg, layout.bubbleRect, isHovered);
+            bool isCurrentHit = (msg.messageId == currentHitId);
+            DrawMessageBubble(&dc, msg, layout.bubbleRect, layout.lineStarts, annotations,
+                              m_highlighted[i] || isCurrentHit, isHovered);
         }
     }
+    
+    if (m_hasLiveMessage && m_liveLayout.bubbleRect.Intersects(viewRect)) {
+        annotations.clear();
+        DrawMessageBubble(&dc, m_liveMessage, m_liveLayout.bubbleRect, m_liveLayout.lineStarts,
+                          annotations, false, false, true);
+    }
 }
 
 void TranscriptionBubbleCtrl::DrawMessageBubble(wxDC* dc, const TranscriptionMessage& msg,
-                                               const wxRect& bubbleRect, bool isHovered) {
+                                               const wxRect& bubbleRect,
+                                               const std::vector<int>& lineStarts,
+                                               const std::vector<const InlineAnnotation*>& annotations,
+                                               bool isHighlighted, bool isHovered, bool isLive) {
     // 设置抗锯齿
     wxGraphicsContext* gc = nullptr;
     
@@ -243,13 +1552,39 @@ void TranscriptionBubbleCtrl::DrawMessageBubble(wxDC* dc, const TranscriptionMes
         gc = wxGraphicsContext::Create(*winDC);
     }
     
+    wxRect contentRect(bubbleRect.x + m_bubblePadding,
+                      bubbleRect.y + m_bubblePadding,
+                      bubbleRect.width - m_bubblePadding * 2,
+                      bubbleRect.height - m_bubblePadding * 2);
+    
+    // 换行位置已在布局阶段算好，这里只按偏移切分文本
+    int lineHeight = m_metricsCache.GetLineHeight();
+    // 发言人颜色在绘制时查样式表，改色不需要更新消息
+    wxColour speakerColor = (msg.speakerId >= 0 && msg.speakerId < static_cast<int>(m_speakerStyles.size()))
+                                ? m_speakerStyles[msg.speakerId].color
+                                : GetSpeakerColor(msg.speakerName);
+    
+    auto lineText = [&msg, &lineStarts](size_t line) {
+        size_t begin = lineStarts[line];
+        size_t end = (line + 1 < lineStarts.size()) ? lineStarts[line + 1] : msg.content.length();
+        wxString text = msg.content.Mid(begin, end - begin);
+        text.Trim();
+        return text;
+    };
+    
     if (!gc) {
         // 如果无法创建图形上下文，使用普通DC
         // 绘制简单矩形气泡
-        dc->SetBrush(wxBrush(msg.isHighlighted ? m_highlightColor : wxColour(245, 255, 245)));
-        dc->SetPen(wxPen(wxColour(220, 220, 220), 1));
+        dc->SetBrush(wxBrush(isLive ? wxColour(250, 250, 250) :
+                             (isHighlighted ? m_highlightColor : wxColour(245, 255, 245))));
+        dc->SetPen(wxPen(wxColour(220, 220, 220), 1, isLive ? wxPENSTYLE_SHORT_DASH : wxPENSTYLE_SOLID));
         dc->DrawRoundedRectangle(bubbleRect, 5);
         
+        // 气泡左侧的发言人色条
+        dc->SetBrush(wxBrush(speakerColor));
+        dc->SetPen(*wxTRANSPARENT_PEN);
+        dc->DrawRectangle(bubbleRect.x + 1, bubbleRect.y + 5, 3, bubbleRect.height - 10);
+        
         // 绘制发言人和时间
         dc->SetFont(m_speakerFont);
         dc->SetTextForeground(wxColour(100, 100, 100));
@@ -260,56 +1595,32 @@ void TranscriptionBubbleCtrl::DrawMessageBubble(wxDC* dc, const TranscriptionMes
         
         // 绘制内容
         dc->SetFont(m_messageFont);
-        dc->SetTextForeground(m_textColor);
-        
-        wxRect contentRect(bubbleRect.x + m_bubblePadding,
-                          bubbleRect.y + m_bubblePadding,
-                          bubbleRect.width - m_bubblePadding * 2,
-                          bubbleRect.height - m_bubblePadding * 2);
+        DrawAnnotationSpans(dc, nullptr, msg, contentRect, lineStarts, annotations);
+        dc->SetTextForeground(isLive ? m_timestampColor : m_textColor);
         
-        // 自动换行绘制文本
-        wxString content = msg.content;
-        int lineHeight = dc->GetCharHeight();
         int y = contentRect.y;
-        
-        while (!content.IsEmpty() && y < contentRect.GetBottom()) {
-            wxString line;
-            int lineWidth = 0;
-            size_t pos = 0;
-            
-            while (pos < content.length()) {
-                wxString ch = content.Mid(pos, 1);
-                int charWidth = dc->GetTextExtent(ch).x;
-                
-                if (lineWidth + charWidth > contentRect.width) {
-                    break;
-                }
-                
-                line += ch;
-                lineWidth += charWidth;
-                pos++;
-            }
-            
-            if (!line.IsEmpty()) {
-                dc->DrawText(line, contentRect.x, y);
-                y += lineHeight;
-                content = content.Mid(pos);
-            } else {
-                break;
-            }
+        for (size_t line = 0; line < lineStarts.size() && y < contentRect.GetBottom(); ++line) {
+            dc->DrawText(lineText(line), contentRect.x, y);
+            y += lineHeight;
         }
+        
+        DrawAnnotationMarkers(dc, nullptr, bubbleRect, annotations);
         return;
     }
     
     // 使用图形上下文绘制更精美的效果
     // 绘制气泡背景 - 类似微信的样式
-    wxColour bubbleColor = msg.isHighlighted ? m_highlightColor : wxColour(245, 255, 245);
+    // 实时识别气泡使用浅色虚线边框和灰色文字，与正式消息区分
+    wxColour bubbleColor = isHighlighted ? m_highlightColor : wxColour(245, 255, 245);
+    if (isLive) {
+        bubbleColor = wxColour(250, 250, 250);
+    }
     if (isHovered) {
         bubbleColor = bubbleColor.ChangeLightness(98);
     }
     
     gc->SetBrush(gc->CreateBrush(wxBrush(bubbleColor)));
-    gc->SetPen(gc->CreatePen(wxPen(wxColour(220, 220, 220), 1)));
+    gc->SetPen(gc->CreatePen(wxPen(wxColour(220, 220, 220), 1, isLive ? wxPENSTYLE_SHORT_DASH : wxPENSTYLE_SOLID)));
     
     // 创建圆角矩形路径
     wxGraphicsPath path = gc->CreatePath();
@@ -332,6 +1643,11 @@ void TranscriptionBubbleCtrl::DrawMessageBubble(wxDC* dc, const TranscriptionMes
     
     gc->DrawPath(path);
     
+    // 气泡左侧的发言人色条
+    gc->SetBrush(gc->CreateBrush(wxBrush(speakerColor)));
+    gc->SetPen(*wxTRANSPARENT_PEN);
+    gc->DrawRectangle(x + 1, y + radius, 3, h - radius * 2);
+    
     // 在气泡左侧绘制发言人名称和时间
     gc->SetFont(m_speakerFont, wxColour(100, 100, 100));
     wxString speakerTime = wxString::Format(wxT("%s %s"), 
@@ -343,143 +1659,612 @@ void TranscriptionBubbleCtrl::DrawMessageBubble(wxDC* dc, const TranscriptionMes
     gc->DrawText(speakerTime, bubbleRect.x - textWidth - 15, bubbleRect.y + 5);
     
     // 绘制内容
-    gc->SetFont(m_messageFont, m_textColor);
-    
-    wxRect contentRect(bubbleRect.x + m_bubblePadding,
-                      bubbleRect.y + m_bubblePadding,
-                      bubbleRect.width - m_bubblePadding * 2,
-                      bubbleRect.height - m_bubblePadding * 2);
+    gc->SetFont(m_messageFont, isLive ? m_timestampColor : m_textColor);
+    DrawAnnotationSpans(dc, gc, msg, contentRect, lineStarts, annotations);
     
-    // 自动换行绘制文本
-    wxString content = msg.content;
-    double lineHeight = 0;
-    double tempWidth = 0;
-    gc->GetTextExtent(wxT("测试"), &tempWidth, &lineHeight);
     double currentY = contentRect.y;
+    for (size_t line = 0; line < lineStarts.size() && currentY < contentRect.GetBottom(); ++line) {
+        gc->DrawText(lineText(line), contentRect.x, currentY);
+        currentY += lineHeight;
+    }
+    
+    DrawAnnotationMarkers(dc, gc, bubbleRect, annotations);
+    
+    delete gc;
+}
+
+void TranscriptionBubbleCtrl::DrawAnnotationSpans(wxDC* dc, wxGraphicsContext* gc,
+                                                 const TranscriptionMessage& msg,
+                                                 const wxRect& contentRect,
+                                                 const std::vector<int>& lineStarts,
+                                                 const std::vector<const InlineAnnotation*>& annotations) {
+    int lineHeight = m_metricsCache.GetLineHeight();
+    auto textWidth = [dc, gc](const wxString& text) {
+        if (gc) {
+            double width = 0, height = 0;
+            gc->GetTextExtent(text, &width, &height);
+            return static_cast<int>(width);
+        }
+        return dc->GetTextExtent(text).x;
+    };
     
-    while (!content.IsEmpty() && currentY < contentRect.GetBottom()) {
-        wxString line;
-        double lineWidth = 0;
-        size_t pos = 0;
+    for (const InlineAnnotation* annotation : annotations) {
+        if (annotation->type != MeetAnt::AnnotationType::Highlight) {
+            continue;
+        }
         
-        while (pos < content.length()) {
-            wxString ch = content.Mid(pos, 1);
-            double charWidth = 0;
-            double charHeight = 0;
-            gc->GetTextExtent(ch, &charWidth, &charHeight);
+        // 高亮文本在消息中的位置；找不到时高亮整条消息
+        size_t spanBegin = 0;
+        size_t spanEnd = msg.content.length();
+        if (!annotation->text.IsEmpty()) {
+            size_t pos = msg.content.find(annotation->text);
+            if (pos != wxString::npos) {
+                spanBegin = pos;
+                spanEnd = pos + annotation->text.length();
+            }
+        }
+        
+        wxColour color = annotation->color.ChangeLightness(180);
+        if (gc) {
+            gc->SetBrush(gc->CreateBrush(wxBrush(color)));
+            gc->SetPen(*wxTRANSPARENT_PEN);
+        } else {
+            dc->SetBrush(wxBrush(color));
+            dc->SetPen(*wxTRANSPARENT_PEN);
+        }
+        
+        // 按行切分高亮范围，逐段绘制背景
+        for (size_t line = 0; line < lineStarts.size(); ++line) {
+            size_t lineBegin = lineStarts[line];
+            size_t lineEnd = (line + 1 < lineStarts.size()) ? lineStarts[line + 1] : msg.content.length();
+            size_t begin = std::max(lineBegin, spanBegin);
+            size_t end = std::min(lineEnd, spanEnd);
+            if (begin >= end) {
+                continue;
+            }
             
-            if (lineWidth + charWidth > contentRect.width) {
-                break;
+            int x = contentRect.x + textWidth(msg.content.Mid(lineBegin, begin - lineBegin));
+            int width = textWidth(msg.content.Mid(begin, end - begin));
+            int y = contentRect.y + static_cast<int>(line) * lineHeight;
+            if (gc) {
+                gc->DrawRectangle(x, y, width, lineHeight);
+            } else {
+                dc->DrawRectangle(x, y, width, lineHeight);
+            }
+        }
+    }
+}
+
+void TranscriptionBubbleCtrl::DrawAnnotationMarkers(wxDC* dc, wxGraphicsContext* gc,
+                                                   const wxRect& bubbleRect,
+                                                   const std::vector<const InlineAnnotation*>& annotations) {
+    int bookmarkY = bubbleRect.y + 6;
+    bool noteDrawn = false;
+    
+    for (const InlineAnnotation* annotation : annotations) {
+        if (annotation->type == MeetAnt::AnnotationType::Note && !noteDrawn) {
+            // 批注：气泡右上角的折角标记
+            int right = bubbleRect.GetRight();
+            wxPoint corner[3] = {
+                wxPoint(right - 10, bubbleRect.y),
+                wxPoint(right, bubbleRect.y),
+                wxPoint(right, bubbleRect.y + 10)
+            };
+            wxColour noteColor(255, 165, 0);
+            if (gc) {
+                wxGraphicsPath path = gc->CreatePath();
+                path.MoveToPoint(corner[0].x, corner[0].y);
+                path.AddLineToPoint(corner[1].x, corner[1].y);
+                path.AddLineToPoint(corner[2].x, corner[2].y);
+                path.CloseSubpath();
+                gc->SetBrush(gc->CreateBrush(wxBrush(noteColor)));
+                gc->SetPen(*wxTRANSPARENT_PEN);
+                gc->FillPath(path);
+            } else {
+                dc->SetBrush(wxBrush(noteColor));
+                dc->SetPen(*wxTRANSPARENT_PEN);
+                dc->DrawPolygon(3, corner);
             }
+            noteDrawn = true;
+        } else if (annotation->type == MeetAnt::AnnotationType::Bookmark) {
+            // 书签：气泡右侧的小旗和标签，多个书签依次向下排列
+            int poleX = bubbleRect.GetRight() + 8;
+            wxColour flagColor(200, 40, 40);
+            wxPoint flag[3] = {
+                wxPoint(poleX, bookmarkY),
+                wxPoint(poleX + 12, bookmarkY + 4),
+                wxPoint(poleX, bookmarkY + 8)
+            };
+            wxString label = annotation->label.IsEmpty() ? annotation->text : annotation->label;
             
-            line += ch;
-            lineWidth += charWidth;
-            pos++;
+            if (gc) {
+                gc->SetPen(gc->CreatePen(wxPen(flagColor, 1)));
+                gc->StrokeLine(poleX, bookmarkY, poleX, bookmarkY + 14);
+                wxGraphicsPath path = gc->CreatePath();
+                path.MoveToPoint(flag[0].x, flag[0].y);
+                path.AddLineToPoint(flag[1].x, flag[1].y);
+                path.AddLineToPoint(flag[2].x, flag[2].y);
+                path.CloseSubpath();
+                gc->SetBrush(gc->CreateBrush(wxBrush(flagColor)));
+                gc->FillPath(path);
+                if (!label.IsEmpty()) {
+                    gc->SetFont(m_timestampFont, flagColor);
+                    gc->DrawText(label.Left(12), poleX + 16, bookmarkY);
+                }
+            } else {
+                dc->SetPen(wxPen(flagColor, 1));
+                dc->DrawLine(poleX, bookmarkY, poleX, bookmarkY + 14);
+                dc->SetBrush(wxBrush(flagColor));
+                dc->DrawPolygon(3, flag);
+                if (!label.IsEmpty()) {
+                    dc->SetFont(m_timestampFont);
+                    dc->SetTextForeground(flagColor);
+                    dc->DrawText(label.Left(12), poleX + 16, bookmarkY);
+                }
+            }
+            bookmarkY += 18;
+        }
+    }
+}
+
+MeetAnt::TimeStamp TranscriptionBubbleCtrl::GetMessageTime(const TranscriptionMessage& msg) {
+    // 与批注使用相同的毫秒时间戳
+    return static_cast<MeetAnt::TimeStamp>(msg.timestamp.GetTicks()) * 1000;
+}
+
+void TranscriptionBubbleCtrl::SetAnnotationSource(const AnnotationSource& source) {
+    m_annotationSource = source;
+    InvalidateAnnotations();
+}
+
+void TranscriptionBubbleCtrl::InvalidateAnnotations() {
+    // 搜索分面要统计任意消息附近的批注，只保留所有批注的时间戳和类型
+    std::vector<MeetAnt::IntervalTree<MeetAnt::TimeStamp, MeetAnt::AnnotationType>::Entry> marks;
+    if (m_annotationSource) {
+        std::vector<MeetAnt::Annotation*> annotations =
+            m_annotationSource(std::numeric_limits<MeetAnt::TimeStamp>::min(),
+                               std::numeric_limits<MeetAnt::TimeStamp>::max());
+        marks.reserve(annotations.size());
+        for (const MeetAnt::Annotation* annotation : annotations) {
+            marks.push_back({annotation->GetTimestamp(), annotation->GetTimestamp(), annotation->GetType()});
         }
+    }
+    
+    {
+        // 后台搜索线程计算分面时会读取批注统计
+        wxCriticalSectionLocker lock(m_searchLock);
+        m_annotationMarks.Build(std::move(marks));
+    }
+    
+    // 内联批注在下次绘制时按可视范围重新查询
+    m_annotationWindowValid = false;
+    m_inlineAnnotations.clear();
+    m_annotationIndex.Clear();
+    Refresh();
+}
+
+MeetAnt::TimeStamp TranscriptionBubbleCtrl::GetMessageTimeEnd(size_t index) const {
+    MeetAnt::TimeStamp begin = GetMessageTime(m_messages[index]);
+    if (index + 1 < m_messages.size()) {
+        return std::max(begin, GetMessageTime(m_messages[index + 1]) - 1);
+    }
+    return std::numeric_limits<MeetAnt::TimeStamp>::max();
+}
+
+void TranscriptionBubbleCtrl::EnsureAnnotationWindow(size_t first, size_t last) {
+    if (first >= last || last > m_messages.size()) {
+        return;
+    }
+    
+    MeetAnt::TimeStamp begin = GetMessageTime(m_messages[first]);
+    MeetAnt::TimeStamp end = GetMessageTimeEnd(last - 1);
+    if (m_annotationWindowValid && begin >= m_annotationWindowBegin && end <= m_annotationWindowEnd) {
+        return;
+    }
+    
+    // 窗口向前后各多取一段，小幅滚动时不必重新查询
+    size_t windowFirst = first > kAnnotationWindowMargin ? first - kAnnotationWindowMargin : 0;
+    size_t windowLast = std::min(m_messages.size(), last + kAnnotationWindowMargin);
+    m_annotationWindowBegin = GetMessageTime(m_messages[windowFirst]);
+    m_annotationWindowEnd = GetMessageTimeEnd(windowLast - 1);
+    m_annotationWindowValid = true;
+    
+    std::vector<MeetAnt::Annotation*> annotations;
+    if (m_annotationSource) {
+        annotations = m_annotationSource(m_annotationWindowBegin, m_annotationWindowEnd);
+    }
+    
+    std::vector<InlineAnnotation> inlineAnnotations;
+    inlineAnnotations.reserve(annotations.size());
+    
+    std::vector<MeetAnt::IntervalTree<MeetAnt::TimeStamp, size_t>::Entry> entries;
+    entries.reserve(annotations.size());
+    
+    for (const MeetAnt::Annotation* annotation : annotations) {
+        InlineAnnotation item;
+        item.type = annotation->GetType();
+        item.timestamp = annotation->GetTimestamp();
+        item.text = annotation->GetContent();
         
-        if (!line.IsEmpty()) {
-            gc->DrawText(line, contentRect.x, currentY);
-            currentY += lineHeight;
-            content = content.Mid(pos);
-        } else {
-            break;
+        switch (item.type) {
+            case MeetAnt::AnnotationType::Highlight:
+                item.color = static_cast<const MeetAnt::HighlightAnnotation*>(annotation)->GetColor();
+                break;
+            case MeetAnt::AnnotationType::Note:
+                item.label = static_cast<const MeetAnt::NoteAnnotation*>(annotation)->GetTitle();
+                break;
+            case MeetAnt::AnnotationType::Bookmark:
+                item.label = static_cast<const MeetAnt::BookmarkAnnotation*>(annotation)->GetLabel();
+                break;
         }
+        
+        entries.push_back({item.timestamp, item.timestamp, inlineAnnotations.size()});
+        inlineAnnotations.push_back(item);
     }
     
-    delete gc;
+    m_inlineAnnotations.swap(inlineAnnotations);
+    m_annotationIndex.Build(std::move(entries));
 }
 
-void TranscriptionBubbleCtrl::CalculateLayout() {
-    m_layouts.clear();
+void TranscriptionBubbleCtrl::CollectMessageAnnotations(size_t index,
+                                                       std::vector<const InlineAnnotation*>& out) const {
+    out.clear();
+    if (m_annotationIndex.IsEmpty() || index >= m_messages.size()) {
+        return;
+    }
+    
+    // 消息覆盖从其时间戳到下一条消息之前的时间段，最后一条消息覆盖之后的所有时间
+    MeetAnt::TimeStamp begin = GetMessageTime(m_messages[index]);
+    MeetAnt::TimeStamp end = GetMessageTimeEnd(index);
+    
+    m_annotationIndex.Query(begin, end,
+        [this, &out](const MeetAnt::IntervalTree<MeetAnt::TimeStamp, size_t>::Entry& entry) {
+            out.push_back(&m_inlineAnnotations[entry.value]);
+        });
+}
+
+void TranscriptionBubbleCtrl::AccumulateSearchFacets(size_t index, MeetAnt::TimeStamp origin,
+                                                     TranscriptionSearchFacets& facets) const {
+    const TranscriptionMessage& msg = m_messages[index];
     
-    wxClientDC dc(this);
+    if (msg.speakerId >= 0) {
+        size_t speaker = static_cast<size_t>(msg.speakerId);
+        if (speaker >= facets.speakerHits.size()) {
+            facets.speakerHits.resize(speaker + 1, 0);
+        }
+        facets.speakerHits[speaker]++;
+    }
+    
+    MeetAnt::TimeStamp time = GetMessageTime(msg);
+    MeetAnt::TimeStamp offset = std::max<MeetAnt::TimeStamp>(0, time - origin);
+    size_t bucket = static_cast<size_t>(offset / TranscriptionSearchFacets::kTimeBucketLength);
+    if (bucket >= facets.timeBucketHits.size()) {
+        facets.timeBucketHits.resize(bucket + 1, 0);
+    }
+    facets.timeBucketHits[bucket]++;
+    facets.hitOffsets.push_back(offset);
+    
+    // 每类批注只计一次
+    bool nearby[MeetAnt::kAnnotationTypeCount] = {};
+    bool any = false;
+    m_annotationMarks.Query(time - TranscriptionSearchFacets::kAnnotationProximity,
+                            time + TranscriptionSearchFacets::kAnnotationProximity,
+        [&nearby, &any](const MeetAnt::IntervalTree<MeetAnt::TimeStamp, MeetAnt::AnnotationType>::Entry& entry) {
+            nearby[static_cast<size_t>(entry.value)] = true;
+            any = true;
+        });
+    for (size_t type = 0; type < MeetAnt::kAnnotationTypeCount; ++type) {
+        if (nearby[type]) {
+            facets.annotationHits[type]++;
+        }
+    }
+    if (!any) {
+        facets.unannotatedHits++;
+    }
+}
+
+int TranscriptionBubbleCtrl::GetContentAreaWidth() const {
     int clientWidth = GetClientSize().GetWidth();
+    return std::max(m_bubblePadding * 2 + 1,
+                    std::min(m_maxBubbleWidth, clientWidth - kLeftMargin - m_bubbleMargin * 2));
+}
+
+void TranscriptionBubbleCtrl::EnsureMetricsCache() {
+    if (!m_metricsCache.IsPrepared()) {
+        wxClientDC dc(this);
+        m_metricsCache.Prepare(dc, m_messageFont);
+    }
+}
+
+int TranscriptionBubbleCtrl::EstimateBubbleHeight(const TranscriptionMessage& msg) const {
+    int textWidth = m_layoutWidth - m_bubblePadding * 2;
+    int lines = m_metricsCache.EstimateLineCount(msg.content.wc_str(), msg.content.length(), textWidth);
+    int height = lines * m_metricsCache.GetLineHeight() + m_bubblePadding * 2;
+    return std::max(height, kMinBubbleHeight);
+}
+
+void TranscriptionBubbleCtrl::MeasureMessage(size_t index) {
+    if (!IsPageResident(index / kPageMessages)) {
+        LoadMessageRange(index, index + 1);
+        EvictPages();
+    }
+    
+    const TranscriptionMessage& msg = m_messages[index];
+    MessageLayout& layout = m_layouts[index];
+    
+    int textWidth = m_layoutWidth - m_bubblePadding * 2;
+    bool estimated = false;
+    layout.lineStarts = m_metricsCache.WrapText(msg.content.wc_str(), msg.content.length(),
+                                                textWidth, nullptr, &estimated);
+    
+    int height = static_cast<int>(layout.lineStarts.size()) * m_metricsCache.GetLineHeight() +
+                 m_bubblePadding * 2;
+    layout.bubbleRect = wxRect(kLeftMargin, layout.bubbleRect.y, m_layoutWidth,
+                               std::max(height, kMinBubbleHeight));
+    // 含估算字宽的消息在补测后需要重新测量
+    layout.measured = !estimated;
+}
+
+void TranscriptionBubbleCtrl::WrapMessage(size_t index) {
+    const TranscriptionMessage& msg = m_messages[index];
+    int textWidth = m_layoutWidth - m_bubblePadding * 2;
+    m_layouts[index].lineStarts = m_metricsCache.WrapText(msg.content.wc_str(), msg.content.length(), textWidth);
+}
+
+void TranscriptionBubbleCtrl::RecomputePositions(size_t fromIndex) {
     int y = m_bubbleMargin;
+    if (fromIndex > 0 && fromIndex <= m_layouts.size()) {
+        y = m_layouts[fromIndex - 1].bubbleRect.GetBottom() + 1 + m_bubbleMargin;
+    }
+    
+    for (size_t i = fromIndex; i < m_layouts.size(); ++i) {
+        m_layouts[i].bubbleRect.y = y;
+        y += m_layouts[i].bubbleRect.height + m_bubbleMargin;
+    }
+    
+    // 实时识别气泡紧跟在最后一条消息之后
+    if (m_hasLiveMessage) {
+        m_liveLayout.bubbleRect.y = y;
+        y += m_liveLayout.bubbleRect.height + m_bubbleMargin;
+    }
+    
+    m_virtualHeight = y;
+    SetVirtualSize(GetClientSize().GetWidth(), m_virtualHeight);
+}
+
+size_t TranscriptionBubbleCtrl::FindFirstLayoutAt(int y) const {
+    // 返回第一个底边不在 y 之上的布局
+    auto it = std::lower_bound(m_layouts.begin(), m_layouts.end(), y,
+                               [](const MessageLayout& layout, int value) {
+                                   return layout.bubbleRect.GetBottom() < value;
+                               });
+    return static_cast<size_t>(it - m_layouts.begin());
+}
+
+void TranscriptionBubbleCtrl::CalculateLayout() {
+    StopLayoutWorker();
+    m_layoutGeneration++;
+    
+    EnsureMetricsCache();
+    int previousWidth = m_layoutWidth;
+    m_layoutWidth = GetContentAreaWidth();
+    if (m_hasLiveMessage) {
+        MeasureLiveMessage();
+    }
+    
+    // 记住当前视口顶部的消息及其屏幕偏移，重新布局后保持不动
+    int viewTop = GetScrollTop();
+    int clientHeight = GetClientSize().GetHeight();
     
-    // 留出左侧空间用于显示发言人和时间
-    int leftMargin = 150;
+    bool followTail = m_autoScroll && (m_followTail || m_layouts.empty());
+    size_t anchorIndex = FindFirstLayoutAt(viewTop);
+    int anchorOffset = 0;
+    if (anchorIndex < m_layouts.size()) {
+        anchorOffset = m_layouts[anchorIndex].bubbleRect.y - viewTop;
+    } else {
+        anchorIndex = 0;
+    }
     
+    // 先用估算高度铺满所有消息，保证滚动条立即可用
+    // 文本已换出的消息按原来的行数和新旧宽度之比估算
+    std::vector<int> previousHeights;
+    if (m_layouts.size() == m_messages.size() && previousWidth > m_bubblePadding * 2) {
+        previousHeights.reserve(m_layouts.size());
+        for (const auto& layout : m_layouts) {
+            previousHeights.push_back(layout.bubbleRect.height);
+        }
+    }
+    int lineHeight = std::max(1, m_metricsCache.GetLineHeight());
+    m_layouts.assign(m_messages.size(), MessageLayout());
     for (size_t i = 0; i < m_messages.size(); ++i) {
-        const TranscriptionMessage& msg = m_messages[i];
-        MessageLayout layout;
-        layout.messageId = msg.messageId;
-        
-        // 计算内容区域的宽度
-        int contentAreaWidth = std::min(m_maxBubbleWidth, clientWidth - leftMargin - m_bubbleMargin * 2);
-        
-        // 计算内容高度
-        dc.SetFont(m_messageFont);
-        wxSize contentSize = CalculateTextSize(dc, msg.content, contentAreaWidth - m_bubblePadding * 2);
-        
-        // 计算实际需要的高度
-        int bubbleHeight = contentSize.y + m_bubblePadding * 2;
-        
-        // 确保最小高度
-        bubbleHeight = std::max(bubbleHeight, 40);
-        
-        // 设置气泡矩形
-        layout.bubbleRect = wxRect(leftMargin, y,
-                                 contentAreaWidth,
-                                 bubbleHeight);
+        int height = kMinBubbleHeight;
+        if (IsPageResident(i / kPageMessages)) {
+            height = EstimateBubbleHeight(m_messages[i]);
+        } else if (i < previousHeights.size()) {
+            long long lines = std::max(1, (previousHeights[i] - m_bubblePadding * 2) / lineHeight);
+            long long scaled = (lines * (previousWidth - m_bubblePadding * 2) +
+                                m_layoutWidth - m_bubblePadding * 2 - 1) /
+                               std::max(1, m_layoutWidth - m_bubblePadding * 2);
+            height = std::max(static_cast<int>(scaled) * lineHeight + m_bubblePadding * 2, kMinBubbleHeight);
+        }
+        m_layouts[i].messageId = m_messages[i].messageId;
+        m_layouts[i].bubbleRect = wxRect(kLeftMargin, 0, m_layoutWidth, height);
+    }
+    
+    // 消息不多时直接全部测量
+    if (m_messages.size() <= kSyncLayoutLimit) {
+        for (size_t i = 0; i < m_layouts.size(); ++i) {
+            MeasureMessage(i);
+        }
+        RecomputePositions(0);
         
-        m_layouts.push_back(layout);
-        y += bubbleHeight + m_bubbleMargin;
+        wxClientDC dc(this);
+        if (m_metricsCache.MeasurePending(dc)) {
+            for (size_t i = 0; i < m_layouts.size(); ++i) {
+                MeasureMessage(i);
+            }
+            RecomputePositions(0);
+        }
+        return;
     }
     
-    m_virtualHeight = y;
-    SetVirtualSize(clientWidth, m_virtualHeight);
+    // 确定视口覆盖的消息范围：跟随尾部时为最后一屏，否则从锚点开始的一屏
+    size_t viewportBegin = anchorIndex;
+    size_t viewportEnd = anchorIndex;
+    if (followTail) {
+        viewportEnd = m_layouts.size();
+        viewportBegin = viewportEnd;
+        int covered = 0;
+        while (viewportBegin > 0 && covered < clientHeight) {
+            viewportBegin--;
+            MeasureMessage(viewportBegin);
+            covered += m_layouts[viewportBegin].bubbleRect.height + m_bubbleMargin;
+        }
+    } else {
+        int covered = 0;
+        while (viewportEnd < m_layouts.size() && covered < clientHeight) {
+            MeasureMessage(viewportEnd);
+            covered += m_layouts[viewportEnd].bubbleRect.height + m_bubbleMargin;
+            viewportEnd++;
+        }
+    }
+    RecomputePositions(0);
+    
+    if (followTail) {
+        ScrollToBottom();
+    } else if (anchorIndex < m_layouts.size()) {
+        ScrollToPixel(m_layouts[anchorIndex].bubbleRect.y - anchorOffset);
+    }
+    
+    // 其余消息交给后台线程：先处理视口之后的，再处理视口之前的
+    StartLayoutWorker(viewportBegin, viewportEnd);
+}
+
+void TranscriptionBubbleCtrl::StartLayoutWorker(size_t skipBegin, size_t skipEnd) {
+    std::vector<std::pair<size_t, size_t>> ranges;
+    if (skipEnd < m_messages.size()) {
+        ranges.emplace_back(skipEnd, m_messages.size());
+    }
+    if (skipBegin > 0) {
+        ranges.emplace_back(0, skipBegin);
+    }
+    if (ranges.empty()) {
+        return;
+    }
+    
+    // 工作线程逐页读取文本，不复制整份转录
+    m_layoutWorker = new LayoutWorker(this, m_layoutGeneration,
+                                      m_layoutWidth - m_bubblePadding * 2,
+                                      m_metricsCache.GetLineHeight(), m_bubblePadding,
+                                      std::move(ranges));
+    if (m_layoutWorker->Run() != wxTHREAD_NO_ERROR) {
+        wxLogError(wxT("无法启动布局线程"));
+        delete m_layoutWorker;
+        m_layoutWorker = nullptr;
+        
+        // 退化为同步布局
+        for (size_t i = 0; i < m_layouts.size(); ++i) {
+            if (!m_layouts[i].measured) {
+                MeasureMessage(i);
+            }
+        }
+        RecomputePositions(0);
+    }
+}
+
+void TranscriptionBubbleCtrl::StopLayoutWorker() {
+    if (m_layoutWorker) {
+        m_layoutWorker->RequestStop();
+        m_layoutWorker->Wait();
+        delete m_layoutWorker;
+        m_layoutWorker = nullptr;
+    }
 }
 
-wxSize TranscriptionBubbleCtrl::CalculateTextSize(wxDC& dc, const wxString& text, int maxWidth) {
-    int width = 0;
-    int height = 0;
-    int lineHeight = dc.GetCharHeight();
+void TranscriptionBubbleCtrl::OnLayoutChunk(wxThreadEvent& event) {
+    auto chunk = event.GetPayload<std::shared_ptr<LayoutChunk>>();
+    
+    // 丢弃过期布局代数的结果
+    if (!chunk || chunk->generation != m_layoutGeneration) {
+        return;
+    }
+    
+    size_t first = chunk->firstIndex;
+    size_t count = chunk->heights.size();
+    if (first + count > m_layouts.size()) {
+        return;
+    }
     
-    wxString remaining = text;
+    int viewTop = GetScrollTop();
+    size_t anchorIndex = FindFirstLayoutAt(viewTop);
+    int anchorOffset = anchorIndex < m_layouts.size() ? m_layouts[anchorIndex].bubbleRect.y - viewTop : 0;
+    bool atBottom = IsFollowingTail();
     
-    while (!remaining.IsEmpty()) {
-        wxString line;
-        int lineWidth = 0;
-        size_t pos = 0;
+    bool heightChanged = false;
+    for (size_t k = 0; k < count; ++k) {
+        MessageLayout& layout = m_layouts[first + k];
+        if (layout.measured) {
+            continue;
+        }
+        if (layout.bubbleRect.height != chunk->heights[k]) {
+            heightChanged = true;
+        }
+        layout.bubbleRect.height = chunk->heights[k];
+        // 文本已换出的消息不保留换行结果，换入时重新换行
+        if (IsPageResident((first + k) / kPageMessages)) {
+            layout.lineStarts = std::move(chunk->lineStarts[k]);
+        }
+        // 含估算字宽的消息在最后统一补测
+        layout.measured = !chunk->estimated[k];
+    }
+    
+    if (heightChanged) {
+        RecomputePositions(first);
+    }
+    
+    if (chunk->isLast) {
+        StopLayoutWorker();
         
-        // 找到适合当前行的文本
-        while (pos < remaining.length()) {
-            wxString ch = remaining.Mid(pos, 1);
-            int charWidth = dc.GetTextExtent(ch).x;
-            
-            if (lineWidth + charWidth > maxWidth) {
-                // 如果是中文或其他可以断开的字符，可以在此处断开
-                if (pos > 0) {
-                    break;
+        wxClientDC dc(this);
+        if (m_metricsCache.MeasurePending(dc)) {
+            for (size_t i = 0; i < m_layouts.size(); ++i) {
+                if (!m_layouts[i].measured) {
+                    MeasureMessage(i);
                 }
-                // 如果第一个字符就超宽，至少要包含这个字符
-                pos++;
-                break;
             }
-            
-            line += ch;
-            lineWidth += charWidth;
-            pos++;
         }
-        
-        if (!line.IsEmpty()) {
-            width = std::max(width, lineWidth);
-            height += lineHeight;
-            remaining = remaining.Mid(pos);
-        } else if (pos > 0) {
-            // 处理单个字符超宽的情况
-            remaining = remaining.Mid(1);
-            height += lineHeight;
-        } else {
-            break;
+        for (auto& layout : m_layouts) {
+            layout.measured = true;
         }
+        RecomputePositions(0);
+        heightChanged = true;
+    }
+    
+    if (!heightChanged) {
+        return;
     }
     
-    return wxSize(width, height);
+    // 保持视口内容稳定：跟随尾部或维持锚点消息的屏幕位置
+    // 此时上方内容的坐标已整体移动，滚动时移动的旧像素不可用，需要整体重绘
+    if (atBottom) {
+        ScrollToBottom();
+        Refresh();
+    } else if (anchorIndex < m_layouts.size()) {
+        int y = m_layouts[anchorIndex].bubbleRect.y - anchorOffset;
+        if (y != viewTop) {
+            ScrollToPixel(y);
+            Refresh();
+        } else if (first <= anchorIndex + 1 || chunk->isLast) {
+            Refresh();
+        }
+    }
 }
 
 void TranscriptionBubbleCtrl::OnSize(wxSizeEvent& event) {
-    CalculateLayout();
+    // 只有内容宽度变化才需要重新换行
+    if (GetContentAreaWidth() != m_layoutWidth) {
+        CalculateLayout();
+    }
     event.Skip();
 }
 
@@ -490,9 +2275,10 @@ void TranscriptionBubbleCtrl::OnMouseWheel(wxMouseEvent& event) {
     int lines = -rotation / delta * event.GetLinesPerAction();
     
     if (event.GetWheelAxis() == wxMOUSE_WHEEL_VERTICAL) {
-        int x, y;
-        GetViewStart(&x, &y);
-        Scroll(x, y + lines);
+        // 连续滚动时在当前目标上累加，动画过程中不丢失滚动量
+        int from = m_smoothScrollTimer.IsRunning() ? m_smoothScrollTarget : GetScrollTop();
+        SmoothScrollTo(from + lines * m_metricsCache.GetLineHeight());
+        UpdateFollowTail();
     }
 }
 
@@ -548,11 +2334,10 @@ int TranscriptionBubbleCtrl::GetMessageAtPoint(const wxPoint& pt) const {
     const_cast<TranscriptionBubbleCtrl*>(this)->CalcUnscrolledPosition(pt.x, pt.y, &x, &y);
     wxPoint unscrolledPt(x, y);
     
-    // 查找包含该点的消息
-    for (size_t i = 0; i < m_layouts.size(); ++i) {
-        if (m_layouts[i].bubbleRect.Contains(unscrolledPt)) {
-            return static_cast<int>(i);
-        }
+    // 二分查找包含该点的消息
+    size_t i = FindFirstLayoutAt(y);
+    if (i < m_layouts.size() && m_layouts[i].bubbleRect.Contains(unscrolledPt)) {
+        return static_cast<int>(i);
     }
     
     return -1;
@@ -4,25 +4,70 @@
 #include <wx/wx.h>
 #include <wx/scrolwin.h>
 #include <wx/datetime.h>
+#include <wx/thread.h>
+#include <wx/timer.h>
+#include <wx/graphics.h>
+#include <wx/hashmap.h>
 #include <vector>
 #include <map>
 #include <memory>
+#include <functional>
+#include <unordered_map>
+#include "FontMetricsCache.h"
+#include "Annotation.h"
+#include "IntervalTree.h"
+#include "SearchIndex.h"
+#include "RegexSearch.h"
+#include "FuzzySearch.h"
+#include "TranscriptPageFile.h"
 
 // 转录消息结构
 struct TranscriptionMessage {
     wxString speakerName;      // 发言人名称
     wxString content;          // 发言内容
     wxDateTime timestamp;      // 时间戳
-    wxColour speakerColor;     // 发言人对应的颜色
-    bool isHighlighted;        // 是否高亮
+    int speakerId;             // 发言人ID，绘制时通过控件的发言人样式表解析颜色
     int messageId;             // 消息ID，用于定位和引用
     
-    TranscriptionMessage() : isHighlighted(false), messageId(0) {}
+    TranscriptionMessage() : speakerId(-1), messageId(0) {}
+};
+
+// 转录搜索方式
+enum class TranscriptionSearchMode {
+    Text,       // 子串，双引号括起时为短语
+    Regex,      // 正则表达式
+    Fuzzy       // 拼音模糊匹配（同音、近音字）
+};
+
+// 会话内搜索结果的分面统计，在校验命中的同一趟中逐条累加，以命中的消息为单位计数
+struct TranscriptionSearchFacets {
+    static constexpr MeetAnt::TimeStamp kTimeBucketLength = 5 * 60 * 1000;    // 时间桶长度（5 分钟）
+    static constexpr MeetAnt::TimeStamp kAnnotationProximity = 30 * 1000;     // 消息前后多远内的批注算作“附近”
+    
+    std::vector<size_t> speakerHits;                      // 发言人ID -> 命中消息数
+    std::vector<size_t> timeBucketHits;                   // 自首条消息起每 5 分钟一个桶
+    size_t annotationHits[MeetAnt::kAnnotationTypeCount]; // 附近有该类批注的命中消息数（按 AnnotationType 索引）
+    size_t unannotatedHits;                               // 附近没有任何批注的命中消息数
+    std::vector<MeetAnt::TimeStamp> hitOffsets;           // 每条命中消息相对首条消息的时间（毫秒），用于绘制命中密度
+    
+    TranscriptionSearchFacets();
+    void Clear();
+    void Merge(const TranscriptionSearchFacets& other);
 };
 
 // 自定义转录气泡控件
+// 消息的发言人、时间和ID始终在内存中；文本按页（连续 256 条消息）换入换出，
+// 只有可视区域附近最近用到的几页留在内存中，其余页写入临时的分页文件（见 TranscriptPageFile）。
+// 内联批注也只查询可视区域附近的时间段，打开很长的会话时内存占用取决于屏幕上的内容。
 class TranscriptionBubbleCtrl : public wxScrolledWindow {
 public:
+    // 内联批注的来源：返回时间戳在 [begin, end] 内的批注
+    typedef std::function<std::vector<MeetAnt::Annotation*>(MeetAnt::TimeStamp begin,
+                                                            MeetAnt::TimeStamp end)> AnnotationSource;
+    
+    // 读取消息的函数（如解码会话的转录），在后台线程中调用，读取失败时返回 false
+    typedef std::function<bool(std::vector<TranscriptionMessage>& messages)> MessageLoader;
+    
     TranscriptionBubbleCtrl(wxWindow* parent, wxWindowID id = wxID_ANY,
                            const wxPoint& pos = wxDefaultPosition,
                            const wxSize& size = wxDefaultSize,
@@ -34,6 +79,40 @@ public:
     void AddMessage(const wxString& speaker, const wxString& content, 
                    const wxDateTime& timestamp = wxDateTime::Now());
     
+    // 更新末尾的实时识别气泡（非最终结果），只重新布局并重绘该气泡
+    void SetLiveMessage(const wxString& speaker, const wxString& content,
+                        const wxDateTime& timestamp = wxDateTime::Now());
+    
+    // 将实时识别气泡转为正式消息，finalContent 为空时沿用当前识别文本
+    // 返回新消息的ID，没有实时气泡时返回 -1
+    int CommitLiveMessage(const wxString& finalContent = wxEmptyString);
+    
+    // 丢弃实时识别气泡
+    void ClearLiveMessage();
+    
+    // 是否存在实时识别气泡
+    bool HasLiveMessage() const { return m_hasLiveMessage; }
+    
+    // 批量载入消息（用于加载会话），替换现有内容
+    // 可视区域同步布局，其余消息在后台线程中测量并逐步更新滚动范围；
+    // 布局后只保留可视区域附近几页的文本，其余页换出到分页文件
+    void SetMessages(std::vector<TranscriptionMessage> messages);
+    
+    // 清空控件后在后台线程中读取消息，立即返回（用于打开会话，不在UI线程中解码转录）
+    // 读取成功时与 SetMessages 相同地载入；完成后向父窗口发送 wxEVT_TRANSCRIPTION_LOADED
+    // 读完之前控件为空：追加消息和实时气泡之前先等待读取完成，新消息排在读到的消息之后
+    // 读取函数不能中途取消，读完之前清空或替换消息时等它结束，丢弃结果
+    void LoadMessages(const MessageLoader& loader);
+    
+    // 是否仍在后台读取消息
+    bool IsLoadPending() const { return m_loadWorker != nullptr; }
+    
+    // 等待后台读取完成并立即载入（用于必须读到全部消息才能继续的场合），没有读取时什么也不做
+    void FinishLoad();
+    
+    // 是否仍有消息在后台布局中
+    bool IsLayoutPending() const { return m_layoutWorker != nullptr; }
+    
     // 清空所有消息
     void Clear();
     
@@ -46,20 +125,90 @@ public:
     // 高亮指定消息
     void HighlightMessage(int messageId, bool highlight = true);
     
-    // 搜索文本
-    std::vector<int> SearchText(const wxString& searchText, bool caseSensitive = false);
+    // 消息是否处于高亮状态
+    bool IsMessageHighlighted(int messageId) const;
+    
+    // 搜索文本，返回按位置排序的消息ID；用双引号括起时按短语（整词）匹配
+    // 同步补齐全文索引（逐页读取文本）后搜索；StartSearch 在后台线程中补齐
+    // mode 选择子串、正则或拼音模糊匹配；speaker 非空时只搜索该发言人的消息
+    // 查询无效（如正则表达式有误）时返回空结果，错误信息见 GetLastSearchError
+    std::vector<int> SearchText(const wxString& searchText, bool caseSensitive = false,
+                                TranscriptionSearchMode mode = TranscriptionSearchMode::Text,
+                                const wxString& speaker = wxEmptyString);
+    
+    // 在后台线程中搜索，立即返回；之前未完成的搜索被取消
+    // 结果分批追加，每批到达和搜索结束时向父窗口发送 wxEVT_TRANSCRIPTION_SEARCH_UPDATED，
+    // 第一批结果到达时自动定位到第一个命中
+    // 查询在取消或被新搜索取代之前一直有效：之后追加的消息只对它单独求值，
+    // 命中追加到结果末尾并同样发送 wxEVT_TRANSCRIPTION_SEARCH_UPDATED
+    void StartSearch(const wxString& searchText, bool caseSensitive = false,
+                     TranscriptionSearchMode mode = TranscriptionSearchMode::Text,
+                     const wxString& speaker = wxEmptyString);
+    
+    // 取消搜索并清空结果
+    void CancelSearch();
+    
+    // 后台搜索是否仍在进行
+    bool IsSearchPending() const { return m_searchWorker != nullptr; }
+    
+    // 搜索结果数量和当前命中在结果中的序号（没有时为 -1）
+    size_t GetSearchResultCount() const { return m_searchResults.size(); }
+    int GetCurrentSearchResult() const { return m_currentSearchIndex; }
+    
+    // 跳转到下一个/上一个命中（到末尾后回绕），返回其消息ID，没有结果时返回 -1
+    int GotoNextSearchResult();
+    int GotoPreviousSearchResult();
+    
+    // 最近一次搜索的错误信息（正则表达式无效等），没有错误时为空
+    const wxString& GetLastSearchError() const { return m_lastSearchError; }
+    
+    // 当前搜索结果的分面统计，随结果分批更新
+    const TranscriptionSearchFacets& GetSearchFacets() const { return m_searchFacets; }
+    
+    // 跳转到相对首条消息 offset 毫秒处之后的第一个命中（之后没有命中时取最后一个），返回其消息ID
+    int GotoSearchResultAt(MeetAnt::TimeStamp offset);
+    
+    // 发言人ID对应的名称，ID无效时为空
+    wxString GetSpeakerName(int speakerId) const;
+    
+    // 当前消息中出现过的发言人（按首次出现的顺序）
+    std::vector<wxString> GetSpeakerNames() const;
     
     // 滚动到指定消息
     void ScrollToMessage(int messageId);
     
-    // 获取所有消息
-    const std::vector<TranscriptionMessage>& GetMessages() const { return m_messages; }
+    // 消息数
+    size_t GetMessageCount() const { return m_messages.size(); }
+    
+    // 第 index 条消息的ID和时间戳，不读取文本；index 必须有效
+    int GetMessageId(size_t index) const { return m_messages[index].messageId; }
+    const wxDateTime& GetMessageTimestamp(size_t index) const { return m_messages[index].timestamp; }
+    
+    // 读取第 index 条消息（含文本）；文本已换出时从分页文件读取，不换入内存
+    // index 无效时返回 false
+    bool GetMessageAt(size_t index, TranscriptionMessage& msg) const;
+    
+    // 复制从 begin 开始的所有消息（含文本），用于保存、导出和建立索引
+    std::vector<TranscriptionMessage> CopyMessages(size_t begin = 0) const;
+    
+    // 根据消息ID求消息索引（消息ID在列表中连续递增），找不到时返回 -1
+    int FindMessageIndex(int messageId) const;
+    
+    // 设置需要在气泡上内联显示的批注（高亮、批注标记、书签旗标）的来源
+    // 绘制时只查询可视消息前后一段时间内的批注，复制其内容并按时间戳建立区间索引
+    void SetAnnotationSource(const AnnotationSource& source);
+    
+    // 批注有变化：重新统计搜索分面用的批注时间和类型，内联批注在下次绘制时重新查询
+    void InvalidateAnnotations();
     
     // 设置是否显示时间戳
     void ShowTimestamps(bool show) { m_showTimestamps = show; Refresh(); }
     
-    // 设置是否自动滚动到底部
-    void SetAutoScroll(bool autoScroll) { m_autoScroll = autoScroll; }
+    // 设置是否自动滚动到底部（跟随尾部）
+    void SetAutoScroll(bool autoScroll);
+    
+    // 当前是否正在跟随尾部：用户向上滚动时自动退出，回到底部时重新进入
+    bool IsFollowingTail() const { return m_autoScroll && m_followTail; }
     
     // 导出为文本
     wxString ExportAsText() const;
@@ -74,28 +223,197 @@ protected:
     void OnMouseMotion(wxMouseEvent& event);
     void OnEraseBackground(wxEraseEvent& event);
     
+    void OnLoadDone(wxThreadEvent& event);
+    void OnLayoutChunk(wxThreadEvent& event);
+    void OnSearchChunk(wxThreadEvent& event);
+    void OnScrollWin(wxScrollWinEvent& event);
+    void OnSmoothScrollTimer(wxTimerEvent& event);
+    
     // 计算布局
     void CalculateLayout();
     
+    // 内联显示的批注
+    struct InlineAnnotation {
+        MeetAnt::AnnotationType type;
+        MeetAnt::TimeStamp timestamp;   // 批注时间戳（毫秒）
+        wxString text;                  // 高亮文本或批注内容
+        wxString label;                 // 批注标题或书签标签
+        wxColour color;                 // 高亮颜色
+    };
+    
     // 绘制单个消息气泡
     void DrawMessageBubble(wxDC* dc, const TranscriptionMessage& msg, 
-                          const wxRect& bubbleRect, bool isHovered);
+                          const wxRect& bubbleRect, const std::vector<int>& lineStarts,
+                          const std::vector<const InlineAnnotation*>& annotations,
+                          bool isHighlighted, bool isHovered, bool isLive = false);
+    
+    // 绘制高亮批注的文字背景（在文字之前绘制）
+    void DrawAnnotationSpans(wxDC* dc, wxGraphicsContext* gc, const TranscriptionMessage& msg,
+                             const wxRect& contentRect, const std::vector<int>& lineStarts,
+                             const std::vector<const InlineAnnotation*>& annotations);
+    
+    // 绘制批注标记和书签旗标（在文字之后绘制）
+    void DrawAnnotationMarkers(wxDC* dc, wxGraphicsContext* gc, const wxRect& bubbleRect,
+                               const std::vector<const InlineAnnotation*>& annotations);
+    
+    // 查询与消息时间段相交的批注，消息须在已查询的批注窗口内
+    void CollectMessageAnnotations(size_t index, std::vector<const InlineAnnotation*>& out) const;
+    
+    // 消息覆盖的时间段的终点：下一条消息之前，最后一条消息覆盖之后的所有时间
+    MeetAnt::TimeStamp GetMessageTimeEnd(size_t index) const;
+    
+    // 确保可视消息 [first, last) 的时间段在已查询的批注窗口内，否则向批注来源重新查询
+    void EnsureAnnotationWindow(size_t first, size_t last);
+    
+    // 把第 index 条消息计入搜索分面；origin 为首条消息的时间戳
+    // 后台搜索线程持有 m_searchLock 时调用
+    void AccumulateSearchFacets(size_t index, MeetAnt::TimeStamp origin,
+                                TranscriptionSearchFacets& facets) const;
     
-    // 计算文本大小
-    wxSize CalculateTextSize(wxDC& dc, const wxString& text, int maxWidth);
+    // 消息时间戳（毫秒，与批注一致）
+    static MeetAnt::TimeStamp GetMessageTime(const TranscriptionMessage& msg);
+    
+    // 使用字体度量缓存同步测量单条消息（文本已换出时先换入）
+    void MeasureMessage(size_t index);
+    
+    // 按当前宽度重新为消息换行，不改变气泡高度（用于换入的页）
+    void WrapMessage(size_t index);
+    
+    // 根据字数估算气泡高度（用于尚未测量的消息）
+    int EstimateBubbleHeight(const TranscriptionMessage& msg) const;
+    
+    // 从指定索引开始重新计算各气泡的纵向位置和虚拟高度
+    void RecomputePositions(size_t fromIndex);
+    
+    // 内容区域宽度
+    int GetContentAreaWidth() const;
+    
+    // 确保字体度量缓存已就绪
+    void EnsureMetricsCache();
+    
+    // 启动/停止后台布局线程
+    void StartLayoutWorker(size_t skipBegin, size_t skipEnd);
+    void StopLayoutWorker();
+    
+    // 等待后台读取线程结束，丢弃读到的消息
+    void StopLoadWorker();
+    
+    // 通知父窗口后台读取已完成
+    void NotifyLoaded(bool loaded);
+    
+    // 停止后台搜索线程，丢弃尚未送达的结果
+    void StopSearchWorker();
+    
+    // 定位到第 resultIndex 个搜索结果
+    int GotoSearchResult(int resultIndex);
+    
+    // 通知父窗口搜索结果有变化
+    void NotifySearchUpdated(bool finished);
+    
+    // 按当前内容宽度为实时气泡换行并计算高度
+    void MeasureLiveMessage();
+    
+    // 重绘气泡所在的整行（包括左侧的发言人和时间）
+    void RefreshBubbleRow(const wxRect& bubbleRect);
+    
+    // 滚动位置（像素）
+    int GetScrollTop() const;
+    int GetMaxScrollTop() const;
+    bool IsScrolledToBottom() const;
+    
+    // 立即滚动到指定像素位置，已有内容通过 ScrollWindow 移动
+    void ScrollToPixel(int y);
+    void ScrollToBottom();
+    
+    // 动画滚动到指定像素位置
+    void SmoothScrollTo(int y);
+    
+    // 根据当前滚动位置更新跟随尾部状态
+    void UpdateFollowTail();
+    
+    // 查找纵坐标 y 处或其后的第一个布局索引
+    size_t FindFirstLayoutAt(int y) const;
     
     // 获取鼠标位置对应的消息索引
     int GetMessageAtPoint(const wxPoint& pt) const;
     
     // 生成发言人默认颜色
-    wxColour GenerateSpeakerColor(const wxString& speaker);
+    wxColour GenerateSpeakerColor(const wxString& speaker) const;
+    
+    // 获取发言人ID，首次出现时登记到样式表
+    int InternSpeaker(const wxString& speaker);
+    
+    // 重绘可视区域内指定发言人的气泡
+    void RefreshSpeakerRows(int speakerId);
+    
+    // 消息文本分页
+    // 第 page 页的文本是否在内存中
+    bool IsPageResident(size_t page) const {
+        return page < m_pageLastUse.size() && m_pageLastUse[page] != 0;
+    }
+    
+    // 换入消息 [begin, end) 所在的页并记为最近使用，不换出；调用者随后换出多出的页
+    void LoadMessageRange(size_t begin, size_t end);
+    
+    // 可视区域内的页记为最近使用，换出多出的页
+    void TrimToVisiblePages();
+    
+    // 从分页文件读回一页文本
+    void LoadPage(size_t page);
+    
+    // 常驻页超过上限时换出最久未用的页（先写入分页文件，再清空文本和换行结果）
+    void EvictPages();
+    // 在当前事件处理完之后执行一次 EvictPages，绘制中只读取分页文件，不写入
+    void ScheduleEvictPages();
+    
+    // 追加一条消息并维护全文索引和分页
+    void AppendMessage(const TranscriptionMessage& msg);
+    
+    // 读取一页的文本：已写入分页文件的页从文件读取，其余从内存复制
+    // 可在后台线程中调用，读取内存时持有 m_searchLock
+    bool ReadPageText(size_t page, std::vector<std::wstring>& contents) const;
+    
+    // 按页读取第 index 条消息的文本：page/loadedPage 缓存最近读取的一页，顺序读取时每页只读一次
+    // 可在后台线程中调用
+    const std::wstring& ReadMessageText(size_t index, std::vector<std::wstring>& page,
+                                        size_t& loadedPage) const;
+    
+    // 把索引还没有的消息补进全文索引，直到索引包含前 limit 条消息：逐页读取文本，换出的页不换入内存
+    // 可在后台线程中调用，修改索引时持有 m_searchLock；stopRequested 返回 true 时中途停止并返回 false，
+    // 已补进的消息留在索引中，下次接着补
+    bool ExtendSearchIndex(size_t limit, const std::function<bool()>& stopRequested);
     
 private:
     // 消息数据
     std::vector<TranscriptionMessage> m_messages;
     
-    // 发言人颜色映射
-    std::map<wxString, wxColour> m_speakerColors;
+    // 发言人样式表：消息只保存发言人ID，颜色在绘制时查表
+    struct SpeakerStyle {
+        wxString name;          // 发言人名称
+        wxColour color;         // 发言人颜色
+    };
+    std::vector<SpeakerStyle> m_speakerStyles;
+    std::unordered_map<wxString, int, wxStringHash, wxStringEqual> m_speakerIds;
+    
+    // 按消息位置索引的高亮位图
+    std::vector<bool> m_highlighted;
+    
+    // 消息文本分页：每页最近一次用到的序号，0 表示文本已换出
+    MeetAnt::TranscriptPageFile m_pageFile;
+    std::vector<uint64_t> m_pageLastUse;
+    uint64_t m_pageClock;
+    bool m_evictPending;        // 已安排换出，尚未执行
+    
+    // 内联批注来源，以及当前批注窗口 [begin, end] 内的批注和它们的时间戳区间索引
+    AnnotationSource m_annotationSource;
+    std::vector<InlineAnnotation> m_inlineAnnotations;
+    MeetAnt::IntervalTree<MeetAnt::TimeStamp, size_t> m_annotationIndex;
+    bool m_annotationWindowValid;
+    MeetAnt::TimeStamp m_annotationWindowBegin;
+    MeetAnt::TimeStamp m_annotationWindowEnd;
+    
+    // 会话所有批注的时间戳和类型，供搜索分面统计
+    MeetAnt::IntervalTree<MeetAnt::TimeStamp, MeetAnt::AnnotationType> m_annotationMarks;
     
     // 消息布局信息
     struct MessageLayout {
@@ -104,12 +422,38 @@ private:
         wxRect avatarRect;      // 头像矩形
         wxRect timestampRect;   // 时间戳矩形
         int messageId;          // 对应的消息ID
+        std::vector<int> lineStarts; // 内容每行的起始偏移
+        bool measured;          // 是否已精确测量（否则为估算高度）
+        
+        MessageLayout() : messageId(0), measured(false) {}
     };
     std::vector<MessageLayout> m_layouts;
     
+    // 实时识别气泡，始终位于所有消息之后，不计入 m_messages
+    TranscriptionMessage m_liveMessage;
+    MessageLayout m_liveLayout;
+    bool m_hasLiveMessage;
+    
+    // 字体度量缓存（UI线程写入，布局线程只读）
+    FontMetricsCache m_metricsCache;
+    
+    // 后台读取线程
+    class LoadWorker;
+    friend class LoadWorker;
+    LoadWorker* m_loadWorker;
+    int m_loadGeneration;       // 读取代数，用于丢弃过期的完成通知
+    
+    // 后台布局线程
+    class LayoutWorker;
+    friend class LayoutWorker;
+    LayoutWorker* m_layoutWorker;
+    int m_layoutGeneration;     // 布局代数，用于丢弃过期的后台结果
+    int m_layoutWidth;          // 当前布局使用的内容区域宽度
+    
     // 控件设置
     bool m_showTimestamps;      // 是否显示时间戳
     bool m_autoScroll;          // 是否自动滚动
+    bool m_followTail;          // 是否正在跟随尾部
     int m_bubbleMargin;         // 气泡边距
     int m_bubblePadding;        // 气泡内边距
     int m_maxBubbleWidth;       // 最大气泡宽度
@@ -132,9 +476,39 @@ private:
     wxFont m_speakerFont;
     wxFont m_timestampFont;
     
+    // 全文索引，文档序号与消息位置一致，包含前 GetDocumentCount() 条消息
+    // 由搜索线程在搜索前补齐；已包含全部消息时，新消息在追加时直接加入
+    // 只保存倒排表，候选消息用 ReadMessageText 读出原文校验，不在内存中另存一份文本
+    MeetAnt::SearchIndex m_searchIndex;
+    
     // 搜索结果
     std::vector<int> m_searchResults;
     int m_currentSearchIndex;
+    wxString m_lastSearchError;
+    TranscriptionSearchFacets m_searchFacets;
+    
+    // 后台搜索线程；它读取索引、消息和批注统计时持有 m_searchLock，
+    // UI线程追加消息、换入换出文本和替换批注统计时也需持有，替换或清空消息前先停止线程
+    // 后台布局线程读取未写入分页文件的文本时同样持有 m_searchLock
+    class SearchWorker;
+    friend class SearchWorker;
+    SearchWorker* m_searchWorker;
+    int m_searchGeneration;     // 搜索代数，用于丢弃过期的后台结果
+    mutable wxCriticalSection m_searchLock;
+    
+    // 常驻查询：最近一次会话内搜索的已编译查询，与后台搜索线程共用
+    class CompiledQuery;
+    std::shared_ptr<const CompiledQuery> m_standingQuery;
+    std::vector<int> m_standingHits;                // 后台搜索结束前新消息中的命中，结束时追加到结果末尾
+    TranscriptionSearchFacets m_standingFacets;
+    
+    // 编译查询；搜索文本为空、发言人不存在或查询无效时返回空，正则错误记入 m_lastSearchError
+    std::shared_ptr<const CompiledQuery> CompileQuery(const wxString& searchText, bool caseSensitive,
+                                                      TranscriptionSearchMode mode, const wxString& speaker);
+    void ResetStandingQuery();
+    
+    // 对新追加的第 index 条消息求值常驻查询，命中时并入结果
+    void EvaluateStandingQuery(size_t index);
     
     // 消息ID计数器
     int m_nextMessageId;
@@ -142,6 +516,10 @@ private:
     // 虚拟高度（用于滚动）
     int m_virtualHeight;
     
+    // 平滑滚动
+    wxTimer m_smoothScrollTimer;
+    int m_smoothScrollTarget;   // 平滑滚动的目标位置（像素）
+    
     // 默认颜色列表
     static const std::vector<wxColour> s_defaultColors;
     
@@ -151,5 +529,9 @@ private:
 // 自定义事件
 wxDECLARE_EVENT(wxEVT_TRANSCRIPTION_MESSAGE_CLICKED, wxCommandEvent);
 wxDECLARE_EVENT(wxEVT_TRANSCRIPTION_MESSAGE_RIGHT_CLICKED, wxCommandEvent);
+// 后台搜索结果有更新：GetInt() 为结果数，GetExtraLong() 非零表示搜索已结束，GetString() 为错误信息
+wxDECLARE_EVENT(wxEVT_TRANSCRIPTION_SEARCH_UPDATED, wxCommandEvent);
+// 后台读取消息已完成（见 LoadMessages）：GetInt() 非零表示读取成功，消息已载入
+wxDECLARE_EVENT(wxEVT_TRANSCRIPTION_LOADED, wxCommandEvent);
 
 #endif // TRANSCRIPTION_BUBBLE_CTRL_H 
\ No newline at end of file
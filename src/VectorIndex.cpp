@@ -0,0 +1,440 @@
+#include "VectorIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MEETANT_VECTOR_X64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define MEETANT_VECTOR_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC/Clang 需要为单个函数打开 AVX2/FMA 指令集，MSVC 不需要
+#if defined(MEETANT_VECTOR_X64) && (defined(__GNUC__) || defined(__clang__))
+#define MEETANT_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define MEETANT_TARGET_AVX2
+#endif
+
+namespace MeetAnt {
+
+namespace {
+    // 序列化格式：文件头之后依次为编号、向量、质心和每条向量所属的列表
+    struct SerializedHeader {
+        char magic[4];          // "MAVX"
+        uint32_t version;
+        uint32_t dimension;
+        uint32_t count;
+        uint32_t listCount;
+        uint32_t reserved;
+        uint64_t tag;
+    };
+    static_assert(sizeof(SerializedHeader) == 32, "SerializedHeader layout");
+
+    const char kMagic[4] = { 'M', 'A', 'V', 'X' };
+    const uint32_t kVersion = 1;
+
+    typedef float (*DotFunction)(const float*, const float*, size_t);
+
+#if !defined(MEETANT_VECTOR_X64) && !defined(MEETANT_VECTOR_NEON)
+    float DotScalar(const float* a, const float* b, size_t dimension) {
+        float sum = 0.0f;
+        for (size_t i = 0; i < dimension; ++i) {
+            sum += a[i] * b[i];
+        }
+        return sum;
+    }
+#endif
+
+#ifdef MEETANT_VECTOR_X64
+    float DotSse(const float* a, const float* b, size_t dimension) {
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= dimension; i += 8) {
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+        __m128 sum = _mm_add_ps(sum0, sum1);
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        float result = _mm_cvtss_f32(sum);
+        for (; i < dimension; ++i) {
+            result += a[i] * b[i];
+        }
+        return result;
+    }
+
+    MEETANT_TARGET_AVX2 float DotAvx2(const float* a, const float* b, size_t dimension) {
+        // 两路累加器掩盖 FMA 的延迟
+        __m256 sum0 = _mm256_setzero_ps();
+        __m256 sum1 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= dimension; i += 16) {
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+            sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), sum1);
+        }
+        for (; i + 8 <= dimension; i += 8) {
+            sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+        }
+        sum0 = _mm256_add_ps(sum0, sum1);
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum0), _mm256_extractf128_ps(sum0, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        float result = _mm_cvtss_f32(sum);
+        for (; i < dimension; ++i) {
+            result += a[i] * b[i];
+        }
+        return result;
+    }
+
+    bool CpuHasAvx2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        // 操作系统须保存 YMM 寄存器状态
+        if (!fma || !osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+#endif
+
+#ifdef MEETANT_VECTOR_NEON
+    float DotNeon(const float* a, const float* b, size_t dimension) {
+        float32x4_t sum0 = vdupq_n_f32(0.0f);
+        float32x4_t sum1 = vdupq_n_f32(0.0f);
+        size_t i = 0;
+        for (; i + 8 <= dimension; i += 8) {
+            sum0 = vmlaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+            sum1 = vmlaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        }
+        float32x4_t sum = vaddq_f32(sum0, sum1);
+        float32x2_t half = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+        float result = vget_lane_f32(vpadd_f32(half, half), 0);
+        for (; i < dimension; ++i) {
+            result += a[i] * b[i];
+        }
+        return result;
+    }
+#endif
+
+    DotFunction SelectDotFunction() {
+#if defined(MEETANT_VECTOR_X64)
+        return CpuHasAvx2() ? DotAvx2 : DotSse;
+#elif defined(MEETANT_VECTOR_NEON)
+        return DotNeon;
+#else
+        return DotScalar;
+#endif
+    }
+
+    // 首次使用时检测一次 CPU 特性
+    DotFunction GetDotFunction() {
+        static const DotFunction function = SelectDotFunction();
+        return function;
+    }
+
+    // 小顶堆：堆顶是当前第 k 名，得分更高的结果替换它
+    bool HeapOrder(const VectorMatch& a, const VectorMatch& b) {
+        return a.score > b.score;
+    }
+
+    void PushCandidate(std::vector<VectorMatch>& heap, size_t k, uint32_t id, float score) {
+        if (heap.size() < k) {
+            heap.push_back(VectorMatch{id, score});
+            std::push_heap(heap.begin(), heap.end(), HeapOrder);
+        } else if (score > heap.front().score) {
+            std::pop_heap(heap.begin(), heap.end(), HeapOrder);
+            heap.back() = VectorMatch{id, score};
+            std::push_heap(heap.begin(), heap.end(), HeapOrder);
+        }
+    }
+
+    void SortMatches(std::vector<VectorMatch>& matches) {
+        std::sort(matches.begin(), matches.end(), [](const VectorMatch& a, const VectorMatch& b) {
+            return a.score > b.score || (a.score == b.score && a.id < b.id);
+        });
+    }
+}
+
+float DotProduct(const float* a, const float* b, size_t dimension) {
+    return GetDotFunction()(a, b, dimension);
+}
+
+void NormalizeVector(float* vector, size_t dimension) {
+    float norm = std::sqrt(DotProduct(vector, vector, dimension));
+    if (norm > 0.0f) {
+        for (size_t i = 0; i < dimension; ++i) {
+            vector[i] /= norm;
+        }
+    }
+}
+
+VectorIndex::VectorIndex(size_t dimension)
+    : m_dimension(dimension) {
+}
+
+void VectorIndex::Reset(size_t dimension) {
+    m_dimension = dimension;
+    m_ids.clear();
+    m_vectors.clear();
+    m_centroids.clear();
+    m_lists.clear();
+}
+
+void VectorIndex::Add(uint32_t id, const float* vector) {
+    uint32_t row = static_cast<uint32_t>(m_ids.size());
+    m_ids.push_back(id);
+    m_vectors.insert(m_vectors.end(), vector, vector + m_dimension);
+    if (!m_lists.empty()) {
+        m_lists[NearestCentroid(vector)].push_back(row);
+    }
+}
+
+void VectorIndex::BuildClusters(size_t listCount, size_t iterations) {
+    size_t count = GetCount();
+    listCount = std::min(listCount, count);
+    ClearClusters();
+    if (listCount < 2 || m_dimension == 0) {
+        return;
+    }
+
+    // 等间隔抽样作为训练集，再从训练集中等间隔取初始质心
+    size_t sampleCount = std::min(count, listCount * kTrainSamplesPerList);
+    std::vector<uint32_t> samples(sampleCount);
+    for (size_t i = 0; i < sampleCount; ++i) {
+        samples[i] = static_cast<uint32_t>(i * count / sampleCount);
+    }
+
+    m_centroids.resize(listCount * m_dimension);
+    for (size_t c = 0; c < listCount; ++c) {
+        const float* source = &m_vectors[static_cast<size_t>(samples[c * sampleCount / listCount]) * m_dimension];
+        std::copy(source, source + m_dimension, &m_centroids[c * m_dimension]);
+    }
+    m_lists.resize(listCount);
+
+    // 球面 k-means：按内积分配，质心取均值后重新归一化
+    std::vector<float> sums(listCount * m_dimension);
+    std::vector<size_t> sizes(listCount);
+    for (size_t iteration = 0; iteration < iterations; ++iteration) {
+        std::fill(sums.begin(), sums.end(), 0.0f);
+        std::fill(sizes.begin(), sizes.end(), 0);
+        for (uint32_t row : samples) {
+            const float* vector = &m_vectors[static_cast<size_t>(row) * m_dimension];
+            size_t c = NearestCentroid(vector);
+            float* sum = &sums[c * m_dimension];
+            for (size_t d = 0; d < m_dimension; ++d) {
+                sum[d] += vector[d];
+            }
+            sizes[c]++;
+        }
+        for (size_t c = 0; c < listCount; ++c) {
+            if (sizes[c] == 0) {
+                continue;   // 空簇保留原质心
+            }
+            float* centroid = &m_centroids[c * m_dimension];
+            std::copy(&sums[c * m_dimension], &sums[c * m_dimension] + m_dimension, centroid);
+            NormalizeVector(centroid, m_dimension);
+        }
+    }
+
+    for (size_t row = 0; row < count; ++row) {
+        m_lists[NearestCentroid(&m_vectors[row * m_dimension])].push_back(static_cast<uint32_t>(row));
+    }
+}
+
+void VectorIndex::ClearClusters() {
+    m_centroids.clear();
+    m_lists.clear();
+}
+
+size_t VectorIndex::NearestCentroid(const float* vector) const {
+    DotFunction dot = GetDotFunction();
+    size_t best = 0;
+    float bestScore = -std::numeric_limits<float>::infinity();
+    for (size_t c = 0; c < m_lists.size(); ++c) {
+        float score = dot(vector, &m_centroids[c * m_dimension], m_dimension);
+        if (score > bestScore) {
+            bestScore = score;
+            best = c;
+        }
+    }
+    return best;
+}
+
+std::vector<VectorMatch> VectorIndex::Search(const float* query, size_t k, size_t probeCount) const {
+    std::vector<VectorMatch> heap;
+    if (k == 0 || m_ids.empty()) {
+        return heap;
+    }
+    heap.reserve(k);
+
+    if (m_lists.empty()) {
+        ScanAll(query, k, heap);
+        SortMatches(heap);
+        return heap;
+    }
+
+    // 先选出最近的若干个质心，再只扫描它们的列表
+    if (probeCount == 0) {
+        probeCount = kDefaultProbeCount;
+    }
+    std::vector<VectorMatch> probes;
+    probes.reserve(probeCount);
+    DotFunction dot = GetDotFunction();
+    for (size_t c = 0; c < m_lists.size(); ++c) {
+        PushCandidate(probes, probeCount, static_cast<uint32_t>(c),
+                      dot(query, &m_centroids[c * m_dimension], m_dimension));
+    }
+    for (const auto& probe : probes) {
+        const std::vector<uint32_t>& rows = m_lists[probe.id];
+        ScanRows(query, rows.data(), rows.size(), k, heap);
+    }
+    SortMatches(heap);
+    return heap;
+}
+
+std::vector<VectorMatch> VectorIndex::SearchExact(const float* query, size_t k) const {
+    std::vector<VectorMatch> heap;
+    if (k == 0 || m_ids.empty()) {
+        return heap;
+    }
+    heap.reserve(k);
+    ScanAll(query, k, heap);
+    SortMatches(heap);
+    return heap;
+}
+
+void VectorIndex::ScanRows(const float* query, const uint32_t* rows, size_t rowCount, size_t k,
+                           std::vector<VectorMatch>& heap) const {
+    DotFunction dot = GetDotFunction();
+    for (size_t i = 0; i < rowCount; ++i) {
+        uint32_t row = rows[i];
+        float score = dot(query, &m_vectors[static_cast<size_t>(row) * m_dimension], m_dimension);
+        PushCandidate(heap, k, m_ids[row], score);
+    }
+}
+
+void VectorIndex::ScanAll(const float* query, size_t k, std::vector<VectorMatch>& heap) const {
+    DotFunction dot = GetDotFunction();
+    const float* vector = m_vectors.data();
+    for (size_t row = 0; row < m_ids.size(); ++row, vector += m_dimension) {
+        PushCandidate(heap, k, m_ids[row], dot(query, vector, m_dimension));
+    }
+}
+
+void VectorIndex::Serialize(std::string& out, uint64_t tag) const {
+    SerializedHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.dimension = static_cast<uint32_t>(m_dimension);
+    header.count = static_cast<uint32_t>(m_ids.size());
+    header.listCount = static_cast<uint32_t>(m_lists.size());
+    header.reserved = 0;
+    header.tag = tag;
+
+    std::vector<uint32_t> assignments;
+    if (!m_lists.empty()) {
+        assignments.resize(m_ids.size());
+        for (size_t c = 0; c < m_lists.size(); ++c) {
+            for (uint32_t row : m_lists[c]) {
+                assignments[row] = static_cast<uint32_t>(c);
+            }
+        }
+    }
+
+    out.clear();
+    out.reserve(sizeof(header) + m_ids.size() * sizeof(uint32_t) + m_vectors.size() * sizeof(float) +
+                m_centroids.size() * sizeof(float) + assignments.size() * sizeof(uint32_t));
+    out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.append(reinterpret_cast<const char*>(m_ids.data()), m_ids.size() * sizeof(uint32_t));
+    out.append(reinterpret_cast<const char*>(m_vectors.data()), m_vectors.size() * sizeof(float));
+    out.append(reinterpret_cast<const char*>(m_centroids.data()), m_centroids.size() * sizeof(float));
+    out.append(reinterpret_cast<const char*>(assignments.data()), assignments.size() * sizeof(uint32_t));
+}
+
+bool VectorIndex::Deserialize(const void* data, size_t size, uint64_t* tag) {
+    SerializedHeader header;
+    if (size < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.dimension == 0 || (header.listCount > 0 && header.listCount > header.count)) {
+        return false;
+    }
+
+    // 以 64 位计算各段长度，防止损坏的文件头导致溢出
+    uint64_t dimension = header.dimension;
+    uint64_t expected = sizeof(header) +
+                        uint64_t(header.count) * sizeof(uint32_t) +
+                        uint64_t(header.count) * dimension * sizeof(float) +
+                        uint64_t(header.listCount) * dimension * sizeof(float) +
+                        (header.listCount > 0 ? uint64_t(header.count) * sizeof(uint32_t) : 0);
+    if (expected != size) {
+        return false;
+    }
+
+    const char* cursor = static_cast<const char*>(data) + sizeof(header);
+    Reset(header.dimension);
+    m_ids.resize(header.count);
+    std::memcpy(m_ids.data(), cursor, m_ids.size() * sizeof(uint32_t));
+    cursor += m_ids.size() * sizeof(uint32_t);
+
+    m_vectors.resize(static_cast<size_t>(header.count) * m_dimension);
+    std::memcpy(m_vectors.data(), cursor, m_vectors.size() * sizeof(float));
+    cursor += m_vectors.size() * sizeof(float);
+
+    if (header.listCount > 0) {
+        m_centroids.resize(static_cast<size_t>(header.listCount) * m_dimension);
+        std::memcpy(m_centroids.data(), cursor, m_centroids.size() * sizeof(float));
+        cursor += m_centroids.size() * sizeof(float);
+
+        m_lists.resize(header.listCount);
+        for (uint32_t row = 0; row < header.count; ++row) {
+            uint32_t list;
+            std::memcpy(&list, cursor + row * sizeof(uint32_t), sizeof(list));
+            if (list >= header.listCount) {
+                Reset(header.dimension);
+                return false;
+            }
+            m_lists[list].push_back(row);
+        }
+    }
+
+    if (tag) {
+        *tag = header.tag;
+    }
+    return true;
+}
+
+size_t VectorIndex::GetMemoryUsage() const {
+    size_t bytes = m_ids.capacity() * sizeof(uint32_t) +
+                   m_vectors.capacity() * sizeof(float) +
+                   m_centroids.capacity() * sizeof(float);
+    for (const auto& list : m_lists) {
+        bytes += sizeof(list) + list.capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+} // namespace MeetAnt
@@ -0,0 +1,88 @@
+#ifndef MEETANT_VECTOR_INDEX_H
+#define MEETANT_VECTOR_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MeetAnt {
+
+// 两个向量的内积，按 CPU 支持情况使用 AVX2/FMA、SSE 或 NEON
+float DotProduct(const float* a, const float* b, size_t dimension);
+
+// 把向量归一化为单位长度（零向量保持不变）
+void NormalizeVector(float* vector, size_t dimension);
+
+// 一条近邻结果
+struct VectorMatch {
+    uint32_t id;        // 添加向量时给出的编号（消息序号）
+    float score;        // 与查询向量的内积，单位向量时即余弦相似度
+};
+
+// 句向量索引
+// 向量连续存放在一块内存中，默认对全部向量做暴力内积（flat）。
+// 调用 BuildClusters 后用 k-means 质心把向量分到若干倒排列表（IVF），
+// 查询时只扫描与查询最接近的几个列表；之后添加的向量直接归入最近的质心。
+class VectorIndex {
+public:
+    explicit VectorIndex(size_t dimension = 0);
+
+    // 清空并设置维度
+    void Reset(size_t dimension);
+
+    size_t GetDimension() const { return m_dimension; }
+    size_t GetCount() const { return m_ids.size(); }
+    size_t GetListCount() const { return m_lists.size(); }
+    bool HasClusters() const { return !m_lists.empty(); }
+
+    // 第 row 条向量的编号（按添加顺序）
+    uint32_t GetId(size_t row) const { return m_ids[row]; }
+
+    // 追加一条向量（应已归一化）
+    void Add(uint32_t id, const float* vector);
+
+    // 用 k-means 训练 listCount 个质心并重新分配全部向量
+    // 训练样本最多取每个质心 kTrainSamplesPerList 条，避免大索引上耗时过长
+    void BuildClusters(size_t listCount, size_t iterations = 10);
+
+    // 去掉聚类，退回暴力搜索
+    void ClearClusters();
+
+    // 返回内积最大的 k 条结果（按得分降序）
+    // 有聚类时扫描最近的 probeCount 个列表，probeCount 为 0 时使用 kDefaultProbeCount
+    std::vector<VectorMatch> Search(const float* query, size_t k, size_t probeCount = 0) const;
+
+    // 暴力搜索全部向量，用于评估 IVF 的召回率
+    std::vector<VectorMatch> SearchExact(const float* query, size_t k) const;
+
+    // 序列化为字节串 / 从字节串恢复（格式见 VectorIndex.cpp）
+    // tag 由调用者定义（例如模型标识），随索引一起保存
+    void Serialize(std::string& out, uint64_t tag = 0) const;
+    bool Deserialize(const void* data, size_t size, uint64_t* tag = nullptr);
+
+    // 估算占用的内存（字节）
+    size_t GetMemoryUsage() const;
+
+    static const size_t kTrainSamplesPerList = 64;
+    static const size_t kDefaultProbeCount = 8;
+
+private:
+    // 与 vector 最接近的质心
+    size_t NearestCentroid(const float* vector) const;
+
+    // 在若干行中收集得分最高的 k 条
+    void ScanRows(const float* query, const uint32_t* rows, size_t rowCount, size_t k,
+                  std::vector<VectorMatch>& heap) const;
+    void ScanAll(const float* query, size_t k, std::vector<VectorMatch>& heap) const;
+
+    size_t m_dimension;
+    std::vector<uint32_t> m_ids;
+    std::vector<float> m_vectors;                 // GetCount() * m_dimension
+    std::vector<float> m_centroids;               // GetListCount() * m_dimension
+    std::vector<std::vector<uint32_t>> m_lists;   // 每个质心下的行号
+};
+
+} // namespace MeetAnt
+
+#endif // MEETANT_VECTOR_INDEX_H
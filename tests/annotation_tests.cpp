@@ -0,0 +1,504 @@
+// 批注存储的单元测试
+// 覆盖批注的二进制编码、按时间和类型的查询索引、旧版本文本文件（竖线分隔的快照和文本日志）的迁移、
+// 日志末尾写了一半的记录、压缩前后不变的编号，以及从会话归档中加载。每个测试在临时目录中读写，失败时打印位置并以非零值退出。
+
+#include "Annotation.h"
+#include "AnnotationJournal.h"
+#include "RecordCodec.h"
+#include <wx/init.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using MeetAnt::Annotation;
+using MeetAnt::AnnotationManager;
+using MeetAnt::AnnotationType;
+using MeetAnt::BookmarkAnnotation;
+using MeetAnt::HighlightAnnotation;
+using MeetAnt::NoteAnnotation;
+
+namespace {
+    int s_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: 检查失败: %s\n", __FILE__, __LINE__, #condition); \
+            s_failures++; \
+        } \
+    } while (0)
+
+    const wxString kSession = wxT("session");
+
+    // 临时的会话目录，析构时删除
+    class TempSessionDir {
+    public:
+        TempSessionDir() {
+            m_path = wxFileName::CreateTempFileName(wxT("meetant_annotation_tests"));
+            wxRemoveFile(m_path);
+            wxMkdir(m_path);
+        }
+        ~TempSessionDir() { wxFileName::Rmdir(m_path, wxPATH_RMDIR_RECURSIVE); }
+
+        const wxString& GetPath() const { return m_path; }
+
+    private:
+        wxString m_path;
+    };
+
+    bool WriteFile(const wxString& path, const std::string& data) {
+        wxFile file;
+        return file.Create(path, true) && file.Write(data.data(), data.size()) == data.size();
+    }
+
+    std::string ReadFile(const wxString& path) {
+        wxFile file;
+        std::string data;
+        if (file.Open(path) && file.Length() > 0) {
+            data.resize(static_cast<size_t>(file.Length()));
+            if (file.Read(&data[0], data.size()) != static_cast<ssize_t>(data.size())) {
+                data.clear();
+            }
+        }
+        return data;
+    }
+
+    NoteAnnotation* GetNote(AnnotationManager& manager, size_t index) {
+        std::vector<Annotation*> notes = manager.GetAnnotationsByType(kSession, AnnotationType::Note);
+        return index < notes.size() ? static_cast<NoteAnnotation*>(notes[index]) : nullptr;
+    }
+
+    void TestEncodeRoundTrip() {
+        // 内容中的竖线和换行原样保留，不需要转义
+        NoteAnnotation note(kSession, 1500, wxT("预算|审批\n下周完成\r\n"), wxT("标题|二\n"));
+        std::string data;
+        note.Encode(data);
+        std::unique_ptr<Annotation> decoded = Annotation::Decode(data.data(), data.size());
+        CHECK(decoded && decoded->GetType() == AnnotationType::Note);
+        if (decoded && decoded->GetType() == AnnotationType::Note) {
+            NoteAnnotation* decodedNote = static_cast<NoteAnnotation*>(decoded.get());
+            CHECK(decodedNote->GetSessionId() == kSession);
+            CHECK(decodedNote->GetTimestamp() == 1500);
+            CHECK(decodedNote->GetContent() == note.GetContent());
+            CHECK(decodedNote->GetTitle() == note.GetTitle());
+        }
+
+        BookmarkAnnotation bookmark(kSession, 42, wxT("a|b"), wxT("c\nd"));
+        data.clear();
+        bookmark.Encode(data);
+        decoded = Annotation::Decode(data.data(), data.size());
+        CHECK(decoded && decoded->GetType() == AnnotationType::Bookmark);
+        if (decoded && decoded->GetType() == AnnotationType::Bookmark) {
+            CHECK(decoded->GetContent() == wxT("a|b"));
+            CHECK(static_cast<BookmarkAnnotation*>(decoded.get())->GetLabel() == wxT("c\nd"));
+        }
+
+        HighlightAnnotation highlight(kSession, 7, wxT("|\n|"), wxColour(10, 20, 30));
+        data.clear();
+        highlight.Encode(data);
+        decoded = Annotation::Decode(data.data(), data.size());
+        CHECK(decoded && decoded->GetType() == AnnotationType::Highlight);
+        if (decoded && decoded->GetType() == AnnotationType::Highlight) {
+            CHECK(decoded->GetContent() == wxT("|\n|"));
+            CHECK(static_cast<HighlightAnnotation*>(decoded.get())->GetColor() == wxColour(10, 20, 30));
+        }
+
+        // 不完整的数据不解码
+        for (size_t size = 0; size < data.size(); ++size) {
+            CHECK(!Annotation::Decode(data.data(), size));
+        }
+    }
+
+    // 批注内容依次拼接，用来比较查询结果的顺序
+    wxString JoinContents(const std::vector<Annotation*>& annotations) {
+        wxString joined;
+        for (const Annotation* annotation : annotations) {
+            joined += annotation->GetContent();
+        }
+        return joined;
+    }
+
+    // 按时间的索引、按类型的索引和批注数三者一致
+    void CheckIndexesConsistent(AnnotationManager& manager) {
+        std::vector<Annotation*> byTime = manager.GetAnnotationsByTimeRange(kSession, 0, 1000000);
+        CHECK(byTime.size() == manager.GetAnnotationCount(kSession));
+        for (size_t i = 1; i < byTime.size(); ++i) {
+            CHECK(byTime[i - 1]->GetTimestamp() <= byTime[i]->GetTimestamp());
+        }
+
+        size_t typed = 0;
+        const AnnotationType types[] = { AnnotationType::Note, AnnotationType::Bookmark, AnnotationType::Highlight };
+        for (AnnotationType type : types) {
+            std::vector<Annotation*> list = manager.GetAnnotationsByType(kSession, type);
+            for (Annotation* annotation : list) {
+                CHECK(annotation->GetType() == type);
+                CHECK(std::find(byTime.begin(), byTime.end(), annotation) != byTime.end());
+            }
+            typed += list.size();
+        }
+        CHECK(typed == byTime.size());
+    }
+
+    void TestTimeRangeQuery() {
+        // 添加顺序与时间顺序不同，200 上有两条批注
+        AnnotationManager manager;
+        manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 400, wxT("e"), wxT("")));
+        manager.AddAnnotation(std::make_unique<BookmarkAnnotation>(kSession, 200, wxT("b")));
+        manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 100, wxT("a"), wxT("")));
+        manager.AddAnnotation(std::make_unique<HighlightAnnotation>(kSession, 300, wxT("d"), wxColour(1, 2, 3)));
+        manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 200, wxT("c"), wxT("")));
+        manager.AddAnnotation(std::make_unique<NoteAnnotation>(wxT("other"), 200, wxT("x"), wxT("")));
+
+        // 两端都包含在内，时间相同的按添加顺序
+        CHECK(JoinContents(manager.GetAnnotationsByTimeRange(kSession, 200, 300)) == wxT("bcd"));
+        CHECK(JoinContents(manager.GetAnnotationsByTimeRange(kSession, 100, 400)) == wxT("abcde"));
+        CHECK(JoinContents(manager.GetAnnotationsByTimeRange(kSession, 0, 1000)) == wxT("abcde"));
+        CHECK(JoinContents(manager.GetAnnotationsByTimeRange(kSession, 200, 200)) == wxT("bc"));
+        CHECK(manager.GetAnnotationsByTimeRange(kSession, 201, 299).empty());
+        CHECK(manager.GetAnnotationsByTimeRange(kSession, 401, 1000).empty());
+        CHECK(manager.GetAnnotationsByTimeRange(wxT("missing"), 0, 1000).empty());
+
+        // 按类型过滤的时间范围查询
+        CHECK(JoinContents(manager.GetAnnotationsByTimeRange(kSession, AnnotationType::Note, 100, 200)) == wxT("ac"));
+        CHECK(JoinContents(manager.GetAnnotationsByTimeRange(kSession, AnnotationType::Note, 200, 400)) == wxT("ce"));
+        CHECK(JoinContents(manager.GetAnnotationsByTimeRange(kSession, AnnotationType::Bookmark, 100, 400)) == wxT("b"));
+        CHECK(manager.GetAnnotationsByTimeRange(kSession, AnnotationType::Highlight, 100, 299).empty());
+        CHECK(JoinContents(manager.GetAnnotationsByType(kSession, AnnotationType::Note)) == wxT("ace"));
+        CheckIndexesConsistent(manager);
+    }
+
+    void TestRemoveAndReplayKeepIndexes() {
+        TempSessionDir dir;
+        {
+            AnnotationManager manager;
+            manager.LoadAnnotations(dir.GetPath());
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 100, wxT("a"), wxT("")));
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 200, wxT("b"), wxT("")));
+            manager.AddAnnotation(std::make_unique<BookmarkAnnotation>(kSession, 200, wxT("c")));
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 200, wxT("d"), wxT("")));
+            manager.SaveAnnotations(dir.GetPath());
+
+            // 删除时间相同的几条中的一条，只去掉这一条
+            std::vector<Annotation*> atTwoHundred = manager.GetAnnotationsByTimeRange(kSession, 200, 200);
+            CHECK(atTwoHundred.size() == 3);
+            CHECK(manager.RemoveAnnotation(atTwoHundred[0]));
+            CHECK(JoinContents(manager.GetAnnotationsByTimeRange(kSession, 0, 1000)) == wxT("acd"));
+            CHECK(JoinContents(manager.GetAnnotationsByType(kSession, AnnotationType::Note)) == wxT("ad"));
+            CheckIndexesConsistent(manager);
+
+            // 修改记为 '~'，重放时先移除再加入
+            NoteAnnotation* note = GetNote(manager, 1);
+            CHECK(note && note->GetContent() == wxT("d"));
+            if (note) {
+                note->SetContent(wxT("D"));
+                manager.UpdateAnnotation(note);
+            }
+            manager.SaveAnnotations(dir.GetPath());
+            CHECK(manager.FlushAnnotations(dir.GetPath()));
+        }
+
+        AnnotationManager manager;
+        CHECK(manager.LoadAnnotations(dir.GetPath()));
+        CHECK(manager.GetAnnotationCount(kSession) == 3);
+        CHECK(JoinContents(manager.GetAnnotationsByType(kSession, AnnotationType::Note)) == wxT("aD"));
+        CHECK(JoinContents(manager.GetAnnotationsByTimeRange(kSession, AnnotationType::Bookmark, 200, 200)) == wxT("c"));
+        CheckIndexesConsistent(manager);
+
+        // 重放后的批注仍然可以删除，两个索引同时去掉
+        std::vector<Annotation*> notes = manager.GetAnnotationsByTimeRange(kSession, AnnotationType::Note, 200, 200);
+        CHECK(notes.size() == 1);
+        if (notes.size() == 1) {
+            CHECK(manager.RemoveAnnotation(notes[0]));
+        }
+        CHECK(JoinContents(manager.GetAnnotationsByTimeRange(kSession, 0, 1000)) == wxT("ac"));
+        CheckIndexesConsistent(manager);
+    }
+
+    // 迁移后两个文件都是新格式，重新加载得到同样的批注
+    void CheckMigrated(const wxString& sessionPath) {
+        CHECK(ReadFile(MeetAnt::AnnotationJournal::GetSnapshotPath(sessionPath)).compare(0, 4, "MAAS") == 0);
+        CHECK(ReadFile(MeetAnt::AnnotationJournal::GetJournalPath(sessionPath)).compare(0, 4, "MAAJ") == 0);
+
+        MeetAnt::AnnotationJournal journal(sessionPath);
+        auto ignore = [](const char*, size_t) {};
+        CHECK(journal.Load(ignore, ignore));
+        CHECK(!journal.IsLegacy());
+    }
+
+    void TestMigrateLegacySnapshot() {
+        TempSessionDir dir;
+        CHECK(WriteFile(MeetAnt::AnnotationJournal::GetSnapshotPath(dir.GetPath()),
+                        "N|session|1000|2024-01-01 10:00:00|旧内容|标题\n"
+                        "B|session|500|2024-01-01 10:00:00|书签|标签\n"));
+        {
+            AnnotationManager manager;
+            CHECK(manager.LoadAnnotations(dir.GetPath()));
+            CHECK(manager.GetAnnotationCount(kSession) == 2);
+            CHECK(manager.FlushAnnotations(dir.GetPath()));
+        }
+        CheckMigrated(dir.GetPath());
+
+        AnnotationManager manager;
+        CHECK(manager.LoadAnnotations(dir.GetPath()));
+        CHECK(manager.GetAnnotationCount(kSession) == 2);
+        NoteAnnotation* note = GetNote(manager, 0);
+        CHECK(note && note->GetContent() == wxT("旧内容") && note->GetTitle() == wxT("标题"));
+        std::vector<Annotation*> bookmarks = manager.GetAnnotationsByType(kSession, AnnotationType::Bookmark);
+        CHECK(bookmarks.size() == 1 && bookmarks[0]->GetTimestamp() == 500);
+    }
+
+    void TestMigrateTextJournal() {
+        // 带代数行的文本日志：添加一个高亮、删除书签、修改批注（内容带转义的换行）
+        TempSessionDir dir;
+        CHECK(WriteFile(MeetAnt::AnnotationJournal::GetSnapshotPath(dir.GetPath()),
+                        "#generation=0\n"
+                        "N|session|1000|2024-01-01 10:00:00|旧内容|标题\n"
+                        "B|session|500|2024-01-01 10:00:00|书签|标签\n"));
+        CHECK(WriteFile(MeetAnt::AnnotationJournal::GetJournalPath(dir.GetPath()),
+                        "#generation=0\n"
+                        "+|3|H|session|700|2024-01-01 10:00:00|高亮|rgb(1,2,3)\n"
+                        "-|2\n"
+                        "~|1|N|session|1000|2024-01-01 10:00:00|第一行\\n第二行|新标题\n"));
+        {
+            AnnotationManager manager;
+            CHECK(manager.LoadAnnotations(dir.GetPath()));
+            CHECK(manager.FlushAnnotations(dir.GetPath()));
+        }
+        CheckMigrated(dir.GetPath());
+
+        AnnotationManager manager;
+        CHECK(manager.LoadAnnotations(dir.GetPath()));
+        CHECK(manager.GetAnnotationCount(kSession) == 2);
+        CHECK(manager.GetAnnotationsByType(kSession, AnnotationType::Bookmark).empty());
+        CHECK(manager.GetAnnotationsByType(kSession, AnnotationType::Highlight).size() == 1);
+        NoteAnnotation* note = GetNote(manager, 0);
+        CHECK(note && note->GetContent() == wxT("第一行\n第二行") && note->GetTitle() == wxT("新标题"));
+    }
+
+    void TestTornJournalRecord() {
+        TempSessionDir dir;
+        {
+            // 第一次保存写快照，之后的添加追加到日志
+            AnnotationManager manager;
+            manager.LoadAnnotations(dir.GetPath());
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 100, wxT("一"), wxT("a")));
+            manager.SaveAnnotations(dir.GetPath());
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 200, wxT("二"), wxT("b")));
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 300, wxT("三|\n"), wxT("c")));
+            manager.SaveAnnotations(dir.GetPath());
+            CHECK(manager.FlushAnnotations(dir.GetPath()));
+        }
+
+        // 模拟写最后一条记录时退出：截掉最后几个字节
+        wxString journalPath = MeetAnt::AnnotationJournal::GetJournalPath(dir.GetPath());
+        std::string journal = ReadFile(journalPath);
+        CHECK(journal.size() > 3);
+        CHECK(WriteFile(journalPath, journal.substr(0, journal.size() - 3)));
+        {
+            AnnotationManager manager;
+            CHECK(manager.LoadAnnotations(dir.GetPath()));
+            CHECK(manager.GetAnnotationCount(kSession) == 2);
+            NoteAnnotation* note = GetNote(manager, 1);
+            CHECK(note && note->GetContent() == wxT("二"));
+
+            // 之后的记录接在最后一条完整的记录后面
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 400, wxT("四"), wxT("d")));
+            manager.SaveAnnotations(dir.GetPath());
+            CHECK(manager.FlushAnnotations(dir.GetPath()));
+        }
+
+        AnnotationManager manager;
+        CHECK(manager.LoadAnnotations(dir.GetPath()));
+        CHECK(manager.GetAnnotationCount(kSession) == 3);
+        NoteAnnotation* note = GetNote(manager, 2);
+        CHECK(note && note->GetContent() == wxT("四"));
+    }
+
+    void TestStableIdsAcrossCompaction() {
+        TempSessionDir dir;
+        std::vector<std::string> changes;
+        unsigned long secondId = 0;
+        unsigned long thirdId = 0;
+        {
+            AnnotationManager manager;
+            manager.SetChangeListener([&changes](const std::string& record) { changes.push_back(record); });
+            manager.LoadAnnotations(dir.GetPath());
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 100, wxT("一"), wxT("a")));
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 200, wxT("二"), wxT("b")));
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 300, wxT("三"), wxT("c")));
+            CHECK(manager.RemoveAnnotation(GetNote(manager, 0)));
+            secondId = GetNote(manager, 0)->GetId();
+            thirdId = GetNote(manager, 1)->GetId();
+
+            // 足够多的修改使保存时压缩为新快照
+            NoteAnnotation* third = GetNote(manager, 1);
+            for (int i = 0; i < 300; ++i) {
+                third->SetContent(wxString::Format(wxT("三%d"), i));
+                manager.UpdateAnnotation(third);
+            }
+            manager.SaveAnnotations(dir.GetPath());
+            CHECK(manager.FlushAnnotations(dir.GetPath()));
+            CHECK(GetNote(manager, 0)->GetId() == secondId);
+            CHECK(GetNote(manager, 1)->GetId() == thirdId);
+
+            // 新批注的编号不与删除过的编号重复
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 400, wxT("四"), wxT("d")));
+            CHECK(GetNote(manager, 2)->GetId() > thirdId);
+            manager.SaveAnnotations(dir.GetPath());
+            CHECK(manager.FlushAnnotations(dir.GetPath()));
+        }
+
+        // 每次修改回调一条记录，按编号引用批注
+        CHECK(changes.size() == 305);
+        char operation = 0;
+        unsigned long id = 0;
+        std::unique_ptr<Annotation> annotation;
+        CHECK(AnnotationManager::DecodeRecord(changes[3].data(), changes[3].size(), operation, id, annotation));
+        CHECK(operation == '-' && !annotation);
+        CHECK(AnnotationManager::DecodeRecord(changes[303].data(), changes[303].size(), operation, id, annotation));
+        CHECK(operation == '~' && id == thirdId && annotation && annotation->GetContent() == wxT("三299"));
+
+        // 重新加载快照和日志后编号不变
+        AnnotationManager manager;
+        CHECK(manager.LoadAnnotations(dir.GetPath()));
+        CHECK(manager.GetAnnotationCount(kSession) == 3);
+        CHECK(GetNote(manager, 0) && GetNote(manager, 0)->GetId() == secondId);
+        CHECK(GetNote(manager, 1) && GetNote(manager, 1)->GetId() == thirdId);
+        CHECK(GetNote(manager, 1) && GetNote(manager, 1)->GetContent() == wxT("三299"));
+
+        // 恢复日志中的修改按编号重做，已经保存过的修改重做后结果不变
+        for (const auto& record : changes) {
+            CHECK(manager.ApplyChange(record));
+        }
+        CHECK(manager.GetAnnotationCount(kSession) == 3);
+        CHECK(JoinContents(manager.GetAnnotationsByType(kSession, AnnotationType::Note)) == wxT("二三299四"));
+        CHECK(GetNote(manager, 1) && GetNote(manager, 1)->GetId() == thirdId);
+    }
+
+    void TestLoadVersion1Snapshot() {
+        // 版本 1 的快照记录没有编号，按出现顺序编号；日志记录引用这些编号
+        TempSessionDir dir;
+        std::string snapshot = MeetAnt::MakeRecordFileHeader("MAAS", 1, 1);
+        std::string journal = MeetAnt::MakeRecordFileHeader("MAAJ", 1, 1);
+        std::string record;
+        NoteAnnotation(kSession, 100, wxT("一"), wxT("a")).Encode(record);
+        MeetAnt::AppendRecord(snapshot, record);
+        MeetAnt::AppendRecord(snapshot, std::string("damaged"));
+        record.clear();
+        NoteAnnotation(kSession, 300, wxT("三"), wxT("c")).Encode(record);
+        MeetAnt::AppendRecord(snapshot, record);
+        record.clear();
+        MeetAnt::AppendValue<char>(record, '-');
+        MeetAnt::AppendValue<uint32_t>(record, 1);
+        MeetAnt::AppendRecord(journal, record);
+        CHECK(WriteFile(MeetAnt::AnnotationJournal::GetSnapshotPath(dir.GetPath()), snapshot));
+        CHECK(WriteFile(MeetAnt::AnnotationJournal::GetJournalPath(dir.GetPath()), journal));
+        {
+            AnnotationManager manager;
+            CHECK(manager.LoadAnnotations(dir.GetPath()));
+            CHECK(manager.GetAnnotationCount(kSession) == 1);
+            NoteAnnotation* note = GetNote(manager, 0);
+            CHECK(note && note->GetContent() == wxT("三") && note->GetId() == 3);
+
+            // 旧版本的日志可以接着追加
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 400, wxT("四"), wxT("d")));
+            CHECK(GetNote(manager, 1) && GetNote(manager, 1)->GetId() == 4);
+            manager.SaveAnnotations(dir.GetPath());
+            CHECK(manager.FlushAnnotations(dir.GetPath()));
+        }
+
+        AnnotationManager manager;
+        CHECK(manager.LoadAnnotations(dir.GetPath()));
+        CHECK(manager.GetAnnotationCount(kSession) == 2);
+        CHECK(GetNote(manager, 1) && GetNote(manager, 1)->GetId() == 4);
+    }
+
+    void TestLoadFromArchive() {
+        // 归档中的快照和日志取自一个普通的会话目录
+        std::map<wxString, std::string> archived;
+        {
+            TempSessionDir source;
+            AnnotationManager manager;
+            manager.LoadAnnotations(source.GetPath());
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 100, wxT("一"), wxT("a")));
+            manager.SaveAnnotations(source.GetPath());
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 200, wxT("二"), wxT("b")));
+            manager.SaveAnnotations(source.GetPath());
+            CHECK(manager.FlushAnnotations(source.GetPath()));
+            archived[wxT("annotations.dat")] = ReadFile(MeetAnt::AnnotationJournal::GetSnapshotPath(source.GetPath()));
+            archived[wxT("annotations.journal")] = ReadFile(MeetAnt::AnnotationJournal::GetJournalPath(source.GetPath()));
+        }
+        auto reader = [&archived](const wxString&, const wxString& fileName, std::string& data) {
+            auto it = archived.find(fileName);
+            if (it == archived.end()) {
+                return false;
+            }
+            data = it->second;
+            return true;
+        };
+
+        // 已归档的会话目录中没有批注文件
+        TempSessionDir dir;
+        {
+            AnnotationManager manager;
+            manager.SetArchiveReader(reader);
+            CHECK(manager.LoadAnnotations(dir.GetPath()));
+            CHECK(manager.GetAnnotationCount(kSession) == 2);
+            CHECK(!wxFileExists(MeetAnt::AnnotationJournal::GetSnapshotPath(dir.GetPath())));
+
+            // 第一次保存在目录中写一份完整的快照，而不是只有新记录的日志
+            manager.AddAnnotation(std::make_unique<NoteAnnotation>(kSession, 300, wxT("三"), wxT("c")));
+            manager.SaveAnnotations(dir.GetPath());
+            CHECK(manager.FlushAnnotations(dir.GetPath()));
+        }
+
+        // 目录中的文件优先于归档：不读取归档也能得到全部批注
+        AnnotationManager manager;
+        CHECK(manager.LoadAnnotations(dir.GetPath()));
+        CHECK(manager.GetAnnotationCount(kSession) == 3);
+        NoteAnnotation* note = GetNote(manager, 2);
+        CHECK(note && note->GetContent() == wxT("三"));
+    }
+
+    struct TestCase {
+        const char* name;
+        void (*function)();
+    };
+}
+
+int main() {
+    // 批注日志的写入线程需要初始化 wx
+    wxInitializer initializer;
+    if (!initializer.IsOk()) {
+        std::fprintf(stderr, "无法初始化 wxWidgets\n");
+        return 1;
+    }
+
+    const TestCase tests[] = {
+        { "二进制编码往返", TestEncodeRoundTrip },
+        { "按时间范围和类型查询", TestTimeRangeQuery },
+        { "删除和重放后索引一致", TestRemoveAndReplayKeepIndexes },
+        { "迁移竖线分隔的快照", TestMigrateLegacySnapshot },
+        { "迁移文本日志", TestMigrateTextJournal },
+        { "丢弃写了一半的日志记录", TestTornJournalRecord },
+        { "压缩前后编号不变", TestStableIdsAcrossCompaction },
+        { "读取版本 1 的快照", TestLoadVersion1Snapshot },
+        { "从会话归档中加载", TestLoadFromArchive },
+    };
+
+    for (const auto& test : tests) {
+        int failuresBefore = s_failures;
+        test.function();
+        std::printf("%s %s\n", s_failures == failuresBefore ? "[通过]" : "[失败]", test.name);
+    }
+    if (s_failures > 0) {
+        std::printf("%d 项检查失败\n", s_failures);
+        return 1;
+    }
+    return 0;
+}
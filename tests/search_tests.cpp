@@ -0,0 +1,215 @@
+// 转录全文搜索的单元测试
+// 在合成转录上把倒排索引、正则筛选和拼音模糊自动机的结果与逐条扫描的参考实现比对，
+// 另外覆盖短语边界、规范化和增量追加等具体行为。失败时打印位置并以非零值退出。
+
+#include "SearchIndex.h"
+#include "RegexSearch.h"
+#include "FuzzySearch.h"
+#include "Pinyin.h"
+#include "synthetic_transcript.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using MeetAnt::SearchHit;
+using MeetAnt::SearchIndex;
+using MeetAnt::Synthetic::Message;
+
+namespace {
+    int s_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: 检查失败: %s\n", __FILE__, __LINE__, #condition); \
+            s_failures++; \
+        } \
+    } while (0)
+
+    // 测试用的转录约 2 小时，覆盖全部词表又能在一秒内跑完
+    const double kTranscriptHours = 2.0;
+
+    const std::vector<Message>& GetTranscript() {
+        static const std::vector<Message> messages = MeetAnt::Synthetic::GenerateTranscript(kTranscriptHours, 42);
+        return messages;
+    }
+
+    const SearchIndex& GetIndex() {
+        static SearchIndex index;
+        if (index.GetDocumentCount() == 0) {
+            for (const auto& message : GetTranscript()) {
+                index.AddDocument(message.text);
+            }
+        }
+        return index;
+    }
+
+    bool SameHits(const std::vector<SearchHit>& a, const std::vector<SearchHit>& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i].document != b[i].document || a[i].offset != b[i].offset || a[i].length != b[i].length) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<SearchHit> SearchOne(const std::wstring& text, const std::wstring& query) {
+        SearchIndex index;
+        index.AddDocument(text);
+        return index.Search(query);
+    }
+
+    void TestSubstringMatchesReference() {
+        const std::vector<Message>& messages = GetTranscript();
+        for (const auto& query : MeetAnt::Synthetic::MakeSubstringQueries(messages, 300, 11)) {
+            CHECK(SameHits(GetIndex().Search(query), MeetAnt::Synthetic::BruteForceSubstring(messages, query)));
+        }
+    }
+
+    void TestNormalization() {
+        // 大小写和全角字母数字视同半角，位置按原文计
+        std::vector<SearchHit> hits = SearchOne(L"下周 Ｒｅｌｅａｓｅ v2", L"release");
+        CHECK(hits.size() == 1 && hits[0].offset == 3 && hits[0].length == 7);
+        CHECK(SearchOne(L"API 版本", L"ＡＰＩ").size() == 1);
+        CHECK(SearchOne(L"预算审批", L"算审").size() == 1);
+        CHECK(SearchOne(L"预算审批", L"审预").empty());
+    }
+
+    void TestPhraseBoundaries() {
+        CHECK(SearchOne(L"new feature review", L"\"feature review\"").size() == 1);
+        CHECK(SearchOne(L"newfeature review", L"\"feature review\"").empty());
+        CHECK(SearchOne(L"feature, review", L"\"feature review\"").size() == 1);
+        CHECK(SearchOne(L"featurereview", L"\"feature review\"").empty());
+        CHECK(SearchOne(L"客户需求", L"\"客户 需求\"").size() == 1);
+    }
+
+    void TestIncrementalAppend() {
+        // 先建索引再追加的结果与一次建好的一致，文档序号即追加顺序
+        const std::vector<Message>& messages = GetTranscript();
+        SearchIndex index;
+        size_t half = messages.size() / 2;
+        for (size_t i = 0; i < half; ++i) {
+            index.AddDocument(messages[i].text);
+        }
+        std::vector<SearchHit> before = index.Search(L"预算");
+        for (size_t i = half; i < messages.size(); ++i) {
+            CHECK(index.AddDocument(messages[i].text) == i);
+        }
+        std::vector<SearchHit> after = index.Search(L"预算");
+        CHECK(after.size() >= before.size());
+        CHECK(SameHits(std::vector<SearchHit>(after.begin(), after.begin() + before.size()), before));
+        CHECK(SameHits(after, GetIndex().Search(L"预算")));
+    }
+
+    void TestRegexMatchesReference() {
+        const std::vector<Message>& messages = GetTranscript();
+        std::vector<SearchHit> hits;
+        for (const auto& pattern : MeetAnt::Synthetic::MakeRegexQueries()) {
+            MeetAnt::RegexQuery regex;
+            CHECK(regex.Compile(pattern, false));
+
+            // 候选筛选不能漏掉任何真正匹配的消息
+            std::vector<uint32_t> candidates = regex.FindCandidates(GetIndex());
+            std::vector<size_t> indexed;
+            for (uint32_t document : candidates) {
+                hits.clear();
+                if (regex.Match(messages[document].text, document, hits, 1)) {
+                    indexed.push_back(document);
+                }
+            }
+            std::vector<size_t> expected;
+            for (size_t document = 0; document < messages.size(); ++document) {
+                hits.clear();
+                if (regex.Match(messages[document].text, document, hits, 1)) {
+                    expected.push_back(document);
+                }
+            }
+            CHECK(indexed == expected);
+        }
+    }
+
+    void TestRegexLiterals() {
+        CHECK(MeetAnt::RegexQuery::ExtractRequiredLiterals(L"会议|讨论").empty());
+        std::vector<std::wstring> literals = MeetAnt::RegexQuery::ExtractRequiredLiterals(L"预算.{0,6}审批");
+        CHECK(literals.size() == 2);
+
+        MeetAnt::RegexQuery invalid;
+        CHECK(!invalid.Compile(L"(预算", false));
+        CHECK(!invalid.GetError().empty());
+    }
+
+    void TestFuzzyMatchesReference() {
+        const std::vector<Message>& messages = GetTranscript();
+        const SearchIndex& index = GetIndex();
+        std::vector<SearchHit> hits;
+        for (const auto& query : MeetAnt::Synthetic::MakeFuzzyQueries()) {
+            MeetAnt::FuzzyQuery fuzzy;
+            CHECK(fuzzy.Compile(query));
+            // 索引筛选出的候选必须包含所有匹配的文档
+            std::vector<uint32_t> candidates = fuzzy.FindCandidates(index);
+            CHECK(std::is_sorted(candidates.begin(), candidates.end()));
+            for (size_t document = 0; document < messages.size(); ++document) {
+                hits.clear();
+                bool matched = fuzzy.Match(index.GetNormalizedText(document), index.GetPinyinKey(document),
+                                           document, hits, 0);
+                bool expected = MeetAnt::Synthetic::ApproximateContains(index.GetPinyinKey(document),
+                                                                        fuzzy.GetKey(), fuzzy.GetMaxDistance());
+                CHECK(matched == expected);
+                CHECK(!expected || std::binary_search(candidates.begin(), candidates.end(),
+                                                      static_cast<uint32_t>(document)));
+                // 命中位置落在原文范围内
+                for (const auto& hit : hits) {
+                    CHECK(hit.length > 0 && hit.offset + hit.length <= messages[document].text.length());
+                }
+            }
+        }
+    }
+
+    void TestPinyin() {
+        CHECK(std::strcmp(MeetAnt::GetPinyinSyllable(L'中'), "zhong") == 0);
+        CHECK(MeetAnt::GetPinyinSyllable(L'a') == nullptr);
+        CHECK(MeetAnt::ToPinyinKey(SearchIndex::Normalize(L"预算 Q3")) == "yusuanq3");
+
+        // 同音字错写也能找到原文，命中位置按原文字符计
+        MeetAnt::FuzzyQuery fuzzy;
+        CHECK(fuzzy.Compile(L"玉算"));
+        std::wstring text = SearchIndex::Normalize(L"今年的预算");
+        std::vector<SearchHit> hits;
+        CHECK(fuzzy.Match(text, MeetAnt::ToPinyinKey(text), 0, hits, 0));
+        CHECK(hits.size() == 1 && hits[0].offset == 3 && hits[0].length == 2);
+    }
+
+    struct TestCase {
+        const char* name;
+        void (*function)();
+    };
+}
+
+int main() {
+    const TestCase tests[] = {
+        { "子串与参考实现一致", TestSubstringMatchesReference },
+        { "规范化", TestNormalization },
+        { "短语边界", TestPhraseBoundaries },
+        { "增量追加", TestIncrementalAppend },
+        { "正则与参考实现一致", TestRegexMatchesReference },
+        { "正则字面串", TestRegexLiterals },
+        { "拼音模糊与参考实现一致", TestFuzzyMatchesReference },
+        { "拼音", TestPinyin },
+    };
+
+    for (const auto& test : tests) {
+        int failuresBefore = s_failures;
+        test.function();
+        std::printf("%s %s\n", s_failures == failuresBefore ? "[通过]" : "[失败]", test.name);
+    }
+    if (s_failures > 0) {
+        std::printf("%d 项检查失败\n", s_failures);
+        return 1;
+    }
+    return 0;
+}